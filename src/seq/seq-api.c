@@ -4,6 +4,26 @@
 
 /* ==================================================================================== Core API */
 
+/* Returns the leading constant of the argument list without consuming it, or 0 if it isn't part of
+ * the same group as @max; this is only needed for SEQ_STATS and SEQ_TRACE. */
+static seq_opt_t seq_args_peek(seq_args_t args, seq_opt_t max) {
+	va_list copy;
+	seq_opt_t opt;
+
+	seq_args_copy(copy, *args);
+
+	opt = seq_arg_opt(&copy);
+
+	va_end(copy);
+
+	if((opt & 0xFFFF0000) != (max & 0xFFFF0000) || opt > max) return 0;
+
+	return opt;
+}
+
+#define seq_args_peek_if(seq, args, max) \
+	((seq)->stats || seq_tracing(seq) ? seq_args_peek(args, max) : 0)
+
 #define seq_args_wrap(func, start, ret) \
 	va_list args; \
 	va_start(args, start); \
@@ -12,21 +32,87 @@
 
 seq_t seq_create(seq_opt_t type) {
 	seq_t seq = NULL;
+	seq_impl_t impl = NULL;
 
 	if(seq_opt(type, SEQ_TYPE)) {
-		seq = seq_malloc(seq_t);
+		/* Queues and stacks are simply lists, used through SEQ_SEND/SEQ_RECV and
+		 * SEQ_PUSH/SEQ_POP respectively. */
+		if(type == SEQ_LIST || type == SEQ_QUEUE || type == SEQ_STACK) impl = seq_impl_list();
+
+		else if(type == SEQ_ARRAY) impl = seq_impl_array();
+
+		else if(type == SEQ_HEAP) impl = seq_impl_heap();
 
-		if(seq) {
-			if(type == SEQ_LIST) seq_impl_list()->create(seq);
+		else if(type == SEQ_DEQUE) impl = seq_impl_deque();
+
+		else if(type == SEQ_VECTOR) impl = seq_impl_vector();
+
+		/* The red-black tree in seq-map.c was never finished; maps are B+trees instead. */
+		else if(type == SEQ_MAP || type == SEQ_BTREE) impl = seq_impl_btree();
+
+		else if(type == SEQ_ART) impl = seq_impl_art();
+
+		else if(type == SEQ_CACHE) impl = seq_impl_cache();
+
+		if(impl && (seq = seq_malloc(seq_t))) {
+			impl->create(seq);
+
+			if(!seq->data) {
+				free(seq);
+
+				seq = NULL;
+			}
+
+			else seq->type = type;
 		}
 	}
 
 	return seq;
 }
 
+seq_t seq_create_from(seq_opt_t type, seq_t src) {
+	seq_t seq = seq_create(type);
+	seq_iter_t iter = NULL;
+
+	if(!seq) return NULL;
+
+	seq->cb.cmp = src->cb.cmp;
+
+	if(!(iter = seq_iter_create(src, SEQ_ERR_NONE))) {
+		seq_destroy(seq);
+
+		return NULL;
+	}
+
+	while(seq_iterate(iter)) {
+		if(seq_add(seq, SEQ_APPEND, seq_iter_get(iter, SEQ_DATA))) {
+			seq_destroy(seq);
+
+			seq = NULL;
+
+			break;
+		}
+	}
+
+	seq_iter_destroy(iter);
+
+	return seq;
+}
+
 void seq_destroy(seq_t seq) {
+	uint64_t begin = seq_trace_begin(seq);
+
 	seq->impl->destroy(seq);
 
+	if(begin) seq_trace_end(seq, SEQ_CALL_DESTROY, 0, begin);
+
+	seq_trace_config(seq, 0);
+	seq_block_config(seq, 0, 0);
+	seq_intern_config(seq, 0);
+	seq_bloom_config(seq, 0);
+	seq_fd_close(seq);
+
+	free(seq->stats);
 	free(seq);
 }
 
@@ -58,7 +144,90 @@ seq_opt_t seq_vconfig(seq_t seq, seq_args_t args) {
 			seq->cb.remove = remove;
 		}
 
-		else return SEQ_ERR_OPT;
+		else if(opt == SEQ_CB_SERIALIZE) {
+			seq_cb_serialize_t serialize = seq_arg(args, seq_cb_serialize_t);
+
+			if(!serialize) return SEQ_ERR_CB;
+
+			seq->cb.serialize = serialize;
+		}
+
+		else if(opt == SEQ_CB_TRACE) {
+			seq_cb_trace_t trace = seq_arg(args, seq_cb_trace_t);
+
+			if(!trace) return SEQ_ERR_CB;
+
+			seq->cb.trace = trace;
+		}
+
+		else if(opt == SEQ_TRACE) return seq_trace_config(seq, seq_arg(args, int));
+
+		else if(opt == SEQ_BLOCKING) {
+			int timeout = seq_arg(args, int);
+
+			return seq_block_config(seq, timeout, seq_arg(args, int));
+		}
+
+		else if(opt == SEQ_CB_DESERIALIZE) {
+			seq_cb_deserialize_t deserialize = seq_arg(args, seq_cb_deserialize_t);
+
+			if(!deserialize) return SEQ_ERR_CB;
+
+			seq->cb.deserialize = deserialize;
+		}
+
+		else if(opt == SEQ_CHECKSUM) seq->io.checksum = seq_arg(args, int);
+
+		else if(opt == SEQ_THREADS) {
+			int threads = seq_arg(args, int);
+
+			if(threads < 0) return SEQ_ERR_OPT;
+
+			seq->parallel.threads = threads;
+		}
+
+		/* Ordering the elements is up to the implementation, which must agree first (it may
+		 * already depend on a previous callback). */
+		else if(opt == SEQ_SORTED || opt == SEQ_CB_CMP) {
+			seq_cb_cmp_t cmp = seq_arg(args, seq_cb_cmp_t);
+			seq_opt_t err = SEQ_ERR_NONE;
+
+			if(!cmp) return SEQ_ERR_CB;
+
+			if((err = seq->impl->config(seq, opt, args))) return err;
+
+			seq->cb.cmp = cmp;
+		}
+
+		else if(opt == SEQ_CB_SIZE) {
+			seq_cb_size_t size = seq_arg(args, seq_cb_size_t);
+			seq_opt_t err = SEQ_ERR_NONE;
+
+			if(!size) return SEQ_ERR_CB;
+
+			if((err = seq->impl->config(seq, opt, args))) return err;
+
+			seq->cb.size = size;
+		}
+
+		else if(opt == SEQ_STATS) {
+			if(!seq_arg(args, int)) {
+				free(seq->stats);
+
+				seq->stats = NULL;
+			}
+
+			else {
+				if(seq->stats) memset(seq->stats, 0, sizeof(struct _seq_stats_t));
+
+				else if(!(seq->stats = seq_malloc(seq_stats_t))) return SEQ_ERR_MEM;
+
+				seq->stats->size_peak = seq->size;
+			}
+		}
+
+		/* Everything else is specific to the implementation in use. */
+		else return seq->impl->config(seq, opt, args);
 	}
 
 	else return SEQ_ERR_OPT;
@@ -76,7 +245,28 @@ seq_opt_t seq_add(seq_t seq, ...) {
 }
 
 seq_opt_t seq_vadd(seq_t seq, seq_args_t args) {
-	return seq->impl->add(seq, args);
+	seq_opt_t opt = seq_args_peek_if(seq, args, SEQ_ADD_MAX);
+	uint64_t begin = seq_trace_begin(seq);
+	seq_opt_t r;
+
+	seq_stats_add(seq, add[seq_opt_val(opt)], 1);
+
+	if(seq->block) r = seq_block_add(seq, args);
+
+	else {
+		/* The size is only read when needed, since a SEQ_DEQUE may be shrinking concurrently. */
+		seq_size_t size = seq->event.enabled ? seq_atomic_load(&seq->size) : 1;
+
+		r = seq->impl->add(seq, args);
+
+		if(!r && !size && seq->event.enabled) seq_fd_notify(seq);
+
+		seq_stats_peak(seq);
+	}
+
+	if(begin) seq_trace_end(seq, SEQ_CALL_ADD, opt, begin);
+
+	return r;
 }
 
 seq_opt_t seq_remove(seq_t seq, ...) {
@@ -88,7 +278,21 @@ seq_opt_t seq_remove(seq_t seq, ...) {
 }
 
 seq_opt_t seq_vremove(seq_t seq, seq_args_t args) {
-	return seq->impl->remove(seq, args);
+	seq_opt_t opt = seq_args_peek_if(seq, args, SEQ_GET_MAX);
+	uint64_t begin = seq_trace_begin(seq);
+	seq_opt_t r;
+
+	seq_stats_add(seq, remove[seq_opt_val(opt)], 1);
+
+	if(seq->block) seq_block_lock(seq);
+
+	r = seq->impl->remove(seq, args);
+
+	if(seq->block) seq_block_unlock(seq);
+
+	if(begin) seq_trace_end(seq, SEQ_CALL_REMOVE, opt, begin);
+
+	return r;
 }
 
 seq_data_t seq_get(seq_t seq, ...) {
@@ -100,7 +304,17 @@ seq_data_t seq_get(seq_t seq, ...) {
 }
 
 seq_data_t seq_vget(seq_t seq, seq_args_t args) {
-	return seq->impl->get(seq, args);
+	seq_opt_t opt = seq_args_peek_if(seq, args, SEQ_GET_MAX);
+	uint64_t begin = seq_trace_begin(seq);
+	seq_data_t r;
+
+	seq_stats_add(seq, get[seq_opt_val(opt)], 1);
+
+	r = seq->block ? seq_block_get(seq, args) : seq->impl->get(seq, args);
+
+	if(begin) seq_trace_end(seq, SEQ_CALL_GET, opt, begin);
+
+	return r;
 }
 
 seq_opt_t seq_set(seq_t seq, ...) {
@@ -112,7 +326,21 @@ seq_opt_t seq_set(seq_t seq, ...) {
 }
 
 seq_opt_t seq_vset(seq_t seq, seq_args_t args) {
-	return seq->impl->set(seq, args);
+	seq_opt_t opt = seq_args_peek_if(seq, args, SEQ_GET_MAX);
+	uint64_t begin = seq_trace_begin(seq);
+	seq_opt_t r;
+
+	seq_stats_add(seq, set[seq_opt_val(opt)], 1);
+
+	if(seq->block) seq_block_lock(seq);
+
+	r = seq->impl->set(seq, args);
+
+	if(seq->block) seq_block_unlock(seq);
+
+	if(begin) seq_trace_end(seq, SEQ_CALL_SET, opt, begin);
+
+	return r;
 }
 
 seq_opt_t seq_type(seq_t seq) {
@@ -120,7 +348,66 @@ seq_opt_t seq_type(seq_t seq) {
 }
 
 seq_size_t seq_size(seq_t seq) {
-	return seq->size;
+	return seq_atomic_load(&seq->size);
+}
+
+seq_opt_t seq_stats(seq_t seq, seq_stats_t stats) {
+	uint64_t* src;
+	uint64_t* dst;
+	seq_size_t i;
+
+	if(!seq->stats) return SEQ_ERR_OPT;
+
+	src = (uint64_t*)(seq->stats);
+	dst = (uint64_t*)(stats);
+
+	for(i = 0; i < sizeof(struct _seq_stats_t) / sizeof(uint64_t); i++) {
+		dst[i] = seq_atomic_load(&src[i]);
+	}
+
+	return SEQ_ERR_NONE;
+}
+
+seq_data_t seq_cb_add(seq_t seq, seq_args_t args) {
+	uint64_t begin;
+	seq_data_t data;
+
+	if(!seq->cb.add) return seq_arg_data(args);
+
+	seq_stats_add(seq, cb[seq_opt_val(SEQ_CB_ADD)], 1);
+
+	begin = seq_trace_begin(seq);
+	data = seq->cb.add(args);
+
+	if(begin) seq_trace_end(seq, SEQ_CALL_CB_ADD, 0, begin);
+
+	return data;
+}
+
+void seq_cb_remove(seq_t seq, seq_data_t data) {
+	uint64_t begin;
+
+	if(!seq->cb.remove) return;
+
+	seq_stats_add(seq, cb[seq_opt_val(SEQ_CB_REMOVE)], 1);
+
+	begin = seq_trace_begin(seq);
+
+	seq->cb.remove(data);
+
+	if(begin) seq_trace_end(seq, SEQ_CALL_CB_REMOVE, 0, begin);
+}
+
+void seq_atomic_min(uint64_t* ptr, uint64_t val) {
+	uint64_t cur = seq_atomic_load(ptr);
+
+	while(val < cur && !seq_atomic_cas(ptr, &cur, val));
+}
+
+void seq_atomic_max(uint64_t* ptr, uint64_t val) {
+	uint64_t cur = seq_atomic_load(ptr);
+
+	while(val > cur && !seq_atomic_cas(ptr, &cur, val));
 }
 
 static const char* seq_string_type[] = {
@@ -130,7 +417,13 @@ static const char* seq_string_type[] = {
 	"RING",
 	"QUEUE",
 	"STACK",
-	"ARRAY"
+	"ARRAY",
+	"HEAP",
+	"DEQUE",
+	"VECTOR",
+	"BTREE",
+	"ART",
+	"CACHE"
 };
 
 static const char* seq_string_config[] = {
@@ -138,7 +431,22 @@ static const char* seq_string_config[] = {
 	"CB_ADD",
 	"CB_REMOVE",
 	"SORTED",
-	"BLOCKING"
+	"BLOCKING",
+	"INTRUSIVE",
+	"CB_SERIALIZE",
+	"CB_DESERIALIZE",
+	"CHECKSUM",
+	"STATS",
+	"CB_TRACE",
+	"TRACE",
+	"STRIDE",
+	"CB_CMP",
+	"THREADS",
+	"INTERN",
+	"CAPACITY",
+	"CB_SIZE",
+	"BLOOM",
+	"COMPACT"
 };
 
 static const char* seq_string_add[] = {
@@ -159,7 +467,9 @@ static const char* seq_string_get[] = {
 	"KEY",
 	"RECV",
 	"POP",
-	"DATA"
+	"DATA",
+	"PEEK",
+	"STEAL"
 };
 
 static const char* seq_string_iter[] = {
@@ -168,7 +478,11 @@ static const char* seq_string_iter[] = {
 	"ACTIVE",
 	"STOP",
 	"RANGE",
-	"INC"
+	"INC",
+	"KEY_PREFIX",
+	"REVERSE",
+	"EXCLUDE_LO",
+	"EXCLUDE_HI"
 };
 
 static const char* seq_string_cmp[] = {
@@ -185,7 +499,19 @@ static const char* seq_string_err[] = {
 	"ERR_DATA",
 	"ERR_NODE",
 	"ERR_CB",
-	"ERR_TODO"
+	"ERR_TODO",
+	"ERR_IO"
+};
+
+static const char* seq_string_call[] = {
+	"CALL",
+	"CALL_ADD",
+	"CALL_REMOVE",
+	"CALL_GET",
+	"CALL_SET",
+	"CALL_DESTROY",
+	"CALL_CB_ADD",
+	"CALL_CB_REMOVE"
 };
 
 static const char** seq_string_data[] = {
@@ -195,7 +521,8 @@ static const char** seq_string_data[] = {
 	seq_string_get,
 	seq_string_iter,
 	seq_string_cmp,
-	seq_string_err
+	seq_string_err,
+	seq_string_call
 };
 
 const char* seq_string(seq_opt_t opt) {
@@ -208,13 +535,13 @@ const char* seq_string(seq_opt_t opt) {
 		seq_opt(opt, SEQ_GET) ||
 		seq_opt(opt, SEQ_ITER) ||
 		seq_opt(opt, SEQ_CMP) ||
-		seq_opt(opt, SEQ_ERR)
+		seq_opt(opt, SEQ_ERR) ||
+		seq_opt(opt, SEQ_CALL)
 	) return seq_string_data[((opt & 0x000F0000) >> 16) - 1][seq_opt_val(opt)];
 
 	else return "";
 }
 
-#if 0
 /* =============================================================================== Iteration API */
 
 seq_iter_t seq_iter_create(seq_t seq, ...) {
@@ -233,7 +560,12 @@ seq_iter_t seq_iter_vcreate(seq_t seq, seq_args_t args) {
 	iter->seq = seq;
 	iter->state = SEQ_READY;
 
-	seq->impl->iter.create(iter, args);
+	if(seq->impl->iter.create(iter, args) || !iter->data) {
+		free(iter->data);
+		free(iter);
+
+		return NULL;
+	}
 
 	return iter;
 }
@@ -245,15 +577,17 @@ void seq_iter_destroy(seq_iter_t iter) {
 	free(iter);
 }
 
-seq_get_t seq_iter_get(seq_iter_t iter, ...) {
-	seq_get_t get;
+seq_data_t seq_iter_get(seq_iter_t iter, ...) {
+	seq_data_t get;
 
 	seq_args_wrap(iter_vget, iter, get);
 
 	return get;
 }
 
-seq_get_t seq_iter_vget(seq_iter_t iter, seq_args_t args) {
+seq_data_t seq_iter_vget(seq_iter_t iter, seq_args_t args) {
+	if(iter->state != SEQ_ACTIVE) return NULL;
+
 	return iter->seq->impl->iter.get(iter, args);
 }
 
@@ -266,13 +600,36 @@ seq_opt_t seq_iter_set(seq_iter_t iter, ...) {
 }
 
 seq_opt_t seq_iter_vset(seq_iter_t iter, seq_args_t args) {
+	if(iter->state != SEQ_ACTIVE) return SEQ_ERR_NODE;
+
 	return iter->seq->impl->iter.set(iter, args);
 }
 
 seq_opt_t seq_iterate(seq_iter_t iter) {
-	return iter->seq->impl->iter.iterate(iter);
+	if(iter->state == SEQ_STOP) return SEQ_ERR_NONE;
+
+	iter->state = iter->seq->impl->iter.iterate(iter);
+
+	return iter->state == SEQ_ACTIVE ? SEQ_ACTIVE : SEQ_ERR_NONE;
+}
+
+seq_iter_t seq_iter_copy(seq_iter_t iter) {
+	seq_iter_t copy = seq_malloc(seq_iter_t);
+
+	if(!copy) return NULL;
+
+	copy->seq = iter->seq;
+	copy->state = iter->state;
+
+	if(iter->seq->impl->iter.copy(copy, iter)) {
+		free(copy->data);
+		free(copy);
+
+		return NULL;
+	}
+
+	return copy;
 }
-#endif
 
 /* =================================================================================== Debugging */
 
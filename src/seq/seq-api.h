@@ -10,36 +10,108 @@
 #define seq_opt(opt, mask) (opt <= mask##_MAX && ((opt & mask) == mask))
 #define seq_opt_val(opt) (opt & 0x0000FFFF)
 
+/* C90 has no va_copy(), but every compiler we care about provides some equivalent. */
+#if defined(va_copy)
+#define seq_args_copy(dst, src) va_copy(dst, src)
+#elif defined(__va_copy)
+#define seq_args_copy(dst, src) __va_copy(dst, src)
+#else
+#define seq_args_copy(dst, src) memcpy(&(dst), &(src), sizeof(va_list))
+#endif
+
+/* The counters of SEQ_STATS and SEQ_TRACE may be updated from several threads at once, but never
+ * order anything else; only publishing a newly allocated SEQ_TRACE histogram needs the stronger
+ * seq_atomic_cas() (which, when it fails, stores the current value in *@old) and the matching
+ * seq_atomic_acquire(). */
+#if defined(__ATOMIC_RELAXED)
+#define seq_atomic_add(ptr, n) __atomic_fetch_add(ptr, n, __ATOMIC_RELAXED)
+#define seq_atomic_load(ptr) __atomic_load_n(ptr, __ATOMIC_RELAXED)
+#define seq_atomic_acquire(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define seq_atomic_cas(ptr, old, val) \
+	__atomic_compare_exchange_n(ptr, old, val, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#else
+#define seq_atomic_add(ptr, n) (*(ptr) += (n))
+#define seq_atomic_load(ptr) (*(ptr))
+#define seq_atomic_acquire(ptr) (*(ptr))
+#define seq_atomic_cas(ptr, old, val) \
+	(*(ptr) == *(old) ? (*(ptr) = (val), 1) : (*(old) = *(ptr), 0))
+#endif
+
+/* A hint to start loading memory that's about to be read; it never faults, even on NULL. */
+#if defined(__GNUC__)
+#define seq_prefetch(ptr) __builtin_prefetch(ptr)
+#else
+#define seq_prefetch(ptr) ((void)(ptr))
+#endif
+
+/* A SEQ_TRACE histogram exists for each SEQ_CALL constant paired with each possible value of the
+ * leading constant of the call; see seq-trace.c. */
+#define SEQ_TRACE_CALLS ((SEQ_CALL_MAX & 0xFFFF) + 1)
+#define SEQ_TRACE_OPS ( \
+	(SEQ_ADD_MAX & 0xFFFF) > (SEQ_GET_MAX & 0xFFFF) ? \
+	(SEQ_ADD_MAX & 0xFFFF) + 1 : \
+	(SEQ_GET_MAX & 0xFFFF) + 1 \
+)
+
+typedef struct _seq_trace_hist_t* seq_trace_hist_t;
+typedef struct _seq_trace_t* seq_trace_t;
+typedef struct _seq_block_t* seq_block_t;
+typedef struct _seq_intern_t* seq_intern_t;
+typedef struct _seq_bloom_t* seq_bloom_t;
+
+struct _seq_trace_t {
+	seq_trace_hist_t hist[SEQ_TRACE_CALLS][SEQ_TRACE_OPS];
+};
+
+/* Bumps one of the SEQ_STATS counters, if enabled; e.g., seq_stats_add(seq, hops, 1). */
+#define seq_stats_add(seq, field, n) \
+	((seq)->stats ? (void)(seq_atomic_add(&(seq)->stats->field, n)) : (void)(0))
+
+/* Raises the SEQ_STATS size_peak to the current size, if enabled; with SEQ_BLOCKING, this must
+ * happen while still holding the lock, which is what protects the size. */
+#define seq_stats_peak(seq) ((seq)->stats ? seq_atomic_max( \
+	&(seq)->stats->size_peak, \
+	(uint64_t)(seq_atomic_load(&(seq)->size)) \
+) : (void)(0))
+
+/* Lowers (or raises) the value at @ptr to @val atomically, unless it's already beyond it. */
+void seq_atomic_min(uint64_t* ptr, uint64_t val);
+void seq_atomic_max(uint64_t* ptr, uint64_t val);
+
 typedef void (*seq_impl_create_t)(seq_t seq);
 typedef void (*seq_impl_destroy_t)(seq_t seq);
+typedef seq_opt_t (*seq_impl_config_t)(seq_t seq, seq_opt_t opt, seq_args_t args);
 typedef seq_opt_t (*seq_impl_add_t)(seq_t seq, seq_args_t args);
 typedef seq_opt_t (*seq_impl_remove_t)(seq_t seq, seq_args_t args);
 typedef seq_data_t (*seq_impl_get_t)(seq_t seq, seq_args_t args);
 typedef seq_opt_t (*seq_impl_set_t)(seq_t seq, seq_args_t args);
 
-typedef void (*seq_impl_iter_create_t)(seq_iter_t iter, seq_args_t args);
+typedef seq_opt_t (*seq_impl_iter_create_t)(seq_iter_t iter, seq_args_t args);
 typedef void (*seq_impl_iter_destroy_t)(seq_iter_t iter);
 typedef seq_data_t (*seq_impl_iter_get_t)(seq_iter_t iter, seq_args_t args);
 typedef seq_opt_t (*seq_impl_iter_set_t)(seq_iter_t iter, seq_args_t args);
 typedef seq_opt_t (*seq_impl_iter_iterate_t)(seq_iter_t iter);
+typedef seq_opt_t (*seq_impl_iter_copy_t)(seq_iter_t iter, seq_iter_t src);
 
 typedef struct _seq_impl_t* seq_impl_t;
 
 struct _seq_impl_t {
 	seq_impl_create_t create;
 	seq_impl_destroy_t destroy;
+	seq_impl_config_t config;
 	seq_impl_add_t add;
 	seq_impl_remove_t remove;
 	seq_impl_get_t get;
 	seq_impl_set_t set;
 
-	/* struct {
+	struct {
 		seq_impl_iter_create_t create;
 		seq_impl_iter_destroy_t destroy;
 		seq_impl_iter_get_t get;
 		seq_impl_iter_set_t set;
 		seq_impl_iter_iterate_t iterate;
-	} iter; */
+		seq_impl_iter_copy_t copy;
+	} iter;
 };
 
 struct _seq_t {
@@ -52,7 +124,31 @@ struct _seq_t {
 		seq_cb_add_t add;
 		seq_cb_remove_t remove;
 		seq_cb_cmp_t cmp;
+		seq_cb_serialize_t serialize;
+		seq_cb_deserialize_t deserialize;
+		seq_cb_trace_t trace;
+		seq_cb_size_t size;
 	} cb;
+
+	struct {
+		int checksum;
+	} io;
+
+	seq_stats_t stats;
+	seq_trace_t trace;
+	seq_block_t block;
+	seq_intern_t intern;
+	seq_bloom_t bloom;
+
+	struct {
+		int enabled;
+		int fd;
+		int wfd;
+	} event;
+
+	struct {
+		int threads;
+	} parallel;
 };
 
 struct _seq_iter_t {
@@ -63,6 +159,80 @@ struct _seq_iter_t {
 };
 
 seq_impl_t seq_impl_list();
+seq_impl_t seq_impl_array();
+seq_impl_t seq_impl_heap();
+seq_impl_t seq_impl_deque();
+seq_impl_t seq_impl_vector();
+seq_impl_t seq_impl_btree();
+seq_impl_t seq_impl_art();
+seq_impl_t seq_impl_cache();
+
+/* Used by seq_filter() and seq_map() to assemble their results without going through seq_add(). */
+seq_opt_t seq_list_splice(seq_t seq, seq_t src);
+seq_data_t* seq_array_fill(seq_t seq, seq_size_t size);
+
+/* Implementations invoke the user callbacks through these, rather than directly, so that every
+ * invocation is accounted for. The seq_cb_add() function returns the seq_data_t value for the
+ * remaining seq_add() arguments: either the result of the seq_cb_add_t callback or, if none is
+ * set, the next argument itself. */
+seq_data_t seq_cb_add(seq_t seq, seq_args_t args);
+void seq_cb_remove(seq_t seq, seq_data_t data);
+
+/* The seq_cb_cmp_t callback is invoked far too often to be traced, so it is merely counted (as
+ * cb[SEQ_CB_CMP & 0xFFFF], whether it was configured with SEQ_CB_CMP or SEQ_SORTED). */
+#define seq_cb_cmp(seq, lhs, rhs) ( \
+	seq_stats_add(seq, cb[seq_opt_val(SEQ_CB_CMP)], 1), \
+	(seq)->cb.cmp(seq, lhs, rhs) \
+)
+
+/* Likewise for the seq_cb_size_t callback, counted as cb[SEQ_CB_SIZE & 0xFFFF]. */
+#define seq_cb_size(seq, data) ( \
+	seq_stats_add(seq, cb[seq_opt_val(SEQ_CB_SIZE)], 1), \
+	(seq)->cb.size(data) \
+)
+
+/* Tracing is split in two halves: seq_trace_begin() returns the current time if tracing is enabled
+ * at all (or 0 otherwise), and seq_trace_end() reports the time elapsed since then, for the given
+ * SEQ_CALL constant and leading constant, to the SEQ_CB_TRACE callback and SEQ_TRACE histograms. */
+#define seq_tracing(seq) ((seq)->cb.trace || (seq)->trace)
+#define seq_trace_begin(seq) (seq_tracing(seq) ? seq_trace_clock() : 0)
+
+uint64_t seq_trace_clock(void);
+void seq_trace_end(seq_t seq, seq_opt_t call, seq_opt_t op, uint64_t begin);
+seq_opt_t seq_trace_config(seq_t seq, int enabled);
+
+/* With SEQ_BLOCKING enabled, every call on a seq_t instance is serialized by a mutex; seq_add() and
+ * seq_get() go through seq_block_add() and seq_block_get() (which also wait for, and wake up,
+ * blocked consumers), while everything else simply takes the lock. See seq-block.c. */
+seq_opt_t seq_block_config(seq_t seq, int timeout, int spins);
+void seq_block_lock(seq_t seq);
+void seq_block_unlock(seq_t seq);
+seq_opt_t seq_block_add(seq_t seq, seq_args_t args);
+seq_data_t seq_block_get(seq_t seq, seq_args_t args);
+
+/* Once seq_fd() has been called, seq_fd_notify() must be invoked whenever a seq_add() call takes
+ * the seq_t instance from empty to non-empty (and only then). */
+void seq_fd_notify(seq_t seq);
+void seq_fd_close(seq_t seq);
+
+/* With SEQ_INTERN enabled, a map copies each key into an arena owned by the seq_t instance, once
+ * (equal keys share a single copy), and uses that copy from then on; since seq_intern_find() only
+ * returns such copies, interned keys are equal if and only if their pointers are. The length of
+ * an interned key is stored alongside it. See seq-intern.c. */
+seq_opt_t seq_intern_config(seq_t seq, int enabled);
+const char* seq_intern(seq_t seq, const char* key);
+const char* seq_intern_find(seq_t seq, const char* key);
+seq_size_t seq_intern_len(const char* key);
+
+/* With SEQ_BLOOM enabled, a map keyed by strings also keeps a blocked Bloom filter of its keys,
+ * which seq_bloom_find() consults (in a single cache line) before the map is searched: a key it
+ * returns 0 for was never added. Maps call seq_bloom_add() for every key they add, and
+ * seq_bloom_remove() after removing one, at which point the filter may be rebuilt by iterating the
+ * map; it must therefore be consistent by then. See seq-bloom.c. */
+seq_opt_t seq_bloom_config(seq_t seq, seq_size_t keys);
+void seq_bloom_add(seq_t seq, const char* key);
+int seq_bloom_find(seq_t seq, const char* key);
+void seq_bloom_remove(seq_t seq);
 
 #if 0
 #define seq_error(seq, err) seq->status = SEQ_ERR_##err
@@ -72,22 +242,24 @@ seq_impl_t seq_impl_list();
 #define seq_return_null(seq, err) seq_return(seq, err, NULL)
 #endif
 
-#if 0
 #define SEQ_TYPE_API(type) \
 	static void seq_##type##_create(seq_t seq); \
 	static void seq_##type##_destroy(seq_t seq); \
+	static seq_opt_t seq_##type##_config(seq_t seq, seq_opt_t opt, seq_args_t args); \
 	static seq_opt_t seq_##type##_add(seq_t seq, seq_args_t args); \
 	static seq_opt_t seq_##type##_remove(seq_t seq, seq_args_t args); \
 	static seq_data_t seq_##type##_get(seq_t seq, seq_args_t args); \
 	static seq_opt_t seq_##type##_set(seq_t seq, seq_args_t args); \
-	static void seq_##type##_iter_create(seq_iter_t iter, seq_args_t args); \
+	static seq_opt_t seq_##type##_iter_create(seq_iter_t iter, seq_args_t args); \
 	static void seq_##type##_iter_destroy(seq_iter_t iter); \
 	static seq_data_t seq_##type##_iter_get(seq_iter_t iter, seq_args_t args); \
 	static seq_opt_t seq_##type##_iter_set(seq_iter_t iter, seq_args_t args); \
 	static seq_opt_t seq_##type##_iter_iterate(seq_iter_t iter); \
+	static seq_opt_t seq_##type##_iter_copy(seq_iter_t iter, seq_iter_t src); \
 	static struct _seq_impl_t SEQ_IMPL_##type = { \
 		seq_##type##_create, \
 		seq_##type##_destroy, \
+		seq_##type##_config, \
 		seq_##type##_add, \
 		seq_##type##_remove, \
 		seq_##type##_get, \
@@ -97,31 +269,12 @@ seq_impl_t seq_impl_list();
 			seq_##type##_iter_destroy, \
 			seq_##type##_iter_get, \
 			seq_##type##_iter_set, \
-			seq_##type##_iter_iterate \
+			seq_##type##_iter_iterate, \
+			seq_##type##_iter_copy \
 		} \
 	}; \
 	seq_impl_t seq_impl_##type() { \
 		return &SEQ_IMPL_##type; \
 	}
-#endif
-
-#define SEQ_TYPE_API(type) \
-	static void seq_##type##_create(seq_t seq); \
-	static void seq_##type##_destroy(seq_t seq); \
-	static seq_opt_t seq_##type##_add(seq_t seq, seq_args_t args); \
-	static seq_opt_t seq_##type##_remove(seq_t seq, seq_args_t args); \
-	static seq_data_t seq_##type##_get(seq_t seq, seq_args_t args); \
-	static seq_opt_t seq_##type##_set(seq_t seq, seq_args_t args); \
-	static struct _seq_impl_t SEQ_IMPL_##type = { \
-		seq_##type##_create, \
-		seq_##type##_destroy, \
-		seq_##type##_add, \
-		seq_##type##_remove, \
-		seq_##type##_get, \
-		seq_##type##_set \
-	}; \
-	seq_impl_t seq_impl_##type() { \
-		return &SEQ_IMPL_##type; \
-	}
 
 #endif
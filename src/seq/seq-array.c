@@ -0,0 +1,708 @@
+#if !defined(_WIN32)
+#define _GNU_SOURCE
+#endif
+
+#include "seq-api.h"
+
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* ======================================================================== Types, Constants, Enums
+ * struct _seq_array_data_t
+ * struct _seq_array_header_t
+ * struct _seq_array_iter_data_t
+ * seq_array_data
+ * seq_array_iter_data
+ * SEQ_TYPE_API(array)
+ * --------------------------------------------------------------------------------------------- */
+
+typedef struct _seq_array_data_t* seq_array_data_t;
+typedef struct _seq_array_header_t* seq_array_header_t;
+typedef struct _seq_array_iter_data_t* seq_array_iter_data_t;
+
+/* By default, a SEQ_ARRAY is a contiguous, growable buffer of seq_data_t values. When configured
+ * with SEQ_STRIDE, it instead stores fixed-size elements BY VALUE, and seq_get() returns pointers
+ * directly into the buffer; seq_create_mapped() does the same inside a shared mapping of a file.
+ * A SEQ_SORTED array keeps its elements ordered by the seq_cb_cmp_t callback, and finds both the
+ * position of a new element and the element matching a given key with a binary search. */
+struct _seq_array_data_t {
+	char* buf;
+	seq_size_t stride;
+	seq_size_t capacity;
+	int values;
+	int sorted;
+
+	struct {
+		int fd;
+		int writable;
+		seq_array_header_t header;
+		seq_size_t length;
+	} map;
+};
+
+/* The on-disk layout of a mapped SEQ_ARRAY: a fixed, 64-byte header, immediately followed by the
+ * elements themselves. The size is updated in place on every modification, so the file is always
+ * usable as-is by the next process that maps it. */
+#define SEQ_ARRAY_MAGIC "SEQARRAY"
+#define SEQ_ARRAY_VERSION 1
+#define SEQ_ARRAY_HEADER 64
+
+struct _seq_array_header_t {
+	char magic[8];
+	uint32_t version;
+	uint32_t stride;
+	uint64_t size;
+};
+
+struct _seq_array_iter_data_t {
+	seq_size_t index;
+	seq_size_t inc;
+
+	struct {
+		seq_size_t begin;
+		seq_size_t end;
+	} range;
+};
+
+#define seq_array_data(seq) ((seq_array_data_t)(seq->data))
+#define seq_array_iter_data(iter) ((seq_array_iter_data_t)(iter->data))
+
+SEQ_TYPE_API(array)
+
+/* ========================================================================== Private Array Helpers
+ * seq_array_index
+ *    Convert user-specified index into an absolute index, or -1 on error.
+ *
+ * seq_array_elem
+ *    Returns the address of the element at the given (absolute) index.
+ *
+ * seq_array_elem_data
+ *    Returns the seq_data_t value of the element at the given (absolute) index; for arrays
+ *    storing values, this is the address of the element itself.
+ *
+ * seq_array_elem_store
+ *    Stores the given seq_data_t value (or the value it points to) at the given index.
+ *
+ * seq_array_elem_search
+ *    Returns the index of the first element of a SEQ_SORTED array that doesn't compare less than
+ *    the given data or, if upper is set, the first one that compares greater than it.
+ *
+ * seq_array_elem_find
+ *    Returns the index of the element bound to the given data, or -1.
+ *
+ * seq_array_elem_key
+ *    Returns the index of the first element of a SEQ_SORTED array that compares equal to the
+ *    given key, or -1.
+ *
+ * seq_array_reserve
+ *    Ensures room for at least the requested number of elements, growing the buffer (or the
+ *    backing file and its mapping) geometrically.
+ *
+ * seq_array_insert
+ *    Opens up a gap at the given index and stores the data there.
+ * ============================================================================================= */
+
+static seq_index_t seq_array_index(seq_t seq, seq_index_t index) {
+	index = index < 0 ? (seq_index_t)(seq->size) + index : index;
+
+	if(index >= (seq_index_t)(seq->size) || index < 0) return -1;
+
+	return index;
+}
+
+static char* seq_array_elem(seq_array_data_t data, seq_size_t index) {
+	return data->buf + (index * data->stride);
+}
+
+static seq_data_t seq_array_elem_data(seq_array_data_t data, seq_size_t index) {
+	if(data->values) return seq_array_elem(data, index);
+
+	return ((seq_data_t*)(data->buf))[index];
+}
+
+static void seq_array_elem_store(seq_array_data_t data, seq_size_t index, seq_data_t d) {
+	if(data->values) memmove(seq_array_elem(data, index), d, data->stride);
+
+	else ((seq_data_t*)(data->buf))[index] = d;
+}
+
+static seq_size_t seq_array_elem_search(seq_t seq, seq_data_t d, int upper) {
+	seq_array_data_t data = seq_array_data(seq);
+	seq_size_t lo = 0;
+	seq_size_t hi = seq->size;
+
+	while(lo < hi) {
+		seq_size_t mid = lo + ((hi - lo) / 2);
+		seq_opt_t cmp = seq_cb_cmp(seq, seq_array_elem_data(data, mid), d);
+
+		if(cmp == SEQ_LESS || (upper && cmp == SEQ_EQUAL)) lo = mid + 1;
+
+		else hi = mid;
+	}
+
+	return lo;
+}
+
+static seq_index_t seq_array_elem_find(seq_t seq, seq_data_t d) {
+	seq_array_data_t data = seq_array_data(seq);
+	seq_size_t i = 0;
+
+	/* Pointers handed out by a value-storing array can be converted back directly. */
+	if(data->values) {
+		char* p = (char*)(d);
+
+		if(
+			p >= data->buf &&
+			p < seq_array_elem(data, seq->size) &&
+			!((seq_size_t)(p - data->buf) % data->stride)
+		) return (seq_index_t)((seq_size_t)(p - data->buf) / data->stride);
+
+		return -1;
+	}
+
+	/* In a sorted array, the element can only be among those that compare equal to it. */
+	if(data->sorted) {
+		if(!d) return -1;
+
+		i = seq_array_elem_search(seq, d, 0);
+	}
+
+	for(; i < seq->size; i++) {
+		seq_data_t e = seq_array_elem_data(data, i);
+
+		if(e == d) return (seq_index_t)(i);
+
+		if(data->sorted && seq_cb_cmp(seq, e, d) != SEQ_EQUAL) break;
+	}
+
+	return -1;
+}
+
+static seq_index_t seq_array_elem_key(seq_t seq, seq_data_t key) {
+	seq_array_data_t data = seq_array_data(seq);
+	seq_size_t i;
+
+	if(!data->sorted) return -1;
+
+	i = seq_array_elem_search(seq, key, 0);
+
+	if(i < seq->size && seq_cb_cmp(seq, seq_array_elem_data(data, i), key) == SEQ_EQUAL) {
+		return (seq_index_t)(i);
+	}
+
+	return -1;
+}
+
+static seq_opt_t seq_array_reserve(seq_t seq, seq_size_t size) {
+	seq_array_data_t data = seq_array_data(seq);
+	seq_size_t capacity = data->capacity ? data->capacity : 16;
+	char* buf = NULL;
+
+	if(size <= data->capacity) return SEQ_ERR_NONE;
+
+	while(capacity < size) capacity *= 2;
+
+#if !defined(_WIN32)
+	if(data->map.header) {
+		seq_size_t length = SEQ_ARRAY_HEADER + (capacity * data->stride);
+		void* map = NULL;
+
+		if(ftruncate(data->map.fd, (off_t)(length))) return SEQ_ERR_MEM;
+
+		/* On failure, the existing mapping is always left intact. */
+#if defined(__linux__)
+		map = mremap(data->map.header, data->map.length, length, MREMAP_MAYMOVE);
+#else
+		map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, data->map.fd, 0);
+
+		if(map != MAP_FAILED) munmap(data->map.header, data->map.length);
+#endif
+
+		if(map == MAP_FAILED) return SEQ_ERR_MEM;
+
+		data->map.header = (seq_array_header_t)(map);
+		data->map.length = length;
+		data->buf = (char*)(map) + SEQ_ARRAY_HEADER;
+		data->capacity = capacity;
+
+		return SEQ_ERR_NONE;
+	}
+#endif
+
+	if(!(buf = (char*)(realloc(data->buf, capacity * data->stride)))) return SEQ_ERR_MEM;
+
+	data->buf = buf;
+	data->capacity = capacity;
+
+	return SEQ_ERR_NONE;
+}
+
+/* A value stored BY VALUE may be copied from an element of the array itself, which growing the
+ * buffer and opening up the gap can both move; its offset is kept so it can be found again. */
+static seq_opt_t seq_array_insert(seq_t seq, seq_size_t index, seq_data_t d) {
+	seq_array_data_t data = seq_array_data(seq);
+	seq_opt_t err = SEQ_ERR_NONE;
+	seq_size_t offset = 0;
+	int inside = 0;
+
+	if(
+		data->values &&
+		data->buf &&
+		(char*)(d) >= data->buf &&
+		(char*)(d) < seq_array_elem(data, seq->size)
+	) {
+		offset = (seq_size_t)((char*)(d) - data->buf);
+		inside = 1;
+	}
+
+	if((err = seq_array_reserve(seq, seq->size + 1))) return err;
+
+	if(index < seq->size) memmove(
+		seq_array_elem(data, index + 1),
+		seq_array_elem(data, index),
+		(seq->size - index) * data->stride
+	);
+
+	if(inside) d = data->buf + offset + (offset >= index * data->stride ? data->stride : 0);
+
+	seq_array_elem_store(data, index, d);
+
+	seq->size++;
+
+	if(data->map.header) data->map.header->size = seq->size;
+
+	return SEQ_ERR_NONE;
+}
+
+/* ======================================================================= SEQ_ARRAY Implementation
+ * seq_array_create
+ * seq_array_destroy
+ * seq_array_config
+ * seq_array_add
+ * seq_array_remove
+ * seq_array_get
+ * seq_array_set
+ * ============================================================================================= */
+
+static void seq_array_create(seq_t seq) {
+	seq_array_data_t data = seq_malloc(seq_array_data_t);
+
+	seq->type = SEQ_ARRAY;
+	seq->impl = seq_impl_array();
+	seq->data = data;
+
+	if(!data) return;
+
+	data->stride = sizeof(seq_data_t);
+	data->map.fd = -1;
+}
+
+static void seq_array_destroy(seq_t seq) {
+	seq_array_data_t data = seq_array_data(seq);
+	seq_size_t i;
+
+#if !defined(_WIN32)
+	/* The elements of a mapped array outlive the seq_t instance; they are left untouched, and the
+	 * file is only trimmed down to the space they actually use. */
+	if(data->map.fd >= 0) {
+		if(data->map.header) {
+			munmap(data->map.header, data->map.length);
+
+			/* Failing to trim the file is harmless, since the header records the real size. */
+			if(data->map.writable && ftruncate(
+				data->map.fd,
+				(off_t)(SEQ_ARRAY_HEADER + (seq->size * data->stride))
+			)) {}
+		}
+
+		close(data->map.fd);
+		free(data);
+
+		return;
+	}
+#endif
+
+	if(seq->cb.remove) {
+		for(i = 0; i < seq->size; i++) seq_cb_remove(seq, seq_array_elem_data(data, i));
+	}
+
+	free(data->buf);
+	free(data);
+}
+
+static seq_opt_t seq_array_config(seq_t seq, seq_opt_t opt, seq_args_t args) {
+	seq_array_data_t data = seq_array_data(seq);
+
+	/* Switching to elements stored by value is only possible while the array is still empty (and
+	 * not mapped, since the file itself already determines the stride). */
+	if(opt == SEQ_STRIDE) {
+		seq_size_t stride = seq_arg(args, seq_size_t);
+
+		if(!stride || seq->size || data->map.fd >= 0) return SEQ_ERR_OPT;
+
+		free(data->buf);
+
+		data->buf = NULL;
+		data->capacity = 0;
+		data->stride = stride;
+		data->values = 1;
+	}
+
+	/* The seq_cb_cmp_t callback itself is stored by seq_config(), once this succeeds. */
+	else if(opt == SEQ_SORTED) {
+		if(seq->size) return SEQ_ERR_OPT;
+
+		data->sorted = 1;
+	}
+
+	/* A different callback would invalidate the order of a sorted array's existing elements. */
+	else if(opt == SEQ_CB_CMP) {
+		if(seq->size && data->sorted) return SEQ_ERR_OPT;
+	}
+
+	else return SEQ_ERR_OPT;
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_opt_t seq_array_add(seq_t seq, seq_args_t args) {
+	seq_array_data_t data = seq_array_data(seq);
+	seq_opt_t add = seq_arg_opt(args);
+	seq_index_t index = (seq_index_t)(seq->size);
+	seq_data_t d = NULL;
+
+	if(data->map.fd >= 0 && !data->map.writable) return SEQ_ERR_OPT;
+
+	/* A sorted array decides on the position itself; SEQ_PREPEND places the new element before
+	 * any others that compare equal to it, and SEQ_APPEND after them. */
+	if(data->sorted) {
+		if(add != SEQ_APPEND && add != SEQ_PREPEND) return SEQ_ERR_OPT;
+
+		if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+		index = (seq_index_t)(seq_array_elem_search(seq, d, add != SEQ_PREPEND));
+
+		return seq_array_insert(seq, (seq_size_t)(index), d);
+	}
+
+	if(add == SEQ_BEFORE || add == SEQ_AFTER || add == SEQ_REPLACE) {
+		if(seq_arg_opt(args) != SEQ_INDEX) return SEQ_ERR_OPT;
+
+		if((index = seq_array_index(seq, seq_arg_index(args))) < 0) return SEQ_ERR_NODE;
+
+		if(add == SEQ_AFTER) index++;
+	}
+
+	else if(add == SEQ_PREPEND) index = 0;
+
+	else if(add != SEQ_APPEND && add != SEQ_PUSH) return SEQ_ERR_OPT;
+
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+	if(add == SEQ_REPLACE) {
+		seq_cb_remove(seq, seq_array_elem_data(data, (seq_size_t)(index)));
+
+		seq_array_elem_store(data, (seq_size_t)(index), d);
+
+		return SEQ_ERR_NONE;
+	}
+
+	return seq_array_insert(seq, (seq_size_t)(index), d);
+}
+
+static seq_index_t seq_array_get_index(seq_t seq, seq_args_t args) {
+	seq_opt_t opt = seq_arg_opt(args);
+
+	if(opt == SEQ_INDEX) return seq_array_index(seq, seq_arg_index(args));
+
+	else if(opt == SEQ_DATA) return seq_array_elem_find(seq, seq_arg_data(args));
+
+	else if(opt == SEQ_KEY) return seq_array_elem_key(seq, seq_arg_data(args));
+
+	return -1;
+}
+
+static seq_opt_t seq_array_remove(seq_t seq, seq_args_t args) {
+	seq_array_data_t data = seq_array_data(seq);
+	seq_index_t index = -1;
+
+	if(data->map.fd >= 0 && !data->map.writable) return SEQ_ERR_OPT;
+
+	if((index = seq_array_get_index(seq, args)) < 0) return SEQ_ERR_NODE;
+
+	seq_cb_remove(seq, seq_array_elem_data(data, (seq_size_t)(index)));
+
+	memmove(
+		seq_array_elem(data, (seq_size_t)(index)),
+		seq_array_elem(data, (seq_size_t)(index) + 1),
+		(seq->size - (seq_size_t)(index) - 1) * data->stride
+	);
+
+	seq->size--;
+
+	if(data->map.header) data->map.header->size = seq->size;
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_data_t seq_array_get(seq_t seq, seq_args_t args) {
+	seq_index_t index = seq_array_get_index(seq, args);
+
+	if(index < 0) return NULL;
+
+	return seq_array_elem_data(seq_array_data(seq), (seq_size_t)(index));
+}
+
+static seq_opt_t seq_array_set(seq_t seq, seq_args_t args) {
+	seq_array_data_t data = seq_array_data(seq);
+	seq_index_t index = -1;
+	seq_data_t d = NULL;
+
+	/* Replacing an element in place could break the order of a sorted array. */
+	if((data->map.fd >= 0 && !data->map.writable) || data->sorted) return SEQ_ERR_OPT;
+
+	if((index = seq_array_get_index(seq, args)) < 0) return SEQ_ERR_NODE;
+
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+	seq_cb_remove(seq, seq_array_elem_data(data, (seq_size_t)(index)));
+
+	seq_array_elem_store(data, (seq_size_t)(index), d);
+
+	return SEQ_ERR_NONE;
+}
+
+/* ============================================================= SEQ_ARRAY Iteration Implementation
+ * seq_array_iter_create
+ * seq_array_iter_destroy
+ * seq_array_iter_get
+ * seq_array_iter_set
+ * seq_array_iter_iterate
+ * seq_array_iter_copy
+ * ============================================================================================= */
+
+static seq_opt_t seq_array_iter_create(seq_iter_t iter, seq_args_t args) {
+	seq_array_iter_data_t data = seq_malloc(seq_array_iter_data_t);
+	seq_index_t begin = 0;
+	seq_index_t end = -1;
+	seq_opt_t opt;
+
+	if(!(iter->data = data)) return SEQ_ERR_MEM;
+
+	data->inc = 1;
+
+	while((opt = seq_arg_opt(args))) {
+		if(opt == SEQ_RANGE) {
+			begin = seq_arg_index(args);
+			end = seq_arg_index(args);
+		}
+
+		else if(opt == SEQ_INC) data->inc = seq_arg(args, seq_size_t);
+
+		else return SEQ_ERR_OPT;
+	}
+
+	if(!data->inc) return SEQ_ERR_OPT;
+
+	begin = seq_array_index(iter->seq, begin);
+	end = seq_array_index(iter->seq, end);
+
+	if(begin < 0 || end < begin) iter->state = SEQ_STOP;
+
+	else {
+		data->range.begin = (seq_size_t)(begin);
+		data->range.end = (seq_size_t)(end);
+	}
+
+	return SEQ_ERR_NONE;
+}
+
+static void seq_array_iter_destroy(seq_iter_t iter) {
+}
+
+static seq_data_t seq_array_iter_get(seq_iter_t iter, seq_args_t args) {
+	seq_array_iter_data_t data = seq_array_iter_data(iter);
+
+	if(seq_arg_opt(args) == SEQ_DATA) return seq_array_elem_data(
+		seq_array_data(iter->seq),
+		data->index
+	);
+
+	return NULL;
+}
+
+static seq_opt_t seq_array_iter_set(seq_iter_t iter, seq_args_t args) {
+	seq_array_iter_data_t data = seq_array_iter_data(iter);
+	seq_array_data_t adata = seq_array_data(iter->seq);
+	seq_t seq = iter->seq;
+	seq_data_t d = NULL;
+
+	if(seq_arg_opt(args) != SEQ_DATA) return SEQ_ERR_OPT;
+
+	if((adata->map.fd >= 0 && !adata->map.writable) || adata->sorted) return SEQ_ERR_OPT;
+
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+	seq_cb_remove(seq, seq_array_elem_data(adata, data->index));
+
+	seq_array_elem_store(adata, data->index, d);
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_opt_t seq_array_iter_iterate(seq_iter_t iter) {
+	seq_array_iter_data_t data = seq_array_iter_data(iter);
+
+	if(iter->state == SEQ_READY) data->index = data->range.begin;
+
+	else data->index += data->inc;
+
+	if(data->index > data->range.end || data->index >= iter->seq->size) return SEQ_STOP;
+
+	return SEQ_ACTIVE;
+}
+
+static seq_opt_t seq_array_iter_copy(seq_iter_t iter, seq_iter_t src) {
+	seq_array_iter_data_t data = seq_malloc(seq_array_iter_data_t);
+
+	if(!(iter->data = data)) return SEQ_ERR_MEM;
+
+	*data = *seq_array_iter_data(src);
+
+	return SEQ_ERR_NONE;
+}
+
+/* ================================================================================ Mapped Arrays
+ * seq_create_mapped
+ * seq_sync
+ * ============================================================================================= */
+
+#if !defined(_WIN32)
+seq_t seq_create_mapped(const char* path, seq_size_t size, int flags) {
+	seq_t seq = NULL;
+	seq_array_data_t data = NULL;
+	struct stat st;
+	int fd = -1;
+	int prot = PROT_READ;
+	void* map = NULL;
+
+	if((fd = open(path, flags, 0644)) < 0) return NULL;
+
+	if(fstat(fd, &st)) goto err;
+
+	if((flags & O_ACCMODE) != O_RDONLY) prot |= PROT_WRITE;
+
+	/* A new (or truncated) file only needs its header written out. */
+	if(!st.st_size) {
+		struct _seq_array_header_t header;
+
+		if(!size || !(prot & PROT_WRITE)) goto err;
+
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, SEQ_ARRAY_MAGIC, sizeof(header.magic));
+
+		header.version = SEQ_ARRAY_VERSION;
+		header.stride = (uint32_t)(size);
+
+		if(ftruncate(fd, SEQ_ARRAY_HEADER)) goto err;
+
+		if(pwrite(fd, &header, sizeof(header), 0) != (ssize_t)(sizeof(header))) goto err;
+
+		st.st_size = SEQ_ARRAY_HEADER;
+	}
+
+	if(st.st_size < SEQ_ARRAY_HEADER) goto err;
+
+	map = mmap(NULL, (size_t)(st.st_size), prot, MAP_SHARED, fd, 0);
+
+	if(map == MAP_FAILED) goto err;
+
+	{
+		seq_array_header_t header = (seq_array_header_t)(map);
+
+		if(
+			memcmp(header->magic, SEQ_ARRAY_MAGIC, sizeof(header->magic)) ||
+			header->version != SEQ_ARRAY_VERSION ||
+			!header->stride ||
+			(size && header->stride != size) ||
+			header->size > ((uint64_t)(st.st_size) - SEQ_ARRAY_HEADER) / header->stride
+		) {
+			munmap(map, (size_t)(st.st_size));
+
+			goto err;
+		}
+
+		if(!(seq = seq_create(SEQ_ARRAY))) {
+			munmap(map, (size_t)(st.st_size));
+
+			goto err;
+		}
+
+		data = seq_array_data(seq);
+
+		data->stride = header->stride;
+		data->values = 1;
+		data->capacity = ((seq_size_t)(st.st_size) - SEQ_ARRAY_HEADER) / data->stride;
+		data->buf = (char*)(map) + SEQ_ARRAY_HEADER;
+		data->map.fd = fd;
+		data->map.writable = (prot & PROT_WRITE) != 0;
+		data->map.header = header;
+		data->map.length = (seq_size_t)(st.st_size);
+
+		seq->size = (seq_size_t)(header->size);
+	}
+
+	return seq;
+
+err:
+	close(fd);
+
+	return NULL;
+}
+
+seq_opt_t seq_sync(seq_t seq) {
+	seq_array_data_t data = NULL;
+
+	if(seq->type != SEQ_ARRAY) return SEQ_ERR_OPT;
+
+	data = seq_array_data(seq);
+
+	if(!data->map.header || !data->map.writable) return SEQ_ERR_OPT;
+
+	data->map.header->size = seq->size;
+
+	if(msync(data->map.header, data->map.length, MS_SYNC)) return SEQ_ERR_IO;
+
+	return SEQ_ERR_NONE;
+}
+#else
+seq_t seq_create_mapped(const char* path, seq_size_t size, int flags) {
+	return NULL;
+}
+
+seq_opt_t seq_sync(seq_t seq) {
+	return SEQ_ERR_OPT;
+}
+#endif
+
+/* =================================================================================== Internal API
+ * seq_array_fill
+ * ============================================================================================= */
+
+/* Resizes an array of seq_data_t values (i.e., one storing neither values nor a mapping) to the
+ * given number of elements, returning its buffer for the caller to fill in; or NULL on failure. */
+seq_data_t* seq_array_fill(seq_t seq, seq_size_t size) {
+	seq_array_data_t data = seq_array_data(seq);
+
+	if(data->values || data->map.header || seq_array_reserve(seq, size)) return NULL;
+
+	seq->size = size;
+
+	return (seq_data_t*)(data->buf);
+}
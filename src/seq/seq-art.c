@@ -0,0 +1,1109 @@
+#include "seq-api.h"
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+#define SEQ_ART_SSE2 1
+#endif
+
+/* ======================================================================== Types, Constants, Enums
+ * struct _seq_art_node_t
+ * struct _seq_art_leaf_t
+ * struct _seq_art_inner_t
+ * struct _seq_art_node4_t
+ * struct _seq_art_node16_t
+ * struct _seq_art_node48_t
+ * struct _seq_art_node256_t
+ * struct _seq_art_data_t
+ * struct _seq_art_iter_data_t
+ * seq_art_data
+ * seq_art_iter_data
+ * SEQ_TYPE_API(art)
+ * --------------------------------------------------------------------------------------------- */
+
+typedef struct _seq_art_node_t* seq_art_node_t;
+typedef struct _seq_art_leaf_t* seq_art_leaf_t;
+typedef struct _seq_art_inner_t* seq_art_inner_t;
+typedef struct _seq_art_node4_t* seq_art_node4_t;
+typedef struct _seq_art_node16_t* seq_art_node16_t;
+typedef struct _seq_art_node48_t* seq_art_node48_t;
+typedef struct _seq_art_node256_t* seq_art_node256_t;
+typedef struct _seq_art_data_t* seq_art_data_t;
+typedef struct _seq_art_iter_data_t* seq_art_iter_data_t;
+
+/* A SEQ_ART is an adaptive radix tree: every inner node branches on a single byte of the key, and
+ * comes in one of four sizes depending on how many children it has. Up to 4 (or 16) children are
+ * found through a sorted array of bytes, which a Node16 compares all at once using SSE2 where it's
+ * available; up to 48 through a 256-byte index into the array of children; and beyond that, the
+ * byte is the index. A chain of nodes with a single child is compressed into the @prefix of the
+ * node below it, so a lookup visits at most one node per byte of the key and never depends on
+ * the number of keys in the map. Only the first SEQ_ART_PREFIX bytes of a longer prefix are kept;
+ * the rest is skipped while descending, and checked against the key in the leaf at the end.
+ *
+ * The keys are NUL-terminated strings, and their terminating NUL is part of the key; since no key
+ * can then be a proper prefix of another, keys are only ever found in the leaves. */
+#define SEQ_ART_LEAF 0
+#define SEQ_ART_NODE4 1
+#define SEQ_ART_NODE16 2
+#define SEQ_ART_NODE48 3
+#define SEQ_ART_NODE256 4
+
+#define SEQ_ART_PREFIX 10
+
+struct _seq_art_node_t {
+	unsigned char kind;
+};
+
+struct _seq_art_leaf_t {
+	struct _seq_art_node_t node;
+	seq_size_t len;
+	seq_data_t key;
+	seq_data_t val;
+};
+
+/* The @len of the prefix is its full length, even when it's longer than SEQ_ART_PREFIX. */
+struct _seq_art_inner_t {
+	struct _seq_art_node_t node;
+	unsigned short count;
+	seq_size_t len;
+	unsigned char prefix[SEQ_ART_PREFIX];
+};
+
+struct _seq_art_node4_t {
+	struct _seq_art_inner_t inner;
+	unsigned char keys[4];
+	seq_art_node_t child[4];
+};
+
+struct _seq_art_node16_t {
+	struct _seq_art_inner_t inner;
+	unsigned char keys[16];
+	seq_art_node_t child[16];
+};
+
+/* The @index holds the position of the child for each byte, plus one, or 0 if there's none. */
+struct _seq_art_node48_t {
+	struct _seq_art_inner_t inner;
+	unsigned char index[256];
+	seq_art_node_t child[48];
+};
+
+struct _seq_art_node256_t {
+	struct _seq_art_inner_t inner;
+	seq_art_node_t child[256];
+};
+
+/* The @longest key ever added (including its NUL) bounds the depth of the tree, and therefore the
+ * size of the stack an iterator needs. */
+struct _seq_art_data_t {
+	seq_art_node_t root;
+	seq_size_t longest;
+};
+
+/* The iterator walks the subtree at @start depth-first, keeping the inner nodes above the current
+ * @leaf on a stack, along with the position of the next child to visit in each. */
+struct _seq_art_iter_data_t {
+	seq_art_node_t start;
+	seq_art_leaf_t leaf;
+	seq_size_t depth;
+
+	struct {
+		seq_art_node_t node;
+		unsigned int pos;
+	}* stack;
+};
+
+#define seq_art_data(seq) ((seq_art_data_t)(seq->data))
+#define seq_art_iter_data(iter) ((seq_art_iter_data_t)(iter->data))
+
+#define seq_art_leaf(node) ((seq_art_leaf_t)(node))
+#define seq_art_inner(node) ((seq_art_inner_t)(node))
+#define seq_art_node4(node) ((seq_art_node4_t)(node))
+#define seq_art_node16(node) ((seq_art_node16_t)(node))
+#define seq_art_node48(node) ((seq_art_node48_t)(node))
+#define seq_art_node256(node) ((seq_art_node256_t)(node))
+
+#define seq_art_min(a, b) ((a) < (b) ? (a) : (b))
+
+SEQ_TYPE_API(art)
+
+/* ============================================================================ Private ART Helpers
+ * seq_art_byte
+ *    Returns the byte of a key at the given depth, or 0 past its end.
+ *
+ * seq_art_match
+ *    Returns whether a leaf holds the given key.
+ *
+ * seq_art_key
+ *    Returns the copy of a key to look up in the map, and its length, or NULL if it can't be there.
+ *
+ * seq_art_ctz
+ *    Returns the position of the lowest bit set in a (non-zero) mask.
+ *
+ * seq_art_find
+ *    Returns a pointer to the slot holding the child for the given byte, or NULL.
+ *
+ * seq_art_next
+ *    Returns the next child of a node in order, starting from (and updating) a position.
+ *
+ * seq_art_first
+ *    Returns the leftmost leaf below a node.
+ *
+ * seq_art_node_create
+ *    Allocates an empty node of the given kind.
+ *
+ * seq_art_leaf_create
+ *    Allocates a leaf for the given key and value.
+ *
+ * seq_art_node_free
+ *    Frees a single node, or leaf.
+ *
+ * seq_art_node_destroy
+ *    Frees a node, along with every node and leaf below it.
+ *
+ * seq_art_check
+ *    Returns how many of the stored prefix bytes of a node match the key at the given depth.
+ *
+ * seq_art_mismatch
+ *    Returns the position of the first byte of the full prefix of a node that differs from the key.
+ *
+ * seq_art_search
+ *    Returns the leaf holding the given key, or NULL.
+ *
+ * seq_art_grow
+ *    Replaces a node with an empty copy of the next larger kind.
+ *
+ * seq_art_shrink
+ *    Replaces a node with a copy of the next smaller kind, if memory allows.
+ *
+ * seq_art_add_child
+ *    Adds a child for the given byte, growing the node if it's full.
+ *
+ * seq_art_remove_child
+ *    Removes the child for the given byte, shrinking (or collapsing) the node if it becomes sparse.
+ *
+ * seq_art_insert
+ *    Inserts a key, or replaces the value of an equal one.
+ *
+ * seq_art_delete
+ *    Removes a key, returning its leaf (which is left for the caller to free).
+ * ============================================================================================= */
+
+static unsigned char seq_art_byte(const unsigned char* key, seq_size_t len, seq_size_t depth) {
+	return depth < len ? key[depth] : 0;
+}
+
+/* Interned keys are equal only if they're the same one. */
+static int seq_art_match(
+	seq_t seq,
+	seq_art_leaf_t leaf,
+	const unsigned char* key,
+	seq_size_t len
+) {
+	if(seq->intern) return leaf->key == key;
+
+	return leaf->len == len && !memcmp(leaf->key, key, len);
+}
+
+/* The length includes the terminating NUL; a key that was never interned (or that the Bloom filter
+ * doesn't know) was never added either. */
+static const unsigned char* seq_art_key(seq_t seq, seq_data_t key, seq_size_t* len) {
+	if(seq->bloom && !seq_bloom_find(seq, (const char*)(key))) return NULL;
+
+	if(!seq->intern) *len = strlen((const char*)(key)) + 1;
+
+	else if((key = (seq_data_t)(seq_intern_find(seq, (const char*)(key))))) {
+		*len = seq_intern_len((const char*)(key)) + 1;
+	}
+
+	return (const unsigned char*)(key);
+}
+
+#if defined(SEQ_ART_SSE2) && defined(__GNUC__)
+#define seq_art_ctz(mask) ((unsigned int)(__builtin_ctz(mask)))
+#elif defined(SEQ_ART_SSE2)
+static unsigned int seq_art_ctz(int mask) {
+	unsigned int i = 0;
+
+	while(!(mask & 1)) {
+		mask >>= 1;
+
+		i++;
+	}
+
+	return i;
+}
+#endif
+
+/* A Node16 compares the byte against all of its keys at once, where SSE2 is available; bytes past
+ * the count are masked out of the result. */
+static seq_art_node_t* seq_art_find(seq_art_node_t node, unsigned char byte) {
+	seq_art_inner_t inner = seq_art_inner(node);
+	unsigned int i;
+
+	if(node->kind == SEQ_ART_NODE4) {
+		seq_art_node4_t n4 = seq_art_node4(node);
+
+		for(i = 0; i < inner->count; i++) {
+			if(n4->keys[i] == byte) return &n4->child[i];
+		}
+	}
+
+	else if(node->kind == SEQ_ART_NODE16) {
+		seq_art_node16_t n16 = seq_art_node16(node);
+
+#if defined(SEQ_ART_SSE2)
+		__m128i cmp = _mm_cmpeq_epi8(
+			_mm_set1_epi8((char)(byte)),
+			_mm_loadu_si128((const __m128i*)(n16->keys))
+		);
+
+		int mask = _mm_movemask_epi8(cmp) & ((1 << inner->count) - 1);
+
+		if(mask) return &n16->child[seq_art_ctz(mask)];
+#else
+		for(i = 0; i < inner->count; i++) {
+			if(n16->keys[i] == byte) return &n16->child[i];
+		}
+#endif
+	}
+
+	else if(node->kind == SEQ_ART_NODE48) {
+		seq_art_node48_t n48 = seq_art_node48(node);
+
+		if(n48->index[byte]) return &n48->child[n48->index[byte] - 1];
+	}
+
+	else if(seq_art_node256(node)->child[byte]) return &seq_art_node256(node)->child[byte];
+
+	return NULL;
+}
+
+/* For a Node4 or Node16, @pos is a position in the (sorted) arrays; otherwise, it's a byte. */
+static seq_art_node_t seq_art_next(seq_art_node_t node, unsigned int* pos) {
+	seq_art_inner_t inner = seq_art_inner(node);
+
+	if(node->kind == SEQ_ART_NODE4) {
+		if(*pos < inner->count) return seq_art_node4(node)->child[(*pos)++];
+	}
+
+	else if(node->kind == SEQ_ART_NODE16) {
+		if(*pos < inner->count) return seq_art_node16(node)->child[(*pos)++];
+	}
+
+	else if(node->kind == SEQ_ART_NODE48) {
+		seq_art_node48_t n48 = seq_art_node48(node);
+
+		for(; *pos < 256; (*pos)++) {
+			if(n48->index[*pos]) return n48->child[n48->index[(*pos)++] - 1];
+		}
+	}
+
+	else {
+		seq_art_node256_t n256 = seq_art_node256(node);
+
+		for(; *pos < 256; (*pos)++) {
+			if(n256->child[*pos]) return n256->child[(*pos)++];
+		}
+	}
+
+	return NULL;
+}
+
+static seq_art_leaf_t seq_art_first(seq_art_node_t node) {
+	unsigned int pos;
+
+	while(node->kind != SEQ_ART_LEAF) {
+		pos = 0;
+		node = seq_art_next(node, &pos);
+	}
+
+	return seq_art_leaf(node);
+}
+
+static seq_art_node_t seq_art_node_create(seq_t seq, unsigned char kind) {
+	seq_art_node_t node = NULL;
+
+	if(kind == SEQ_ART_NODE4) node = (seq_art_node_t)(seq_malloc(seq_art_node4_t));
+
+	else if(kind == SEQ_ART_NODE16) node = (seq_art_node_t)(seq_malloc(seq_art_node16_t));
+
+	else if(kind == SEQ_ART_NODE48) node = (seq_art_node_t)(seq_malloc(seq_art_node48_t));
+
+	else node = (seq_art_node_t)(seq_malloc(seq_art_node256_t));
+
+	if(!node) return NULL;
+
+	node->kind = kind;
+
+	seq_stats_add(seq, nodes_alloc, 1);
+
+	return node;
+}
+
+static seq_art_leaf_t seq_art_leaf_create(
+	seq_t seq,
+	seq_data_t key,
+	seq_size_t len,
+	seq_data_t val
+) {
+	seq_art_leaf_t leaf = seq_malloc(seq_art_leaf_t);
+
+	if(!leaf) return NULL;
+
+	leaf->node.kind = SEQ_ART_LEAF;
+	leaf->len = len;
+	leaf->key = key;
+	leaf->val = val;
+
+	seq_stats_add(seq, nodes_alloc, 1);
+
+	return leaf;
+}
+
+static void seq_art_node_free(seq_t seq, seq_art_node_t node) {
+	free(node);
+
+	seq_stats_add(seq, nodes_free, 1);
+}
+
+static void seq_art_node_destroy(seq_t seq, seq_art_node_t node) {
+	seq_art_node_t child = NULL;
+	unsigned int pos = 0;
+
+	if(node->kind == SEQ_ART_LEAF) seq_cb_remove(seq, seq_art_leaf(node)->val);
+
+	else while((child = seq_art_next(node, &pos))) seq_art_node_destroy(seq, child);
+
+	seq_art_node_free(seq, node);
+}
+
+static seq_size_t seq_art_check(
+	seq_art_inner_t inner,
+	const unsigned char* key,
+	seq_size_t len,
+	seq_size_t depth
+) {
+	seq_size_t max = seq_art_min(inner->len, SEQ_ART_PREFIX);
+	seq_size_t i;
+
+	for(i = 0; i < max; i++) {
+		if(inner->prefix[i] != seq_art_byte(key, len, depth + i)) return i;
+	}
+
+	return i;
+}
+
+/* Beyond the bytes stored in the node, the prefix is read from any of the keys below it. */
+static seq_size_t seq_art_mismatch(
+	seq_art_inner_t inner,
+	const unsigned char* key,
+	seq_size_t len,
+	seq_size_t depth
+) {
+	seq_size_t i = seq_art_check(inner, key, len, depth);
+	seq_art_leaf_t leaf = NULL;
+
+	if(i < SEQ_ART_PREFIX || i == inner->len) return i;
+
+	leaf = seq_art_first(&inner->node);
+
+	for(; i < inner->len; i++) {
+		if(((unsigned char*)(leaf->key))[depth + i] != seq_art_byte(key, len, depth + i)) break;
+	}
+
+	return i;
+}
+
+static seq_art_leaf_t seq_art_search(seq_t seq, const unsigned char* key, seq_size_t len) {
+	seq_art_node_t node = seq_art_data(seq)->root;
+	seq_art_node_t* child = NULL;
+	seq_size_t depth = 0;
+	seq_size_t hops = 0;
+
+	while(node && node->kind != SEQ_ART_LEAF) {
+		seq_art_inner_t inner = seq_art_inner(node);
+
+		if(seq_art_check(inner, key, len, depth) != seq_art_min(inner->len, SEQ_ART_PREFIX)) break;
+
+		depth += inner->len;
+
+		child = seq_art_find(node, seq_art_byte(key, len, depth));
+		node = child ? *child : NULL;
+
+		depth++;
+		hops++;
+	}
+
+	seq_stats_add(seq, hops, hops);
+
+	if(node && node->kind == SEQ_ART_LEAF && seq_art_match(seq, seq_art_leaf(node), key, len)) {
+		return seq_art_leaf(node);
+	}
+
+	return NULL;
+}
+
+/* Returns NULL if memory allocation fails, leaving the original node untouched. */
+static seq_art_node_t seq_art_grow(seq_t seq, seq_art_node_t node) {
+	seq_art_node_t grown = seq_art_node_create(seq, node->kind + 1);
+	seq_art_inner_t inner = seq_art_inner(node);
+	unsigned int i;
+
+	if(!grown) return NULL;
+
+	seq_art_inner(grown)->count = inner->count;
+	seq_art_inner(grown)->len = inner->len;
+
+	memcpy(seq_art_inner(grown)->prefix, inner->prefix, SEQ_ART_PREFIX);
+
+	if(node->kind == SEQ_ART_NODE4) {
+		memcpy(seq_art_node16(grown)->keys, seq_art_node4(node)->keys, 4);
+
+		memcpy(
+			seq_art_node16(grown)->child,
+			seq_art_node4(node)->child,
+			4 * sizeof(seq_art_node_t)
+		);
+	}
+
+	else if(node->kind == SEQ_ART_NODE16) {
+		for(i = 0; i < 16; i++) {
+			seq_art_node48(grown)->index[seq_art_node16(node)->keys[i]] = (unsigned char)(i + 1);
+			seq_art_node48(grown)->child[i] = seq_art_node16(node)->child[i];
+		}
+	}
+
+	else {
+		for(i = 0; i < 256; i++) {
+			if(seq_art_node48(node)->index[i]) {
+				seq_art_node256(grown)->child[i] =
+					seq_art_node48(node)->child[seq_art_node48(node)->index[i] - 1];
+			}
+		}
+	}
+
+	return grown;
+}
+
+/* Shrinking is merely an optimization, so the larger node is kept if memory allocation fails. */
+static seq_art_node_t seq_art_shrink(seq_t seq, seq_art_node_t node) {
+	seq_art_node_t shrunk = seq_art_node_create(seq, node->kind - 1);
+	seq_art_inner_t inner = seq_art_inner(node);
+	seq_art_node_t child = NULL;
+	unsigned int pos = 0;
+	unsigned int i = 0;
+
+	if(!shrunk) return node;
+
+	seq_art_inner(shrunk)->count = inner->count;
+	seq_art_inner(shrunk)->len = inner->len;
+
+	memcpy(seq_art_inner(shrunk)->prefix, inner->prefix, SEQ_ART_PREFIX);
+
+	if(node->kind == SEQ_ART_NODE16) {
+		memcpy(seq_art_node4(shrunk)->keys, seq_art_node16(node)->keys, inner->count);
+
+		memcpy(
+			seq_art_node4(shrunk)->child,
+			seq_art_node16(node)->child,
+			inner->count * sizeof(seq_art_node_t)
+		);
+	}
+
+	else if(node->kind == SEQ_ART_NODE48) {
+		while((child = seq_art_next(node, &pos))) {
+			seq_art_node16(shrunk)->keys[i] = (unsigned char)(pos - 1);
+			seq_art_node16(shrunk)->child[i++] = child;
+		}
+	}
+
+	else {
+		while((child = seq_art_next(node, &pos))) {
+			seq_art_node48(shrunk)->index[pos - 1] = (unsigned char)(i + 1);
+			seq_art_node48(shrunk)->child[i++] = child;
+		}
+	}
+
+	seq_art_node_free(seq, node);
+
+	return shrunk;
+}
+
+/* The byte must not have a child yet. The node (which @ref points to) is replaced if it grows. */
+static seq_opt_t seq_art_add_child(
+	seq_t seq,
+	seq_art_node_t* ref,
+	unsigned char byte,
+	seq_art_node_t child
+) {
+	seq_art_node_t node = *ref;
+	seq_art_inner_t inner = seq_art_inner(node);
+	unsigned char* keys = NULL;
+	seq_art_node_t* children = NULL;
+	unsigned int full = 4;
+	unsigned int i;
+
+	if(node->kind == SEQ_ART_NODE4) {
+		keys = seq_art_node4(node)->keys;
+		children = seq_art_node4(node)->child;
+	}
+
+	else if(node->kind == SEQ_ART_NODE16) {
+		keys = seq_art_node16(node)->keys;
+		children = seq_art_node16(node)->child;
+		full = 16;
+	}
+
+	else if(node->kind == SEQ_ART_NODE48) full = 48;
+
+	else full = 256;
+
+	if(inner->count == full) {
+		if(!(node = seq_art_grow(seq, *ref))) return SEQ_ERR_MEM;
+
+		seq_art_node_free(seq, *ref);
+
+		*ref = node;
+
+		return seq_art_add_child(seq, ref, byte, child);
+	}
+
+	if(keys) {
+		for(i = 0; i < inner->count && keys[i] < byte; i++);
+
+		memmove(&keys[i + 1], &keys[i], inner->count - i);
+		memmove(&children[i + 1], &children[i], (inner->count - i) * sizeof(seq_art_node_t));
+
+		keys[i] = byte;
+		children[i] = child;
+	}
+
+	else if(node->kind == SEQ_ART_NODE48) {
+		seq_art_node48_t n48 = seq_art_node48(node);
+
+		for(i = 0; n48->child[i]; i++);
+
+		n48->index[byte] = (unsigned char)(i + 1);
+		n48->child[i] = child;
+	}
+
+	else seq_art_node256(node)->child[byte] = child;
+
+	inner->count++;
+
+	return SEQ_ERR_NONE;
+}
+
+/* A Node4 left with a single child is replaced by it, its prefix (and the byte leading to the
+ * child) being prepended to that of the child. */
+static void seq_art_remove_child(seq_t seq, seq_art_node_t* ref, unsigned char byte) {
+	seq_art_node_t node = *ref;
+	seq_art_inner_t inner = seq_art_inner(node);
+	seq_art_node_t* slot = seq_art_find(node, byte);
+	unsigned char* keys = NULL;
+	seq_art_node_t* children = NULL;
+	unsigned int i;
+
+	if(node->kind == SEQ_ART_NODE4 || node->kind == SEQ_ART_NODE16) {
+		keys = node->kind == SEQ_ART_NODE4 ? seq_art_node4(node)->keys : seq_art_node16(node)->keys;
+		children = node->kind == SEQ_ART_NODE4 ?
+			seq_art_node4(node)->child :
+			seq_art_node16(node)->child
+		;
+
+		i = (unsigned int)(slot - children);
+
+		memmove(&keys[i], &keys[i + 1], inner->count - i - 1);
+		memmove(&children[i], &children[i + 1], (inner->count - i - 1) * sizeof(seq_art_node_t));
+	}
+
+	else if(node->kind == SEQ_ART_NODE48) {
+		*slot = NULL;
+
+		seq_art_node48(node)->index[byte] = 0;
+	}
+
+	else *slot = NULL;
+
+	inner->count--;
+
+	if(node->kind == SEQ_ART_NODE4 && inner->count == 1) {
+		seq_art_node_t child = children[0];
+
+		if(child->kind != SEQ_ART_LEAF) {
+			seq_art_inner_t sub = seq_art_inner(child);
+			unsigned char prefix[SEQ_ART_PREFIX];
+			seq_size_t len = seq_art_min(inner->len, SEQ_ART_PREFIX);
+
+			memcpy(prefix, inner->prefix, len);
+
+			if(len < SEQ_ART_PREFIX) prefix[len++] = keys[0];
+
+			if(len < SEQ_ART_PREFIX) {
+				i = (unsigned int)(seq_art_min(sub->len, SEQ_ART_PREFIX - len));
+
+				memcpy(&prefix[len], sub->prefix, i);
+
+				len += i;
+			}
+
+			memcpy(sub->prefix, prefix, seq_art_min(len, SEQ_ART_PREFIX));
+
+			sub->len += inner->len + 1;
+		}
+
+		*ref = child;
+
+		seq_art_node_free(seq, node);
+	}
+
+	else if(
+		(node->kind == SEQ_ART_NODE16 && inner->count == 3) ||
+		(node->kind == SEQ_ART_NODE48 && inner->count == 12) ||
+		(node->kind == SEQ_ART_NODE256 && inner->count == 37)
+	) *ref = seq_art_shrink(seq, node);
+}
+
+/* Returns SEQ_EQUAL if the key was already there, in which case the value it replaced is handed
+ * back through @val (and the key given originally is kept). New nodes are always allocated before
+ * anything is modified, so running out of memory leaves the tree as it was. */
+static seq_opt_t seq_art_insert(
+	seq_t seq,
+	seq_art_node_t* ref,
+	seq_size_t depth,
+	seq_data_t key,
+	seq_size_t len,
+	seq_data_t* val
+) {
+	const unsigned char* k = (const unsigned char*)(key);
+	seq_art_node_t node = *ref;
+	seq_art_node_t split = NULL;
+	seq_art_leaf_t leaf = NULL;
+	seq_art_inner_t inner = NULL;
+	seq_art_node_t* child = NULL;
+	seq_data_t old = NULL;
+	seq_size_t diff;
+
+	if(!node) {
+		if(!(leaf = seq_art_leaf_create(seq, key, len, *val))) return SEQ_ERR_MEM;
+
+		*ref = &leaf->node;
+
+		return SEQ_ERR_NONE;
+	}
+
+	if(node->kind == SEQ_ART_LEAF) {
+		const unsigned char* other = (const unsigned char*)(seq_art_leaf(node)->key);
+		seq_size_t olen = seq_art_leaf(node)->len;
+
+		if(seq_art_match(seq, seq_art_leaf(node), k, len)) {
+			old = seq_art_leaf(node)->val;
+
+			seq_art_leaf(node)->val = *val;
+
+			*val = old;
+
+			return SEQ_EQUAL;
+		}
+
+		if(!(split = seq_art_node_create(seq, SEQ_ART_NODE4))) return SEQ_ERR_MEM;
+
+		if(!(leaf = seq_art_leaf_create(seq, key, len, *val))) {
+			seq_art_node_free(seq, split);
+
+			return SEQ_ERR_MEM;
+		}
+
+		for(diff = 0; seq_art_byte(other, olen, depth + diff) == k[depth + diff]; diff++);
+
+		seq_art_inner(split)->len = diff;
+
+		memcpy(seq_art_inner(split)->prefix, &k[depth], seq_art_min(diff, SEQ_ART_PREFIX));
+
+		seq_art_add_child(seq, &split, seq_art_byte(other, olen, depth + diff), node);
+		seq_art_add_child(seq, &split, k[depth + diff], &leaf->node);
+
+		*ref = split;
+
+		return SEQ_ERR_NONE;
+	}
+
+	inner = seq_art_inner(node);
+
+	if(inner->len) {
+		if((diff = seq_art_mismatch(inner, k, len, depth)) < inner->len) {
+			if(!(split = seq_art_node_create(seq, SEQ_ART_NODE4))) return SEQ_ERR_MEM;
+
+			if(!(leaf = seq_art_leaf_create(seq, key, len, *val))) {
+				seq_art_node_free(seq, split);
+
+				return SEQ_ERR_MEM;
+			}
+
+			seq_art_inner(split)->len = diff;
+
+			memcpy(seq_art_inner(split)->prefix, inner->prefix, seq_art_min(diff, SEQ_ART_PREFIX));
+
+			if(inner->len <= SEQ_ART_PREFIX) {
+				seq_art_add_child(seq, &split, inner->prefix[diff], node);
+
+				inner->len -= diff + 1;
+
+				memmove(inner->prefix, &inner->prefix[diff + 1], inner->len);
+			}
+
+			else {
+				const unsigned char* first = (const unsigned char*)(seq_art_first(node)->key);
+
+				seq_art_add_child(seq, &split, first[depth + diff], node);
+
+				inner->len -= diff + 1;
+
+				memcpy(
+					inner->prefix,
+					&first[depth + diff + 1],
+					seq_art_min(inner->len, SEQ_ART_PREFIX)
+				);
+			}
+
+			seq_art_add_child(seq, &split, seq_art_byte(k, len, depth + diff), &leaf->node);
+
+			*ref = split;
+
+			return SEQ_ERR_NONE;
+		}
+
+		depth += inner->len;
+	}
+
+	seq_stats_add(seq, hops, 1);
+
+	if((child = seq_art_find(node, seq_art_byte(k, len, depth)))) {
+		return seq_art_insert(seq, child, depth + 1, key, len, val);
+	}
+
+	if(!(leaf = seq_art_leaf_create(seq, key, len, *val))) return SEQ_ERR_MEM;
+
+	if(seq_art_add_child(seq, ref, seq_art_byte(k, len, depth), &leaf->node)) {
+		seq_art_node_free(seq, &leaf->node);
+
+		return SEQ_ERR_MEM;
+	}
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_art_leaf_t seq_art_delete(
+	seq_t seq,
+	seq_art_node_t* ref,
+	seq_size_t depth,
+	const unsigned char* key,
+	seq_size_t len
+) {
+	seq_art_node_t node = *ref;
+	seq_art_inner_t inner = NULL;
+	seq_art_node_t* child = NULL;
+	seq_art_leaf_t leaf = NULL;
+	unsigned char byte;
+
+	if(!node) return NULL;
+
+	if(node->kind == SEQ_ART_LEAF) {
+		if(!seq_art_match(seq, seq_art_leaf(node), key, len)) return NULL;
+
+		*ref = NULL;
+
+		return seq_art_leaf(node);
+	}
+
+	inner = seq_art_inner(node);
+
+	if(seq_art_check(inner, key, len, depth) != seq_art_min(inner->len, SEQ_ART_PREFIX)) {
+		return NULL;
+	}
+
+	depth += inner->len;
+	byte = seq_art_byte(key, len, depth);
+
+	seq_stats_add(seq, hops, 1);
+
+	if(!(child = seq_art_find(node, byte))) return NULL;
+
+	if((*child)->kind != SEQ_ART_LEAF) return seq_art_delete(seq, child, depth + 1, key, len);
+
+	if(!seq_art_match(seq, leaf = seq_art_leaf(*child), key, len)) return NULL;
+
+	seq_art_remove_child(seq, ref, byte);
+
+	return leaf;
+}
+
+/* ========================================================================= SEQ_ART Implementation
+ * seq_art_create
+ * seq_art_destroy
+ * seq_art_config
+ * seq_art_add
+ * seq_art_remove
+ * seq_art_get
+ * seq_art_set
+ * ============================================================================================= */
+
+static void seq_art_create(seq_t seq) {
+	seq->type = SEQ_ART;
+	seq->impl = seq_impl_art();
+	seq->data = seq_malloc(seq_art_data_t);
+}
+
+static void seq_art_destroy(seq_t seq) {
+	seq_art_data_t data = seq_art_data(seq);
+
+	if(data->root) seq_art_node_destroy(seq, data->root);
+
+	free(data);
+}
+
+/* Keys are always ordered bytewise, so no comparison callback is accepted; whether they're
+ * interned can only change while there aren't any. */
+static seq_opt_t seq_art_config(seq_t seq, seq_opt_t opt, seq_args_t args) {
+	if(opt == SEQ_INTERN && !seq->size) return seq_intern_config(seq, seq_arg(args, int));
+
+	if(opt == SEQ_BLOOM) return seq_bloom_config(seq, seq_arg(args, seq_size_t));
+
+	return SEQ_ERR_OPT;
+}
+
+/* Replacing the value of an existing key invokes the seq_cb_remove_t callback on the old one. */
+static seq_opt_t seq_art_add(seq_t seq, seq_args_t args) {
+	seq_art_data_t data = seq_art_data(seq);
+	seq_data_t key = NULL;
+	seq_data_t d = NULL;
+	seq_size_t len;
+	seq_opt_t err;
+
+	if(seq_arg_opt(args) != SEQ_KEYVAL) return SEQ_ERR_OPT;
+
+	if(!(key = seq_arg_data(args))) return SEQ_ERR_DATA;
+
+	if(seq->intern && !(key = (seq_data_t)(seq_intern(seq, (const char*)(key))))) {
+		return SEQ_ERR_MEM;
+	}
+
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+	len = (seq->intern ? seq_intern_len((const char*)(key)) : strlen((const char*)(key))) + 1;
+
+	if((err = seq_art_insert(seq, &data->root, 0, key, len, &d)) == SEQ_EQUAL) {
+		seq_cb_remove(seq, d);
+
+		return SEQ_ERR_NONE;
+	}
+
+	if(err) return err;
+
+	if(len > data->longest) data->longest = len;
+
+	seq->size++;
+
+	if(seq->bloom) seq_bloom_add(seq, (const char*)(key));
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_opt_t seq_art_remove(seq_t seq, seq_args_t args) {
+	seq_art_leaf_t leaf = NULL;
+	seq_data_t key = NULL;
+	const unsigned char* k = NULL;
+	seq_size_t len;
+
+	if(seq_arg_opt(args) != SEQ_KEY) return SEQ_ERR_OPT;
+
+	if(!(key = seq_arg_data(args))) return SEQ_ERR_DATA;
+
+	if(!(k = seq_art_key(seq, key, &len))) return SEQ_ERR_NODE;
+
+	if(!(leaf = seq_art_delete(seq, &seq_art_data(seq)->root, 0, k, len))) return SEQ_ERR_NODE;
+
+	seq_cb_remove(seq, leaf->val);
+	seq_art_node_free(seq, &leaf->node);
+
+	seq->size--;
+
+	if(seq->bloom) seq_bloom_remove(seq);
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_data_t seq_art_get(seq_t seq, seq_args_t args) {
+	seq_art_leaf_t leaf = NULL;
+	seq_data_t key = NULL;
+	const unsigned char* k = NULL;
+	seq_size_t len;
+
+	if(seq_arg_opt(args) != SEQ_KEY || !(key = seq_arg_data(args))) return NULL;
+
+	if(!(k = seq_art_key(seq, key, &len))) return NULL;
+
+	leaf = seq_art_search(seq, k, len);
+
+	return leaf ? leaf->val : NULL;
+}
+
+static seq_opt_t seq_art_set(seq_t seq, seq_args_t args) {
+	seq_art_leaf_t leaf = NULL;
+	seq_data_t key = NULL;
+	const unsigned char* k = NULL;
+	seq_data_t d = NULL;
+	seq_size_t len;
+
+	if(seq_arg_opt(args) != SEQ_KEY) return SEQ_ERR_OPT;
+
+	if(!(key = seq_arg_data(args))) return SEQ_ERR_DATA;
+
+	if(!(k = seq_art_key(seq, key, &len)) || !(leaf = seq_art_search(seq, k, len))) {
+		return SEQ_ERR_NODE;
+	}
+
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+	seq_cb_remove(seq, leaf->val);
+
+	leaf->val = d;
+
+	return SEQ_ERR_NONE;
+}
+
+/* =============================================================== SEQ_ART Iteration Implementation
+ * seq_art_iter_create
+ * seq_art_iter_destroy
+ * seq_art_iter_get
+ * seq_art_iter_set
+ * seq_art_iter_iterate
+ * seq_art_iter_copy
+ * ============================================================================================= */
+
+/* With SEQ_KEY_PREFIX, the prefix is followed down the tree for as long as it lasts; every key
+ * below the node reached then shares the same leading bytes, so checking any one of them tells
+ * whether they all start with the prefix (or none does). */
+static seq_opt_t seq_art_iter_create(seq_iter_t iter, seq_args_t args) {
+	seq_art_iter_data_t data = seq_malloc(seq_art_iter_data_t);
+	seq_art_data_t map = seq_art_data(iter->seq);
+	seq_art_node_t node = map->root;
+	seq_art_node_t* child = NULL;
+	const unsigned char* prefix = NULL;
+	seq_size_t depth = 0;
+	seq_size_t len = 0;
+	seq_art_leaf_t leaf = NULL;
+	seq_opt_t opt;
+
+	if(!(iter->data = data)) return SEQ_ERR_MEM;
+
+	while((opt = seq_arg_opt(args))) {
+		if(opt == SEQ_KEY_PREFIX) {
+			if(!(prefix = (const unsigned char*)(seq_arg_data(args)))) return SEQ_ERR_DATA;
+
+			len = strlen((const char*)(prefix));
+		}
+
+		else return SEQ_ERR_OPT;
+	}
+
+	if(!(data->stack = malloc((map->longest + 1) * sizeof(*data->stack)))) return SEQ_ERR_MEM;
+
+	while(prefix && node && node->kind != SEQ_ART_LEAF) {
+		if(depth + seq_art_inner(node)->len >= len) break;
+
+		depth += seq_art_inner(node)->len;
+
+		child = seq_art_find(node, prefix[depth]);
+		node = child ? *child : NULL;
+
+		depth++;
+	}
+
+	if(prefix && node) {
+		leaf = seq_art_first(node);
+
+		if(leaf->len <= len || memcmp(leaf->key, prefix, len)) node = NULL;
+	}
+
+	data->start = node;
+
+	return SEQ_ERR_NONE;
+}
+
+static void seq_art_iter_destroy(seq_iter_t iter) {
+	free(seq_art_iter_data(iter)->stack);
+}
+
+static seq_data_t seq_art_iter_get(seq_iter_t iter, seq_args_t args) {
+	seq_art_iter_data_t data = seq_art_iter_data(iter);
+	seq_opt_t opt = seq_arg_opt(args);
+
+	if(opt == SEQ_DATA) return data->leaf->val;
+
+	else if(opt == SEQ_KEY) return data->leaf->key;
+
+	return NULL;
+}
+
+static seq_opt_t seq_art_iter_set(seq_iter_t iter, seq_args_t args) {
+	seq_art_iter_data_t data = seq_art_iter_data(iter);
+	seq_data_t d = NULL;
+
+	if(seq_arg_opt(args) != SEQ_DATA) return SEQ_ERR_OPT;
+
+	if(!(d = seq_cb_add(iter->seq, args))) return SEQ_ERR_DATA;
+
+	seq_cb_remove(iter->seq, data->leaf->val);
+
+	data->leaf->val = d;
+
+	return SEQ_ERR_NONE;
+}
+
+/* Backs up to the closest node with a child left to visit, then descends to its leftmost leaf. */
+static seq_opt_t seq_art_iter_iterate(seq_iter_t iter) {
+	seq_art_iter_data_t data = seq_art_iter_data(iter);
+	seq_art_node_t node = NULL;
+
+	if(iter->state == SEQ_READY) node = data->start;
+
+	else while(data->depth) {
+		seq_size_t top = data->depth - 1;
+
+		if((node = seq_art_next(data->stack[top].node, &data->stack[top].pos))) break;
+
+		data->depth--;
+	}
+
+	if(!node) return SEQ_STOP;
+
+	while(node->kind != SEQ_ART_LEAF) {
+		data->stack[data->depth].node = node;
+		data->stack[data->depth].pos = 0;
+
+		node = seq_art_next(node, &data->stack[data->depth++].pos);
+	}
+
+	data->leaf = seq_art_leaf(node);
+
+	return SEQ_ACTIVE;
+}
+
+static seq_opt_t seq_art_iter_copy(seq_iter_t iter, seq_iter_t src) {
+	seq_art_iter_data_t data = seq_malloc(seq_art_iter_data_t);
+	seq_size_t size = (seq_art_data(src->seq)->longest + 1) * sizeof(*data->stack);
+
+	if(!(iter->data = data)) return SEQ_ERR_MEM;
+
+	*data = *seq_art_iter_data(src);
+
+	if(!(data->stack = malloc(size))) return SEQ_ERR_MEM;
+
+	memcpy(data->stack, seq_art_iter_data(src)->stack, size);
+
+	return SEQ_ERR_NONE;
+}
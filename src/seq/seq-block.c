@@ -0,0 +1,366 @@
+#if !defined(_WIN32)
+#define _GNU_SOURCE
+#endif
+
+#include "seq-api.h"
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+/* ======================================================================== Types, Constants, Enums
+ * struct _seq_block_t
+ * seq_block_atomic_add
+ * seq_block_atomic_load
+ * seq_block_relax
+ * --------------------------------------------------------------------------------------------- */
+
+/* Every successful seq_add() bumps the event counter, which is what blocked consumers actually wait
+ * on: a consumer reads it BEFORE looking for an element, so an element added at any point after
+ * that either shows up in its search or changes the counter it's about to wait on. Producers only
+ * make the (comparatively expensive) wake-up call when the number of waiters says it's needed.
+ * On Linux, consumers wait on the counter itself using a futex; elsewhere, a condition variable
+ * (protected by the same mutex that serializes every call) is used instead. */
+struct _seq_block_t {
+	pthread_mutex_t lock;
+	int timeout;
+	int spins;
+	uint32_t events;
+	uint32_t waiters;
+
+#if !defined(__linux__)
+	pthread_cond_t cond;
+#endif
+};
+
+/* Unlike the SEQ_STATS counters, these need full ordering between producers and consumers. */
+#if defined(__ATOMIC_SEQ_CST)
+#define seq_block_atomic_add(ptr, n) __atomic_fetch_add(ptr, n, __ATOMIC_SEQ_CST)
+#define seq_block_atomic_load(ptr) __atomic_load_n(ptr, __ATOMIC_SEQ_CST)
+#else
+#define seq_block_atomic_add(ptr, n) __sync_fetch_and_add(ptr, n)
+#define seq_block_atomic_load(ptr) __sync_fetch_and_add(ptr, 0)
+#endif
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define seq_block_relax() __builtin_ia32_pause()
+#else
+#define seq_block_relax()
+#endif
+
+/* ========================================================================= Private Block Helpers
+ * seq_block_waitable
+ *    Returns whether the given leading constant of seq_get() may block.
+ *
+ * seq_block_wait
+ *    Waits until the event counter no longer has the given value, or the absolute deadline (in
+ *    seq_trace_clock() nanoseconds, or 0 for none) passes; it may also return spuriously.
+ *
+ * seq_block_wake
+ *    Bumps the event counter, waking a single waiter (if any).
+ * ============================================================================================= */
+
+static int seq_block_waitable(seq_opt_t opt) {
+	return opt == SEQ_RECV || opt == SEQ_POP;
+}
+
+static void seq_block_wait(seq_block_t block, uint32_t events, uint64_t deadline) {
+	uint64_t now = 0;
+	int spins = block->spins;
+
+	/* A short burst of spinning catches elements that are added right away, without a syscall. */
+	while(spins-- > 0) {
+		if(seq_block_atomic_load(&block->events) != events) return;
+
+		seq_block_relax();
+	}
+
+	if(deadline && (now = seq_trace_clock()) >= deadline) return;
+
+	seq_block_atomic_add(&block->waiters, 1);
+
+#if defined(__linux__)
+	{
+		struct timespec ts;
+
+		ts.tv_sec = (time_t)((deadline - now) / 1000000000);
+		ts.tv_nsec = (long)((deadline - now) % 1000000000);
+
+		syscall(
+			SYS_futex,
+			&block->events,
+			FUTEX_WAIT_PRIVATE,
+			events,
+			deadline ? &ts : NULL,
+			NULL,
+			0
+		);
+	}
+#else
+	pthread_mutex_lock(&block->lock);
+
+	while(seq_block_atomic_load(&block->events) == events) {
+		struct timespec ts;
+		uint64_t ns;
+
+		if(!deadline) {
+			pthread_cond_wait(&block->cond, &block->lock);
+
+			continue;
+		}
+
+		if((now = seq_trace_clock()) >= deadline) break;
+
+		/* The condition variable measures its timeout against the realtime clock. */
+		clock_gettime(CLOCK_REALTIME, &ts);
+
+		ns = (uint64_t)(ts.tv_nsec) + (deadline - now);
+
+		ts.tv_sec += (time_t)(ns / 1000000000);
+		ts.tv_nsec = (long)(ns % 1000000000);
+
+		if(pthread_cond_timedwait(&block->cond, &block->lock, &ts) == ETIMEDOUT) break;
+	}
+
+	pthread_mutex_unlock(&block->lock);
+#endif
+
+	seq_block_atomic_add(&block->waiters, (uint32_t)(-1));
+}
+
+static void seq_block_wake(seq_block_t block) {
+	seq_block_atomic_add(&block->events, 1);
+
+	if(!seq_block_atomic_load(&block->waiters)) return;
+
+#if defined(__linux__)
+	syscall(SYS_futex, &block->events, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+	pthread_mutex_lock(&block->lock);
+	pthread_cond_signal(&block->cond);
+	pthread_mutex_unlock(&block->lock);
+#endif
+}
+
+/* ======================================================================================= Blocking
+ * seq_block_config
+ * seq_block_lock
+ * seq_block_unlock
+ * seq_block_add
+ * seq_block_get
+ * ============================================================================================= */
+
+seq_opt_t seq_block_config(seq_t seq, int timeout, int spins) {
+	seq_block_t block = seq->block;
+
+	if(!timeout) {
+		if(block) {
+			pthread_mutex_destroy(&block->lock);
+
+#if !defined(__linux__)
+			pthread_cond_destroy(&block->cond);
+#endif
+
+			free(block);
+		}
+
+		seq->block = NULL;
+
+		return SEQ_ERR_NONE;
+	}
+
+	if(!block) {
+		if(!(block = seq_malloc(seq_block_t))) return SEQ_ERR_MEM;
+
+		if(pthread_mutex_init(&block->lock, NULL)) {
+			free(block);
+
+			return SEQ_ERR_MEM;
+		}
+
+#if !defined(__linux__)
+		if(pthread_cond_init(&block->cond, NULL)) {
+			pthread_mutex_destroy(&block->lock);
+			free(block);
+
+			return SEQ_ERR_MEM;
+		}
+#endif
+
+		seq->block = block;
+	}
+
+	block->timeout = timeout;
+	block->spins = spins;
+
+	return SEQ_ERR_NONE;
+}
+
+void seq_block_lock(seq_t seq) {
+	pthread_mutex_lock(&seq->block->lock);
+}
+
+void seq_block_unlock(seq_t seq) {
+	pthread_mutex_unlock(&seq->block->lock);
+}
+
+seq_opt_t seq_block_add(seq_t seq, seq_args_t args) {
+	seq_size_t size;
+	seq_opt_t r;
+
+	pthread_mutex_lock(&seq->block->lock);
+
+	size = seq->size;
+	r = seq->impl->add(seq, args);
+
+	seq_stats_peak(seq);
+
+	pthread_mutex_unlock(&seq->block->lock);
+
+	if(!r) {
+		seq_block_wake(seq->block);
+
+		if(!size && seq->event.enabled) seq_fd_notify(seq);
+	}
+
+	return r;
+}
+
+seq_data_t seq_block_get(seq_t seq, seq_args_t args) {
+	seq_block_t block = seq->block;
+	seq_data_t r = NULL;
+	uint64_t deadline = 0;
+	int waitable = -1;
+
+	/* Every attempt needs the arguments from the start, so they're only ever used via copies. */
+	for(;;) {
+		uint32_t events = seq_block_atomic_load(&block->events);
+		va_list copy;
+
+		seq_args_copy(copy, *args);
+
+		if(waitable < 0) {
+			va_list opt;
+
+			seq_args_copy(opt, *args);
+
+			waitable = seq_block_waitable(seq_arg_opt(&opt));
+
+			va_end(opt);
+		}
+
+		pthread_mutex_lock(&block->lock);
+
+		r = seq->impl->get(seq, &copy);
+
+		pthread_mutex_unlock(&block->lock);
+
+		va_end(copy);
+
+		if(r || !waitable) break;
+
+		/* Once the deadline has passed, the attempt that was just made was the last one. */
+		if(block->timeout > 0) {
+			uint64_t now = seq_trace_clock();
+
+			if(!deadline) deadline = now + ((uint64_t)(block->timeout) * 1000000);
+
+			else if(now >= deadline) break;
+		}
+
+		seq_block_wait(block, events, deadline);
+	}
+
+	return r;
+}
+
+/* =================================================================================== Notification
+ * seq_fd
+ * seq_fd_notify
+ * seq_fd_close
+ * ============================================================================================= */
+
+/* On Linux, this is an eventfd; elsewhere, it's the reading end of a non-blocking pipe. */
+int seq_fd(seq_t seq) {
+	int fds[2];
+
+	if(seq->event.enabled) return seq->event.fd;
+
+#if defined(__linux__)
+	if((fds[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) return -1;
+
+	fds[1] = fds[0];
+#else
+	if(pipe(fds)) return -1;
+
+	fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+	fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+
+	seq->event.fd = fds[0];
+	seq->event.wfd = fds[1];
+	seq->event.enabled = 1;
+
+	/* Elements added before the descriptor existed still need to be reported. */
+	if(seq->size) seq_fd_notify(seq);
+
+	return seq->event.fd;
+}
+
+/* A full pipe (or an eventfd counter about to overflow) is already readable, so a failed write is
+ * simply ignored. */
+void seq_fd_notify(seq_t seq) {
+	uint64_t one = 1;
+
+	if(write(seq->event.wfd, &one, sizeof(one)) < 0) {}
+}
+
+void seq_fd_close(seq_t seq) {
+	if(!seq->event.enabled) return;
+
+	if(seq->event.wfd != seq->event.fd) close(seq->event.wfd);
+
+	close(seq->event.fd);
+
+	seq->event.enabled = 0;
+}
+#else
+seq_opt_t seq_block_config(seq_t seq, int timeout, int spins) {
+	return timeout ? SEQ_ERR_OPT : SEQ_ERR_NONE;
+}
+
+void seq_block_lock(seq_t seq) {
+}
+
+void seq_block_unlock(seq_t seq) {
+}
+
+seq_opt_t seq_block_add(seq_t seq, seq_args_t args) {
+	return seq->impl->add(seq, args);
+}
+
+seq_data_t seq_block_get(seq_t seq, seq_args_t args) {
+	return seq->impl->get(seq, args);
+}
+
+int seq_fd(seq_t seq) {
+	return -1;
+}
+
+void seq_fd_notify(seq_t seq) {
+}
+
+void seq_fd_close(seq_t seq) {
+}
+#endif
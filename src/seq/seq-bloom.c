@@ -0,0 +1,199 @@
+#include "seq-api.h"
+
+/* ======================================================================== Types, Constants, Enums
+ * struct _seq_bloom_t
+ * SEQ_BLOOM_WORDS
+ * SEQ_BLOOM_BITS
+ * SEQ_BLOOM_PROBES
+ * SEQ_BLOOM_ALIGN
+ * --------------------------------------------------------------------------------------------- */
+
+/* The filter is an array of @count blocks of SEQ_BLOOM_WORDS words each, aligned so that every
+ * block is a single cache line: a key only ever sets (and tests) bits of the one block its hash
+ * picks. It was built for @capacity keys (but at least the @expected ones configured), and @keys
+ * have been added to it since, @stale of which were removed from the map again; a Bloom filter
+ * can't forget a key, so it's rebuilt from the map once those become too many. */
+struct _seq_bloom_t {
+	void* mem;
+	uint32_t* blocks;
+	seq_size_t count;
+	seq_size_t expected;
+	seq_size_t capacity;
+	seq_size_t keys;
+	seq_size_t stale;
+};
+
+/* With 10 bits per key, 7 probes within a 512-bit block yield about 1% false positives. */
+#define SEQ_BLOOM_WORDS 16
+#define SEQ_BLOOM_BITS 10
+#define SEQ_BLOOM_PROBES 7
+#define SEQ_BLOOM_ALIGN 64
+
+/* ========================================================================== Private Bloom Helpers
+ * seq_bloom_mix
+ *    Scrambles the bits of a 32-bit hash (using the MurmurHash3 finalizer).
+ *
+ * seq_bloom_hash
+ *    Returns the hash of a key.
+ *
+ * seq_bloom_block
+ *    Returns the block of a filter that the given hash picks.
+ *
+ * seq_bloom_set
+ *    Sets the bits of the given hash in a filter.
+ *
+ * seq_bloom_build
+ *    Replaces the filter with a new one, sized for the given number of keys, holding every key of
+ *    the map.
+ * ============================================================================================= */
+
+static uint32_t seq_bloom_mix(uint32_t h) {
+	h ^= h >> 16;
+	h = (uint32_t)(h * 0x85EBCA6BUL);
+	h ^= h >> 13;
+	h = (uint32_t)(h * 0xC2B2AE35UL);
+	h ^= h >> 16;
+
+	return h;
+}
+
+static uint32_t seq_bloom_hash(const char* key) {
+	const unsigned char* c = (const unsigned char*)(key);
+	uint32_t hash = 2166136261UL;
+
+	for(; *c; c++) hash = (uint32_t)((hash ^ *c) * 16777619UL);
+
+	return seq_bloom_mix(hash);
+}
+
+/* The block is picked by the high bits of the hash (scaled to the number of blocks, so that
+ * needn't be a power of 2), and the probes walk the block using the low bits. */
+#define seq_bloom_block(blocks, count, hash) \
+	(&(blocks)[(seq_size_t)(((uint64_t)(hash) * (count)) >> 32) * SEQ_BLOOM_WORDS])
+
+static void seq_bloom_set(uint32_t* blocks, seq_size_t count, uint32_t hash) {
+	uint32_t* block = seq_bloom_block(blocks, count, hash);
+	uint32_t probe = seq_bloom_mix(hash);
+	uint32_t step = (probe >> 9) | 1;
+	int i;
+
+	for(i = 0; i < SEQ_BLOOM_PROBES; i++, probe += step) {
+		block[(probe & 511) >> 5] |= (uint32_t)(1) << (probe & 31);
+	}
+}
+
+/* The map is walked with an ordinary iterator. If that (or allocating the new filter) fails, the
+ * current one is kept: it still holds every key, just less accurately. */
+static seq_opt_t seq_bloom_build(seq_t seq, seq_size_t keys) {
+	seq_bloom_t bloom = seq->bloom;
+	seq_iter_t iter = NULL;
+	seq_size_t count;
+	char* mem = NULL;
+	uint32_t* blocks = NULL;
+	uint32_t hash;
+
+	if(keys < bloom->expected) keys = bloom->expected;
+
+	count = ((keys * SEQ_BLOOM_BITS) + (SEQ_BLOOM_WORDS * 32) - 1) / (SEQ_BLOOM_WORDS * 32);
+
+	if(!(mem = (char*)(calloc(count * SEQ_BLOOM_WORDS * sizeof(uint32_t) + SEQ_BLOOM_ALIGN, 1)))) {
+		return SEQ_ERR_MEM;
+	}
+
+	blocks = (uint32_t*)(mem + SEQ_BLOOM_ALIGN - ((seq_size_t)(mem) % SEQ_BLOOM_ALIGN));
+
+	if(seq->size) {
+		if(!(iter = seq_iter_create(seq, SEQ_ERR_NONE))) {
+			free(mem);
+
+			return SEQ_ERR_MEM;
+		}
+
+		while(seq_iterate(iter)) {
+			hash = seq_bloom_hash((const char*)(seq_iter_get(iter, SEQ_KEY)));
+
+			seq_bloom_set(blocks, count, hash);
+		}
+
+		seq_iter_destroy(iter);
+	}
+
+	free(bloom->mem);
+
+	bloom->mem = mem;
+	bloom->blocks = blocks;
+	bloom->count = count;
+	bloom->capacity = keys;
+	bloom->keys = seq->size;
+	bloom->stale = 0;
+
+	return SEQ_ERR_NONE;
+}
+
+/* ================================================================================ Internal Bloom
+ * seq_bloom_config
+ * seq_bloom_add
+ * seq_bloom_find
+ * seq_bloom_remove
+ * ============================================================================================= */
+
+/* Resizing an existing filter may fail harmlessly, but a new one must be complete. */
+seq_opt_t seq_bloom_config(seq_t seq, seq_size_t keys) {
+	seq_bloom_t bloom = seq->bloom;
+	seq_opt_t err = SEQ_ERR_NONE;
+
+	if(!keys) {
+		if(bloom) free(bloom->mem);
+
+		free(bloom);
+
+		seq->bloom = NULL;
+
+		return SEQ_ERR_NONE;
+	}
+
+	if(!bloom && !(bloom = seq->bloom = seq_malloc(seq_bloom_t))) return SEQ_ERR_MEM;
+
+	bloom->expected = keys;
+
+	if((err = seq_bloom_build(seq, seq->size)) && !bloom->mem) {
+		free(bloom);
+
+		seq->bloom = NULL;
+	}
+
+	return err;
+}
+
+/* Once the filter holds more keys than it was built for, it's rebuilt at twice the size of the
+ * map, which includes the new key already. */
+void seq_bloom_add(seq_t seq, const char* key) {
+	seq_bloom_t bloom = seq->bloom;
+
+	if(++bloom->keys > bloom->capacity && !seq_bloom_build(seq, seq->size * 2)) return;
+
+	seq_bloom_set(bloom->blocks, bloom->count, seq_bloom_hash(key));
+}
+
+int seq_bloom_find(seq_t seq, const char* key) {
+	seq_bloom_t bloom = seq->bloom;
+	uint32_t hash = seq_bloom_hash(key);
+	uint32_t* block = seq_bloom_block(bloom->blocks, bloom->count, hash);
+	uint32_t probe = seq_bloom_mix(hash);
+	uint32_t step = (probe >> 9) | 1;
+	int i;
+
+	for(i = 0; i < SEQ_BLOOM_PROBES; i++, probe += step) {
+		if(!(block[(probe & 511) >> 5] & ((uint32_t)(1) << (probe & 31)))) return 0;
+	}
+
+	return 1;
+}
+
+/* Rebuilding once the stale keys outnumber the ones left in the map costs O(n) every n removals
+ * or so, that is, O(1) per removal. */
+void seq_bloom_remove(seq_t seq) {
+	seq_bloom_t bloom = seq->bloom;
+
+	if(++bloom->stale > seq->size) seq_bloom_build(seq, seq->size * 2);
+}
@@ -0,0 +1,874 @@
+#include "seq-api.h"
+
+#include <string.h>
+
+/* ======================================================================== Types, Constants, Enums
+ * struct _seq_btree_node_t
+ * struct _seq_btree_data_t
+ * struct _seq_btree_iter_data_t
+ * seq_btree_data
+ * seq_btree_iter_data
+ * SEQ_TYPE_API(btree)
+ * --------------------------------------------------------------------------------------------- */
+
+typedef struct _seq_btree_node_t* seq_btree_node_t;
+typedef struct _seq_btree_data_t* seq_btree_data_t;
+typedef struct _seq_btree_iter_data_t* seq_btree_iter_data_t;
+
+/* A SEQ_MAP (or SEQ_BTREE) is a B+tree: the keys of every node are kept in a single sorted array
+ * that's binary searched, so a lookup touches a handful of contiguous cache lines per level rather
+ * than one scattered node per comparison, and the tree is only about log32(n) levels deep. Inner
+ * nodes merely route the search: the key at position i is the smallest key below child i + 1.
+ * Every key and value lives in the leaves, which are linked to each other in order, so iterating
+ * never goes back up the tree.
+ *
+ * Nodes are split on the way down when inserting, so an insertion that fails (for lack of memory)
+ * leaves the tree intact; removing never allocates anything. Every node but the root holds at
+ * least SEQ_BTREE_MIN keys. */
+#define SEQ_BTREE_ORDER 32
+#define SEQ_BTREE_HALF (SEQ_BTREE_ORDER / 2)
+#define SEQ_BTREE_MIN (SEQ_BTREE_HALF - 1)
+
+struct _seq_btree_node_t {
+	seq_size_t count;
+	seq_data_t keys[SEQ_BTREE_ORDER];
+
+	union {
+		struct {
+			seq_data_t vals[SEQ_BTREE_ORDER];
+			seq_btree_node_t next;
+			seq_btree_node_t prev;
+		} leaf;
+
+		seq_btree_node_t child[SEQ_BTREE_ORDER + 1];
+	} as;
+};
+
+/* The @height is the number of inner levels above the leaves; @first and @last are the leftmost
+ * and rightmost leaves. An empty map has no nodes at all. */
+struct _seq_btree_data_t {
+	seq_btree_node_t root;
+	seq_btree_node_t first;
+	seq_btree_node_t last;
+	unsigned int height;
+};
+
+/* With SEQ_KEY_PREFIX, iteration stops at the first key that doesn't start with the @prefix. With
+ * SEQ_RANGE, it starts at the @lo key (or the @hi one, if @reverse) and stops past the other one;
+ * either may be NULL for no bound, and the @exclude_lo and @exclude_hi flags leave the bound key
+ * itself out. */
+struct _seq_btree_iter_data_t {
+	seq_btree_node_t leaf;
+	seq_size_t pos;
+	const char* prefix;
+	seq_size_t len;
+	seq_data_t lo;
+	seq_data_t hi;
+	int exclude_lo;
+	int exclude_hi;
+	int reverse;
+};
+
+#define seq_btree_data(seq) ((seq_btree_data_t)(seq->data))
+#define seq_btree_iter_data(iter) ((seq_btree_iter_data_t)(iter->data))
+
+SEQ_TYPE_API(btree)
+
+/* ========================================================================== Private BTree Helpers
+ * seq_btree_cmp
+ *    Compares two keys, returning a negative, zero or positive value.
+ *
+ * seq_btree_key
+ *    Returns the copy of a key to look up in the map, or NULL if it can't be there.
+ *
+ * seq_btree_search
+ *    Returns the position of the first key in a node that doesn't order before the given one.
+ *
+ * seq_btree_leaf
+ *    Returns the leaf where the given key is (or would be), and its position in there.
+ *
+ * seq_btree_node_create
+ *    Allocates an empty node.
+ *
+ * seq_btree_node_destroy
+ *    Frees a node, along with every node below it.
+ *
+ * seq_btree_split
+ *    Splits the full child in the given slot of a node, which must have room for one more.
+ *
+ * seq_btree_put
+ *    Inserts a key, or replaces the value of an equal one.
+ *
+ * seq_btree_min
+ *    Returns the smallest key below a node.
+ *
+ * seq_btree_merge
+ *    Merges the child following the given slot of a node into the one in it.
+ *
+ * seq_btree_fix
+ *    Refills the child in the given slot of a node, after it dropped below SEQ_BTREE_MIN keys.
+ *
+ * seq_btree_delete
+ *    Removes a key from below a node.
+ *
+ * seq_btree_take
+ *    Removes a key from the map, collapsing the root if needed.
+ *
+ * seq_btree_iter_step
+ *    Moves an iterator to the next key in its direction, or to a NULL leaf past the last one.
+ *
+ * seq_btree_iter_seek
+ *    Moves an iterator to the first key it should visit (ignoring the bound it stops at).
+ *
+ * seq_btree_iter_past
+ *    Returns whether an iterator went past the bound (or prefix) it stops at.
+ * ============================================================================================= */
+
+/* Keys are NUL-terminated strings unless a seq_cb_cmp_t callback is configured; interned keys
+ * only need to be compared as strings when they aren't the same one. */
+static int seq_btree_cmp(seq_t seq, seq_data_t lhs, seq_data_t rhs) {
+	seq_opt_t cmp;
+
+	if(!seq->cb.cmp) return lhs == rhs ? 0 : strcmp((const char*)(lhs), (const char*)(rhs));
+
+	cmp = seq_cb_cmp(seq, lhs, rhs);
+
+	return cmp == SEQ_LESS ? -1 : cmp == SEQ_GREATER;
+}
+
+/* A key that was never interned (or that the Bloom filter doesn't know) was never added either. */
+static seq_data_t seq_btree_key(seq_t seq, seq_data_t key) {
+	if(!key || (seq->bloom && !seq_bloom_find(seq, (const char*)(key)))) return NULL;
+
+	if(!seq->intern) return key;
+
+	return (seq_data_t)(seq_intern_find(seq, (const char*)(key)));
+}
+
+/* The @found flag is raised if the key at the position returned is equal to @key. */
+static seq_size_t seq_btree_search(seq_t seq, seq_btree_node_t node, seq_data_t key, int* found) {
+	seq_size_t lo = 0;
+	seq_size_t hi = node->count;
+	seq_size_t mid;
+	int cmp;
+
+	*found = 0;
+
+	while(lo < hi) {
+		mid = lo + ((hi - lo) / 2);
+
+		if((cmp = seq_btree_cmp(seq, node->keys[mid], key)) < 0) lo = mid + 1;
+
+		else {
+			if(!cmp) *found = 1;
+
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+/* An inner key equal to the one looked up is the smallest key of the child following it. */
+static seq_btree_node_t seq_btree_leaf(seq_t seq, seq_data_t key, seq_size_t* pos, int* found) {
+	seq_btree_data_t data = seq_btree_data(seq);
+	seq_btree_node_t node = data->root;
+	unsigned int height;
+
+	for(height = data->height; height; height--) {
+		*pos = seq_btree_search(seq, node, key, found);
+
+		node = node->as.child[*pos + *found];
+	}
+
+	seq_stats_add(seq, hops, data->height);
+
+	*pos = seq_btree_search(seq, node, key, found);
+
+	return node;
+}
+
+static seq_btree_node_t seq_btree_node_create(seq_t seq) {
+	seq_btree_node_t node = seq_malloc(seq_btree_node_t);
+
+	if(node) seq_stats_add(seq, nodes_alloc, 1);
+
+	return node;
+}
+
+static void seq_btree_node_destroy(seq_t seq, seq_btree_node_t node, unsigned int height) {
+	seq_size_t i;
+
+	if(height) {
+		for(i = 0; i <= node->count; i++) {
+			seq_btree_node_destroy(seq, node->as.child[i], height - 1);
+		}
+	}
+
+	free(node);
+
+	seq_stats_add(seq, nodes_free, 1);
+}
+
+/* A leaf is split evenly, and the first key of its second half is copied up as the separator; an
+ * inner node moves its middle key up instead. The @height is that of the child. */
+static seq_opt_t seq_btree_split(
+	seq_t seq,
+	seq_btree_node_t node,
+	seq_size_t pos,
+	unsigned int height
+) {
+	seq_btree_data_t data = seq_btree_data(seq);
+	seq_btree_node_t child = node->as.child[pos];
+	seq_btree_node_t right = seq_btree_node_create(seq);
+	seq_data_t sep = NULL;
+
+	if(!right) return SEQ_ERR_MEM;
+
+	if(!height) {
+		memcpy(right->keys, &child->keys[SEQ_BTREE_HALF], SEQ_BTREE_HALF * sizeof(seq_data_t));
+
+		memcpy(
+			right->as.leaf.vals,
+			&child->as.leaf.vals[SEQ_BTREE_HALF],
+			SEQ_BTREE_HALF * sizeof(seq_data_t)
+		);
+
+		right->count = SEQ_BTREE_HALF;
+		right->as.leaf.prev = child;
+
+		if((right->as.leaf.next = child->as.leaf.next)) right->as.leaf.next->as.leaf.prev = right;
+
+		else data->last = right;
+
+		child->as.leaf.next = right;
+		child->count = SEQ_BTREE_HALF;
+
+		sep = right->keys[0];
+	}
+
+	else {
+		right->count = SEQ_BTREE_ORDER - SEQ_BTREE_HALF - 1;
+
+		memcpy(right->keys, &child->keys[SEQ_BTREE_HALF + 1], right->count * sizeof(seq_data_t));
+
+		memcpy(
+			right->as.child,
+			&child->as.child[SEQ_BTREE_HALF + 1],
+			(right->count + 1) * sizeof(seq_btree_node_t)
+		);
+
+		child->count = SEQ_BTREE_HALF;
+
+		sep = child->keys[SEQ_BTREE_HALF];
+	}
+
+	memmove(&node->keys[pos + 1], &node->keys[pos], (node->count - pos) * sizeof(seq_data_t));
+
+	memmove(
+		&node->as.child[pos + 2],
+		&node->as.child[pos + 1],
+		(node->count - pos) * sizeof(seq_btree_node_t)
+	);
+
+	node->keys[pos] = sep;
+	node->as.child[pos + 1] = right;
+	node->count++;
+
+	return SEQ_ERR_NONE;
+}
+
+/* Returns SEQ_EQUAL if the key was already there, in which case the value it replaced is handed
+ * back through @val (and the key given originally is kept). */
+static seq_opt_t seq_btree_put(seq_t seq, seq_data_t key, seq_data_t* val) {
+	seq_btree_data_t data = seq_btree_data(seq);
+	seq_btree_node_t node = data->root;
+	seq_btree_node_t root = NULL;
+	seq_data_t old = NULL;
+	unsigned int height;
+	seq_size_t pos;
+	int found;
+
+	if(!node) {
+		if(!(node = seq_btree_node_create(seq))) return SEQ_ERR_MEM;
+
+		data->root = data->first = data->last = node;
+	}
+
+	else if(node->count == SEQ_BTREE_ORDER) {
+		if(!(root = seq_btree_node_create(seq))) return SEQ_ERR_MEM;
+
+		root->as.child[0] = node;
+
+		if(seq_btree_split(seq, root, 0, data->height)) {
+			free(root);
+
+			seq_stats_add(seq, nodes_free, 1);
+
+			return SEQ_ERR_MEM;
+		}
+
+		node = data->root = root;
+
+		data->height++;
+	}
+
+	for(height = data->height; height; height--) {
+		pos = seq_btree_search(seq, node, key, &found) + found;
+
+		if(node->as.child[pos]->count == SEQ_BTREE_ORDER) {
+			if(seq_btree_split(seq, node, pos, height - 1)) return SEQ_ERR_MEM;
+
+			if(seq_btree_cmp(seq, key, node->keys[pos]) >= 0) pos++;
+		}
+
+		node = node->as.child[pos];
+	}
+
+	seq_stats_add(seq, hops, data->height);
+
+	pos = seq_btree_search(seq, node, key, &found);
+
+	if(found) {
+		old = node->as.leaf.vals[pos];
+
+		node->as.leaf.vals[pos] = *val;
+
+		*val = old;
+
+		return SEQ_EQUAL;
+	}
+
+	memmove(&node->keys[pos + 1], &node->keys[pos], (node->count - pos) * sizeof(seq_data_t));
+
+	memmove(
+		&node->as.leaf.vals[pos + 1],
+		&node->as.leaf.vals[pos],
+		(node->count - pos) * sizeof(seq_data_t)
+	);
+
+	node->keys[pos] = key;
+	node->as.leaf.vals[pos] = *val;
+	node->count++;
+
+	seq->size++;
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_data_t seq_btree_min(seq_btree_node_t node, unsigned int height) {
+	for(; height; height--) node = node->as.child[0];
+
+	return node->keys[0];
+}
+
+/* The @height is that of the children; the leaf that's merged away is unlinked as well. */
+static void seq_btree_merge(seq_t seq, seq_btree_node_t node, seq_size_t pos, unsigned int height) {
+	seq_btree_node_t left = node->as.child[pos];
+	seq_btree_node_t right = node->as.child[pos + 1];
+
+	if(!height) {
+		memcpy(&left->keys[left->count], right->keys, right->count * sizeof(seq_data_t));
+
+		memcpy(
+			&left->as.leaf.vals[left->count],
+			right->as.leaf.vals,
+			right->count * sizeof(seq_data_t)
+		);
+
+		left->count += right->count;
+
+		if((left->as.leaf.next = right->as.leaf.next)) left->as.leaf.next->as.leaf.prev = left;
+
+		else seq_btree_data(seq)->last = left;
+	}
+
+	else {
+		left->keys[left->count] = node->keys[pos];
+
+		memcpy(&left->keys[left->count + 1], right->keys, right->count * sizeof(seq_data_t));
+
+		memcpy(
+			&left->as.child[left->count + 1],
+			right->as.child,
+			(right->count + 1) * sizeof(seq_btree_node_t)
+		);
+
+		left->count += right->count + 1;
+	}
+
+	memmove(&node->keys[pos], &node->keys[pos + 1], (node->count - pos - 1) * sizeof(seq_data_t));
+
+	memmove(
+		&node->as.child[pos + 1],
+		&node->as.child[pos + 2],
+		(node->count - pos - 1) * sizeof(seq_btree_node_t)
+	);
+
+	node->count--;
+
+	free(right);
+
+	seq_stats_add(seq, nodes_free, 1);
+}
+
+/* A key is borrowed from a sibling that can spare one (rotating it through the separator, for inner
+ * nodes); otherwise, the child is merged with one of them. The @height is that of the child. */
+static void seq_btree_fix(seq_t seq, seq_btree_node_t node, seq_size_t pos, unsigned int height) {
+	seq_btree_node_t child = node->as.child[pos];
+	seq_btree_node_t left = pos ? node->as.child[pos - 1] : NULL;
+	seq_btree_node_t right = pos < node->count ? node->as.child[pos + 1] : NULL;
+
+	if(left && left->count > SEQ_BTREE_MIN) {
+		memmove(&child->keys[1], child->keys, child->count * sizeof(seq_data_t));
+
+		if(!height) {
+			memmove(
+				&child->as.leaf.vals[1],
+				child->as.leaf.vals,
+				child->count * sizeof(seq_data_t)
+			);
+
+			child->keys[0] = left->keys[left->count - 1];
+			child->as.leaf.vals[0] = left->as.leaf.vals[left->count - 1];
+
+			node->keys[pos - 1] = child->keys[0];
+		}
+
+		else {
+			memmove(
+				&child->as.child[1],
+				child->as.child,
+				(child->count + 1) * sizeof(seq_btree_node_t)
+			);
+
+			child->keys[0] = node->keys[pos - 1];
+			child->as.child[0] = left->as.child[left->count];
+
+			node->keys[pos - 1] = left->keys[left->count - 1];
+		}
+
+		left->count--;
+		child->count++;
+	}
+
+	else if(right && right->count > SEQ_BTREE_MIN) {
+		if(!height) {
+			child->keys[child->count] = right->keys[0];
+			child->as.leaf.vals[child->count] = right->as.leaf.vals[0];
+
+			memmove(
+				right->as.leaf.vals,
+				&right->as.leaf.vals[1],
+				(right->count - 1) * sizeof(seq_data_t)
+			);
+		}
+
+		else {
+			child->keys[child->count] = node->keys[pos];
+			child->as.child[child->count + 1] = right->as.child[0];
+
+			node->keys[pos] = right->keys[0];
+
+			memmove(right->as.child, &right->as.child[1], right->count * sizeof(seq_btree_node_t));
+		}
+
+		memmove(right->keys, &right->keys[1], (right->count - 1) * sizeof(seq_data_t));
+
+		if(!height) node->keys[pos] = right->keys[0];
+
+		right->count--;
+		child->count++;
+	}
+
+	else seq_btree_merge(seq, node, left ? pos - 1 : pos, height);
+}
+
+/* Returns SEQ_ERR_NODE if the key isn't there. Since the keys belong to the caller, one that's
+ * removed must not linger on as a separator in an inner node either; it's replaced by the smallest
+ * key remaining below it, which separates the same two children just as well. */
+static seq_opt_t seq_btree_delete(
+	seq_t seq,
+	seq_btree_node_t node,
+	unsigned int height,
+	seq_data_t key,
+	seq_data_t* val
+) {
+	int found;
+	seq_size_t pos = seq_btree_search(seq, node, key, &found);
+	seq_opt_t err;
+
+	if(!height) {
+		if(!found) return SEQ_ERR_NODE;
+
+		*val = node->as.leaf.vals[pos];
+
+		memmove(
+			&node->keys[pos],
+			&node->keys[pos + 1],
+			(node->count - pos - 1) * sizeof(seq_data_t)
+		);
+
+		memmove(
+			&node->as.leaf.vals[pos],
+			&node->as.leaf.vals[pos + 1],
+			(node->count - pos - 1) * sizeof(seq_data_t)
+		);
+
+		node->count--;
+
+		return SEQ_ERR_NONE;
+	}
+
+	pos += found;
+
+	if((err = seq_btree_delete(seq, node->as.child[pos], height - 1, key, val))) return err;
+
+	if(found) node->keys[pos - 1] = seq_btree_min(node->as.child[pos], height - 1);
+
+	if(node->as.child[pos]->count < SEQ_BTREE_MIN) seq_btree_fix(seq, node, pos, height - 1);
+
+	return SEQ_ERR_NONE;
+}
+
+/* An inner root left with a single child is replaced by it, and a leaf left empty is freed. */
+static seq_opt_t seq_btree_take(seq_t seq, seq_data_t key, seq_data_t* val) {
+	seq_btree_data_t data = seq_btree_data(seq);
+	seq_btree_node_t root = data->root;
+	seq_opt_t err;
+
+	if(!root) return SEQ_ERR_NODE;
+
+	if((err = seq_btree_delete(seq, root, data->height, key, val))) return err;
+
+	seq_stats_add(seq, hops, data->height);
+
+	seq->size--;
+
+	if(root->count) return SEQ_ERR_NONE;
+
+	if(data->height) {
+		data->root = root->as.child[0];
+		data->height--;
+	}
+
+	else data->root = data->first = data->last = NULL;
+
+	free(root);
+
+	seq_stats_add(seq, nodes_free, 1);
+
+	return SEQ_ERR_NONE;
+}
+
+/* Entering a leaf starts loading the one after it, which a scan will need next. */
+static void seq_btree_iter_step(seq_btree_iter_data_t data) {
+	if(!data->reverse) {
+		if(++data->pos < data->leaf->count) return;
+
+		data->leaf = data->leaf->as.leaf.next;
+		data->pos = 0;
+
+		if(data->leaf) seq_prefetch(data->leaf->as.leaf.next);
+	}
+
+	else if(data->pos) data->pos--;
+
+	else if((data->leaf = data->leaf->as.leaf.prev)) {
+		data->pos = data->leaf->count - 1;
+
+		seq_prefetch(data->leaf->as.leaf.prev);
+	}
+}
+
+/* Seeking a bound lands on the first key that doesn't order before it: a forward iterator only
+ * skips it if it's equal to an excluded bound, and a reverse one only keeps it then if it isn't. */
+static void seq_btree_iter_seek(seq_t seq, seq_btree_iter_data_t data) {
+	seq_btree_data_t tree = seq_btree_data(seq);
+	seq_data_t key = data->reverse ? data->hi : data->lo;
+	int exclude = data->reverse ? data->exclude_hi : data->exclude_lo;
+	int found = 0;
+
+	if(!key) key = (seq_data_t)(data->prefix);
+
+	if(!(data->leaf = data->reverse ? tree->last : tree->first)) return;
+
+	data->pos = data->reverse ? data->leaf->count - 1 : 0;
+
+	if(!key) return;
+
+	data->leaf = seq_btree_leaf(seq, key, &data->pos, &found);
+
+	if(data->reverse) {
+		if(!found || exclude) seq_btree_iter_step(data);
+	}
+
+	else if(found && exclude) seq_btree_iter_step(data);
+
+	else if(data->pos == data->leaf->count) {
+		data->pos--;
+
+		seq_btree_iter_step(data);
+	}
+}
+
+static int seq_btree_iter_past(seq_t seq, seq_btree_iter_data_t data) {
+	seq_data_t key = data->leaf->keys[data->pos];
+	int cmp;
+
+	if(data->prefix) return strncmp((const char*)(key), data->prefix, data->len) != 0;
+
+	if(data->reverse && data->lo) {
+		cmp = seq_btree_cmp(seq, key, data->lo);
+
+		return cmp < 0 || (!cmp && data->exclude_lo);
+	}
+
+	if(!data->reverse && data->hi) {
+		cmp = seq_btree_cmp(seq, key, data->hi);
+
+		return cmp > 0 || (!cmp && data->exclude_hi);
+	}
+
+	return 0;
+}
+
+/* ======================================================================= SEQ_BTREE Implementation
+ * seq_btree_create
+ * seq_btree_destroy
+ * seq_btree_config
+ * seq_btree_add
+ * seq_btree_remove
+ * seq_btree_get
+ * seq_btree_set
+ * ============================================================================================= */
+
+static void seq_btree_create(seq_t seq) {
+	seq->type = SEQ_BTREE;
+	seq->impl = seq_impl_btree();
+	seq->data = seq_malloc(seq_btree_data_t);
+}
+
+static void seq_btree_destroy(seq_t seq) {
+	seq_btree_data_t data = seq_btree_data(seq);
+	seq_btree_node_t leaf = NULL;
+	seq_size_t i;
+
+	if(seq->cb.remove) {
+		for(leaf = data->first; leaf; leaf = leaf->as.leaf.next) {
+			for(i = 0; i < leaf->count; i++) seq_cb_remove(seq, leaf->as.leaf.vals[i]);
+		}
+	}
+
+	if(data->root) seq_btree_node_destroy(seq, data->root, data->height);
+
+	free(data);
+}
+
+/* The order of the keys, and whether they're interned, can only change while there aren't any; a
+ * Bloom filter can be added at any time, but only hashes strings. */
+static seq_opt_t seq_btree_config(seq_t seq, seq_opt_t opt, seq_args_t args) {
+	if(opt == SEQ_BLOOM && !seq->cb.cmp) return seq_bloom_config(seq, seq_arg(args, seq_size_t));
+
+	if(seq->size) return SEQ_ERR_OPT;
+
+	/* Interned keys are told apart by their address, which a callback couldn't do. */
+	if(opt == SEQ_CB_CMP && !seq->intern && !seq->bloom) return SEQ_ERR_NONE;
+
+	if(opt == SEQ_INTERN && !seq->cb.cmp) return seq_intern_config(seq, seq_arg(args, int));
+
+	return SEQ_ERR_OPT;
+}
+
+/* Replacing the value of an existing key invokes the seq_cb_remove_t callback on the old one. */
+static seq_opt_t seq_btree_add(seq_t seq, seq_args_t args) {
+	seq_data_t key = NULL;
+	seq_data_t d = NULL;
+	seq_opt_t err;
+
+	if(seq_arg_opt(args) != SEQ_KEYVAL) return SEQ_ERR_OPT;
+
+	if(!(key = seq_arg_data(args))) return SEQ_ERR_DATA;
+
+	if(seq->intern && !(key = (seq_data_t)(seq_intern(seq, (const char*)(key))))) {
+		return SEQ_ERR_MEM;
+	}
+
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+	if((err = seq_btree_put(seq, key, &d)) == SEQ_EQUAL) {
+		seq_cb_remove(seq, d);
+
+		return SEQ_ERR_NONE;
+	}
+
+	if(!err && seq->bloom) seq_bloom_add(seq, (const char*)(key));
+
+	return err;
+}
+
+static seq_opt_t seq_btree_remove(seq_t seq, seq_args_t args) {
+	seq_data_t key = NULL;
+	seq_data_t d = NULL;
+	seq_opt_t err;
+
+	if(seq_arg_opt(args) != SEQ_KEY) return SEQ_ERR_OPT;
+
+	if(!(key = seq_arg_data(args))) return SEQ_ERR_DATA;
+
+	if(!(key = seq_btree_key(seq, key))) return SEQ_ERR_NODE;
+
+	if((err = seq_btree_take(seq, key, &d))) return err;
+
+	if(seq->bloom) seq_bloom_remove(seq);
+
+	seq_cb_remove(seq, d);
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_data_t seq_btree_get(seq_t seq, seq_args_t args) {
+	seq_btree_node_t leaf = NULL;
+	seq_data_t key = NULL;
+	seq_size_t pos;
+	int found;
+
+	if(seq_arg_opt(args) != SEQ_KEY || !seq->size) return NULL;
+
+	if(!(key = seq_btree_key(seq, seq_arg_data(args)))) return NULL;
+
+	leaf = seq_btree_leaf(seq, key, &pos, &found);
+
+	return found ? leaf->as.leaf.vals[pos] : NULL;
+}
+
+static seq_opt_t seq_btree_set(seq_t seq, seq_args_t args) {
+	seq_btree_node_t leaf = NULL;
+	seq_data_t key = NULL;
+	seq_data_t d = NULL;
+	seq_size_t pos;
+	int found;
+
+	if(seq_arg_opt(args) != SEQ_KEY) return SEQ_ERR_OPT;
+
+	if(!(key = seq_arg_data(args))) return SEQ_ERR_DATA;
+
+	if(!seq->size || !(key = seq_btree_key(seq, key))) return SEQ_ERR_NODE;
+
+	leaf = seq_btree_leaf(seq, key, &pos, &found);
+
+	if(!found) return SEQ_ERR_NODE;
+
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+	seq_cb_remove(seq, leaf->as.leaf.vals[pos]);
+
+	leaf->as.leaf.vals[pos] = d;
+
+	return SEQ_ERR_NONE;
+}
+
+/* ============================================================= SEQ_BTREE Iteration Implementation
+ * seq_btree_iter_create
+ * seq_btree_iter_destroy
+ * seq_btree_iter_get
+ * seq_btree_iter_set
+ * seq_btree_iter_iterate
+ * seq_btree_iter_copy
+ * ============================================================================================= */
+
+/* A prefix only makes sense while the keys are ordered as strings; the bounds of a SEQ_RANGE are
+ * keys, ordered like any other (by the seq_cb_cmp_t callback, if there's one). */
+static seq_opt_t seq_btree_iter_create(seq_iter_t iter, seq_args_t args) {
+	seq_btree_iter_data_t data = seq_malloc(seq_btree_iter_data_t);
+	seq_opt_t opt;
+	int cmp;
+
+	if(!(iter->data = data)) return SEQ_ERR_MEM;
+
+	while((opt = seq_arg_opt(args))) {
+		if(opt == SEQ_KEY_PREFIX && !iter->seq->cb.cmp) {
+			if(!(data->prefix = (const char*)(seq_arg_data(args)))) return SEQ_ERR_DATA;
+
+			data->len = strlen(data->prefix);
+		}
+
+		else if(opt == SEQ_RANGE) {
+			data->lo = seq_arg_data(args);
+			data->hi = seq_arg_data(args);
+		}
+
+		else if(opt == SEQ_REVERSE) data->reverse = 1;
+
+		else if(opt == SEQ_EXCLUDE_LO) data->exclude_lo = 1;
+
+		else if(opt == SEQ_EXCLUDE_HI) data->exclude_hi = 1;
+
+		else return SEQ_ERR_OPT;
+	}
+
+	/* A prefix is only ever scanned forward, from the prefix itself. */
+	if(data->prefix && (data->lo || data->hi || data->reverse)) return SEQ_ERR_OPT;
+
+	/* A range whose bounds are out of order (or equal, but excluded) simply visits no keys. */
+	if(data->lo && data->hi) {
+		cmp = seq_btree_cmp(iter->seq, data->lo, data->hi);
+
+		if(cmp > 0 || (!cmp && (data->exclude_lo || data->exclude_hi))) iter->state = SEQ_STOP;
+	}
+
+	return SEQ_ERR_NONE;
+}
+
+static void seq_btree_iter_destroy(seq_iter_t iter) {
+}
+
+static seq_data_t seq_btree_iter_get(seq_iter_t iter, seq_args_t args) {
+	seq_btree_iter_data_t data = seq_btree_iter_data(iter);
+	seq_opt_t opt = seq_arg_opt(args);
+
+	if(opt == SEQ_DATA) return data->leaf->as.leaf.vals[data->pos];
+
+	else if(opt == SEQ_KEY) return data->leaf->keys[data->pos];
+
+	return NULL;
+}
+
+static seq_opt_t seq_btree_iter_set(seq_iter_t iter, seq_args_t args) {
+	seq_btree_iter_data_t data = seq_btree_iter_data(iter);
+	seq_data_t d = NULL;
+
+	if(seq_arg_opt(args) != SEQ_DATA) return SEQ_ERR_OPT;
+
+	if(!(d = seq_cb_add(iter->seq, args))) return SEQ_ERR_DATA;
+
+	seq_cb_remove(iter->seq, data->leaf->as.leaf.vals[data->pos]);
+
+	data->leaf->as.leaf.vals[data->pos] = d;
+
+	return SEQ_ERR_NONE;
+}
+
+/* Only the first step seeks, in O(log n); every following one is a move to the next key in the
+ * same leaf (or to the leaf linked to it). */
+static seq_opt_t seq_btree_iter_iterate(seq_iter_t iter) {
+	seq_btree_iter_data_t data = seq_btree_iter_data(iter);
+
+	if(iter->state == SEQ_READY) seq_btree_iter_seek(iter->seq, data);
+
+	else seq_btree_iter_step(data);
+
+	if(!data->leaf || seq_btree_iter_past(iter->seq, data)) return SEQ_STOP;
+
+	return SEQ_ACTIVE;
+}
+
+static seq_opt_t seq_btree_iter_copy(seq_iter_t iter, seq_iter_t src) {
+	seq_btree_iter_data_t data = seq_malloc(seq_btree_iter_data_t);
+
+	if(!(iter->data = data)) return SEQ_ERR_MEM;
+
+	*data = *seq_btree_iter_data(src);
+
+	return SEQ_ERR_NONE;
+}
@@ -0,0 +1,471 @@
+#include "seq-api.h"
+
+#include <string.h>
+
+/* ======================================================================== Types, Constants, Enums
+ * struct _seq_cache_entry_t
+ * struct _seq_cache_data_t
+ * struct _seq_cache_iter_data_t
+ * seq_cache_data
+ * seq_cache_iter_data
+ * seq_cache_key
+ * seq_cache_over
+ * SEQ_CACHE_BUCKETS
+ * SEQ_TYPE_API(cache)
+ * --------------------------------------------------------------------------------------------- */
+
+typedef struct _seq_cache_entry_t* seq_cache_entry_t;
+typedef struct _seq_cache_data_t* seq_cache_data_t;
+typedef struct _seq_cache_iter_data_t* seq_cache_iter_data_t;
+
+/* Every entry is a single allocation, followed by a copy of its key. It's chained into its bucket
+ * of the hash index through @chain, and into the CLOCK ring through @next and @prev; @ref is set
+ * whenever the entry is used, and cleared again as the hand passes it by. The @size is whatever
+ * the seq_cb_size_t callback returned for the data (or 0, without one). */
+struct _seq_cache_entry_t {
+	seq_cache_entry_t chain;
+	seq_cache_entry_t next;
+	seq_cache_entry_t prev;
+	seq_data_t data;
+	seq_size_t size;
+	uint32_t hash;
+	int ref;
+};
+
+/* Entries join the ring right behind the @hand, which is where the search for the next entry to
+ * evict starts, so a new entry is the last one the hand comes across. The @bytes are the sum of
+ * the sizes of every entry, and a @capacity or @budget of 0 is no limit at all. */
+struct _seq_cache_data_t {
+	seq_cache_entry_t* buckets;
+	seq_size_t mask;
+	seq_cache_entry_t hand;
+	seq_size_t capacity;
+	seq_size_t budget;
+	seq_size_t bytes;
+};
+
+struct _seq_cache_iter_data_t {
+	seq_cache_entry_t entry;
+	seq_cache_entry_t start;
+};
+
+#define SEQ_CACHE_BUCKETS 16
+
+#define seq_cache_data(seq) ((seq_cache_data_t)(seq->data))
+#define seq_cache_iter_data(iter) ((seq_cache_iter_data_t)(iter->data))
+#define seq_cache_key(entry) ((char*)((entry) + 1))
+
+#define seq_cache_over(seq, data) ( \
+	((data)->capacity && (seq)->size > (data)->capacity) || \
+	((data)->budget && (data)->bytes > (data)->budget) \
+)
+
+SEQ_TYPE_API(cache)
+
+/* ========================================================================== Private Cache Helpers
+ * seq_cache_hash
+ *    Returns the (32-bit FNV-1a) hash of a key, storing its length in @len.
+ *
+ * seq_cache_size
+ *    Returns the size of the given data, as reported by the seq_cb_size_t callback.
+ *
+ * seq_cache_find
+ *    Returns the entry holding the given key, or NULL.
+ *
+ * seq_cache_grow
+ *    Doubles the number of buckets, if possible.
+ *
+ * seq_cache_unlink
+ *    Takes an entry out of the hash index and the ring, and frees it; the data is returned.
+ *
+ * seq_cache_evict
+ *    Evicts entries until the cache is within its limits again, sparing the given one.
+ *
+ * seq_cache_replace
+ *    Replaces the data of an entry with the data given by the remaining arguments.
+ * ============================================================================================= */
+
+static uint32_t seq_cache_hash(const char* key, seq_size_t* len) {
+	const unsigned char* c = (const unsigned char*)(key);
+	uint32_t hash = 2166136261UL;
+
+	for(; *c; c++) hash = (hash ^ *c) * 16777619UL;
+
+	*len = (seq_size_t)(c - (const unsigned char*)(key));
+
+	return hash;
+}
+
+static seq_size_t seq_cache_size(seq_t seq, seq_data_t d) {
+	return seq->cb.size ? seq_cb_size(seq, d) : 0;
+}
+
+static seq_cache_entry_t seq_cache_find(seq_t seq, const char* key, uint32_t hash) {
+	seq_cache_data_t data = seq_cache_data(seq);
+	seq_cache_entry_t entry = data->buckets[hash & data->mask];
+
+	for(; entry; entry = entry->chain) {
+		seq_stats_add(seq, hops, 1);
+
+		if(entry->hash == hash && !strcmp(seq_cache_key(entry), key)) break;
+	}
+
+	return entry;
+}
+
+/* Failing to grow isn't an error; the chains merely get longer. */
+static void seq_cache_grow(seq_t seq) {
+	seq_cache_data_t data = seq_cache_data(seq);
+	seq_size_t size = (data->mask + 1) * 2;
+	seq_cache_entry_t* buckets = (seq_cache_entry_t*)(calloc(size, sizeof(seq_cache_entry_t)));
+	seq_cache_entry_t entry = NULL;
+	seq_size_t i;
+
+	if(!buckets) return;
+
+	for(i = 0; i <= data->mask; i++) {
+		while((entry = data->buckets[i])) {
+			data->buckets[i] = entry->chain;
+
+			entry->chain = buckets[entry->hash & (size - 1)];
+
+			buckets[entry->hash & (size - 1)] = entry;
+		}
+	}
+
+	free(data->buckets);
+
+	data->buckets = buckets;
+	data->mask = size - 1;
+}
+
+static seq_data_t seq_cache_unlink(seq_t seq, seq_cache_entry_t entry) {
+	seq_cache_data_t data = seq_cache_data(seq);
+	seq_cache_entry_t* link = &data->buckets[entry->hash & data->mask];
+	seq_data_t d = entry->data;
+
+	while(*link != entry) link = &(*link)->chain;
+
+	*link = entry->chain;
+
+	if(data->hand == entry) data->hand = entry->next != entry ? entry->next : NULL;
+
+	entry->prev->next = entry->next;
+	entry->next->prev = entry->prev;
+
+	data->bytes -= entry->size;
+
+	seq->size--;
+
+	free(entry);
+
+	seq_stats_add(seq, nodes_free, 1);
+
+	return d;
+}
+
+/* The hand clears the bit of every entry that was used since it last went by, and evicts the first
+ * one that wasn't; that is, the CLOCK approximation of evicting the least recently used entry. The
+ * entry that was just added (or replaced) is passed as @keep, which can't be the only one left
+ * while the cache is over its limits (see seq_cache_add()). */
+static void seq_cache_evict(seq_t seq, seq_cache_entry_t keep) {
+	seq_cache_data_t data = seq_cache_data(seq);
+	seq_cache_entry_t victim = NULL;
+
+	while(seq->size > (keep ? 1 : 0) && seq_cache_over(seq, data)) {
+		for(victim = data->hand; victim->ref || victim == keep; victim = victim->next) {
+			victim->ref = 0;
+		}
+
+		/* Unlinking the entry under the hand moves the hand on to the next one. */
+		data->hand = victim;
+
+		seq_cb_remove(seq, seq_cache_unlink(seq, victim));
+	}
+}
+
+/* Data that doesn't fit in the byte budget on its own can't be cached under any key, so the entry
+ * is dropped (rather than left holding the stale data), along with the new data. */
+static seq_opt_t seq_cache_replace(seq_t seq, seq_cache_entry_t entry, seq_args_t args) {
+	seq_cache_data_t data = seq_cache_data(seq);
+	seq_data_t d = NULL;
+	seq_size_t size;
+
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+	size = seq_cache_size(seq, d);
+
+	if(data->budget && size > data->budget) {
+		seq_cb_remove(seq, seq_cache_unlink(seq, entry));
+		seq_cb_remove(seq, d);
+
+		return SEQ_ERR_DATA;
+	}
+
+	seq_cb_remove(seq, entry->data);
+
+	data->bytes = data->bytes - entry->size + size;
+
+	entry->data = d;
+	entry->size = size;
+	entry->ref = 1;
+
+	seq_cache_evict(seq, entry);
+
+	return SEQ_ERR_NONE;
+}
+
+/* ======================================================================= SEQ_CACHE Implementation
+ * seq_cache_create
+ * seq_cache_destroy
+ * seq_cache_config
+ * seq_cache_add
+ * seq_cache_remove
+ * seq_cache_get
+ * seq_cache_set
+ * ============================================================================================= */
+
+static void seq_cache_create(seq_t seq) {
+	seq_cache_data_t data = seq_malloc(seq_cache_data_t);
+
+	seq->type = SEQ_CACHE;
+	seq->impl = seq_impl_cache();
+
+	if(data) {
+		data->buckets = (seq_cache_entry_t*)(calloc(SEQ_CACHE_BUCKETS, sizeof(seq_cache_entry_t)));
+		data->mask = SEQ_CACHE_BUCKETS - 1;
+
+		if(!data->buckets) {
+			free(data);
+
+			data = NULL;
+		}
+	}
+
+	seq->data = data;
+}
+
+static void seq_cache_destroy(seq_t seq) {
+	seq_cache_data_t data = seq_cache_data(seq);
+	seq_cache_entry_t entry = NULL;
+
+	while((entry = data->hand)) seq_cb_remove(seq, seq_cache_unlink(seq, entry));
+
+	free(data->buckets);
+	free(data);
+}
+
+/* Limits can change at any time (evicting whatever no longer fits), but the sizes of the entries
+ * already in the cache can't. */
+static seq_opt_t seq_cache_config(seq_t seq, seq_opt_t opt, seq_args_t args) {
+	seq_cache_data_t data = seq_cache_data(seq);
+
+	if(opt == SEQ_CAPACITY) {
+		data->capacity = seq_arg(args, seq_size_t);
+		data->budget = seq_arg(args, seq_size_t);
+
+		seq_cache_evict(seq, NULL);
+
+		return SEQ_ERR_NONE;
+	}
+
+	if(opt == SEQ_CB_SIZE && !seq->size) return SEQ_ERR_NONE;
+
+	return SEQ_ERR_OPT;
+}
+
+/* Adding an existing key replaces its data, invoking the seq_cb_remove_t callback on the old one.
+ * The entry is allocated before the seq_cb_add_t callback is invoked, so that the data is never
+ * lost for lack of memory. */
+static seq_opt_t seq_cache_add(seq_t seq, seq_args_t args) {
+	seq_cache_data_t data = seq_cache_data(seq);
+	seq_cache_entry_t entry = NULL;
+	seq_cache_entry_t hand = data->hand;
+	const char* key = NULL;
+	seq_data_t d = NULL;
+	seq_size_t len;
+	seq_size_t size;
+	uint32_t hash;
+
+	if(seq_arg_opt(args) != SEQ_KEYVAL) return SEQ_ERR_OPT;
+
+	if(!(key = seq_arg(args, const char*))) return SEQ_ERR_DATA;
+
+	hash = seq_cache_hash(key, &len);
+
+	if((entry = seq_cache_find(seq, key, hash))) return seq_cache_replace(seq, entry, args);
+
+	if(!(entry = (seq_cache_entry_t)(malloc(sizeof(struct _seq_cache_entry_t) + len + 1)))) {
+		return SEQ_ERR_MEM;
+	}
+
+	if(!(d = seq_cb_add(seq, args))) {
+		free(entry);
+
+		return SEQ_ERR_DATA;
+	}
+
+	size = seq_cache_size(seq, d);
+
+	if(data->budget && size > data->budget) {
+		free(entry);
+
+		seq_cb_remove(seq, d);
+
+		return SEQ_ERR_DATA;
+	}
+
+	seq_stats_add(seq, nodes_alloc, 1);
+
+	memcpy(seq_cache_key(entry), key, len + 1);
+
+	entry->data = d;
+	entry->size = size;
+	entry->hash = hash;
+	entry->ref = 0;
+	entry->chain = data->buckets[hash & data->mask];
+
+	data->buckets[hash & data->mask] = entry;
+
+	if(!hand) entry->next = entry->prev = data->hand = entry;
+
+	else {
+		entry->next = hand;
+		entry->prev = hand->prev;
+
+		hand->prev->next = entry;
+		hand->prev = entry;
+	}
+
+	data->bytes += size;
+
+	seq->size++;
+
+	if(seq->size > data->mask + 1) seq_cache_grow(seq);
+
+	seq_cache_evict(seq, entry);
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_opt_t seq_cache_remove(seq_t seq, seq_args_t args) {
+	seq_cache_entry_t entry = NULL;
+	const char* key = NULL;
+	seq_size_t len;
+
+	if(seq_arg_opt(args) != SEQ_KEY) return SEQ_ERR_OPT;
+
+	if(!(key = seq_arg(args, const char*))) return SEQ_ERR_DATA;
+
+	if(!(entry = seq_cache_find(seq, key, seq_cache_hash(key, &len)))) return SEQ_ERR_NODE;
+
+	seq_cb_remove(seq, seq_cache_unlink(seq, entry));
+
+	return SEQ_ERR_NONE;
+}
+
+/* A hit only writes to the entry the first time since the hand last cleared it, so that looking up
+ * a popular entry doesn't dirty its cache line over and over; SEQ_PEEK doesn't count as a use. */
+static seq_data_t seq_cache_get(seq_t seq, seq_args_t args) {
+	seq_opt_t opt = seq_arg_opt(args);
+	seq_cache_entry_t entry = NULL;
+	const char* key = NULL;
+	seq_size_t len;
+
+	if((opt != SEQ_KEY && opt != SEQ_PEEK) || !(key = seq_arg(args, const char*))) return NULL;
+
+	if(!seq->size || !(entry = seq_cache_find(seq, key, seq_cache_hash(key, &len)))) return NULL;
+
+	if(opt == SEQ_KEY && !entry->ref) entry->ref = 1;
+
+	return entry->data;
+}
+
+static seq_opt_t seq_cache_set(seq_t seq, seq_args_t args) {
+	seq_cache_entry_t entry = NULL;
+	const char* key = NULL;
+	seq_size_t len;
+
+	if(seq_arg_opt(args) != SEQ_KEY) return SEQ_ERR_OPT;
+
+	if(!(key = seq_arg(args, const char*))) return SEQ_ERR_DATA;
+
+	if(!(entry = seq_cache_find(seq, key, seq_cache_hash(key, &len)))) return SEQ_ERR_NODE;
+
+	return seq_cache_replace(seq, entry, args);
+}
+
+/* ============================================================= SEQ_CACHE Iteration Implementation
+ * seq_cache_iter_create
+ * seq_cache_iter_destroy
+ * seq_cache_iter_get
+ * seq_cache_iter_set
+ * seq_cache_iter_iterate
+ * seq_cache_iter_copy
+ * ============================================================================================= */
+
+static seq_opt_t seq_cache_iter_create(seq_iter_t iter, seq_args_t args) {
+	if(!(iter->data = seq_malloc(seq_cache_iter_data_t))) return SEQ_ERR_MEM;
+
+	return seq_arg_opt(args) ? SEQ_ERR_OPT : SEQ_ERR_NONE;
+}
+
+static void seq_cache_iter_destroy(seq_iter_t iter) {
+}
+
+static seq_data_t seq_cache_iter_get(seq_iter_t iter, seq_args_t args) {
+	seq_cache_iter_data_t data = seq_cache_iter_data(iter);
+	seq_opt_t opt = seq_arg_opt(args);
+
+	if(opt == SEQ_DATA) return data->entry->data;
+
+	else if(opt == SEQ_KEY) return seq_cache_key(data->entry);
+
+	return NULL;
+}
+
+/* Evicting would pull entries out from under the iterator, so the limits are only enforced again
+ * by the next seq_add() or seq_set(). */
+static seq_opt_t seq_cache_iter_set(seq_iter_t iter, seq_args_t args) {
+	seq_cache_iter_data_t data = seq_cache_iter_data(iter);
+	seq_cache_entry_t entry = data->entry;
+	seq_cache_data_t cache = seq_cache_data(iter->seq);
+	seq_data_t d = NULL;
+	seq_size_t size;
+
+	if(seq_arg_opt(args) != SEQ_DATA) return SEQ_ERR_OPT;
+
+	if(!(d = seq_cb_add(iter->seq, args))) return SEQ_ERR_DATA;
+
+	size = seq_cache_size(iter->seq, d);
+
+	seq_cb_remove(iter->seq, entry->data);
+
+	cache->bytes = cache->bytes - entry->size + size;
+
+	entry->data = d;
+	entry->size = size;
+
+	return SEQ_ERR_NONE;
+}
+
+/* Entries are visited in ring order, starting from the hand. */
+static seq_opt_t seq_cache_iter_iterate(seq_iter_t iter) {
+	seq_cache_iter_data_t data = seq_cache_iter_data(iter);
+
+	if(iter->state == SEQ_READY) data->entry = data->start = seq_cache_data(iter->seq)->hand;
+
+	else if((data->entry = data->entry->next) == data->start) data->entry = NULL;
+
+	return data->entry ? SEQ_ACTIVE : SEQ_STOP;
+}
+
+static seq_opt_t seq_cache_iter_copy(seq_iter_t iter, seq_iter_t src) {
+	seq_cache_iter_data_t data = seq_malloc(seq_cache_iter_data_t);
+
+	if(!(iter->data = data)) return SEQ_ERR_MEM;
+
+	*data = *seq_cache_iter_data(src);
+
+	return SEQ_ERR_NONE;
+}
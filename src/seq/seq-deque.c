@@ -0,0 +1,346 @@
+#include "seq-api.h"
+
+/* ======================================================================== Types, Constants, Enums
+ * struct _seq_deque_buf_t
+ * struct _seq_deque_data_t
+ * struct _seq_deque_iter_data_t
+ * seq_deque_data
+ * seq_deque_iter_data
+ * seq_deque_elem
+ * SEQ_TYPE_API(deque)
+ * --------------------------------------------------------------------------------------------- */
+
+typedef struct _seq_deque_buf_t* seq_deque_buf_t;
+typedef struct _seq_deque_data_t* seq_deque_data_t;
+typedef struct _seq_deque_iter_data_t* seq_deque_iter_data_t;
+
+/* A SEQ_DEQUE is a Chase-Lev work-stealing deque: a circular buffer (whose capacity is always a
+ * power of two) indexed by two ever-increasing counters. The owner pushes and pops at the bottom,
+ * and only has to synchronize with thieves--which take elements from the top using CAS--when at
+ * most one element remains. Once grown, a buffer is retired rather than freed, since a thief may
+ * still be reading from it; retired buffers are chained together and freed along with the deque.
+ * Since each buffer is twice the size of the one it replaced, they never add up to more memory than
+ * the current one. The top and bottom counters are kept on separate cache lines. */
+#define SEQ_DEQUE_CAPACITY 16
+#define SEQ_DEQUE_CACHE_LINE 64
+
+struct _seq_deque_buf_t {
+	seq_index_t mask;
+	seq_deque_buf_t retired;
+	seq_data_t elems[1];
+};
+
+struct _seq_deque_data_t {
+	seq_index_t top;
+	char pad[SEQ_DEQUE_CACHE_LINE - sizeof(seq_index_t)];
+	seq_index_t bottom;
+	seq_deque_buf_t buf;
+};
+
+struct _seq_deque_iter_data_t {
+	seq_index_t index;
+};
+
+#define seq_deque_data(seq) ((seq_deque_data_t)(seq->data))
+#define seq_deque_iter_data(iter) ((seq_deque_iter_data_t)(iter->data))
+#define seq_deque_elem(buf, i) (&(buf)->elems[(i) & (buf)->mask])
+
+/* The orderings follow "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al.);
+ * without the GCC builtins, a SEQ_DEQUE is only safe to use from a single thread. */
+#if defined(__ATOMIC_SEQ_CST)
+#define seq_deque_load(ptr, order) __atomic_load_n(ptr, __ATOMIC_##order)
+#define seq_deque_store(ptr, val, order) __atomic_store_n(ptr, val, __ATOMIC_##order)
+#define seq_deque_fence() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define seq_deque_cas(ptr, old, val) \
+	__atomic_compare_exchange_n(ptr, &(old), val, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)
+#define seq_deque_size(seq, n) __atomic_fetch_add(&(seq)->size, n, __ATOMIC_RELAXED)
+#elif defined(__GNUC__)
+#define seq_deque_load(ptr, order) __sync_fetch_and_add(ptr, 0)
+#define seq_deque_store(ptr, val, order) (__sync_synchronize(), *(ptr) = (val), __sync_synchronize())
+#define seq_deque_fence() __sync_synchronize()
+#define seq_deque_cas(ptr, old, val) __sync_bool_compare_and_swap(ptr, old, val)
+#define seq_deque_size(seq, n) __sync_fetch_and_add(&(seq)->size, n)
+#else
+#define seq_deque_load(ptr, order) (*(ptr))
+#define seq_deque_store(ptr, val, order) (*(ptr) = (val))
+#define seq_deque_fence()
+#define seq_deque_cas(ptr, old, val) (*(ptr) == (old) ? (*(ptr) = (val), 1) : 0)
+#define seq_deque_size(seq, n) ((seq)->size += (n))
+#endif
+
+SEQ_TYPE_API(deque)
+
+/* ========================================================================== Private Deque Helpers
+ * seq_deque_buf_create
+ *    Allocates a buffer for the given (power of two) number of elements.
+ *
+ * seq_deque_grow
+ *    Replaces the buffer with one twice its size, retiring the old one; only the owner may call it.
+ *
+ * seq_deque_push
+ *    Adds the data at the bottom; only the owner may call it.
+ *
+ * seq_deque_pop
+ *    Takes the data at the bottom, or returns NULL; only the owner may call it.
+ *
+ * seq_deque_steal
+ *    Takes the data at the top, or returns NULL; any thread may call it.
+ * ============================================================================================= */
+
+static seq_deque_buf_t seq_deque_buf_create(seq_index_t capacity) {
+	seq_deque_buf_t buf = (seq_deque_buf_t)(malloc(
+		sizeof(struct _seq_deque_buf_t) + ((seq_size_t)(capacity) - 1) * sizeof(seq_data_t)
+	));
+
+	if(buf) {
+		buf->mask = capacity - 1;
+		buf->retired = NULL;
+	}
+
+	return buf;
+}
+
+static seq_opt_t seq_deque_grow(seq_deque_data_t data, seq_index_t top, seq_index_t bottom) {
+	seq_deque_buf_t buf = seq_deque_buf_create((data->buf->mask + 1) * 2);
+	seq_index_t i;
+
+	if(!buf) return SEQ_ERR_MEM;
+
+	for(i = top; i < bottom; i++) {
+		seq_deque_store(
+			seq_deque_elem(buf, i),
+			seq_deque_load(seq_deque_elem(data->buf, i), RELAXED),
+			RELAXED
+		);
+	}
+
+	buf->retired = data->buf;
+
+	seq_deque_store(&data->buf, buf, RELEASE);
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_opt_t seq_deque_push(seq_t seq, seq_data_t d) {
+	seq_deque_data_t data = seq_deque_data(seq);
+	seq_index_t bottom = seq_deque_load(&data->bottom, RELAXED);
+	seq_index_t top = seq_deque_load(&data->top, ACQUIRE);
+
+	if(bottom - top > data->buf->mask && seq_deque_grow(data, top, bottom)) return SEQ_ERR_MEM;
+
+	seq_deque_store(seq_deque_elem(data->buf, bottom), d, RELAXED);
+	seq_deque_size(seq, 1);
+
+	/* Publishes the element (and the size counting it) before the new bottom, so a thief can never
+	 * take it out of the size first; nothing else is needed on the fast path. */
+	seq_deque_store(&data->bottom, bottom + 1, RELEASE);
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_data_t seq_deque_pop(seq_t seq) {
+	seq_deque_data_t data = seq_deque_data(seq);
+	seq_index_t bottom = seq_deque_load(&data->bottom, RELAXED) - 1;
+	seq_deque_buf_t buf = data->buf;
+	seq_data_t d = NULL;
+	seq_index_t top;
+
+	/* Claiming the bottom element first means thieves can only race us for the very last one. */
+	seq_deque_store(&data->bottom, bottom, RELAXED);
+	seq_deque_fence();
+
+	top = seq_deque_load(&data->top, RELAXED);
+
+	if(top <= bottom) {
+		d = seq_deque_load(seq_deque_elem(buf, bottom), RELAXED);
+
+		if(top == bottom) {
+			if(!seq_deque_cas(&data->top, top, top + 1)) d = NULL;
+
+			seq_deque_store(&data->bottom, bottom + 1, RELAXED);
+		}
+	}
+
+	else seq_deque_store(&data->bottom, bottom + 1, RELAXED);
+
+	if(d) seq_deque_size(seq, (seq_size_t)(-1));
+
+	return d;
+}
+
+/* Losing the CAS to another thread means there was something to take, so it's simply retried. */
+static seq_data_t seq_deque_steal(seq_t seq) {
+	seq_deque_data_t data = seq_deque_data(seq);
+
+	for(;;) {
+		seq_index_t top = seq_deque_load(&data->top, ACQUIRE);
+		seq_index_t bottom;
+		seq_deque_buf_t buf;
+		seq_data_t d;
+
+		seq_deque_fence();
+
+		bottom = seq_deque_load(&data->bottom, ACQUIRE);
+
+		if(top >= bottom) return NULL;
+
+		buf = seq_deque_load(&data->buf, ACQUIRE);
+		d = seq_deque_load(seq_deque_elem(buf, top), RELAXED);
+
+		if(seq_deque_cas(&data->top, top, top + 1)) {
+			seq_deque_size(seq, (seq_size_t)(-1));
+
+			return d;
+		}
+	}
+}
+
+/* ======================================================================= SEQ_DEQUE Implementation
+ * seq_deque_create
+ * seq_deque_destroy
+ * seq_deque_config
+ * seq_deque_add
+ * seq_deque_remove
+ * seq_deque_get
+ * seq_deque_set
+ * ============================================================================================= */
+
+static void seq_deque_create(seq_t seq) {
+	seq_deque_data_t data = seq_malloc(seq_deque_data_t);
+
+	seq->type = SEQ_DEQUE;
+	seq->impl = seq_impl_deque();
+
+	if(data && !(data->buf = seq_deque_buf_create(SEQ_DEQUE_CAPACITY))) {
+		free(data);
+
+		data = NULL;
+	}
+
+	seq->data = data;
+}
+
+static void seq_deque_destroy(seq_t seq) {
+	seq_deque_data_t data = seq_deque_data(seq);
+	seq_deque_buf_t buf = data->buf;
+	seq_index_t i;
+
+	if(seq->cb.remove) {
+		for(i = data->top; i < data->bottom; i++) seq_cb_remove(seq, *seq_deque_elem(buf, i));
+	}
+
+	while(buf) {
+		seq_deque_buf_t retired = buf->retired;
+
+		free(buf);
+
+		buf = retired;
+	}
+
+	free(data);
+}
+
+static seq_opt_t seq_deque_config(seq_t seq, seq_opt_t opt, seq_args_t args) {
+	return SEQ_ERR_OPT;
+}
+
+static seq_opt_t seq_deque_add(seq_t seq, seq_args_t args) {
+	seq_opt_t add = seq_arg_opt(args);
+	seq_data_t d = NULL;
+
+	if(add != SEQ_PUSH && add != SEQ_APPEND) return SEQ_ERR_OPT;
+
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+	return seq_deque_push(seq, d);
+}
+
+static seq_opt_t seq_deque_remove(seq_t seq, seq_args_t args) {
+	seq_opt_t opt = seq_arg_opt(args);
+	seq_data_t d = NULL;
+
+	if(opt == SEQ_POP) d = seq_deque_pop(seq);
+
+	else if(opt == SEQ_STEAL) d = seq_deque_steal(seq);
+
+	else return SEQ_ERR_OPT;
+
+	if(!d) return SEQ_ERR_NODE;
+
+	seq_cb_remove(seq, d);
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_data_t seq_deque_get(seq_t seq, seq_args_t args) {
+	seq_opt_t opt = seq_arg_opt(args);
+
+	if(opt == SEQ_POP) return seq_deque_pop(seq);
+
+	else if(opt == SEQ_STEAL) return seq_deque_steal(seq);
+
+	return NULL;
+}
+
+static seq_opt_t seq_deque_set(seq_t seq, seq_args_t args) {
+	return SEQ_ERR_OPT;
+}
+
+/* ============================================================= SEQ_DEQUE Iteration Implementation
+ * seq_deque_iter_create
+ * seq_deque_iter_destroy
+ * seq_deque_iter_get
+ * seq_deque_iter_set
+ * seq_deque_iter_iterate
+ * seq_deque_iter_copy
+ * ============================================================================================= */
+
+static seq_opt_t seq_deque_iter_create(seq_iter_t iter, seq_args_t args) {
+	seq_deque_iter_data_t data = seq_malloc(seq_deque_iter_data_t);
+
+	if(!(iter->data = data)) return SEQ_ERR_MEM;
+
+	if(seq_arg_opt(args)) return SEQ_ERR_OPT;
+
+	return SEQ_ERR_NONE;
+}
+
+static void seq_deque_iter_destroy(seq_iter_t iter) {
+}
+
+static seq_data_t seq_deque_iter_get(seq_iter_t iter, seq_args_t args) {
+	seq_deque_iter_data_t data = seq_deque_iter_data(iter);
+
+	if(seq_arg_opt(args) == SEQ_DATA) {
+		return *seq_deque_elem(seq_deque_data(iter->seq)->buf, data->index);
+	}
+
+	return NULL;
+}
+
+static seq_opt_t seq_deque_iter_set(seq_iter_t iter, seq_args_t args) {
+	return SEQ_ERR_OPT;
+}
+
+static seq_opt_t seq_deque_iter_iterate(seq_iter_t iter) {
+	seq_deque_iter_data_t data = seq_deque_iter_data(iter);
+	seq_deque_data_t deque = seq_deque_data(iter->seq);
+
+	if(iter->state == SEQ_READY) data->index = deque->top;
+
+	else data->index++;
+
+	if(data->index >= deque->bottom) return SEQ_STOP;
+
+	return SEQ_ACTIVE;
+}
+
+static seq_opt_t seq_deque_iter_copy(seq_iter_t iter, seq_iter_t src) {
+	seq_deque_iter_data_t data = seq_malloc(seq_deque_iter_data_t);
+
+	if(!(iter->data = data)) return SEQ_ERR_MEM;
+
+	*data = *seq_deque_iter_data(src);
+
+	return SEQ_ERR_NONE;
+}
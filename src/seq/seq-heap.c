@@ -0,0 +1,419 @@
+#include "seq-api.h"
+
+/* ======================================================================== Types, Constants, Enums
+ * struct _seq_heap_data_t
+ * struct _seq_heap_iter_data_t
+ * seq_heap_data
+ * seq_heap_iter_data
+ * SEQ_TYPE_API(heap)
+ * --------------------------------------------------------------------------------------------- */
+
+typedef struct _seq_heap_data_t* seq_heap_data_t;
+typedef struct _seq_heap_iter_data_t* seq_heap_iter_data_t;
+
+/* A SEQ_HEAP is an implicit 4-ary heap: the children of the element at index i are found at
+ * (4 * i) + 1 through (4 * i) + 4. Compared to a binary heap it's half as deep, and all of the
+ * children compared while sifting down share a cache line. The dirty flag is set while elements
+ * added with SEQ_APPEND (or a change of the seq_cb_cmp_t callback) still await a rebuild. */
+#define SEQ_HEAP_ARITY 4
+
+struct _seq_heap_data_t {
+	seq_data_t* buf;
+	seq_size_t capacity;
+	int dirty;
+
+	struct {
+		int enabled;
+		seq_size_t offset;
+	} intrusive;
+};
+
+struct _seq_heap_iter_data_t {
+	seq_size_t index;
+	seq_size_t inc;
+
+	struct {
+		seq_size_t begin;
+		seq_size_t end;
+	} range;
+};
+
+#define seq_heap_data(seq) ((seq_heap_data_t)(seq->data))
+#define seq_heap_iter_data(iter) ((seq_heap_iter_data_t)(iter->data))
+#define seq_heap_pos(data, d) ((seq_size_t*)((char*)(d) + (data)->intrusive.offset))
+#define seq_heap_less(seq, lhs, rhs) (seq_cb_cmp(seq, lhs, rhs) == SEQ_LESS)
+
+SEQ_TYPE_API(heap)
+
+/* =========================================================================== Private Heap Helpers
+ * seq_heap_index
+ *    Convert user-specified index into an absolute index, or -1 on error.
+ *
+ * seq_heap_place
+ *    Stores the data at the given index, updating its position (if intrusive).
+ *
+ * seq_heap_sift_up
+ *    Moves the element at the given index up towards the top, until its parent doesn't compare
+ *    greater than it.
+ *
+ * seq_heap_sift_down
+ *    Moves the element at the given index down towards the bottom, until none of its children
+ *    compare less than it.
+ *
+ * seq_heap_sift
+ *    Restores the heap order around an element whose priority may have changed either way.
+ *
+ * seq_heap_ready
+ *    Rebuilds a dirty heap in O(n), returning 0 if it can't be ordered (for lack of a callback).
+ *
+ * seq_heap_find
+ *    Returns the index of the element bound to the given data, or -1.
+ *
+ * seq_heap_get_index
+ *    Returns the index corresponding to the given user-specified args, or -1.
+ *
+ * seq_heap_take
+ *    Detaches the element at the given index, filling the hole with the last element.
+ * ============================================================================================= */
+
+static seq_index_t seq_heap_index(seq_t seq, seq_index_t index) {
+	index = index < 0 ? (seq_index_t)(seq->size) + index : index;
+
+	if(index >= (seq_index_t)(seq->size) || index < 0) return -1;
+
+	return index;
+}
+
+static void seq_heap_place(seq_heap_data_t data, seq_size_t index, seq_data_t d) {
+	data->buf[index] = d;
+
+	if(data->intrusive.enabled) *seq_heap_pos(data, d) = index;
+}
+
+/* Both sifts move a "hole" rather than swapping, so each step costs a single store. */
+static seq_size_t seq_heap_sift_up(seq_t seq, seq_size_t index) {
+	seq_heap_data_t data = seq_heap_data(seq);
+	seq_data_t d = data->buf[index];
+
+	while(index) {
+		seq_size_t parent = (index - 1) / SEQ_HEAP_ARITY;
+
+		if(!seq_heap_less(seq, d, data->buf[parent])) break;
+
+		seq_heap_place(data, index, data->buf[parent]);
+
+		index = parent;
+	}
+
+	seq_heap_place(data, index, d);
+
+	return index;
+}
+
+static void seq_heap_sift_down(seq_t seq, seq_size_t index) {
+	seq_heap_data_t data = seq_heap_data(seq);
+	seq_data_t d = data->buf[index];
+
+	for(;;) {
+		seq_size_t first = (index * SEQ_HEAP_ARITY) + 1;
+		seq_size_t last = first + SEQ_HEAP_ARITY;
+		seq_size_t child;
+		seq_size_t i;
+
+		if(first >= seq->size) break;
+
+		if(last > seq->size) last = seq->size;
+
+		for(child = first, i = first + 1; i < last; i++) {
+			if(seq_heap_less(seq, data->buf[i], data->buf[child])) child = i;
+		}
+
+		if(!seq_heap_less(seq, data->buf[child], d)) break;
+
+		seq_heap_place(data, index, data->buf[child]);
+
+		index = child;
+	}
+
+	seq_heap_place(data, index, d);
+}
+
+static void seq_heap_sift(seq_t seq, seq_size_t index) {
+	if(seq_heap_data(seq)->dirty) return;
+
+	if(seq_heap_sift_up(seq, index) == index) seq_heap_sift_down(seq, index);
+}
+
+static int seq_heap_ready(seq_t seq) {
+	seq_heap_data_t data = seq_heap_data(seq);
+	seq_size_t i;
+
+	if(!data->dirty) return 1;
+
+	if(!seq->cb.cmp) return 0;
+
+	/* Sifting down every element that has children, from the bottom up, is Floyd's method. */
+	if(seq->size > 1) {
+		for(i = ((seq->size - 2) / SEQ_HEAP_ARITY) + 1; i--;) seq_heap_sift_down(seq, i);
+	}
+
+	data->dirty = 0;
+
+	return 1;
+}
+
+static seq_index_t seq_heap_find(seq_t seq, seq_data_t d) {
+	seq_heap_data_t data = seq_heap_data(seq);
+	seq_size_t i;
+
+	if(!d) return -1;
+
+	/* Intrusive elements know where they are; we only need to make sure it's true. */
+	if(data->intrusive.enabled) {
+		i = *seq_heap_pos(data, d);
+
+		return i < seq->size && data->buf[i] == d ? (seq_index_t)(i) : -1;
+	}
+
+	for(i = 0; i < seq->size; i++) {
+		if(data->buf[i] == d) return (seq_index_t)(i);
+	}
+
+	return -1;
+}
+
+static seq_index_t seq_heap_get_index(seq_t seq, seq_opt_t opt, seq_args_t args) {
+	if(opt == SEQ_INDEX) return seq_heap_index(seq, seq_arg_index(args));
+
+	else if(opt == SEQ_DATA) return seq_heap_find(seq, seq_arg_data(args));
+
+	else if(opt == SEQ_POP || opt == SEQ_RECV || opt == SEQ_PEEK) {
+		if(!seq->size || !seq_heap_ready(seq)) return -1;
+
+		return 0;
+	}
+
+	return -1;
+}
+
+static seq_data_t seq_heap_take(seq_t seq, seq_size_t index) {
+	seq_heap_data_t data = seq_heap_data(seq);
+	seq_data_t d = data->buf[index];
+
+	seq->size--;
+
+	if(index < seq->size) {
+		seq_heap_place(data, index, data->buf[seq->size]);
+		seq_heap_sift(seq, index);
+	}
+
+	return d;
+}
+
+/* ======================================================================== SEQ_HEAP Implementation
+ * seq_heap_create
+ * seq_heap_destroy
+ * seq_heap_config
+ * seq_heap_add
+ * seq_heap_remove
+ * seq_heap_get
+ * seq_heap_set
+ * ============================================================================================= */
+
+static void seq_heap_create(seq_t seq) {
+	seq->type = SEQ_HEAP;
+	seq->impl = seq_impl_heap();
+	seq->data = seq_malloc(seq_heap_data_t);
+}
+
+static void seq_heap_destroy(seq_t seq) {
+	seq_heap_data_t data = seq_heap_data(seq);
+	seq_size_t i;
+
+	if(seq->cb.remove) {
+		for(i = 0; i < seq->size; i++) seq_cb_remove(seq, data->buf[i]);
+	}
+
+	free(data->buf);
+	free(data);
+}
+
+static seq_opt_t seq_heap_config(seq_t seq, seq_opt_t opt, seq_args_t args) {
+	seq_heap_data_t data = seq_heap_data(seq);
+	seq_size_t i;
+
+	/* Any existing elements are simply told where they are. */
+	if(opt == SEQ_INTRUSIVE) {
+		data->intrusive.enabled = 1;
+		data->intrusive.offset = seq_arg(args, seq_size_t);
+
+		for(i = 0; i < seq->size; i++) seq_heap_place(data, i, data->buf[i]);
+	}
+
+	/* The seq_cb_cmp_t callback itself is stored by seq_config(), once this succeeds; the heap
+	 * is then rebuilt when it's next needed. */
+	else if(opt == SEQ_CB_CMP) data->dirty = seq->size > 1;
+
+	else return SEQ_ERR_OPT;
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_opt_t seq_heap_add(seq_t seq, seq_args_t args) {
+	seq_heap_data_t data = seq_heap_data(seq);
+	seq_opt_t add = seq_arg_opt(args);
+	seq_data_t d = NULL;
+
+	if(add != SEQ_PUSH && add != SEQ_APPEND) return SEQ_ERR_OPT;
+
+	if(add == SEQ_PUSH && !seq->cb.cmp) return SEQ_ERR_CB;
+
+	if(seq->size == data->capacity) {
+		seq_size_t capacity = data->capacity ? data->capacity * 2 : 16;
+		seq_data_t* buf = (seq_data_t*)(realloc(data->buf, capacity * sizeof(seq_data_t)));
+
+		if(!buf) return SEQ_ERR_MEM;
+
+		data->buf = buf;
+		data->capacity = capacity;
+	}
+
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+	seq_heap_place(data, seq->size, d);
+
+	seq->size++;
+
+	if(add == SEQ_APPEND) data->dirty = seq->size > 1 || data->dirty;
+
+	else seq_heap_sift(seq, seq->size - 1);
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_opt_t seq_heap_remove(seq_t seq, seq_args_t args) {
+	seq_index_t index = seq_heap_get_index(seq, seq_arg_opt(args), args);
+
+	if(index < 0) return SEQ_ERR_NODE;
+
+	seq_cb_remove(seq, seq_heap_take(seq, (seq_size_t)(index)));
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_data_t seq_heap_get(seq_t seq, seq_args_t args) {
+	seq_opt_t opt = seq_arg_opt(args);
+	seq_index_t index = seq_heap_get_index(seq, opt, args);
+
+	if(index < 0) return NULL;
+
+	if(opt == SEQ_POP || opt == SEQ_RECV) return seq_heap_take(seq, (seq_size_t)(index));
+
+	return seq_heap_data(seq)->buf[index];
+}
+
+/* Replacing an element with itself (after changing its priority) only restores the heap order. */
+static seq_opt_t seq_heap_set(seq_t seq, seq_args_t args) {
+	seq_heap_data_t data = seq_heap_data(seq);
+	seq_opt_t opt = seq_arg_opt(args);
+	seq_index_t index = -1;
+	seq_data_t d = NULL;
+
+	if(opt == SEQ_POP || opt == SEQ_RECV) return SEQ_ERR_OPT;
+
+	if((index = seq_heap_get_index(seq, opt, args)) < 0) return SEQ_ERR_NODE;
+
+	if(!seq->cb.cmp) return SEQ_ERR_CB;
+
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+	if(d != data->buf[index]) seq_cb_remove(seq, data->buf[index]);
+
+	seq_heap_place(data, (seq_size_t)(index), d);
+	seq_heap_sift(seq, (seq_size_t)(index));
+
+	return SEQ_ERR_NONE;
+}
+
+/* ============================================================== SEQ_HEAP Iteration Implementation
+ * seq_heap_iter_create
+ * seq_heap_iter_destroy
+ * seq_heap_iter_get
+ * seq_heap_iter_set
+ * seq_heap_iter_iterate
+ * seq_heap_iter_copy
+ * ============================================================================================= */
+
+static seq_opt_t seq_heap_iter_create(seq_iter_t iter, seq_args_t args) {
+	seq_heap_iter_data_t data = seq_malloc(seq_heap_iter_data_t);
+	seq_index_t begin = 0;
+	seq_index_t end = -1;
+	seq_opt_t opt;
+
+	if(!(iter->data = data)) return SEQ_ERR_MEM;
+
+	data->inc = 1;
+
+	while((opt = seq_arg_opt(args))) {
+		if(opt == SEQ_RANGE) {
+			begin = seq_arg_index(args);
+			end = seq_arg_index(args);
+		}
+
+		else if(opt == SEQ_INC) data->inc = seq_arg(args, seq_size_t);
+
+		else return SEQ_ERR_OPT;
+	}
+
+	if(!data->inc) return SEQ_ERR_OPT;
+
+	begin = seq_heap_index(iter->seq, begin);
+	end = seq_heap_index(iter->seq, end);
+
+	if(begin < 0 || end < begin) iter->state = SEQ_STOP;
+
+	else {
+		data->range.begin = (seq_size_t)(begin);
+		data->range.end = (seq_size_t)(end);
+	}
+
+	return SEQ_ERR_NONE;
+}
+
+static void seq_heap_iter_destroy(seq_iter_t iter) {
+}
+
+static seq_data_t seq_heap_iter_get(seq_iter_t iter, seq_args_t args) {
+	seq_heap_iter_data_t data = seq_heap_iter_data(iter);
+
+	if(seq_arg_opt(args) == SEQ_DATA) return seq_heap_data(iter->seq)->buf[data->index];
+
+	return NULL;
+}
+
+/* Replacing an element could move it (or others) past the iterator's position. */
+static seq_opt_t seq_heap_iter_set(seq_iter_t iter, seq_args_t args) {
+	return SEQ_ERR_OPT;
+}
+
+static seq_opt_t seq_heap_iter_iterate(seq_iter_t iter) {
+	seq_heap_iter_data_t data = seq_heap_iter_data(iter);
+
+	if(iter->state == SEQ_READY) data->index = data->range.begin;
+
+	else data->index += data->inc;
+
+	if(data->index > data->range.end || data->index >= iter->seq->size) return SEQ_STOP;
+
+	return SEQ_ACTIVE;
+}
+
+static seq_opt_t seq_heap_iter_copy(seq_iter_t iter, seq_iter_t src) {
+	seq_heap_iter_data_t data = seq_malloc(seq_heap_iter_data_t);
+
+	if(!(iter->data = data)) return SEQ_ERR_MEM;
+
+	*data = *seq_heap_iter_data(src);
+
+	return SEQ_ERR_NONE;
+}
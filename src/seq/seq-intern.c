@@ -0,0 +1,235 @@
+#include "seq-api.h"
+
+#include <string.h>
+
+/* ======================================================================== Types, Constants, Enums
+ * struct _seq_intern_key_t
+ * struct _seq_intern_block_t
+ * struct _seq_intern_t
+ * SEQ_INTERN_BLOCK
+ * SEQ_INTERN_BLOCK_MAX
+ * SEQ_INTERN_SLOTS
+ * --------------------------------------------------------------------------------------------- */
+
+typedef struct _seq_intern_key_t* seq_intern_key_t;
+typedef struct _seq_intern_block_t* seq_intern_block_t;
+
+/* Every interned key is stored in the arena right after its length and hash, so that neither ever
+ * needs to be computed again; entries are padded to keep the next header aligned. */
+struct _seq_intern_key_t {
+	seq_size_t len;
+	uint32_t hash;
+};
+
+struct _seq_intern_block_t {
+	seq_intern_block_t next;
+	seq_size_t used;
+	seq_size_t size;
+};
+
+/* The arena is a list of blocks, each twice the size of the previous one (up to a limit), with the
+ * newest one first; keys are only ever appended to it. The @table is an open-addressing hash table
+ * (using linear probing) of pointers to the keys, which is never more than half full. */
+struct _seq_intern_t {
+	seq_intern_block_t blocks;
+	const char** table;
+	seq_size_t mask;
+	seq_size_t count;
+};
+
+#define SEQ_INTERN_BLOCK 4096
+#define SEQ_INTERN_BLOCK_MAX (1024 * 1024)
+#define SEQ_INTERN_SLOTS 64
+
+#define seq_intern_key(key) ((seq_intern_key_t)(key) - 1)
+
+/* ========================================================================= Private Intern Helpers
+ * seq_intern_hash
+ *    Returns the (32-bit FNV-1a) hash of a key, storing its length in @len.
+ *
+ * seq_intern_slot
+ *    Returns the slot of the table holding the given key, or the empty slot where it would go.
+ *
+ * seq_intern_grow
+ *    Doubles the size of the table.
+ *
+ * seq_intern_alloc
+ *    Reserves room for an entry of the given size in the arena, adding a block if needed.
+ * ============================================================================================= */
+
+static uint32_t seq_intern_hash(const char* key, seq_size_t* len) {
+	const unsigned char* c = (const unsigned char*)(key);
+	uint32_t hash = 2166136261UL;
+
+	for(; *c; c++) hash = (hash ^ *c) * 16777619UL;
+
+	*len = (seq_size_t)(c - (const unsigned char*)(key));
+
+	return hash;
+}
+
+static const char** seq_intern_slot(
+	seq_intern_t intern,
+	const char* key,
+	seq_size_t len,
+	uint32_t hash
+) {
+	seq_size_t i = hash & intern->mask;
+	seq_intern_key_t k = NULL;
+
+	for(; intern->table[i]; i = (i + 1) & intern->mask) {
+		k = seq_intern_key(intern->table[i]);
+
+		if(k->hash == hash && k->len == len && !memcmp(intern->table[i], key, len)) break;
+	}
+
+	return &intern->table[i];
+}
+
+static seq_opt_t seq_intern_grow(seq_intern_t intern) {
+	seq_size_t size = (intern->mask + 1) * 2;
+	const char** table = (const char**)(calloc(size, sizeof(const char*)));
+	const char** old = intern->table;
+	seq_size_t i;
+	seq_size_t j;
+
+	if(!table) return SEQ_ERR_MEM;
+
+	for(i = 0; i <= intern->mask; i++) {
+		if(!old[i]) continue;
+
+		for(j = seq_intern_key(old[i])->hash & (size - 1); table[j]; j = (j + 1) & (size - 1));
+
+		table[j] = old[i];
+	}
+
+	free(old);
+
+	intern->table = table;
+	intern->mask = size - 1;
+
+	return SEQ_ERR_NONE;
+}
+
+static char* seq_intern_alloc(seq_intern_t intern, seq_size_t size) {
+	seq_intern_block_t block = intern->blocks;
+	seq_size_t next = SEQ_INTERN_BLOCK;
+	char* data = NULL;
+
+	if(!block || block->size - block->used < size) {
+		if(block) next = block->size * 2;
+
+		if(next > SEQ_INTERN_BLOCK_MAX) next = SEQ_INTERN_BLOCK_MAX;
+
+		if(next < size) next = size;
+
+		if(!(block = (seq_intern_block_t)(malloc(sizeof(struct _seq_intern_block_t) + next)))) {
+			return NULL;
+		}
+
+		block->next = intern->blocks;
+		block->used = 0;
+		block->size = next;
+
+		intern->blocks = block;
+	}
+
+	data = (char*)(block + 1) + block->used;
+
+	block->used += size;
+
+	return data;
+}
+
+/* =============================================================================== Internal Intern
+ * seq_intern_config
+ * seq_intern
+ * seq_intern_find
+ * seq_intern_len
+ * ============================================================================================= */
+
+/* Disabling interning frees the whole arena at once; whoever still holds interned keys must not
+ * use them anymore. */
+seq_opt_t seq_intern_config(seq_t seq, int enabled) {
+	seq_intern_t intern = seq->intern;
+	seq_intern_block_t block = NULL;
+
+	if(enabled) {
+		if(intern) return SEQ_ERR_NONE;
+
+		if(!(intern = seq_malloc(seq_intern_t))) return SEQ_ERR_MEM;
+
+		if(!(intern->table = (const char**)(calloc(SEQ_INTERN_SLOTS, sizeof(const char*))))) {
+			free(intern);
+
+			return SEQ_ERR_MEM;
+		}
+
+		intern->mask = SEQ_INTERN_SLOTS - 1;
+
+		seq->intern = intern;
+
+		return SEQ_ERR_NONE;
+	}
+
+	if(!intern) return SEQ_ERR_NONE;
+
+	while((block = intern->blocks)) {
+		intern->blocks = block->next;
+
+		free(block);
+	}
+
+	free(intern->table);
+	free(intern);
+
+	seq->intern = NULL;
+
+	return SEQ_ERR_NONE;
+}
+
+const char* seq_intern(seq_t seq, const char* key) {
+	seq_intern_t intern = seq->intern;
+	seq_intern_key_t k = NULL;
+	const char** slot = NULL;
+	seq_size_t len;
+	seq_size_t size;
+	uint32_t hash = seq_intern_hash(key, &len);
+
+	if(*(slot = seq_intern_slot(intern, key, len, hash))) return *slot;
+
+	/* The table is grown ahead of time, so that the slot found above stays valid (or is found
+	 * again) whether or not the arena can hold the key. */
+	if((intern->count + 1) * 2 > intern->mask + 1) {
+		if(seq_intern_grow(intern)) return NULL;
+
+		slot = seq_intern_slot(intern, key, len, hash);
+	}
+
+	size = sizeof(struct _seq_intern_key_t) + len + 1;
+	size = (size + sizeof(seq_size_t) - 1) & ~(sizeof(seq_size_t) - 1);
+
+	if(!(k = (seq_intern_key_t)(seq_intern_alloc(intern, size)))) return NULL;
+
+	k->len = len;
+	k->hash = hash;
+
+	memcpy(k + 1, key, len + 1);
+
+	*slot = (const char*)(k + 1);
+
+	intern->count++;
+
+	return *slot;
+}
+
+const char* seq_intern_find(seq_t seq, const char* key) {
+	seq_size_t len;
+	uint32_t hash = seq_intern_hash(key, &len);
+
+	return *seq_intern_slot(seq->intern, key, len, hash);
+}
+
+seq_size_t seq_intern_len(const char* key) {
+	return seq_intern_key(key)->len;
+}
@@ -1,7 +1,10 @@
 #include "seq-api.h"
 
+#include <string.h>
+
 /* ======================================================================== Types, Constants, Enums
  * struct _seq_list_node_t
+ * struct _seq_list_skip_t
  * struct _seq_list_data_t
  * struct _seq_list_iter_data_t
  * seq_list_data
@@ -10,22 +13,61 @@
  * --------------------------------------------------------------------------------------------- */
 
 typedef struct _seq_list_node_t* seq_list_node_t;
+typedef struct _seq_list_skip_t* seq_list_skip_t;
 typedef struct _seq_list_data_t* seq_list_data_t;
 typedef struct _seq_list_iter_data_t* seq_list_iter_data_t;
 
+/* The list itself only ever deals with seq_list_link_t instances; a node is simply a link that
+ * the list allocated on its own, carrying the data alongside it. When SEQ_INTRUSIVE is enabled, the
+ * links are instead embedded in the user's objects and no seq_list_node_t is ever allocated. */
 struct _seq_list_node_t {
+	struct _seq_list_link_t link;
 	seq_data_t data;
-	seq_list_node_t next;
-	seq_list_node_t prev;
+};
+
+/* The nodes of a SEQ_SORTED list are indexed by a skip list, whose bottom level is simply the list
+ * itself. Each node carries a "tower" of forward pointers for the levels above that, of a random
+ * height (each level being 1/4 as likely as the one below it), allocated along with the node. */
+#define SEQ_LIST_SKIP_LEVELS 16
+
+struct _seq_list_skip_t {
+	struct _seq_list_node_t node;
+	seq_size_t levels;
+	seq_list_skip_t next[1];
 };
 
 struct _seq_list_data_t {
-	seq_list_node_t front;
-	seq_list_node_t back;
+	seq_list_link_t front;
+	seq_list_link_t back;
+
+	struct {
+		int enabled;
+		seq_size_t offset;
+	} intrusive;
+
+	struct {
+		int enabled;
+		seq_size_t levels;
+		uint32_t seed;
+		seq_list_skip_t head[SEQ_LIST_SKIP_LEVELS];
+	} sorted;
+
+	/* Compacting moves every node, in order, into the single block from @mem to @end; @live of
+	 * the @count nodes placed there remain, and a node within the block is never freed on its
+	 * own (the block goes once none are left). Beyond @threshold percent of the nodes being out
+	 * of place, the list compacts itself, but never while any of its @iters iterators are open. */
+	struct {
+		char* mem;
+		char* end;
+		seq_size_t count;
+		seq_size_t live;
+		seq_size_t iters;
+		int threshold;
+	} compact;
 };
 
 struct _seq_list_iter_data_t {
-	seq_list_node_t node;
+	seq_list_link_t link;
 	seq_size_t index;
 	seq_size_t inc;
 
@@ -35,13 +77,15 @@ struct _seq_list_iter_data_t {
 	} range;
 };
 
-typedef struct _seq_list_node_get_t {
-	seq_list_node_t node;
+typedef struct _seq_list_link_get_t {
+	seq_list_link_t link;
 	seq_size_t index;
-} seq_list_node_get_t;
+	seq_opt_t opt;
+} seq_list_link_get_t;
 
-#define seq_list_data(seq) (seq_list_data_t)(seq->data)
-#define seq_list_iter_data(iter) (seq_list_iter_data_t)(iter->data)
+#define seq_list_data(seq) ((seq_list_data_t)(seq->data))
+#define seq_list_iter_data(iter) ((seq_list_iter_data_t)(iter->data))
+#define seq_list_intrusive_link(data, d) (seq_list_link_t)((char*)(d) + (data)->intrusive.offset)
 
 SEQ_TYPE_API(list)
 
@@ -49,21 +93,68 @@ SEQ_TYPE_API(list)
  * seq_list_index
  *    Convert user-specified index into an absolute index, or -1 on error.
  *
- * seq_list_node_data
- *    Returns a seq_data_t value for the given user-specified args, calling a seq_cb_add_t
- *    callback (if set).
+ * seq_list_link_data
+ *    Returns the seq_data_t value bound to the given link, whether it belongs to a node or is
+ *    embedded in an intrusive object.
+ *
+ * seq_list_skip_create
+ *    Allocates a node for a SEQ_SORTED list, with a tower of random height.
+ *
+ * seq_list_skip_search
+ *    Returns the last link of a SEQ_SORTED list that compares less than the given data (or, if
+ *    upper is set, that doesn't compare greater), or NULL if there is none. If prev is given, it
+ *    receives the corresponding node on each level of the skip list.
+ *
+ * seq_list_node_size
+ *    Returns the size of the memory allocated for a node (including its tower, if any).
+ *
+ * seq_list_node_free
+ *    Frees a node, unless it's part of the compacted block.
+ *
+ * seq_list_link_create
+ *    Returns a new, unattached seq_list_link_t for the given user-specified args, calling a
+ *    seq_cb_add_t callback (if set).
+ *
+ * seq_list_link_release
+ *    Detaches the data from the link and frees the node (if the list owns one), returning the
+ *    data.
+ *
+ * seq_list_link_destroy
+ *    Releases the link, calling a seq_cb_remove_t callback (if set) on its data.
+ *
+ * seq_list_link_insert
+ *    Attaches a link immediately after another one (or at the front, if NULL).
+ *
+ * seq_list_link_remove
+ *    Detaches a link from its neighbors, leaving it unattached.
  *
- * seq_list_node_data_destroy
- *    Removes the data from the seq_list_node_t, calling a seq_cb_remove_t callback (if set).
+ * seq_list_skip_insert
+ *    Attaches a node to a SEQ_SORTED list at its ordered position.
  *
- * seq_list_node_destroy
- *    Calls seq_list_node_data_destroy, then subsequently destroys the node itself.
+ * seq_list_skip_remove
+ *    Detaches a node from every level of the skip list (but not from the list itself).
  *
- * seq_list_node_get_index
- *    Returns the seq_list_node_t corresponding to the given index.
+ * seq_list_link_claim
+ *    Takes ownership of an intrusive link, first moving it out of its current list (if any).
  *
- * seq_list_node_get
- *    Returns the seq_list_node_t corresponding to the given user-specified args.
+ * seq_list_link_get_index
+ *    Returns the seq_list_link_t corresponding to the given index.
+ *
+ * seq_list_link_get_data
+ *    Returns the seq_list_link_t bound to the given data.
+ *
+ * seq_list_link_get
+ *    Returns the seq_list_link_t corresponding to the given user-specified args; SEQ_RECV and
+ *    SEQ_POP both refer to the front of the list.
+ *
+ * seq_list_link_take
+ *    Detaches a link from the list entirely and releases it, returning its data.
+ *
+ * seq_list_compact
+ *    Moves every node into a new block, in order, freeing the old ones.
+ *
+ * seq_list_compact_auto
+ *    Compacts the list if enough of its nodes are out of place.
  * ============================================================================================= */
 
 static seq_index_t seq_list_index(seq_t seq, seq_index_t index) {
@@ -74,25 +165,272 @@ static seq_index_t seq_list_index(seq_t seq, seq_index_t index) {
 	return index;
 }
 
-static seq_data_t seq_list_node_data(seq_t seq, seq_args_t args) {
-	if(!seq->cb.add) return seq_arg_data(args);
+static seq_data_t seq_list_link_data(seq_t seq, seq_list_link_t link) {
+	seq_list_data_t data = seq_list_data(seq);
+
+	if(data->intrusive.enabled) return (seq_data_t)((char*)(link) - data->intrusive.offset);
+
+	return ((seq_list_node_t)(link))->data;
+}
+
+static seq_list_node_t seq_list_skip_create(seq_list_data_t data) {
+	seq_list_skip_t node = NULL;
+	seq_size_t levels = 0;
+	uint32_t r = data->sorted.seed;
+
+	/* A plain xorshift generator is more than random enough to balance the skip list. */
+	r ^= r << 13;
+	r ^= r >> 17;
+	r ^= r << 5;
+
+	data->sorted.seed = r;
+
+	while(!(r & 3) && levels < SEQ_LIST_SKIP_LEVELS) {
+		levels++;
+
+		r >>= 2;
+	}
+
+	node = (seq_list_skip_t)(calloc(
+		1,
+		sizeof(struct _seq_list_skip_t) + ((levels ? levels - 1 : 0) * sizeof(seq_list_skip_t))
+	));
+
+	if(!node) return NULL;
+
+	node->levels = levels;
+
+	return &node->node;
+}
+
+static seq_list_link_t seq_list_skip_search(
+	seq_t seq,
+	seq_data_t d,
+	int upper,
+	seq_list_skip_t* prev
+) {
+	seq_list_data_t data = seq_list_data(seq);
+	seq_list_skip_t node = NULL;
+	seq_list_skip_t next = NULL;
+	seq_list_link_t link = NULL;
+	seq_list_link_t nlink = NULL;
+	seq_size_t level = data->sorted.levels;
+	seq_size_t hops = 0;
+	seq_opt_t cmp;
+
+	while(level--) {
+		while((next = node ? node->next[level] : data->sorted.head[level])) {
+			cmp = seq_cb_cmp(seq, next->node.data, d);
+
+			if(cmp == SEQ_GREATER || (!upper && cmp == SEQ_EQUAL)) break;
+
+			node = next;
+			hops++;
+		}
+
+		if(prev) prev[level] = node;
+	}
+
+	/* The rest of the way (only a few links, on average) is covered by the list itself. */
+	link = node ? &node->node.link : NULL;
+
+	while((nlink = link ? link->next : data->front)) {
+		cmp = seq_cb_cmp(seq, ((seq_list_node_t)(nlink))->data, d);
 
-	else return seq->cb.add(args);
+		if(cmp == SEQ_GREATER || (!upper && cmp == SEQ_EQUAL)) break;
+
+		link = nlink;
+		hops++;
+	}
+
+	seq_stats_add(seq, hops, hops);
+
+	return link;
 }
 
-static void seq_list_node_data_destroy(seq_t seq, seq_list_node_t node) {
-	if(seq->cb.remove) seq->cb.remove(node->data);
+/* Every node of a SEQ_SORTED list is a seq_list_skip_t, whose tower is sized by its @levels. */
+static seq_size_t seq_list_node_size(seq_list_data_t data, seq_list_link_t link) {
+	seq_size_t levels = data->sorted.enabled ? ((seq_list_skip_t)(link))->levels : 0;
+
+	if(!data->sorted.enabled) return sizeof(struct _seq_list_node_t);
+
+	return sizeof(struct _seq_list_skip_t) + ((levels ? levels - 1 : 0) * sizeof(seq_list_skip_t));
 }
 
-static void seq_list_node_destroy(seq_t seq, seq_list_node_t node) {
-	seq_list_node_data_destroy(seq, node);
+static void seq_list_node_free(seq_t seq, seq_list_link_t link) {
+	seq_list_data_t data = seq_list_data(seq);
+
+	if((char*)(link) < data->compact.mem || (char*)(link) >= data->compact.end) free(link);
+
+	else if(!--data->compact.live) {
+		free(data->compact.mem);
+
+		data->compact.mem = NULL;
+		data->compact.end = NULL;
+		data->compact.count = 0;
+	}
 
-	free(node);
+	seq_stats_add(seq, nodes_free, 1);
 }
 
-static seq_list_node_t seq_list_node_get_index(seq_t seq, seq_index_t index) {
+static seq_list_link_t seq_list_link_create(seq_t seq, seq_args_t args, seq_opt_t* err) {
 	seq_list_data_t data = seq_list_data(seq);
 	seq_list_node_t node = NULL;
+	seq_data_t d = NULL;
+
+	if(data->intrusive.enabled) {
+		if(!(d = seq_cb_add(seq, args))) {
+			*err = SEQ_ERR_DATA;
+
+			return NULL;
+		}
+
+		return seq_list_intrusive_link(data, d);
+	}
+
+	if(data->sorted.enabled) node = seq_list_skip_create(data);
+
+	else node = seq_malloc(seq_list_node_t);
+
+	if(!node) {
+		*err = SEQ_ERR_MEM;
+
+		return NULL;
+	}
+
+	if(!(node->data = seq_cb_add(seq, args))) {
+		free(node);
+
+		*err = SEQ_ERR_DATA;
+
+		return NULL;
+	}
+
+	seq_stats_add(seq, nodes_alloc, 1);
+
+	return &node->link;
+}
+
+static seq_data_t seq_list_link_release(seq_t seq, seq_list_link_t link) {
+	seq_list_data_t data = seq_list_data(seq);
+	seq_data_t d = seq_list_link_data(seq, link);
+
+	/* The link must be cleared BEFORE the callback runs, since it may well free the object the
+	 * link is embedded in (or return it to a pool). */
+	if(data->intrusive.enabled) {
+		link->next = NULL;
+		link->prev = NULL;
+		link->seq = NULL;
+	}
+
+	else seq_list_node_free(seq, link);
+
+	return d;
+}
+
+static void seq_list_link_destroy(seq_t seq, seq_list_link_t link) {
+	seq_cb_remove(seq, seq_list_link_release(seq, link));
+}
+
+static void seq_list_link_insert(seq_list_data_t data, seq_list_link_t link, seq_list_link_t prev) {
+	link->prev = prev;
+	link->next = prev ? prev->next : data->front;
+
+	if(link->next) link->next->prev = link;
+
+	else data->back = link;
+
+	if(prev) prev->next = link;
+
+	else data->front = link;
+}
+
+static void seq_list_link_remove(seq_list_data_t data, seq_list_link_t link) {
+	if(link->prev) link->prev->next = link->next;
+
+	else data->front = link->next;
+
+	if(link->next) link->next->prev = link->prev;
+
+	else data->back = link->prev;
+
+	link->next = NULL;
+	link->prev = NULL;
+}
+
+static void seq_list_skip_insert(seq_t seq, seq_list_link_t link, int upper) {
+	seq_list_data_t data = seq_list_data(seq);
+	seq_list_skip_t node = (seq_list_skip_t)(link);
+	seq_list_skip_t prev[SEQ_LIST_SKIP_LEVELS];
+	seq_size_t level;
+
+	seq_list_link_insert(data, link, seq_list_skip_search(seq, node->node.data, upper, prev));
+
+	for(level = 0; level < node->levels; level++) {
+		seq_list_skip_t* next = NULL;
+
+		/* Levels the skip list didn't have yet start out at the head. */
+		if(level >= data->sorted.levels) prev[level] = NULL;
+
+		next = prev[level] ? &prev[level]->next[level] : &data->sorted.head[level];
+
+		node->next[level] = *next;
+
+		*next = node;
+	}
+
+	if(node->levels > data->sorted.levels) data->sorted.levels = node->levels;
+}
+
+static void seq_list_skip_remove(seq_t seq, seq_list_link_t link) {
+	seq_list_data_t data = seq_list_data(seq);
+	seq_list_skip_t node = (seq_list_skip_t)(link);
+	seq_list_skip_t prev = NULL;
+	seq_list_skip_t next = NULL;
+	seq_size_t level = data->sorted.levels;
+	seq_opt_t cmp;
+
+	/* Since several nodes may compare equal, the search stops short of all of them on the levels
+	 * the node doesn't reach, and only steps through them (until it finds the node itself) on the
+	 * levels it does. */
+	while(level--) {
+		while((next = prev ? prev->next[level] : data->sorted.head[level]) && next != node) {
+			cmp = seq_cb_cmp(seq, next->node.data, node->node.data);
+
+			if(cmp == SEQ_GREATER || (cmp == SEQ_EQUAL && level >= node->levels)) break;
+
+			prev = next;
+		}
+
+		if(level < node->levels) {
+			if(prev) prev->next[level] = node->next[level];
+
+			else data->sorted.head[level] = node->next[level];
+		}
+	}
+
+	while(data->sorted.levels && !data->sorted.head[data->sorted.levels - 1]) {
+		data->sorted.levels--;
+	}
+}
+
+static void seq_list_link_claim(seq_t seq, seq_list_link_t link) {
+	seq_list_data_t data = seq_list_data(seq);
+
+	if(!data->intrusive.enabled) return;
+
+	if(link->seq) {
+		seq_list_link_remove(seq_list_data(link->seq), link);
+
+		link->seq->size--;
+	}
+
+	link->seq = seq;
+}
+
+static seq_list_link_t seq_list_link_get_index(seq_t seq, seq_index_t index) {
+	seq_list_data_t data = seq_list_data(seq);
+	seq_list_link_t link = NULL;
 	seq_size_t i;
 	seq_size_t n;
 
@@ -103,38 +441,203 @@ static seq_list_node_t seq_list_node_get_index(seq_t seq, seq_index_t index) {
 
 		/* If the index is PAST the middle of the list, work backwards. */
 		if(i > seq->size / 2) {
-			node = data->back;
+			link = data->back;
+
+			for(n = 1; n < seq->size - index; n++) link = link->prev;
 
-			for(n = 1; n < seq->size - index; n++) node = node->prev;
+			seq_stats_add(seq, hops, n - 1);
 		}
 
 		/* Otherwise, start from the front. */
 		else {
-			node = data->front;
+			link = data->front;
+
+			for(n = 0; n < i; n++) link = link->next;
+
+			seq_stats_add(seq, hops, n);
+		}
+	}
+
+	return link;
+}
+
+static seq_list_link_t seq_list_link_get_data(seq_t seq, seq_data_t d, seq_size_t* index) {
+	seq_list_data_t data = seq_list_data(seq);
+	seq_list_link_t link = NULL;
+
+	if(!d) return NULL;
+
+	/* Intrusive objects know where their link is; we only need to make sure it's ours. */
+	if(data->intrusive.enabled) {
+		link = seq_list_intrusive_link(data, d);
+
+		return link->seq == seq ? link : NULL;
+	}
 
-			for(n = 0; n < i; n++) node = node->next;
+	/* In a sorted list, the data can only be among the nodes that compare equal to it. */
+	if(data->sorted.enabled) {
+		link = seq_list_skip_search(seq, d, 0, NULL);
+
+		for(link = link ? link->next : data->front; link; link = link->next) {
+			seq_data_t e = ((seq_list_node_t)(link))->data;
+
+			if(e == d) return link;
+
+			if(seq_cb_cmp(seq, e, d) != SEQ_EQUAL) break;
 		}
+
+		return NULL;
 	}
 
-	return node;
+	for(link = data->front, *index = 0; link; link = link->next, (*index)++) {
+		if(((seq_list_node_t)(link))->data == d) break;
+	}
+
+	seq_stats_add(seq, hops, *index);
+
+	return link;
 }
 
-static seq_list_node_get_t seq_list_node_get(seq_t seq, seq_args_t args) {
-	seq_list_node_get_t get;
+static seq_list_link_get_t seq_list_link_get(seq_t seq, seq_args_t args) {
+	seq_list_link_get_t get;
 	seq_opt_t opt = seq_arg_opt(args);
-	seq_size_t index = seq_arg_index(args);
 
-	if(seq_opt(opt, SEQ_GET) && opt == SEQ_INDEX) {
-		get.node = seq_list_node_get_index(seq, index);
+	get.link = NULL;
+	get.index = 0;
+	get.opt = opt;
+
+	if(opt == SEQ_INDEX) {
+		seq_index_t index = seq_arg_index(args);
+
+		get.link = seq_list_link_get_index(seq, index);
 		get.index = index;
 	}
 
+	else if(opt == SEQ_DATA) get.link = seq_list_link_get_data(seq, seq_arg_data(args), &get.index);
+
+	else if(opt == SEQ_RECV || opt == SEQ_POP) get.link = seq_list_data(seq)->front;
+
+	else if(opt == SEQ_KEY && seq_list_data(seq)->sorted.enabled) {
+		seq_data_t key = seq_arg_data(args);
+		seq_list_link_t link = seq_list_skip_search(seq, key, 0, NULL);
+
+		link = link ? link->next : seq_list_data(seq)->front;
+
+		if(link && seq_cb_cmp(seq, ((seq_list_node_t)(link))->data, key) == SEQ_EQUAL) {
+			get.link = link;
+		}
+	}
+
 	return get;
 }
 
+static seq_data_t seq_list_link_take(seq_t seq, seq_list_link_t link) {
+	if(seq_list_data(seq)->sorted.enabled) seq_list_skip_remove(seq, link);
+
+	seq_list_link_remove(seq_list_data(seq), link);
+
+	seq->size--;
+
+	return seq_list_link_release(seq, link);
+}
+
+/* The nodes are copied in two passes: the first one leaves the address of each copy in the @data
+ * of the original (the rest of which is still needed to walk the old list), so that the second
+ * one can translate every link, including those of the skip list, before the originals are
+ * freed. Iterators would be left pointing at the originals, so none may be active. */
+static seq_opt_t seq_list_compact(seq_t seq) {
+	seq_list_data_t data = seq_list_data(seq);
+	seq_list_link_t link = NULL;
+	seq_list_link_t next = NULL;
+	seq_list_link_t prev = NULL;
+	seq_list_skip_t node = NULL;
+	seq_size_t total = 0;
+	seq_size_t size;
+	seq_size_t level;
+	char* mem = NULL;
+	char* pos = NULL;
+
+	if(data->intrusive.enabled || data->compact.iters) return SEQ_ERR_OPT;
+
+	if(!seq->size) return SEQ_ERR_NONE;
+
+	for(link = data->front; link; link = link->next) total += seq_list_node_size(data, link);
+
+	if(!(pos = mem = (char*)(malloc(total)))) return SEQ_ERR_MEM;
+
+	for(link = data->front; link; link = link->next) {
+		size = seq_list_node_size(data, link);
+
+		memcpy(pos, link, size);
+
+		((seq_list_node_t)(link))->data = (seq_data_t)(pos);
+
+		pos += size;
+	}
+
+	/* The copies still hold the old links, so each one is translated through its target. */
+	for(pos = mem; pos < mem + total; pos += seq_list_node_size(data, link)) {
+		link = (seq_list_link_t)(pos);
+
+		link->prev = prev;
+
+		if(link->next) link->next = (seq_list_link_t)(((seq_list_node_t)(link->next))->data);
+
+		if(data->sorted.enabled) {
+			node = (seq_list_skip_t)(link);
+
+			for(level = 0; level < node->levels; level++) {
+				if(node->next[level]) {
+					node->next[level] = (seq_list_skip_t)(node->next[level]->node.data);
+				}
+			}
+		}
+
+		prev = link;
+	}
+
+	for(level = 0; level < data->sorted.levels; level++) {
+		if(data->sorted.head[level]) {
+			data->sorted.head[level] = (seq_list_skip_t)(data->sorted.head[level]->node.data);
+		}
+	}
+
+	for(link = data->front; link; link = next) {
+		next = link->next;
+
+		seq_list_node_free(seq, link);
+	}
+
+	data->front = (seq_list_link_t)(mem);
+	data->back = prev;
+	data->compact.mem = mem;
+	data->compact.end = mem + total;
+	data->compact.count = seq->size;
+	data->compact.live = seq->size;
+
+	seq_stats_add(seq, nodes_alloc, seq->size);
+
+	return SEQ_ERR_NONE;
+}
+
+/* A node is out of place if it was added since the last compaction, and so is every hole one
+ * left in the block by being removed. Each call to seq_add() or seq_remove() moves at most one
+ * node out of place, so compacting once they exceed a fixed share of the list costs amortized
+ * O(1) per call; failing to do so (for lack of memory, or because an iterator is open, which is
+ * then simply deferred until the next call) is harmless. */
+static void seq_list_compact_auto(seq_t seq) {
+	seq_list_data_t data = seq_list_data(seq);
+	seq_size_t scattered = seq->size + data->compact.count - (2 * data->compact.live);
+
+	if(!data->compact.threshold || data->intrusive.enabled) return;
+
+	if(scattered * 100 > seq->size * (seq_size_t)(data->compact.threshold)) seq_list_compact(seq);
+}
+
 /* ======================================================================== SEQ_LIST Implementation
  * seq_list_create
  * seq_list_destroy
+ * seq_list_config
  * seq_list_add
  * seq_list_remove
  * seq_list_get
@@ -149,261 +652,358 @@ static void seq_list_create(seq_t seq) {
 
 static void seq_list_destroy(seq_t seq) {
 	seq_list_data_t data = seq_list_data(seq);
-	seq_list_node_t node = data->front;
+	seq_list_link_t link = data->front;
 
-	while(node) {
-		seq_list_node_t tmp = node->next;
+	while(link) {
+		seq_list_link_t tmp = link->next;
 
-		seq_list_node_destroy(seq, node);
+		seq_list_link_destroy(seq, link);
 
-		node = tmp;
+		link = tmp;
 	}
 
 	free(data);
 }
 
-static seq_opt_t seq_list_add(seq_t seq, seq_args_t args) {
+static seq_opt_t seq_list_config(seq_t seq, seq_opt_t opt, seq_args_t args) {
 	seq_list_data_t data = seq_list_data(seq);
-	seq_list_node_t node = NULL;
-	seq_opt_t add = seq_arg_opt(args);
-	seq_opt_t err = SEQ_ERR_NONE;
 
-	if(!(node = seq_malloc(seq_list_node_t))) return SEQ_ERR_MEM;
+	/* Switching to (intrusive) links is only possible while the list is still empty. */
+	if(opt == SEQ_INTRUSIVE) {
+		seq_size_t offset = seq_arg(args, seq_size_t);
 
-	if(add == SEQ_APPEND || add == SEQ_PREPEND) {
-		if((node->data = seq_list_node_data(seq, args))) {
-			/* This is the first node. */
-			if(!data->front && !data->back) {
-				data->front = node;
-				data->back = node;
-			}
+		if(seq->size || data->sorted.enabled) return SEQ_ERR_OPT;
 
-			else {
-				if(add == SEQ_APPEND) {
-					node->prev = data->back;
+		data->intrusive.enabled = 1;
+		data->intrusive.offset = offset;
+	}
 
-					data->back->next = node;
-					data->back = node;
-				}
+	/* The skip list is woven through nodes of the list's own, so intrusive links can't be sorted.
+	 * The seq_cb_cmp_t callback itself is stored by seq_config(), once this succeeds. */
+	else if(opt == SEQ_SORTED) {
+		if(seq->size || data->intrusive.enabled) return SEQ_ERR_OPT;
 
-				else {
-					node->next = data->front;
+		data->sorted.enabled = 1;
+		data->sorted.seed = 0x9E3779B9;
+	}
 
-					data->front->prev = node;
-					data->front = node;
-				}
-			}
-		}
+	/* A different callback would invalidate the order of a sorted list's existing nodes. */
+	else if(opt == SEQ_CB_CMP) {
+		if(seq->size && data->sorted.enabled) return SEQ_ERR_OPT;
+	}
 
-		else err = SEQ_ERR_DATA;
+	/* The threshold is a percentage of the list; intrusive links can't be moved at all. */
+	else if(opt == SEQ_COMPACT) {
+		int threshold = seq_arg(args, int);
+
+		if(threshold < 0 || data->intrusive.enabled) return SEQ_ERR_OPT;
+
+		data->compact.threshold = threshold;
 	}
 
-	else if(add == SEQ_BEFORE || add == SEQ_AFTER || add == SEQ_REPLACE) {
-		seq_list_node_t pnode = NULL;
+	else return SEQ_ERR_OPT;
 
-		if((pnode = seq_list_node_get(seq, args).node)) {
-			if((node->data = seq_list_node_data(seq, args))) {
-				if(add == SEQ_BEFORE) {
-					node->next = pnode;
-					node->prev = pnode->prev;
+	return SEQ_ERR_NONE;
+}
 
-					if(pnode == data->front) data->front = node;
+static seq_opt_t seq_list_add(seq_t seq, seq_args_t args) {
+	seq_list_data_t data = seq_list_data(seq);
+	seq_list_link_t link = NULL;
+	seq_list_link_t plink = NULL;
+	seq_opt_t add = seq_arg_opt(args);
+	seq_opt_t err = SEQ_ERR_NONE;
 
-					else pnode->prev->next = node;
+	/* Used as a queue, SEQ_SEND appends and SEQ_RECV takes from the front; used as a stack,
+	 * SEQ_PUSH prepends and SEQ_POP takes from the front as well. */
+	if(add == SEQ_SEND) add = SEQ_APPEND;
 
-					pnode->prev = node;
-				}
+	else if(add == SEQ_PUSH) add = SEQ_PREPEND;
 
-				else if(add == SEQ_AFTER) {
-					node->next = pnode->next;
-					node->prev = pnode;
+	/* A sorted list decides on the position itself; SEQ_PREPEND places the new node before any
+	 * others that compare equal to it, and SEQ_APPEND after them. */
+	if(data->sorted.enabled) {
+		if(add != SEQ_APPEND && add != SEQ_PREPEND) return SEQ_ERR_OPT;
 
-					if(pnode == data->back) data->back = node;
+		if(!(link = seq_list_link_create(seq, args, &err))) return err;
 
-					else pnode->next->prev = node;
+		seq_list_skip_insert(seq, link, add == SEQ_APPEND);
+	}
 
-					pnode->next = node;
-				}
+	else if(add == SEQ_APPEND || add == SEQ_PREPEND) {
+		if(!(link = seq_list_link_create(seq, args, &err))) return err;
 
-				else {
-					node->next = pnode->next;
-					node->prev = pnode->prev;
+		seq_list_link_claim(seq, link);
+		seq_list_link_insert(data, link, add == SEQ_APPEND ? data->back : NULL);
+	}
 
-					if(node->next) node->next->prev = node;
+	else if(add == SEQ_BEFORE || add == SEQ_AFTER || add == SEQ_REPLACE) {
+		if(!(plink = seq_list_link_get(seq, args).link)) return SEQ_ERR_NODE;
 
-					if(node->prev) node->prev->next = node;
+		if(!(link = seq_list_link_create(seq, args, &err))) return err;
 
-					if(pnode == data->front) data->front = node;
+		/* An intrusive object can't be positioned relative to itself. */
+		if(link == plink) return SEQ_ERR_DATA;
 
-					else if(pnode == data->back) data->back = node;
+		seq_list_link_claim(seq, link);
 
-					seq_list_node_destroy(seq, pnode);
+		if(add == SEQ_BEFORE) seq_list_link_insert(data, link, plink->prev);
 
-					/* TODO: This is a silly hack, since we know the top-level seq_add() will
-					 * increment the size for us (by design). In the case of SEQ_REPLACE however,
-					 * we do not want this. Fixing this will require having the
-					 * implementation-specific functions return something more complex than they
-					 * currently do. */
-					seq->size--;
-				}
-			}
+		else if(add == SEQ_AFTER) seq_list_link_insert(data, link, plink);
 
-			else err = SEQ_ERR_DATA;
+		else {
+			seq_list_link_insert(data, link, plink);
+			seq_list_link_remove(data, plink);
+			seq_list_link_destroy(seq, plink);
+
+			/* TODO: This is a silly hack, since we know the top-level seq_add() will
+			 * increment the size for us (by design). In the case of SEQ_REPLACE however,
+			 * we do not want this. Fixing this will require having the
+			 * implementation-specific functions return something more complex than they
+			 * currently do. */
+			seq->size--;
 		}
-
-		else err = SEQ_ERR_NODE;
 	}
 
-	else err = SEQ_ERR_OPT;
+	else return SEQ_ERR_OPT;
 
-	if(err && node) seq_list_node_destroy(seq, node);
+	seq->size++;
 
-	else seq->size++;
+	seq_list_compact_auto(seq);
 
-	return err;
+	return SEQ_ERR_NONE;
 }
 
 static seq_opt_t seq_list_remove(seq_t seq, seq_args_t args) {
-	seq_list_data_t data = seq_list_data(seq);
-	seq_list_node_t node = seq_list_node_get(seq, args).node;
+	seq_list_link_t link = seq_list_link_get(seq, args).link;
 
-	if(!node) return SEQ_ERR_NODE;
+	if(!link) return SEQ_ERR_NODE;
 
-	/* Somewhere in the middle. */
-	if(node->prev && node->next) {
-		node->prev->next = node->next;
-		node->next->prev = node->prev;
-	}
+	seq_cb_remove(seq, seq_list_link_take(seq, link));
 
-	/* The very last node. */
-	else if(node->prev) {
-		if(node->prev) node->prev->next = NULL;
+	seq_list_compact_auto(seq);
 
-		data->back = node->prev;
-	}
+	return SEQ_ERR_NONE;
+}
 
-	/* The very first node. */
-	else {
-		if(node->next) node->next->prev = NULL;
+static seq_data_t seq_list_get(seq_t seq, seq_args_t args) {
+	seq_list_link_get_t get = seq_list_link_get(seq, args);
+	seq_data_t d = NULL;
 
-		data->front = node->next;
-	}
+	if(!get.link) return NULL;
 
-	seq_list_node_destroy(seq, node);
+	/* Taking the front node hands its data (and the ownership of it) back to the caller. */
+	if(get.opt == SEQ_RECV || get.opt == SEQ_POP) {
+		d = seq_list_link_take(seq, get.link);
 
-	seq->size--;
+		seq_list_compact_auto(seq);
 
-	return SEQ_ERR_NONE;
+		return d;
+	}
+
+	return seq_list_link_data(seq, get.link);
 }
 
-static seq_data_t seq_list_get(seq_t seq, seq_args_t args) {
-	seq_list_node_get_t get = seq_list_node_get(seq, args);
+static seq_opt_t seq_list_set(seq_t seq, seq_args_t args) {
+	seq_list_data_t data = seq_list_data(seq);
+	seq_list_link_get_t get = seq_list_link_get(seq, args);
+	seq_list_link_t link = get.link;
+	seq_data_t d = NULL;
 
-	if(get.node) return get.node->data;
+	/* Replacing a node in place could break the order of a sorted list. */
+	if(data->sorted.enabled || get.opt == SEQ_RECV || get.opt == SEQ_POP) return SEQ_ERR_OPT;
 
-	return NULL;
-}
+	if(!link) return SEQ_ERR_NODE;
 
-static seq_opt_t seq_list_set(seq_t seq, seq_args_t args) {
-	seq_list_node_get_t get = seq_list_node_get(seq, args);
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
 
-	if(get.node) {
-		seq_data_t data = seq_list_node_data(seq, args);
+	/* Intrusive objects carry their own link, so the new object simply takes the place of the
+	 * old one. */
+	if(data->intrusive.enabled) {
+		seq_list_link_t next = seq_list_intrusive_link(data, d);
 
-		if(data) {
-			seq_list_node_data_destroy(seq, get.node);
+		if(next == link) return SEQ_ERR_NONE;
 
-			get.node->data = data;
+		seq_list_link_claim(seq, next);
+		seq_list_link_insert(data, next, link);
+		seq_list_link_remove(data, link);
+		seq_list_link_destroy(seq, link);
+	}
 
-			return SEQ_ERR_NONE;
-		}
+	/* Otherwise, the existing node is kept and only its data is exchanged. */
+	else {
+		seq_list_node_t node = (seq_list_node_t)(link);
 
-		else return SEQ_ERR_DATA;
+		seq_cb_remove(seq, node->data);
+
+		node->data = d;
 	}
 
-	else return SEQ_ERR_NODE;
+	return SEQ_ERR_NONE;
 }
 
-#if 0
 /* ============================================================== SEQ_LIST Iteration Implementation
  * seq_list_iter_create
  * seq_list_iter_destroy
  * seq_list_iter_get
  * seq_list_iter_set
  * seq_list_iter_iterate
+ * seq_list_iter_copy
  * ============================================================================================= */
 
-static void seq_list_iter_create(seq_iter_t iter, seq_args_t args) {
+static seq_opt_t seq_list_iter_create(seq_iter_t iter, seq_args_t args) {
+	seq_list_iter_data_t data = seq_malloc(seq_list_iter_data_t);
+	seq_index_t begin = 0;
+	seq_index_t end = -1;
 	seq_opt_t opt;
-	seq_list_iter_data_t data = NULL;
 
-	iter->data = seq_malloc(seq_list_iter_data_t);
+	if(!(iter->data = data)) return SEQ_ERR_MEM;
 
-	if(!iter->data) return;
-
-	data = iter->data;
-
-	data->node = NULL;
-	data->index = -1;
-	data->range.begin = 0;
-	data->range.end = iter->seq->size - 1;
 	data->inc = 1;
 
 	while((opt = seq_arg_opt(args))) {
 		if(opt == SEQ_RANGE) {
-			data->range.begin = seq_list_index(iter->seq, seq_arg_size(args));
-			data->range.end = seq_list_index(iter->seq, seq_arg_size(args));
+			begin = seq_arg_index(args);
+			end = seq_arg_index(args);
 		}
 
-		else if(opt == SEQ_INC) data->inc = seq_arg_size(args);
+		else if(opt == SEQ_INC) data->inc = seq_arg(args, seq_size_t);
+
+		else return SEQ_ERR_OPT;
 	}
 
-	data->node = seq_list_node_get_index(iter->seq, data->range.begin);
+	if(!data->inc) return SEQ_ERR_OPT;
+
+	begin = seq_list_index(iter->seq, begin);
+	end = seq_list_index(iter->seq, end);
+
+	/* An empty (or invalid) range simply produces no elements. */
+	if(begin < 0 || end < begin) iter->state = SEQ_STOP;
+
+	else {
+		data->range.begin = (seq_size_t)(begin);
+		data->range.end = (seq_size_t)(end);
+	}
+
+	seq_list_data(iter->seq)->compact.iters++;
+
+	return SEQ_ERR_NONE;
 }
 
 static void seq_list_iter_destroy(seq_iter_t iter) {
+	seq_list_data(iter->seq)->compact.iters--;
 }
 
-static seq_get_t seq_list_iter_get(seq_iter_t iter, seq_args_t args) {
+static seq_data_t seq_list_iter_get(seq_iter_t iter, seq_args_t args) {
 	seq_list_iter_data_t data = seq_list_iter_data(iter);
 	seq_opt_t get = seq_arg_opt(args);
 
-	if(seq_opt(get, SEQ_GET) && get == SEQ_DATA) return seq_got_index(
-		data->node->data,
-		data->index
-	);
+	if(get == SEQ_DATA) return seq_list_link_data(iter->seq, data->link);
 
-	return seq_got_null();
+	return NULL;
 }
 
 static seq_opt_t seq_list_iter_set(seq_iter_t iter, seq_args_t args) {
-	/* seq_list_iter_data_t data = seq_list_iter_data(iter); */
+	seq_list_iter_data_t data = seq_list_iter_data(iter);
+	seq_list_node_t node = (seq_list_node_t)(data->link);
+	seq_t seq = iter->seq;
+	seq_data_t d = NULL;
+
+	/* Replacing an intrusive object would invalidate the iterator's own position, and replacing
+	 * the data of a sorted list could break its order. */
+	if(
+		seq_arg_opt(args) != SEQ_DATA ||
+		seq_list_data(seq)->intrusive.enabled ||
+		seq_list_data(seq)->sorted.enabled
+	) return SEQ_ERR_OPT;
 
-	return SEQ_ERR_OPT;
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+	seq_cb_remove(seq, node->data);
+
+	node->data = d;
+
+	return SEQ_ERR_NONE;
 }
 
 static seq_opt_t seq_list_iter_iterate(seq_iter_t iter) {
 	seq_list_iter_data_t data = seq_list_iter_data(iter);
+	seq_size_t i;
 
-	if(iter->state == SEQ_STOP) return SEQ_ERR_TODO;
-
-	else if(iter->state == SEQ_READY) {
-		iter->state = SEQ_ACTIVE;
+	if(iter->state == SEQ_READY) {
+		data->link = seq_list_link_get_index(iter->seq, (seq_index_t)(data->range.begin));
 		data->index = data->range.begin;
 	}
 
 	else {
-		seq_size_t i;
+		for(i = 0; i < data->inc && data->link; i++) data->link = data->link->next;
 
-		for(i = 0; i < data->inc; i++) {
-			data->node = data->node->next;
+		data->index += data->inc;
+	}
 
-			if(!data->node) return SEQ_ERR_TODO;
+	if(!data->link || data->index > data->range.end) return SEQ_STOP;
 
-			data->index++;
-		}
+	return SEQ_ACTIVE;
+}
+
+static seq_opt_t seq_list_iter_copy(seq_iter_t iter, seq_iter_t src) {
+	seq_list_iter_data_t data = seq_malloc(seq_list_iter_data_t);
+
+	if(!(iter->data = data)) return SEQ_ERR_MEM;
+
+	*data = *seq_list_iter_data(src);
+
+	seq_list_data(iter->seq)->compact.iters++;
+
+	return SEQ_ERR_NONE;
+}
+
+/* ===================================================================================== Compaction
+ * seq_compact
+ * ============================================================================================= */
+
+seq_opt_t seq_compact(seq_t seq) {
+	seq_opt_t err;
+
+	if(seq->impl != seq_impl_list()) return SEQ_ERR_OPT;
+
+	if(seq->block) seq_block_lock(seq);
+
+	err = seq_list_compact(seq);
+
+	if(seq->block) seq_block_unlock(seq);
+
+	return err;
+}
+
+/* =================================================================================== Internal API
+ * seq_list_splice
+ * ============================================================================================= */
+
+/* Moves every node of @src to the back of the list in O(1), leaving @src empty; neither list can be
+ * SEQ_SORTED or SEQ_INTRUSIVE, and the nodes of @src can't have been compacted into its block. */
+seq_opt_t seq_list_splice(seq_t seq, seq_t src) {
+	seq_list_data_t data = seq_list_data(seq);
+	seq_list_data_t sdata = seq_list_data(src);
+
+	if(data->sorted.enabled || data->intrusive.enabled) return SEQ_ERR_OPT;
+
+	if(sdata->sorted.enabled || sdata->intrusive.enabled || sdata->compact.mem) return SEQ_ERR_OPT;
+
+	if(!sdata->front) return SEQ_ERR_NONE;
+
+	if(data->back) {
+		data->back->next = sdata->front;
+		sdata->front->prev = data->back;
 	}
 
+	else data->front = sdata->front;
+
+	data->back = sdata->back;
+	seq->size += src->size;
+
+	sdata->front = NULL;
+	sdata->back = NULL;
+	src->size = 0;
+
 	return SEQ_ERR_NONE;
 }
-#endif
@@ -0,0 +1,596 @@
+#if !defined(_WIN32)
+#define _GNU_SOURCE
+#endif
+
+#include "seq-api.h"
+
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/* ======================================================================== Types, Constants, Enums
+ * struct _seq_parallel_chunk_t
+ * struct _seq_parallel_job_t
+ * seq_parallel_exec_t
+ * seq_parallel_pool
+ * --------------------------------------------------------------------------------------------- */
+
+typedef struct _seq_parallel_chunk_t* seq_parallel_chunk_t;
+typedef struct _seq_parallel_job_t* seq_parallel_job_t;
+
+/* Chunks per thread when no grain is given; more chunks balance better, but cost more to set up. */
+#define SEQ_PARALLEL_CHUNKS 8
+#define SEQ_PARALLEL_THREADS_MAX 256
+
+/* Every chunk starts out with an iterator already positioned on its first element, whose index
+ * within the whole sequence is @first. Whatever a chunk produces is left in @result (or @err). */
+struct _seq_parallel_chunk_t {
+	seq_iter_t iter;
+	seq_size_t first;
+	seq_size_t count;
+	seq_data_t result;
+	seq_opt_t err;
+};
+
+typedef void (*seq_parallel_exec_t)(seq_parallel_job_t job, seq_parallel_chunk_t chunk);
+
+/* A job describes what's done with every chunk, along with everything that needs; @one is the
+ * chunk used when the whole sequence is processed by the calling thread alone. */
+struct _seq_parallel_job_t {
+	seq_parallel_exec_t exec;
+	seq_data_t ctx;
+	int threads;
+	seq_data_t* buf;
+	seq_data_t identity;
+
+	struct {
+		seq_cb_each_t each;
+		seq_cb_map_t map;
+		seq_cb_pred_t pred;
+		seq_cb_reduce_t reduce;
+	} cb;
+
+	struct _seq_parallel_chunk_t one;
+};
+
+#if !defined(_WIN32)
+/* Participant 0 is whichever thread called into the pool; the workers are numbered from 1. Each
+ * participant owns the SEQ_DEQUE with the same index for the duration of a call, except that the
+ * calling thread fills all of them before waking the workers up. The call mutex is held for as
+ * long as a call is in progress, while the lock mutex protects everything else; that includes the
+ * generation each worker last saw, which is set up by the thread creating it, since the worker
+ * itself may not get to run until after the next call has already begun. A worker may also wake
+ * up late, after the call it was woken for has returned, so the job (which lives on the calling
+ * thread's stack) is only published alongside its number of participants while that call lasts. */
+static struct {
+	pthread_mutex_t call;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t done;
+	int workers;
+	int active;
+	int threads;
+	unsigned long generation;
+	seq_parallel_job_t job;
+	seq_t deques[SEQ_PARALLEL_THREADS_MAX];
+	unsigned long seen[SEQ_PARALLEL_THREADS_MAX];
+} seq_parallel_pool = {
+	PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	0,
+	0,
+	0,
+	0,
+	NULL,
+	{ NULL },
+	{ 0 }
+};
+#endif
+
+/* ======================================================================= Private Parallel Helpers
+ * seq_parallel_split
+ *    Fills the chunks for the given grain, returning the number actually used (or 0 on error).
+ *
+ * seq_parallel_chunks_destroy
+ *    Destroys the iterators of the given chunks, and then the chunks themselves.
+ *
+ * seq_parallel_next
+ *    Returns the data of the ith element of a chunk, or NULL once past its end.
+ *
+ * seq_parallel_threads
+ *    Returns the number of threads a seq_t instance should be processed with.
+ *
+ * seq_parallel_work
+ *    Executes chunks (first its own, then stolen ones) until none are left anywhere.
+ *
+ * seq_parallel_worker
+ *    The main loop of a pool thread, which sleeps until it's needed by a call.
+ *
+ * seq_parallel_grow
+ *    Makes sure the pool can accommodate the given number of participants.
+ *
+ * seq_parallel_dispatch
+ *    Executes a job over every element, on the pool if possible, handing back the chunks.
+ * ============================================================================================= */
+
+/* Walking a list once is far cheaper than the O(n) seek a SEQ_RANGE iterator would need for every
+ * chunk, so only the types supporting random access are split by index. */
+static seq_size_t seq_parallel_split(
+	seq_t seq,
+	seq_parallel_chunk_t chunks,
+	seq_size_t n,
+	seq_size_t grain
+) {
+	seq_iter_t iter = NULL;
+	seq_size_t size = seq->size;
+	seq_size_t i = 0;
+	seq_size_t k = 0;
+
+	if(n == 1) {
+		if(!(chunks[0].iter = seq_iter_create(seq, SEQ_ERR_NONE))) return 0;
+
+		chunks[0].count = size;
+
+		seq_iterate(chunks[0].iter);
+
+		return 1;
+	}
+
+	if(seq->type == SEQ_ARRAY || seq->type == SEQ_HEAP || seq->type == SEQ_VECTOR) {
+		for(k = 0; k < n; k++) {
+			seq_size_t begin = k * grain;
+			seq_size_t end = begin + grain > size ? size : begin + grain;
+
+			chunks[k].first = begin;
+			chunks[k].count = end - begin;
+			chunks[k].iter = seq_iter_create(
+				seq,
+				SEQ_RANGE,
+				(seq_index_t)(begin),
+				(seq_index_t)(end - 1),
+				SEQ_ERR_NONE
+			);
+
+			if(!chunks[k].iter) return 0;
+
+			seq_iterate(chunks[k].iter);
+		}
+
+		return n;
+	}
+
+	if(!(iter = seq_iter_create(seq, SEQ_ERR_NONE))) return 0;
+
+	while(seq_iterate(iter)) {
+		if(!(i % grain)) {
+			if(k == n) break;
+
+			if(!(chunks[k].iter = seq_iter_copy(iter))) {
+				seq_iter_destroy(iter);
+
+				return 0;
+			}
+
+			chunks[k++].first = i;
+		}
+
+		chunks[k - 1].count++;
+
+		i++;
+	}
+
+	seq_iter_destroy(iter);
+
+	return k;
+}
+
+static void seq_parallel_chunks_destroy(
+	seq_parallel_job_t job,
+	seq_parallel_chunk_t chunks,
+	seq_size_t n
+) {
+	seq_size_t k;
+
+	if(!chunks) return;
+
+	for(k = 0; k < n; k++) {
+		if(chunks[k].iter) seq_iter_destroy(chunks[k].iter);
+	}
+
+	if(chunks != &job->one) free(chunks);
+}
+
+/* Elements are never NULL, so that's unambiguous. */
+static seq_data_t seq_parallel_next(seq_parallel_chunk_t chunk, seq_size_t i) {
+	if(i >= chunk->count || (i && !seq_iterate(chunk->iter))) return NULL;
+
+	return seq_iter_get(chunk->iter, SEQ_DATA);
+}
+
+#if !defined(_WIN32)
+static int seq_parallel_threads(seq_t seq) {
+	int threads = seq->parallel.threads;
+
+	if(!threads) threads = (int)(sysconf(_SC_NPROCESSORS_ONLN));
+
+	return threads > SEQ_PARALLEL_THREADS_MAX ? SEQ_PARALLEL_THREADS_MAX : threads;
+}
+
+/* No new chunks appear once a call is under way, so finding every deque empty means we're done;
+ * the remaining chunks are already being executed elsewhere. */
+static void seq_parallel_work(seq_parallel_job_t job, int self) {
+	seq_t* deques = seq_parallel_pool.deques;
+
+	for(;;) {
+		seq_parallel_chunk_t chunk = (seq_parallel_chunk_t)(seq_get(deques[self], SEQ_POP));
+		int i;
+
+		for(i = 1; !chunk && i < job->threads; i++) {
+			chunk = (seq_parallel_chunk_t)(seq_get(deques[(self + i) % job->threads], SEQ_STEAL));
+		}
+
+		if(!chunk) break;
+
+		job->exec(job, chunk);
+	}
+}
+
+static void* seq_parallel_worker(void* arg) {
+	int self = (int)((seq_size_t)(arg));
+
+	for(;;) {
+		seq_parallel_job_t job = NULL;
+
+		pthread_mutex_lock(&seq_parallel_pool.lock);
+
+		while(seq_parallel_pool.generation == seq_parallel_pool.seen[self]) {
+			pthread_cond_wait(&seq_parallel_pool.wake, &seq_parallel_pool.lock);
+		}
+
+		seq_parallel_pool.seen[self] = seq_parallel_pool.generation;
+
+		/* The job belongs to the calling thread, so it can't be touched without taking part. */
+		if(self < seq_parallel_pool.threads) job = seq_parallel_pool.job;
+
+		pthread_mutex_unlock(&seq_parallel_pool.lock);
+
+		if(!job) continue;
+
+		seq_parallel_work(job, self);
+
+		pthread_mutex_lock(&seq_parallel_pool.lock);
+
+		if(!--seq_parallel_pool.active) pthread_cond_signal(&seq_parallel_pool.done);
+
+		pthread_mutex_unlock(&seq_parallel_pool.lock);
+	}
+
+	return NULL;
+}
+
+/* Only ever called while holding the call mutex, which is what protects the deques array. */
+static seq_opt_t seq_parallel_grow(int threads) {
+	int i;
+
+	for(i = 0; i < threads; i++) {
+		if(!seq_parallel_pool.deques[i] && !(seq_parallel_pool.deques[i] = seq_create(SEQ_DEQUE))) {
+			return SEQ_ERR_MEM;
+		}
+	}
+
+	while(seq_parallel_pool.workers < threads - 1) {
+		int self = seq_parallel_pool.workers + 1;
+		pthread_t thread;
+
+		pthread_mutex_lock(&seq_parallel_pool.lock);
+
+		seq_parallel_pool.seen[self] = seq_parallel_pool.generation;
+
+		pthread_mutex_unlock(&seq_parallel_pool.lock);
+
+		if(pthread_create(&thread, NULL, seq_parallel_worker, (void*)((seq_size_t)(self)))) {
+			return SEQ_ERR_MEM;
+		}
+
+		pthread_detach(thread);
+
+		seq_parallel_pool.workers++;
+	}
+
+	return SEQ_ERR_NONE;
+}
+#endif
+
+/* Whenever the pool can't be used--because it's busy (possibly with the very call that led here),
+ * or runs out of memory--the whole sequence is processed as a single chunk, right away. The chunks
+ * handed back must be passed to seq_parallel_chunks_destroy() afterwards. */
+static seq_opt_t seq_parallel_dispatch(
+	seq_t seq,
+	seq_parallel_job_t job,
+	seq_size_t grain,
+	seq_parallel_chunk_t* chunks,
+	seq_size_t* n
+) {
+	seq_size_t size = seq->size;
+#if !defined(_WIN32)
+	int threads = seq_parallel_threads(seq);
+#endif
+
+	*chunks = NULL;
+	*n = 0;
+
+	if(!size) return SEQ_ERR_NONE;
+
+#if !defined(_WIN32)
+	if(threads > 1 && size > 1) {
+		seq_parallel_chunk_t pchunks = NULL;
+		seq_size_t total = 0;
+		seq_size_t k;
+
+		if(!grain) grain = size / ((seq_size_t)(threads) * SEQ_PARALLEL_CHUNKS);
+
+		if(!grain) grain = 1;
+
+		total = (size + grain - 1) / grain;
+
+		if((seq_size_t)(threads) > total) threads = (int)(total);
+
+		if(threads > 1 && !pthread_mutex_trylock(&seq_parallel_pool.call)) {
+			if(
+				!seq_parallel_grow(threads) &&
+				(pchunks = (seq_parallel_chunk_t)(calloc(total, sizeof(*pchunks)))) &&
+				(*n = seq_parallel_split(seq, pchunks, total, grain))
+			) {
+				job->threads = threads;
+
+				/* Consecutive chunks go to different threads; should a push fail, the
+				 * chunk is simply executed right away instead. */
+				for(k = *n; k--;) {
+					if(seq_add(seq_parallel_pool.deques[k % threads], SEQ_PUSH, &pchunks[k])) {
+						job->exec(job, &pchunks[k]);
+					}
+				}
+
+				pthread_mutex_lock(&seq_parallel_pool.lock);
+
+				seq_parallel_pool.job = job;
+				seq_parallel_pool.threads = threads;
+				seq_parallel_pool.active = threads - 1;
+				seq_parallel_pool.generation++;
+
+				pthread_cond_broadcast(&seq_parallel_pool.wake);
+				pthread_mutex_unlock(&seq_parallel_pool.lock);
+
+				seq_parallel_work(job, 0);
+
+				pthread_mutex_lock(&seq_parallel_pool.lock);
+
+				while(seq_parallel_pool.active) {
+					pthread_cond_wait(&seq_parallel_pool.done, &seq_parallel_pool.lock);
+				}
+
+				seq_parallel_pool.job = NULL;
+				seq_parallel_pool.threads = 0;
+
+				pthread_mutex_unlock(&seq_parallel_pool.lock);
+				pthread_mutex_unlock(&seq_parallel_pool.call);
+
+				*chunks = pchunks;
+
+				return SEQ_ERR_NONE;
+			}
+
+			seq_parallel_chunks_destroy(job, pchunks, total);
+
+			pthread_mutex_unlock(&seq_parallel_pool.call);
+		}
+	}
+#endif
+
+	job->threads = 1;
+
+	if(!(*n = seq_parallel_split(seq, &job->one, 1, size))) {
+		seq_parallel_chunks_destroy(job, &job->one, 1);
+
+		return SEQ_ERR_MEM;
+	}
+
+	*chunks = &job->one;
+
+	job->exec(job, *chunks);
+
+	return SEQ_ERR_NONE;
+}
+
+/* ====================================================================== Parallel Chunk Execution
+ * seq_parallel_exec_each
+ * seq_parallel_exec_map
+ * seq_parallel_exec_filter
+ * seq_parallel_exec_reduce
+ * ============================================================================================= */
+
+static void seq_parallel_exec_each(seq_parallel_job_t job, seq_parallel_chunk_t chunk) {
+	seq_data_t d;
+	seq_size_t i;
+
+	for(i = 0; (d = seq_parallel_next(chunk, i)); i++) job->cb.each(d, job->ctx);
+}
+
+/* Every chunk writes straight into its own slice of the preallocated result. */
+static void seq_parallel_exec_map(seq_parallel_job_t job, seq_parallel_chunk_t chunk) {
+	seq_data_t d;
+	seq_size_t i;
+
+	for(i = 0; (d = seq_parallel_next(chunk, i)); i++) {
+		if(!(job->buf[chunk->first + i] = job->cb.map(d, job->ctx))) chunk->err = SEQ_ERR_DATA;
+	}
+}
+
+/* Every chunk collects the elements it keeps into a list of its own. */
+static void seq_parallel_exec_filter(seq_parallel_job_t job, seq_parallel_chunk_t chunk) {
+	seq_data_t d;
+	seq_size_t i;
+
+	for(i = 0; !chunk->err && (d = seq_parallel_next(chunk, i)); i++) {
+		if(!job->cb.pred(d, job->ctx)) continue;
+
+		if(!chunk->result && !(chunk->result = seq_create(SEQ_LIST))) chunk->err = SEQ_ERR_MEM;
+
+		else chunk->err = seq_add((seq_t)(chunk->result), SEQ_APPEND, d);
+	}
+}
+
+static void seq_parallel_exec_reduce(seq_parallel_job_t job, seq_parallel_chunk_t chunk) {
+	seq_data_t d;
+	seq_size_t i;
+
+	chunk->result = job->identity;
+
+	for(i = 0; (d = seq_parallel_next(chunk, i)); i++) {
+		chunk->result = job->cb.reduce(chunk->result, d, job->ctx);
+	}
+}
+
+/* ============================================================================== Parallel Iteration
+ * seq_parallel_for
+ * seq_map
+ * seq_filter
+ * seq_reduce
+ * ============================================================================================= */
+
+seq_opt_t seq_parallel_for(seq_t seq, seq_cb_each_t each, seq_data_t ctx, seq_size_t grain) {
+	struct _seq_parallel_job_t job;
+	seq_parallel_chunk_t chunks = NULL;
+	seq_size_t n = 0;
+	seq_opt_t err;
+
+	if(!each) return SEQ_ERR_CB;
+
+	memset(&job, 0, sizeof(job));
+
+	job.exec = seq_parallel_exec_each;
+	job.ctx = ctx;
+	job.cb.each = each;
+
+	err = seq_parallel_dispatch(seq, &job, grain, &chunks, &n);
+
+	seq_parallel_chunks_destroy(&job, chunks, n);
+
+	return err;
+}
+
+seq_t seq_map(seq_t seq, seq_cb_map_t map, seq_data_t ctx) {
+	struct _seq_parallel_job_t job;
+	seq_parallel_chunk_t chunks = NULL;
+	seq_t out = NULL;
+	seq_size_t n = 0;
+	seq_size_t k;
+	seq_opt_t err;
+
+	if(!map || !(out = seq_create(SEQ_ARRAY))) return NULL;
+
+	out->parallel.threads = seq->parallel.threads;
+
+	if(!seq->size) return out;
+
+	memset(&job, 0, sizeof(job));
+
+	job.exec = seq_parallel_exec_map;
+	job.ctx = ctx;
+	job.cb.map = map;
+
+	if(!(job.buf = seq_array_fill(out, seq->size))) {
+		seq_destroy(out);
+
+		return NULL;
+	}
+
+	err = seq_parallel_dispatch(seq, &job, 0, &chunks, &n);
+
+	for(k = 0; k < n; k++) {
+		if(chunks[k].err) err = chunks[k].err;
+	}
+
+	seq_parallel_chunks_destroy(&job, chunks, n);
+
+	if(err) {
+		seq_destroy(out);
+
+		return NULL;
+	}
+
+	return out;
+}
+
+/* The per-chunk lists are spliced together in order, which is O(1) for each of them. */
+seq_t seq_filter(seq_t seq, seq_cb_pred_t pred, seq_data_t ctx) {
+	struct _seq_parallel_job_t job;
+	seq_parallel_chunk_t chunks = NULL;
+	seq_t out = NULL;
+	seq_size_t n = 0;
+	seq_size_t k;
+	seq_opt_t err;
+
+	if(!pred || !(out = seq_create(SEQ_LIST))) return NULL;
+
+	out->parallel.threads = seq->parallel.threads;
+
+	memset(&job, 0, sizeof(job));
+
+	job.exec = seq_parallel_exec_filter;
+	job.ctx = ctx;
+	job.cb.pred = pred;
+
+	err = seq_parallel_dispatch(seq, &job, 0, &chunks, &n);
+
+	for(k = 0; k < n; k++) {
+		if(chunks[k].err) err = chunks[k].err;
+
+		if(chunks[k].result) {
+			if(!err) seq_list_splice(out, (seq_t)(chunks[k].result));
+
+			seq_destroy((seq_t)(chunks[k].result));
+		}
+	}
+
+	seq_parallel_chunks_destroy(&job, chunks, n);
+
+	if(err) {
+		seq_destroy(out);
+
+		return NULL;
+	}
+
+	return out;
+}
+
+/* The partial results of the chunks are combined in order, on the calling thread. */
+seq_data_t seq_reduce(seq_t seq, seq_cb_reduce_t reduce, seq_data_t identity, seq_data_t ctx) {
+	struct _seq_parallel_job_t job;
+	seq_parallel_chunk_t chunks = NULL;
+	seq_data_t acc = identity;
+	seq_size_t n = 0;
+	seq_size_t k;
+
+	if(!reduce) return identity;
+
+	memset(&job, 0, sizeof(job));
+
+	job.exec = seq_parallel_exec_reduce;
+	job.ctx = ctx;
+	job.identity = identity;
+	job.cb.reduce = reduce;
+
+	seq_parallel_dispatch(seq, &job, 0, &chunks, &n);
+
+	for(k = 0; k < n; k++) acc = reduce(acc, chunks[k].result, ctx);
+
+	seq_parallel_chunks_destroy(&job, chunks, n);
+
+	return acc;
+}
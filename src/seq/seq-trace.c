@@ -0,0 +1,249 @@
+#if !defined(_WIN32)
+#define _GNU_SOURCE
+#endif
+
+#include "seq-api.h"
+
+#include <string.h>
+#include <time.h>
+
+/* ======================================================================== Types, Constants, Enums
+ * struct _seq_trace_hist_t
+ * SEQ_TRACE_SUB
+ * SEQ_TRACE_BUCKETS
+ * --------------------------------------------------------------------------------------------- */
+
+/* Every histogram uses the same fixed layout: values below SEQ_TRACE_SUB get an exact bucket each,
+ * and every power of 2 above that is split into SEQ_TRACE_SUB equally-sized buckets. This covers the
+ * entire range of uint64_t in 252 buckets with a relative error of at most 1 / SEQ_TRACE_SUB, and
+ * finding the bucket of a value is nothing more than a bit scan and a shift. */
+#define SEQ_TRACE_SUB_BITS 2
+#define SEQ_TRACE_SUB (1 << SEQ_TRACE_SUB_BITS)
+#define SEQ_TRACE_BUCKETS (SEQ_TRACE_SUB + (64 - SEQ_TRACE_SUB_BITS) * SEQ_TRACE_SUB)
+
+struct _seq_trace_hist_t {
+	uint64_t count;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+	uint64_t buckets[SEQ_TRACE_BUCKETS];
+};
+
+/* ========================================================================== Private Trace Helpers
+ * seq_trace_bucket
+ *    Returns the index of the histogram bucket the given value falls into.
+ *
+ * seq_trace_bucket_max
+ *    Returns the largest value that still falls into the given bucket.
+ *
+ * seq_trace_hist
+ *    Returns the histogram of the given call/constant pair, or NULL if there isn't any.
+ *
+ * seq_trace_hist_percentile
+ *    Returns the (approximate) value at the given percentile of the histogram.
+ * ============================================================================================= */
+
+static seq_size_t seq_trace_bucket(uint64_t val) {
+	seq_size_t e;
+
+	if(val < SEQ_TRACE_SUB) return (seq_size_t)(val);
+
+#if defined(__GNUC__)
+	e = (seq_size_t)(63 - __builtin_clzll(val));
+#else
+	for(e = SEQ_TRACE_SUB_BITS; val >> (e + 1); e++);
+#endif
+
+	return
+		SEQ_TRACE_SUB +
+		(e - SEQ_TRACE_SUB_BITS) * SEQ_TRACE_SUB +
+		(seq_size_t)((val >> (e - SEQ_TRACE_SUB_BITS)) & (SEQ_TRACE_SUB - 1));
+}
+
+static uint64_t seq_trace_bucket_max(seq_size_t bucket) {
+	seq_size_t e;
+	uint64_t sub;
+
+	if(bucket < SEQ_TRACE_SUB) return bucket;
+
+	e = (bucket - SEQ_TRACE_SUB) / SEQ_TRACE_SUB;
+	sub = (bucket - SEQ_TRACE_SUB) % SEQ_TRACE_SUB;
+
+	return ((SEQ_TRACE_SUB + sub + 1) << e) - 1;
+}
+
+static seq_trace_hist_t seq_trace_hist(seq_t seq, seq_opt_t call, seq_opt_t op) {
+	if(!seq->trace || !seq_opt(call, SEQ_CALL) || seq_opt_val(op) >= SEQ_TRACE_OPS) return NULL;
+
+	return seq_atomic_acquire(&seq->trace->hist[seq_opt_val(call)][seq_opt_val(op)]);
+}
+
+static uint64_t seq_trace_hist_percentile(seq_trace_hist_t hist, double percentile) {
+	uint64_t rank;
+	uint64_t n = 0;
+	seq_size_t i;
+
+	if(percentile >= 100.0) return hist->max;
+
+	rank = (uint64_t)((percentile / 100.0) * (double)(hist->count) + 0.5);
+
+	if(!rank) rank = 1;
+
+	for(i = 0; i < SEQ_TRACE_BUCKETS; i++) {
+		if((n += hist->buckets[i]) >= rank) {
+			uint64_t val = seq_trace_bucket_max(i);
+
+			/* The bucket bounds are only an approximation; the extremes are exact. */
+			if(val > hist->max) return hist->max;
+
+			if(val < hist->min) return hist->min;
+
+			return val;
+		}
+	}
+
+	return hist->max;
+}
+
+/* ================================================================================ Internal Trace
+ * seq_trace_clock
+ * seq_trace_end
+ * seq_trace_config
+ * ============================================================================================= */
+
+/* The coarse clocks (CLOCK_MONOTONIC_COARSE and friends) only tick once every few milliseconds,
+ * which is useless for timing individual calls, and the raw TSC would need calibrating; a plain
+ * CLOCK_MONOTONIC, on the other hand, is served from the vDSO on Linux without a system call. */
+uint64_t seq_trace_clock(void) {
+#if defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)(ts.tv_sec) * 1000000000) + (uint64_t)(ts.tv_nsec);
+#else
+	return ((uint64_t)(clock()) * (1000000000 / CLOCKS_PER_SEC)) + 1;
+#endif
+}
+
+/* Calls may end on several threads at once (with SEQ_BLOCKING, whose lock is already released by
+ * now, or while thieves steal from a SEQ_DEQUE), so every field is updated atomically, and a new
+ * histogram is only published if no other thread got there first; otherwise, it's thrown away. */
+void seq_trace_end(seq_t seq, seq_opt_t call, seq_opt_t op, uint64_t begin) {
+	uint64_t ns = seq_trace_clock() - begin;
+	seq_trace_hist_t* slot;
+	seq_trace_hist_t hist;
+	seq_trace_hist_t prev = NULL;
+
+	if(seq->cb.trace) seq->cb.trace(seq, call, op, ns);
+
+	if(!seq->trace || seq_opt_val(op) >= SEQ_TRACE_OPS) return;
+
+	slot = &seq->trace->hist[seq_opt_val(call)][seq_opt_val(op)];
+
+	if(!(hist = seq_atomic_acquire(slot))) {
+		/* A histogram we can't allocate simply won't be recorded. */
+		if(!(hist = seq_malloc(seq_trace_hist_t))) return;
+
+		hist->min = (uint64_t)(-1);
+
+		if(!seq_atomic_cas(slot, &prev, hist)) {
+			free(hist);
+
+			hist = prev;
+		}
+	}
+
+	seq_atomic_min(&hist->min, ns);
+	seq_atomic_max(&hist->max, ns);
+	seq_atomic_add(&hist->sum, ns);
+	seq_atomic_add(&hist->buckets[seq_trace_bucket(ns)], 1);
+	seq_atomic_add(&hist->count, 1);
+}
+
+seq_opt_t seq_trace_config(seq_t seq, int enabled) {
+	seq_size_t c;
+	seq_size_t o;
+
+	if(seq->trace) {
+		for(c = 0; c < SEQ_TRACE_CALLS; c++) {
+			for(o = 0; o < SEQ_TRACE_OPS; o++) free(seq->trace->hist[c][o]);
+		}
+
+		memset(seq->trace, 0, sizeof(struct _seq_trace_t));
+	}
+
+	if(!enabled) {
+		free(seq->trace);
+
+		seq->trace = NULL;
+	}
+
+	else if(!seq->trace && !(seq->trace = seq_malloc(seq_trace_t))) return SEQ_ERR_MEM;
+
+	return SEQ_ERR_NONE;
+}
+
+/* ====================================================================================== Trace API
+ * seq_trace
+ * seq_trace_dump
+ * ============================================================================================= */
+
+uint64_t seq_trace(seq_t seq, seq_opt_t call, seq_opt_t op, double percentile) {
+	seq_trace_hist_t hist = seq_trace_hist(seq, call, op);
+
+	if(!hist) return 0;
+
+	return seq_trace_hist_percentile(hist, percentile);
+}
+
+seq_opt_t seq_trace_dump(seq_t seq, seq_cb_write_t write, seq_data_t ctx) {
+	static const double percentiles[] = { 50.0, 90.0, 99.0, 99.9 };
+	char line[512];
+	seq_size_t c;
+	seq_size_t o;
+	seq_size_t i;
+
+	if(!seq->trace) return SEQ_ERR_OPT;
+
+	for(c = 1; c < SEQ_TRACE_CALLS; c++) {
+		for(o = 0; o < SEQ_TRACE_OPS; o++) {
+			seq_trace_hist_t hist = seq_atomic_acquire(&seq->trace->hist[c][o]);
+			seq_opt_t call = SEQ_CALL | (seq_opt_t)(c);
+			const char* op = "-";
+			seq_size_t len;
+
+			/* A histogram is published just before its first call is counted. */
+			if(!hist || !seq_atomic_load(&hist->count)) continue;
+
+			if(o && call == SEQ_CALL_ADD) op = seq_string(SEQ_ADD | (seq_opt_t)(o));
+
+			else if(o && call != SEQ_CALL_DESTROY) op = seq_string(SEQ_GET | (seq_opt_t)(o));
+
+			len = (seq_size_t)(sprintf(
+				line,
+				"%-16s %-8s count=%lu mean=%lu min=%lu",
+				seq_string(call),
+				op,
+				(unsigned long)(hist->count),
+				(unsigned long)(hist->sum / hist->count),
+				(unsigned long)(hist->min)
+			));
+
+			for(i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+				len += (seq_size_t)(sprintf(
+					line + len,
+					" p%g=%lu",
+					percentiles[i],
+					(unsigned long)(seq_trace_hist_percentile(hist, percentiles[i]))
+				));
+			}
+
+			len += (seq_size_t)(sprintf(line + len, " max=%lu\n", (unsigned long)(hist->max)));
+
+			if(write(line, len, ctx) != len) return SEQ_ERR_IO;
+		}
+	}
+
+	return SEQ_ERR_NONE;
+}
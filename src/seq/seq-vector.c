@@ -0,0 +1,1271 @@
+#include "seq-api.h"
+
+#include <string.h>
+
+/* ======================================================================== Types, Constants, Enums
+ * union _seq_vector_slot_t
+ * struct _seq_vector_node_t
+ * struct _seq_vector_data_t
+ * struct _seq_vector_iter_data_t
+ * seq_vector_data
+ * seq_vector_iter_data
+ * seq_vector_before
+ * SEQ_TYPE_API(vector)
+ * --------------------------------------------------------------------------------------------- */
+
+typedef union _seq_vector_slot_t seq_vector_slot_t;
+typedef struct _seq_vector_node_t* seq_vector_node_t;
+typedef struct _seq_vector_data_t* seq_vector_data_t;
+typedef struct _seq_vector_iter_data_t* seq_vector_iter_data_t;
+
+/* A SEQ_VECTOR is a persistent, 32-way relaxed radix balanced (RRB) tree, with the elements stored
+ * in the leaves. As long as a node is regular--that is, every child but the last is full--the slot
+ * holding the element at index i is picked by the next group of 5 bits of i (most significant
+ * first), just like in a plain bit-partitioned trie. Concatenating and slicing leave nodes whose
+ * children may hold fewer elements than that, so these are relaxed: they carry a table of the
+ * cumulative sizes of their children, stored right after the node itself. The radix then still
+ * gives a lower bound for the slot, and the table is scanned from there, which takes a step or two
+ * at most as long as the tree stays balanced. The @shift is the number of bits consumed above the
+ * leaves, so a vector of up to 32 elements usually has a leaf for its root, and a shift of 0. The
+ * slots in use always come first; the others are NULL.
+ *
+ * Every node is reference counted, and may be shared by any number of vectors (that is, a live
+ * vector, its snapshots, and whatever versions were derived from either). A node is only ever
+ * modified in place while its count is 1; otherwise it's copied first, along with the path leading
+ * to it, so that whoever else refers to it keeps seeing the old version. Since copying a path is
+ * idempotent, an operation that fails halfway (for lack of memory) leaves the vector exactly as it
+ * was. */
+#define SEQ_VECTOR_BITS 5
+#define SEQ_VECTOR_WIDTH (1 << SEQ_VECTOR_BITS)
+
+/* A concatenation merges the nodes along the seam until at most this many more remain than would
+ * be strictly needed, skipping over those short of full by this many slots or less. */
+#define SEQ_VECTOR_EXTRAS 2
+#define SEQ_VECTOR_INVARIANT 1
+
+union _seq_vector_slot_t {
+	seq_vector_node_t node;
+	seq_data_t data;
+};
+
+struct _seq_vector_node_t {
+	seq_size_t refs;
+	seq_size_t* sizes;
+	seq_vector_slot_t slots[SEQ_VECTOR_WIDTH];
+};
+
+struct _seq_vector_data_t {
+	seq_vector_node_t root;
+	unsigned int shift;
+	int snapshot;
+};
+
+/* The leaf holding the current element is cached, along with the indexes of its first element and
+ * of the one after its last. */
+struct _seq_vector_iter_data_t {
+	seq_size_t index;
+	seq_size_t inc;
+	seq_vector_node_t leaf;
+	seq_size_t base;
+	seq_size_t end;
+
+	struct {
+		seq_size_t begin;
+		seq_size_t end;
+	} range;
+};
+
+#define seq_vector_data(seq) ((seq_vector_data_t)(seq->data))
+#define seq_vector_iter_data(iter) ((seq_vector_iter_data_t)(iter->data))
+
+/* The number of elements held by the children of an (internal) node before the given slot. */
+#define seq_vector_before(node, shift, pos) ((node)->sizes ? \
+	((pos) ? (node)->sizes[(pos) - 1] : 0) : \
+	(seq_size_t)(pos) << (shift) \
+)
+
+/* Snapshots may be released on other threads, so the reference counts are atomic; once a node's
+ * count is seen to be 1 (with acquire semantics), nobody else can be reading it anymore. */
+#if defined(__ATOMIC_ACQ_REL)
+#define seq_vector_ref(node) __atomic_fetch_add(&(node)->refs, 1, __ATOMIC_RELAXED)
+#define seq_vector_unref(node) __atomic_sub_fetch(&(node)->refs, 1, __ATOMIC_ACQ_REL)
+#define seq_vector_refs(node) __atomic_load_n(&(node)->refs, __ATOMIC_ACQUIRE)
+#elif defined(__GNUC__)
+#define seq_vector_ref(node) __sync_fetch_and_add(&(node)->refs, 1)
+#define seq_vector_unref(node) __sync_sub_and_fetch(&(node)->refs, 1)
+#define seq_vector_refs(node) __sync_fetch_and_add(&(node)->refs, 0)
+#else
+#define seq_vector_ref(node) ((node)->refs++)
+#define seq_vector_unref(node) (--(node)->refs)
+#define seq_vector_refs(node) ((node)->refs)
+#endif
+
+SEQ_TYPE_API(vector)
+
+/* ========================================================================= Private Vector Helpers
+ * seq_vector_index
+ *    Convert user-specified index into an absolute index, or -1 on error.
+ *
+ * seq_vector_get_index
+ *    Returns the index corresponding to the given user-specified args, or -1.
+ *
+ * seq_vector_node_create
+ *    Allocates an empty node, referenced once, with a size table if it's to be relaxed.
+ *
+ * seq_vector_release
+ *    Drops a reference to a node at the given shift, freeing it (and releasing its children) once
+ *    none are left.
+ *
+ * seq_vector_slots
+ *    Returns the number of slots in use in a node at the given shift.
+ *
+ * seq_vector_size
+ *    Returns the number of elements in the subtree below a node at the given shift.
+ *
+ * seq_vector_span
+ *    Returns the number of elements below the child in the given slot of a node.
+ *
+ * seq_vector_measure
+ *    Fills in the size table of a relaxed node from its children.
+ *
+ * seq_vector_own
+ *    Makes sure the node in the given slot isn't shared, replacing it with a copy if it is.
+ *
+ * seq_vector_relax
+ *    Like seq_vector_own(), but also makes sure the node is relaxed.
+ *
+ * seq_vector_find
+ *    Returns the slot of the child holding the element at the given index, relative to the node,
+ *    and makes the index relative to that child.
+ *
+ * seq_vector_leaf
+ *    Returns the leaf holding the element at the given (valid) index, and its offset in there.
+ *
+ * seq_vector_path
+ *    Like seq_vector_leaf(), but owns every node along the way, so the leaf can be modified.
+ *
+ * seq_vector_full
+ *    Returns whether nothing can be appended below a node without adding a level.
+ *
+ * seq_vector_branch
+ *    Returns a new subtree at the given shift, holding a single element.
+ *
+ * seq_vector_append
+ *    Appends an element below the (non-full) node in the given slot.
+ *
+ * seq_vector_trim
+ *    Removes the last element below the node in the given slot, releasing it if it's left empty.
+ *
+ * seq_vector_take
+ *    Returns a subtree holding the first n elements below a node.
+ *
+ * seq_vector_drop
+ *    Returns a subtree holding all but the first n elements below a node.
+ *
+ * seq_vector_rebalance
+ *    Redistributes the children along the seam of a concatenation over as few nodes as needed.
+ *
+ * seq_vector_merge
+ *    Concatenates two subtrees, returning a node one level above the taller of them.
+ *
+ * seq_vector_collapse
+ *    Replaces the root for as long as it's left with a single child.
+ *
+ * seq_vector_join
+ *    Makes the concatenation of two subtrees (not both empty) the new tree of a vector.
+ *
+ * seq_vector_push
+ *    Appends an element, adding a level to the tree if the root is full.
+ *
+ * seq_vector_pop
+ *    Detaches the last element and returns it, or NULL if memory allocation fails.
+ *
+ * seq_vector_cut
+ *    Detaches the element at the given index and returns it, or NULL if memory allocation fails.
+ *
+ * seq_vector_version
+ *    Returns a new SEQ_VECTOR sharing the whole tree of another one.
+ * ============================================================================================= */
+
+static seq_index_t seq_vector_index(seq_t seq, seq_index_t index) {
+	index = index < 0 ? (seq_index_t)(seq->size) + index : index;
+
+	if(index >= (seq_index_t)(seq->size) || index < 0) return -1;
+
+	return index;
+}
+
+static seq_index_t seq_vector_get_index(seq_t seq, seq_opt_t opt, seq_args_t args) {
+	if(opt == SEQ_INDEX) return seq_vector_index(seq, seq_arg_index(args));
+
+	else if(opt == SEQ_POP) return (seq_index_t)(seq->size) - 1;
+
+	return -1;
+}
+
+static seq_vector_node_t seq_vector_node_create(seq_t seq, int relaxed) {
+	size_t size = sizeof(struct _seq_vector_node_t);
+	seq_vector_node_t node = NULL;
+
+	if(relaxed) size += SEQ_VECTOR_WIDTH * sizeof(seq_size_t);
+
+	if(!(node = (seq_vector_node_t)(calloc(1, size)))) return NULL;
+
+	node->refs = 1;
+
+	if(relaxed) node->sizes = (seq_size_t*)(node + 1);
+
+	seq_stats_add(seq, nodes_alloc, 1);
+
+	return node;
+}
+
+static void seq_vector_release(seq_t seq, seq_vector_node_t node, unsigned int shift) {
+	int i;
+
+	if(!node || seq_vector_unref(node)) return;
+
+	if(shift) {
+		for(i = 0; i < SEQ_VECTOR_WIDTH; i++) {
+			seq_vector_release(seq, node->slots[i].node, shift - SEQ_VECTOR_BITS);
+		}
+	}
+
+	free(node);
+
+	seq_stats_add(seq, nodes_free, 1);
+}
+
+static int seq_vector_slots(seq_vector_node_t node, unsigned int shift) {
+	int count = 0;
+
+	if(shift) while(count < SEQ_VECTOR_WIDTH && node->slots[count].node) count++;
+
+	else while(count < SEQ_VECTOR_WIDTH && node->slots[count].data) count++;
+
+	return count;
+}
+
+static seq_size_t seq_vector_size(seq_vector_node_t node, unsigned int shift) {
+	int count = seq_vector_slots(node, shift);
+
+	if(!shift) return (seq_size_t)(count);
+
+	if(node->sizes) return node->sizes[count - 1];
+
+	return
+		seq_vector_before(node, shift, count - 1) +
+		seq_vector_size(node->slots[count - 1].node, shift - SEQ_VECTOR_BITS)
+	;
+}
+
+/* The @size is that of the whole subtree below the node; the last child gets what's left of it. */
+static seq_size_t seq_vector_span(
+	seq_vector_node_t node,
+	unsigned int shift,
+	seq_size_t size,
+	int pos
+) {
+	seq_size_t end = size;
+
+	if(pos + 1 < SEQ_VECTOR_WIDTH && node->slots[pos + 1].node) {
+		end = seq_vector_before(node, shift, pos + 1);
+	}
+
+	return end - seq_vector_before(node, shift, pos);
+}
+
+static void seq_vector_measure(seq_vector_node_t node, unsigned int shift) {
+	seq_size_t size = 0;
+	int i;
+
+	for(i = 0; i < SEQ_VECTOR_WIDTH && node->slots[i].node; i++) {
+		node->sizes[i] = size += seq_vector_size(node->slots[i].node, shift - SEQ_VECTOR_BITS);
+	}
+}
+
+/* The copy takes over our reference to the original, and adds one of its own to every child. */
+static seq_vector_node_t seq_vector_own(seq_t seq, seq_vector_node_t* slot, unsigned int shift) {
+	seq_vector_node_t node = *slot;
+	seq_vector_node_t copy = NULL;
+	int i;
+
+	if(seq_vector_refs(node) == 1) return node;
+
+	if(!(copy = seq_vector_node_create(seq, node->sizes != NULL))) return NULL;
+
+	memcpy(copy->slots, node->slots, sizeof(node->slots));
+
+	if(node->sizes) memcpy(copy->sizes, node->sizes, SEQ_VECTOR_WIDTH * sizeof(seq_size_t));
+
+	if(shift) {
+		for(i = 0; i < SEQ_VECTOR_WIDTH; i++) {
+			if(copy->slots[i].node) seq_vector_ref(copy->slots[i].node);
+		}
+	}
+
+	seq_vector_release(seq, node, shift);
+
+	return *slot = copy;
+}
+
+/* Once owned, the regular node can simply hand its children (and their references) over. */
+static seq_vector_node_t seq_vector_relax(seq_t seq, seq_vector_node_t* slot, unsigned int shift) {
+	seq_vector_node_t node = seq_vector_own(seq, slot, shift);
+	seq_vector_node_t relaxed = NULL;
+
+	if(!node || node->sizes) return node;
+
+	if(!(relaxed = seq_vector_node_create(seq, 1))) return NULL;
+
+	memcpy(relaxed->slots, node->slots, sizeof(node->slots));
+
+	seq_vector_measure(relaxed, shift);
+
+	free(node);
+
+	seq_stats_add(seq, nodes_free, 1);
+
+	return *slot = relaxed;
+}
+
+/* No child holds more than 1 << shift elements, so the radix never overshoots the slot. */
+static int seq_vector_find(seq_vector_node_t node, unsigned int shift, seq_size_t* index) {
+	int pos = (int)(*index >> shift);
+
+	if(node->sizes) while(node->sizes[pos] <= *index) pos++;
+
+	*index -= seq_vector_before(node, shift, pos);
+
+	return pos;
+}
+
+static seq_vector_node_t seq_vector_leaf(seq_t seq, seq_size_t index, seq_size_t* offset) {
+	seq_vector_data_t data = seq_vector_data(seq);
+	seq_vector_node_t node = data->root;
+	unsigned int shift;
+
+	for(shift = data->shift; shift; shift -= SEQ_VECTOR_BITS) {
+		node = node->slots[seq_vector_find(node, shift, &index)].node;
+	}
+
+	*offset = index;
+
+	return node;
+}
+
+static seq_vector_node_t seq_vector_path(seq_t seq, seq_size_t index, seq_size_t* offset) {
+	seq_vector_data_t data = seq_vector_data(seq);
+	seq_vector_node_t* slot = &data->root;
+	seq_vector_node_t node = NULL;
+	unsigned int shift;
+
+	*offset = index;
+
+	for(shift = data->shift; ; shift -= SEQ_VECTOR_BITS) {
+		if(!(node = seq_vector_own(seq, slot, shift)) || !shift) return node;
+
+		slot = &node->slots[seq_vector_find(node, shift, offset)].node;
+	}
+}
+
+/* This only depends on the shape of the node, not on the number of elements below it: a relaxed
+ * node may well be full while holding fewer elements than a regular one would. */
+static int seq_vector_full(seq_vector_node_t node, unsigned int shift) {
+	int count = seq_vector_slots(node, shift);
+
+	if(count < SEQ_VECTOR_WIDTH) return 0;
+
+	return !shift || seq_vector_full(node->slots[count - 1].node, shift - SEQ_VECTOR_BITS);
+}
+
+static seq_vector_node_t seq_vector_branch(seq_t seq, unsigned int shift, seq_data_t d) {
+	seq_vector_node_t node = seq_vector_node_create(seq, 0);
+
+	if(!node) return NULL;
+
+	if(!shift) node->slots[0].data = d;
+
+	else if(!(node->slots[0].node = seq_vector_branch(seq, shift - SEQ_VECTOR_BITS, d))) {
+		seq_vector_release(seq, node, shift);
+
+		return NULL;
+	}
+
+	return node;
+}
+
+/* A regular node can only take on a new child after a full one, and has to be relaxed otherwise. */
+static seq_opt_t seq_vector_append(
+	seq_t seq,
+	seq_vector_node_t* slot,
+	unsigned int shift,
+	seq_data_t d
+) {
+	seq_vector_node_t node = *slot;
+	seq_vector_node_t child = NULL;
+	int count = seq_vector_slots(node, shift);
+	seq_opt_t err;
+
+	if(!shift) {
+		if(!(node = seq_vector_own(seq, slot, shift))) return SEQ_ERR_MEM;
+
+		node->slots[count].data = d;
+
+		return SEQ_ERR_NONE;
+	}
+
+	child = node->slots[count - 1].node;
+
+	if(!seq_vector_full(child, shift - SEQ_VECTOR_BITS)) {
+		if(!(node = seq_vector_own(seq, slot, shift))) return SEQ_ERR_MEM;
+
+		err = seq_vector_append(seq, &node->slots[count - 1].node, shift - SEQ_VECTOR_BITS, d);
+
+		if(err) return err;
+
+		if(node->sizes) node->sizes[count - 1]++;
+
+		return SEQ_ERR_NONE;
+	}
+
+	if(!node->sizes && seq_vector_size(child, shift - SEQ_VECTOR_BITS) >> shift != 1) {
+		node = seq_vector_relax(seq, slot, shift);
+	}
+
+	else node = seq_vector_own(seq, slot, shift);
+
+	if(!node) return SEQ_ERR_MEM;
+
+	if(!(node->slots[count].node = seq_vector_branch(seq, shift - SEQ_VECTOR_BITS, d))) {
+		return SEQ_ERR_MEM;
+	}
+
+	if(node->sizes) node->sizes[count] = node->sizes[count - 1] + 1;
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_opt_t seq_vector_trim(
+	seq_t seq,
+	seq_vector_node_t* slot,
+	unsigned int shift,
+	seq_size_t size
+) {
+	seq_vector_node_t node = NULL;
+	int count;
+	seq_opt_t err;
+
+	if(size == 1) {
+		seq_vector_release(seq, *slot, shift);
+
+		*slot = NULL;
+
+		return SEQ_ERR_NONE;
+	}
+
+	if(!(node = seq_vector_own(seq, slot, shift))) return SEQ_ERR_MEM;
+
+	if(!shift) {
+		node->slots[size - 1].data = NULL;
+
+		return SEQ_ERR_NONE;
+	}
+
+	count = seq_vector_slots(node, shift);
+
+	err = seq_vector_trim(
+		seq,
+		&node->slots[count - 1].node,
+		shift - SEQ_VECTOR_BITS,
+		seq_vector_span(node, shift, size, count - 1)
+	);
+
+	if(err) return err;
+
+	if(node->sizes) node->sizes[count - 1]--;
+
+	return SEQ_ERR_NONE;
+}
+
+/* Every child but the last one kept is shared, so a regular node stays regular. */
+static seq_vector_node_t seq_vector_take(
+	seq_t seq,
+	seq_vector_node_t node,
+	unsigned int shift,
+	seq_size_t size,
+	seq_size_t n
+) {
+	seq_vector_node_t copy = NULL;
+	seq_vector_node_t child = NULL;
+	seq_size_t index = n - 1;
+	int pos, i;
+
+	if(n == size) {
+		seq_vector_ref(node);
+
+		return node;
+	}
+
+	if(!(copy = seq_vector_node_create(seq, node->sizes != NULL))) return NULL;
+
+	if(!shift) {
+		memcpy(copy->slots, node->slots, n * sizeof(seq_vector_slot_t));
+
+		return copy;
+	}
+
+	pos = seq_vector_find(node, shift, &index);
+
+	child = seq_vector_take(
+		seq,
+		node->slots[pos].node,
+		shift - SEQ_VECTOR_BITS,
+		seq_vector_span(node, shift, size, pos),
+		index + 1
+	);
+
+	if(!child) {
+		seq_vector_release(seq, copy, shift);
+
+		return NULL;
+	}
+
+	for(i = 0; i < pos; i++) {
+		copy->slots[i].node = node->slots[i].node;
+
+		seq_vector_ref(copy->slots[i].node);
+	}
+
+	copy->slots[pos].node = child;
+
+	if(copy->sizes) {
+		memcpy(copy->sizes, node->sizes, pos * sizeof(seq_size_t));
+
+		copy->sizes[pos] = n;
+	}
+
+	return copy;
+}
+
+/* The first child kept is (usually) cut short, so the copy is always relaxed. */
+static seq_vector_node_t seq_vector_drop(
+	seq_t seq,
+	seq_vector_node_t node,
+	unsigned int shift,
+	seq_size_t size,
+	seq_size_t n
+) {
+	seq_vector_node_t copy = NULL;
+	seq_vector_node_t child = NULL;
+	seq_size_t index = n;
+	int count, pos, i;
+
+	if(!n) {
+		seq_vector_ref(node);
+
+		return node;
+	}
+
+	if(!(copy = seq_vector_node_create(seq, shift != 0))) return NULL;
+
+	if(!shift) {
+		memcpy(copy->slots, &node->slots[n], (size - n) * sizeof(seq_vector_slot_t));
+
+		return copy;
+	}
+
+	count = seq_vector_slots(node, shift);
+	pos = seq_vector_find(node, shift, &index);
+
+	child = seq_vector_drop(
+		seq,
+		node->slots[pos].node,
+		shift - SEQ_VECTOR_BITS,
+		seq_vector_span(node, shift, size, pos),
+		index
+	);
+
+	if(!child) {
+		seq_vector_release(seq, copy, shift);
+
+		return NULL;
+	}
+
+	copy->slots[0].node = child;
+
+	for(i = pos; i < count; i++) {
+		if(i > pos) {
+			copy->slots[i - pos].node = node->slots[i].node;
+
+			seq_vector_ref(copy->slots[i - pos].node);
+		}
+
+		copy->sizes[i - pos] = seq_vector_before(node, shift, i) +
+			seq_vector_span(node, shift, size, i) - n;
+	}
+
+	return copy;
+}
+
+/* The children of @mid (all at the given shift, like @left and @right) are taken along with those
+ * of @left but its last, and those of @right but its first, which @mid was built from. Following
+ * the concatenation plan of L'orange ("Improving RRB-Tree Performance through Transience"), the
+ * first node that isn't nearly full has its slots spread over the nodes after it, one after the
+ * other, until no more than SEQ_VECTOR_EXTRAS nodes remain than the total number of slots needs.
+ * The nodes that come out unchanged are shared; the rest are rebuilt. Since @left and @right hold
+ * 32 children at most, so do the two nodes below the one returned. Consumes @mid. */
+static seq_vector_node_t seq_vector_rebalance(
+	seq_t seq,
+	seq_vector_node_t left,
+	seq_vector_node_t mid,
+	seq_vector_node_t right,
+	unsigned int shift
+) {
+	seq_vector_node_t all[SEQ_VECTOR_WIDTH * 2];
+	int slots[SEQ_VECTOR_WIDTH * 2];
+	int plan[SEQ_VECTOR_WIDTH * 2 + 1];
+	seq_vector_node_t top = NULL;
+	seq_vector_node_t node = NULL;
+	seq_vector_node_t out = NULL;
+	unsigned int below = shift - SEQ_VECTOR_BITS;
+	int n = 0, m, total = 0, i, j, k, src, off, take;
+
+	if(left) for(i = 0; i < seq_vector_slots(left, shift) - 1; i++) all[n++] = left->slots[i].node;
+
+	for(i = 0; i < seq_vector_slots(mid, shift); i++) all[n++] = mid->slots[i].node;
+
+	if(right) for(i = 1; i < seq_vector_slots(right, shift); i++) all[n++] = right->slots[i].node;
+
+	for(i = 0; i < n; i++) total += plan[i] = slots[i] = seq_vector_slots(all[i], below);
+
+	plan[n] = 0;
+
+	for(m = n, i = 0; (total + SEQ_VECTOR_WIDTH - 1) / SEQ_VECTOR_WIDTH + SEQ_VECTOR_EXTRAS < m; ) {
+		while(plan[i] > SEQ_VECTOR_WIDTH - SEQ_VECTOR_INVARIANT) i++;
+
+		for(k = plan[i]; k > 0; i++) {
+			j = k + plan[i + 1] < SEQ_VECTOR_WIDTH ? k + plan[i + 1] : SEQ_VECTOR_WIDTH;
+			k += plan[i + 1] - j;
+			plan[i] = j;
+		}
+
+		for(j = i; j < m - 1; j++) plan[j] = plan[j + 1];
+
+		m--;
+		i--;
+	}
+
+	if(!(top = seq_vector_node_create(seq, 1))) goto fail;
+
+	for(i = 0; i * SEQ_VECTOR_WIDTH < m; i++) {
+		if(!(top->slots[i].node = seq_vector_node_create(seq, 1))) goto fail;
+	}
+
+	for(k = 0, src = 0, off = 0; k < m; k++) {
+		node = top->slots[k / SEQ_VECTOR_WIDTH].node;
+
+		if(!off && slots[src] == plan[k]) {
+			seq_vector_ref(out = all[src++]);
+		}
+
+		else {
+			if(!(out = seq_vector_node_create(seq, below != 0))) goto fail;
+
+			for(j = 0; j < plan[k]; j += take) {
+				take = slots[src] - off < plan[k] - j ? slots[src] - off : plan[k] - j;
+
+				memcpy(&out->slots[j], &all[src]->slots[off], take * sizeof(seq_vector_slot_t));
+
+				if(below) for(i = j; i < j + take; i++) seq_vector_ref(out->slots[i].node);
+
+				if((off += take) == slots[src]) {
+					src++;
+					off = 0;
+				}
+			}
+
+			if(below) seq_vector_measure(out, below);
+		}
+
+		node->slots[k % SEQ_VECTOR_WIDTH].node = out;
+	}
+
+	for(i = 0; i < SEQ_VECTOR_WIDTH && top->slots[i].node; i++) {
+		seq_vector_measure(top->slots[i].node, shift);
+	}
+
+	seq_vector_measure(top, shift + SEQ_VECTOR_BITS);
+	seq_vector_release(seq, mid, shift);
+
+	return top;
+
+	fail:
+
+	seq_vector_release(seq, top, shift + SEQ_VECTOR_BITS);
+	seq_vector_release(seq, mid, shift);
+
+	return NULL;
+}
+
+/* Only the nodes along the seam are touched: the taller side is descended first, until both sides
+ * are at the same height, and then both, down to the leaves. Two leaves are merged into one if they
+ * fit, and simply put side by side otherwise. The subtrees themselves are merely borrowed. */
+static seq_vector_node_t seq_vector_merge(
+	seq_t seq,
+	seq_vector_node_t left,
+	unsigned int ls,
+	seq_vector_node_t right,
+	unsigned int rs
+) {
+	seq_vector_node_t mid = NULL;
+	seq_vector_node_t node = NULL;
+	seq_vector_node_t leaf = NULL;
+	int lc = seq_vector_slots(left, ls);
+	int rc = seq_vector_slots(right, rs);
+
+	if(ls > rs) {
+		mid = seq_vector_merge(seq, left->slots[lc - 1].node, ls - SEQ_VECTOR_BITS, right, rs);
+
+		return mid ? seq_vector_rebalance(seq, left, mid, NULL, ls) : NULL;
+	}
+
+	if(ls < rs) {
+		mid = seq_vector_merge(seq, left, ls, right->slots[0].node, rs - SEQ_VECTOR_BITS);
+
+		return mid ? seq_vector_rebalance(seq, NULL, mid, right, rs) : NULL;
+	}
+
+	if(ls) {
+		mid = seq_vector_merge(
+			seq,
+			left->slots[lc - 1].node,
+			ls - SEQ_VECTOR_BITS,
+			right->slots[0].node,
+			rs - SEQ_VECTOR_BITS
+		);
+
+		return mid ? seq_vector_rebalance(seq, left, mid, right, ls) : NULL;
+	}
+
+	if(!(node = seq_vector_node_create(seq, 1))) return NULL;
+
+	if(lc + rc <= SEQ_VECTOR_WIDTH) {
+		if(!(leaf = seq_vector_node_create(seq, 0))) {
+			seq_vector_release(seq, node, SEQ_VECTOR_BITS);
+
+			return NULL;
+		}
+
+		memcpy(leaf->slots, left->slots, lc * sizeof(seq_vector_slot_t));
+		memcpy(&leaf->slots[lc], right->slots, rc * sizeof(seq_vector_slot_t));
+
+		node->slots[0].node = leaf;
+	}
+
+	else {
+		node->slots[0].node = left;
+		node->slots[1].node = right;
+
+		seq_vector_ref(left);
+		seq_vector_ref(right);
+	}
+
+	seq_vector_measure(node, SEQ_VECTOR_BITS);
+
+	return node;
+}
+
+/* The root may be shared, so it's referenced rather than detached. */
+static void seq_vector_collapse(seq_t seq, seq_vector_data_t data) {
+	seq_vector_node_t root = NULL;
+
+	while(data->shift && seq_vector_slots(data->root, data->shift) == 1) {
+		root = data->root;
+
+		data->root = root->slots[0].node;
+
+		seq_vector_ref(data->root);
+		seq_vector_release(seq, root, data->shift);
+
+		data->shift -= SEQ_VECTOR_BITS;
+	}
+}
+
+/* Either subtree may be NULL (but not both), in which case the other one is simply shared. The old
+ * tree of the vector is released only once the new one is complete; the subtrees are borrowed. */
+static seq_opt_t seq_vector_join(
+	seq_t seq,
+	seq_vector_node_t left,
+	unsigned int ls,
+	seq_vector_node_t right,
+	unsigned int rs
+) {
+	seq_vector_data_t data = seq_vector_data(seq);
+	seq_vector_node_t root = NULL;
+	unsigned int shift = ls > rs ? ls : rs;
+
+	if(left && right) {
+		if(!(root = seq_vector_merge(seq, left, ls, right, rs))) return SEQ_ERR_MEM;
+
+		shift += SEQ_VECTOR_BITS;
+	}
+
+	else {
+		root = left ? left : right;
+		shift = left ? ls : rs;
+
+		seq_vector_ref(root);
+	}
+
+	seq_vector_release(seq, data->root, data->shift);
+
+	data->root = root;
+	data->shift = shift;
+
+	seq_vector_collapse(seq, data);
+
+	return SEQ_ERR_NONE;
+}
+
+/* A full root gets a new parent, which is only regular if the root held as many elements as it
+ * possibly could. */
+static seq_opt_t seq_vector_push(seq_t seq, seq_data_t d) {
+	seq_vector_data_t data = seq_vector_data(seq);
+	seq_vector_node_t root = NULL;
+	int relaxed;
+	seq_opt_t err;
+
+	if(!data->root) {
+		if(!(data->root = seq_vector_branch(seq, 0, d))) return SEQ_ERR_MEM;
+	}
+
+	else if(!seq_vector_full(data->root, data->shift)) {
+		if((err = seq_vector_append(seq, &data->root, data->shift, d))) return err;
+	}
+
+	else {
+		relaxed = seq->size >> (data->shift + SEQ_VECTOR_BITS) != 1;
+
+		if(!(root = seq_vector_node_create(seq, relaxed))) return SEQ_ERR_MEM;
+
+		if(!(root->slots[1].node = seq_vector_branch(seq, data->shift, d))) {
+			seq_vector_release(seq, root, data->shift + SEQ_VECTOR_BITS);
+
+			return SEQ_ERR_MEM;
+		}
+
+		root->slots[0].node = data->root;
+
+		if(relaxed) {
+			root->sizes[0] = seq->size;
+			root->sizes[1] = seq->size + 1;
+		}
+
+		data->root = root;
+		data->shift += SEQ_VECTOR_BITS;
+	}
+
+	seq->size++;
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_data_t seq_vector_pop(seq_t seq) {
+	seq_vector_data_t data = seq_vector_data(seq);
+	seq_size_t offset = 0;
+	seq_data_t d = seq_vector_leaf(seq, seq->size - 1, &offset)->slots[offset].data;
+
+	if(seq_vector_trim(seq, &data->root, data->shift, seq->size)) return NULL;
+
+	if(!--seq->size) data->shift = 0;
+
+	else seq_vector_collapse(seq, data);
+
+	return d;
+}
+
+/* The elements before and after the one cut are sliced off, and concatenated back together. */
+static seq_data_t seq_vector_cut(seq_t seq, seq_size_t index) {
+	seq_vector_data_t data = seq_vector_data(seq);
+	seq_vector_node_t left = NULL;
+	seq_vector_node_t right = NULL;
+	seq_size_t offset = 0;
+	seq_data_t d = seq_vector_leaf(seq, index, &offset)->slots[offset].data;
+	unsigned int shift = data->shift;
+	seq_opt_t err = SEQ_ERR_MEM;
+
+	if(index + 1 == seq->size) return seq_vector_pop(seq);
+
+	if(index && !(left = seq_vector_take(seq, data->root, shift, seq->size, index))) return NULL;
+
+	if((right = seq_vector_drop(seq, data->root, shift, seq->size, index + 1))) {
+		err = seq_vector_join(seq, left, shift, right, shift);
+	}
+
+	seq_vector_release(seq, left, shift);
+	seq_vector_release(seq, right, shift);
+
+	if(err) return NULL;
+
+	seq->size--;
+
+	return d;
+}
+
+static seq_t seq_vector_version(seq_t seq) {
+	seq_t version = seq_create(SEQ_VECTOR);
+	seq_vector_data_t src = NULL;
+	seq_vector_data_t data = NULL;
+
+	if(!version) return NULL;
+
+	if(seq->block) seq_block_lock(seq);
+
+	src = seq_vector_data(seq);
+	data = seq_vector_data(version);
+
+	if((data->root = src->root)) seq_vector_ref(data->root);
+
+	data->shift = src->shift;
+
+	version->size = seq->size;
+	version->parallel.threads = seq->parallel.threads;
+
+	if(seq->block) seq_block_unlock(seq);
+
+	return version;
+}
+
+/* ====================================================================== SEQ_VECTOR Implementation
+ * seq_vector_create
+ * seq_vector_destroy
+ * seq_vector_config
+ * seq_vector_add
+ * seq_vector_remove
+ * seq_vector_get
+ * seq_vector_set
+ * ============================================================================================= */
+
+static void seq_vector_create(seq_t seq) {
+	seq->type = SEQ_VECTOR;
+	seq->impl = seq_impl_vector();
+	seq->data = seq_malloc(seq_vector_data_t);
+}
+
+/* A snapshot never owns the elements it shares with the live vector. */
+static void seq_vector_destroy(seq_t seq) {
+	seq_vector_data_t data = seq_vector_data(seq);
+	seq_vector_node_t leaf = NULL;
+	seq_size_t offset = 0;
+	seq_size_t i = 0;
+
+	if(seq->cb.remove && !data->snapshot) {
+		while(i < seq->size) {
+			leaf = seq_vector_leaf(seq, i, &offset);
+
+			for(; offset < SEQ_VECTOR_WIDTH && leaf->slots[offset].data; offset++, i++) {
+				seq_cb_remove(seq, leaf->slots[offset].data);
+			}
+		}
+	}
+
+	seq_vector_release(seq, data->root, data->shift);
+
+	free(data);
+}
+
+static seq_opt_t seq_vector_config(seq_t seq, seq_opt_t opt, seq_args_t args) {
+	return SEQ_ERR_OPT;
+}
+
+/* Prepending concatenates a new leaf in front of the tree. */
+static seq_opt_t seq_vector_add(seq_t seq, seq_args_t args) {
+	seq_vector_data_t data = seq_vector_data(seq);
+	seq_opt_t opt = seq_arg_opt(args);
+	seq_vector_node_t leaf = NULL;
+	seq_data_t d = NULL;
+	seq_opt_t err;
+
+	if(data->snapshot || (opt != SEQ_APPEND && opt != SEQ_PREPEND)) return SEQ_ERR_OPT;
+
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+	if(opt == SEQ_APPEND || !data->root) return seq_vector_push(seq, d);
+
+	if(!(leaf = seq_vector_branch(seq, 0, d))) return SEQ_ERR_MEM;
+
+	err = seq_vector_join(seq, leaf, 0, data->root, data->shift);
+
+	seq_vector_release(seq, leaf, 0);
+
+	if(!err) seq->size++;
+
+	return err;
+}
+
+/* Removing any but the last element takes O(log n): the tree is split and joined around it. */
+static seq_opt_t seq_vector_remove(seq_t seq, seq_args_t args) {
+	seq_index_t index = seq_vector_get_index(seq, seq_arg_opt(args), args);
+	seq_data_t d = NULL;
+
+	if(seq_vector_data(seq)->snapshot) return SEQ_ERR_OPT;
+
+	if(index < 0) return SEQ_ERR_NODE;
+
+	if(!(d = seq_vector_cut(seq, (seq_size_t)(index)))) return SEQ_ERR_MEM;
+
+	seq_cb_remove(seq, d);
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_data_t seq_vector_get(seq_t seq, seq_args_t args) {
+	seq_opt_t opt = seq_arg_opt(args);
+	seq_index_t index = seq_vector_get_index(seq, opt, args);
+	seq_size_t offset = 0;
+
+	if(index < 0) return NULL;
+
+	if(opt == SEQ_POP) return seq_vector_data(seq)->snapshot ? NULL : seq_vector_pop(seq);
+
+	return seq_vector_leaf(seq, (seq_size_t)(index), &offset)->slots[offset].data;
+}
+
+static seq_opt_t seq_vector_set(seq_t seq, seq_args_t args) {
+	seq_opt_t opt = seq_arg_opt(args);
+	seq_vector_node_t leaf = NULL;
+	seq_index_t index = -1;
+	seq_size_t offset = 0;
+	seq_data_t d = NULL;
+
+	if(seq_vector_data(seq)->snapshot || opt == SEQ_POP) return SEQ_ERR_OPT;
+
+	if((index = seq_vector_get_index(seq, opt, args)) < 0) return SEQ_ERR_NODE;
+
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+	if(!(leaf = seq_vector_path(seq, (seq_size_t)(index), &offset))) return SEQ_ERR_MEM;
+
+	seq_cb_remove(seq, leaf->slots[offset].data);
+
+	leaf->slots[offset].data = d;
+
+	return SEQ_ERR_NONE;
+}
+
+/* ============================================================ SEQ_VECTOR Iteration Implementation
+ * seq_vector_iter_create
+ * seq_vector_iter_destroy
+ * seq_vector_iter_get
+ * seq_vector_iter_set
+ * seq_vector_iter_iterate
+ * seq_vector_iter_copy
+ * ============================================================================================= */
+
+static seq_opt_t seq_vector_iter_create(seq_iter_t iter, seq_args_t args) {
+	seq_vector_iter_data_t data = seq_malloc(seq_vector_iter_data_t);
+	seq_index_t begin = 0;
+	seq_index_t end = -1;
+	seq_opt_t opt;
+
+	if(!(iter->data = data)) return SEQ_ERR_MEM;
+
+	data->inc = 1;
+
+	while((opt = seq_arg_opt(args))) {
+		if(opt == SEQ_RANGE) {
+			begin = seq_arg_index(args);
+			end = seq_arg_index(args);
+		}
+
+		else if(opt == SEQ_INC) data->inc = seq_arg(args, seq_size_t);
+
+		else return SEQ_ERR_OPT;
+	}
+
+	if(!data->inc) return SEQ_ERR_OPT;
+
+	begin = seq_vector_index(iter->seq, begin);
+	end = seq_vector_index(iter->seq, end);
+
+	if(begin < 0 || end < begin) iter->state = SEQ_STOP;
+
+	else {
+		data->range.begin = (seq_size_t)(begin);
+		data->range.end = (seq_size_t)(end);
+	}
+
+	return SEQ_ERR_NONE;
+}
+
+static void seq_vector_iter_destroy(seq_iter_t iter) {
+}
+
+static seq_data_t seq_vector_iter_get(seq_iter_t iter, seq_args_t args) {
+	seq_vector_iter_data_t data = seq_vector_iter_data(iter);
+
+	if(seq_arg_opt(args) == SEQ_DATA) return data->leaf->slots[data->index - data->base].data;
+
+	return NULL;
+}
+
+/* The leaf may have been copied, in which case the iterator follows along. */
+static seq_opt_t seq_vector_iter_set(seq_iter_t iter, seq_args_t args) {
+	seq_vector_iter_data_t data = seq_vector_iter_data(iter);
+	seq_t seq = iter->seq;
+	seq_vector_node_t leaf = NULL;
+	seq_size_t offset = 0;
+	seq_data_t d = NULL;
+
+	if(seq_arg_opt(args) != SEQ_DATA || seq_vector_data(seq)->snapshot) return SEQ_ERR_OPT;
+
+	if(!(d = seq_cb_add(seq, args))) return SEQ_ERR_DATA;
+
+	if(!(leaf = seq_vector_path(seq, data->index, &offset))) return SEQ_ERR_MEM;
+
+	seq_cb_remove(seq, leaf->slots[offset].data);
+
+	leaf->slots[offset].data = d;
+
+	data->leaf = leaf;
+
+	return SEQ_ERR_NONE;
+}
+
+static seq_opt_t seq_vector_iter_iterate(seq_iter_t iter) {
+	seq_vector_iter_data_t data = seq_vector_iter_data(iter);
+	seq_size_t offset = 0;
+
+	if(iter->state == SEQ_READY) data->index = data->range.begin;
+
+	else data->index += data->inc;
+
+	if(data->index > data->range.end || data->index >= iter->seq->size) return SEQ_STOP;
+
+	if(!data->leaf || data->index >= data->end) {
+		data->leaf = seq_vector_leaf(iter->seq, data->index, &offset);
+		data->base = data->index - offset;
+		data->end = data->base + seq_vector_slots(data->leaf, 0);
+	}
+
+	return SEQ_ACTIVE;
+}
+
+static seq_opt_t seq_vector_iter_copy(seq_iter_t iter, seq_iter_t src) {
+	seq_vector_iter_data_t data = seq_malloc(seq_vector_iter_data_t);
+
+	if(!(iter->data = data)) return SEQ_ERR_MEM;
+
+	*data = *seq_vector_iter_data(src);
+
+	return SEQ_ERR_NONE;
+}
+
+/* ===================================================================================== Snapshots
+ * seq_snapshot
+ * ============================================================================================= */
+
+/* Taking a snapshot merely shares the root, so it costs the same no matter the size. */
+seq_t seq_snapshot(seq_t seq) {
+	seq_t snapshot = NULL;
+
+	if(seq->type != SEQ_VECTOR || !(snapshot = seq_vector_version(seq))) return NULL;
+
+	seq_vector_data(snapshot)->snapshot = 1;
+
+	return snapshot;
+}
+
+/* ====================================================================================== Versions
+ * seq_update
+ * seq_concat
+ * seq_slice
+ * ============================================================================================= */
+
+seq_t seq_update(seq_t seq, seq_index_t index, seq_data_t data) {
+	seq_t version = NULL;
+
+	if(seq->type != SEQ_VECTOR || !(version = seq_vector_version(seq))) return NULL;
+
+	if(seq_set(version, SEQ_INDEX, index, data)) {
+		seq_destroy(version);
+
+		return NULL;
+	}
+
+	return version;
+}
+
+seq_t seq_concat(seq_t left, seq_t right) {
+	seq_t version = NULL;
+	seq_vector_data_t l = NULL;
+	seq_vector_data_t r = NULL;
+
+	if(left->type != SEQ_VECTOR || right->type != SEQ_VECTOR) return NULL;
+
+	if(!right->size) return seq_vector_version(left);
+
+	if(!left->size) return seq_vector_version(right);
+
+	if(!(version = seq_create(SEQ_VECTOR))) return NULL;
+
+	l = seq_vector_data(left);
+	r = seq_vector_data(right);
+
+	if(seq_vector_join(version, l->root, l->shift, r->root, r->shift)) {
+		seq_destroy(version);
+
+		return NULL;
+	}
+
+	version->size = left->size + right->size;
+	version->parallel.threads = left->parallel.threads;
+
+	return version;
+}
+
+/* A slice that turns out empty is still a (new, empty) SEQ_VECTOR. */
+seq_t seq_slice(seq_t seq, seq_index_t begin, seq_index_t end) {
+	seq_vector_data_t src = seq_vector_data(seq);
+	seq_vector_node_t left = NULL;
+	seq_vector_node_t right = NULL;
+	seq_t version = NULL;
+	seq_opt_t err = SEQ_ERR_MEM;
+
+	if(seq->type != SEQ_VECTOR || !(version = seq_create(SEQ_VECTOR))) return NULL;
+
+	begin = seq_vector_index(seq, begin);
+	end = seq_vector_index(seq, end);
+
+	version->parallel.threads = seq->parallel.threads;
+
+	if(begin < 0 || end < begin) return version;
+
+	left = seq_vector_take(version, src->root, src->shift, seq->size, (seq_size_t)(end) + 1);
+
+	if(left) {
+		right = seq_vector_drop(
+			version,
+			left,
+			src->shift,
+			(seq_size_t)(end) + 1,
+			(seq_size_t)(begin)
+		);
+	}
+
+	if(right) err = seq_vector_join(version, NULL, 0, right, src->shift);
+
+	seq_vector_release(version, left, src->shift);
+	seq_vector_release(version, right, src->shift);
+
+	if(err) {
+		seq_destroy(version);
+
+		return NULL;
+	}
+
+	version->size = (seq_size_t)(end - begin) + 1;
+
+	return version;
+}
@@ -0,0 +1,361 @@
+#include "seq-api.h"
+
+/* ======================================================================== Types, Constants, Enums
+ * struct _seq_view_stage_t
+ * struct _seq_view_t
+ * seq_view_stage_t
+ * --------------------------------------------------------------------------------------------- */
+
+typedef struct _seq_view_stage_t* seq_view_stage_t;
+
+/* The stages of a view are stored inline, so composing one never allocates anything beyond the
+ * view itself. */
+#define SEQ_VIEW_STAGES 16
+
+#define SEQ_VIEW_FILTER 1
+#define SEQ_VIEW_MAP 2
+#define SEQ_VIEW_SKIP 3
+#define SEQ_VIEW_TAKE 4
+#define SEQ_VIEW_STRIDE 5
+
+/* Every stage counts the elements that reached it during the current pass in @seen. A stage that
+ * was folded into the SEQ_RANGE and SEQ_INC of the source iterator is marked @pushed, and is then
+ * skipped entirely. */
+struct _seq_view_stage_t {
+	int kind;
+	int pushed;
+	seq_size_t n;
+	seq_size_t seen;
+	seq_data_t ctx;
+
+	struct {
+		seq_cb_pred_t pred;
+		seq_cb_map_t map;
+	} cb;
+};
+
+/* The @last flag is raised once a SEQ_VIEW_TAKE stage has let its final element through, so the
+ * pass can end without pulling (and filtering, and mapping) one more element from the source. */
+struct _seq_view_t {
+	seq_t seq;
+	seq_iter_t iter;
+	seq_opt_t state;
+	seq_opt_t err;
+	seq_data_t data;
+	int last;
+	seq_size_t stages;
+	struct _seq_view_stage_t stage[SEQ_VIEW_STAGES];
+};
+
+/* ========================================================================== Private View Helpers
+ * seq_view_ranged
+ *    Returns whether the iterators of a seq_t instance support SEQ_RANGE and SEQ_INC.
+ *
+ * seq_view_reset
+ *    Abandons the current pass, if any, so that the next one starts from the beginning.
+ *
+ * seq_view_stage
+ *    Appends a stage of the given kind, destroying the view (and returning NULL) if it's invalid.
+ *
+ * seq_view_begin
+ *    Starts a new pass, folding the leading index-based stages into the source iterator.
+ *
+ * seq_view_pass
+ *    Runs an element through the remaining stages, returning SEQ_ACTIVE if it comes out the end.
+ * ============================================================================================= */
+
+static int seq_view_ranged(seq_t seq) {
+	return
+		seq->type == SEQ_LIST ||
+		seq->type == SEQ_QUEUE ||
+		seq->type == SEQ_STACK ||
+		seq->type == SEQ_ARRAY ||
+		seq->type == SEQ_HEAP ||
+		seq->type == SEQ_VECTOR
+	;
+}
+
+static void seq_view_reset(seq_view_t view) {
+	if(view->iter) seq_iter_destroy(view->iter);
+
+	view->iter = NULL;
+	view->state = SEQ_READY;
+	view->data = NULL;
+	view->last = 0;
+}
+
+static seq_view_stage_t seq_view_stage(seq_view_t view, int kind, int invalid) {
+	seq_view_stage_t stage = NULL;
+
+	if(!view) return NULL;
+
+	if(invalid || view->stages == SEQ_VIEW_STAGES) {
+		seq_view_destroy(view);
+
+		return NULL;
+	}
+
+	seq_view_reset(view);
+
+	stage = &view->stage[view->stages++];
+	stage->kind = kind;
+
+	return stage;
+}
+
+/* Skipping, taking and striding commute with mapping, so only a filter ends the run of stages that
+ * can be folded; what's left of the source is then described by @begin, @count and @inc. Once the
+ * count drops to 1 or less, the increment no longer matters (and must not overflow). */
+static void seq_view_begin(seq_view_t view) {
+	seq_t seq = view->seq;
+	seq_size_t begin = 0;
+	seq_size_t count = seq->size;
+	seq_size_t inc = 1;
+	int ranged = seq_view_ranged(seq);
+	int pushed = 0;
+	seq_size_t i;
+
+	view->err = SEQ_ERR_NONE;
+	view->state = SEQ_ACTIVE;
+
+	for(i = 0; i < view->stages; i++) {
+		seq_view_stage_t stage = &view->stage[i];
+		seq_size_t n = stage->n;
+
+		stage->seen = 0;
+		stage->pushed = 0;
+
+		if(!ranged || stage->kind == SEQ_VIEW_MAP) continue;
+
+		if(stage->kind == SEQ_VIEW_FILTER) ranged = 0;
+
+		else {
+			if(stage->kind == SEQ_VIEW_SKIP) {
+				n = n < count ? n : count;
+				begin += n * inc;
+				count -= n;
+			}
+
+			else if(stage->kind == SEQ_VIEW_TAKE) count = n < count ? n : count;
+
+			else {
+				count = (count / n) + (count % n ? 1 : 0);
+				inc = count > 1 ? inc * n : 1;
+			}
+
+			stage->pushed = pushed = 1;
+		}
+	}
+
+	if(pushed && !count) view->state = SEQ_STOP;
+
+	else if(pushed) view->iter = seq_iter_create(
+		seq,
+		SEQ_RANGE,
+		(seq_index_t)(begin),
+		(seq_index_t)(begin + ((count - 1) * inc)),
+		SEQ_INC,
+		inc,
+		SEQ_ERR_NONE
+	);
+
+	else view->iter = seq_iter_create(seq, SEQ_ERR_NONE);
+
+	if(view->state == SEQ_ACTIVE && !view->iter) {
+		view->err = SEQ_ERR_MEM;
+		view->state = SEQ_STOP;
+	}
+}
+
+static seq_opt_t seq_view_pass(seq_view_t view, seq_data_t* data) {
+	seq_size_t i;
+
+	for(i = 0; i < view->stages; i++) {
+		seq_view_stage_t stage = &view->stage[i];
+
+		if(stage->pushed) continue;
+
+		if(stage->kind == SEQ_VIEW_FILTER) {
+			if(!stage->cb.pred(*data, stage->ctx)) return SEQ_ERR_NONE;
+		}
+
+		else if(stage->kind == SEQ_VIEW_MAP) {
+			if(!(*data = stage->cb.map(*data, stage->ctx))) {
+				view->err = SEQ_ERR_DATA;
+
+				return SEQ_STOP;
+			}
+		}
+
+		else if(stage->kind == SEQ_VIEW_SKIP) {
+			if(stage->seen < stage->n) {
+				stage->seen++;
+
+				return SEQ_ERR_NONE;
+			}
+		}
+
+		else if(stage->kind == SEQ_VIEW_TAKE) {
+			if(stage->seen == stage->n) return SEQ_STOP;
+
+			if(++stage->seen == stage->n) view->last = 1;
+		}
+
+		else if(stage->seen++ % stage->n) return SEQ_ERR_NONE;
+	}
+
+	return SEQ_ACTIVE;
+}
+
+/* ======================================================================================= View API
+ * seq_view_create
+ * seq_view_destroy
+ * seq_view_filter
+ * seq_view_map
+ * seq_view_skip
+ * seq_view_take
+ * seq_view_stride
+ * seq_view_iterate
+ * seq_view_get
+ * seq_view_collect
+ * seq_view_reduce
+ * ============================================================================================= */
+
+seq_view_t seq_view_create(seq_t seq) {
+	seq_view_t view = NULL;
+
+	if(!seq || !(view = seq_malloc(seq_view_t))) return NULL;
+
+	view->seq = seq;
+	view->state = SEQ_READY;
+
+	return view;
+}
+
+void seq_view_destroy(seq_view_t view) {
+	if(!view) return;
+
+	seq_view_reset(view);
+
+	free(view);
+}
+
+seq_view_t seq_view_filter(seq_view_t view, seq_cb_pred_t pred, seq_data_t ctx) {
+	seq_view_stage_t stage = seq_view_stage(view, SEQ_VIEW_FILTER, !pred);
+
+	if(!stage) return NULL;
+
+	stage->cb.pred = pred;
+	stage->ctx = ctx;
+
+	return view;
+}
+
+seq_view_t seq_view_map(seq_view_t view, seq_cb_map_t map, seq_data_t ctx) {
+	seq_view_stage_t stage = seq_view_stage(view, SEQ_VIEW_MAP, !map);
+
+	if(!stage) return NULL;
+
+	stage->cb.map = map;
+	stage->ctx = ctx;
+
+	return view;
+}
+
+seq_view_t seq_view_skip(seq_view_t view, seq_size_t n) {
+	seq_view_stage_t stage = seq_view_stage(view, SEQ_VIEW_SKIP, 0);
+
+	if(!stage) return NULL;
+
+	stage->n = n;
+
+	return view;
+}
+
+seq_view_t seq_view_take(seq_view_t view, seq_size_t n) {
+	seq_view_stage_t stage = seq_view_stage(view, SEQ_VIEW_TAKE, 0);
+
+	if(!stage) return NULL;
+
+	stage->n = n;
+
+	return view;
+}
+
+seq_view_t seq_view_stride(seq_view_t view, seq_size_t n) {
+	seq_view_stage_t stage = seq_view_stage(view, SEQ_VIEW_STRIDE, !n);
+
+	if(!stage) return NULL;
+
+	stage->n = n;
+
+	return view;
+}
+
+seq_opt_t seq_view_iterate(seq_view_t view) {
+	seq_data_t data = NULL;
+	seq_opt_t pass;
+
+	if(view->state == SEQ_READY) seq_view_begin(view);
+
+	while(view->state == SEQ_ACTIVE && !view->last && seq_iterate(view->iter)) {
+		data = seq_iter_get(view->iter, SEQ_DATA);
+
+		if((pass = seq_view_pass(view, &data)) == SEQ_ACTIVE) {
+			view->data = data;
+
+			return SEQ_ACTIVE;
+		}
+
+		if(pass == SEQ_STOP) break;
+	}
+
+	seq_view_reset(view);
+
+	return SEQ_ERR_NONE;
+}
+
+seq_data_t seq_view_get(seq_view_t view) {
+	return view->data;
+}
+
+seq_t seq_view_collect(seq_view_t view, seq_opt_t type) {
+	seq_t out = seq_create(type);
+
+	if(!out) return NULL;
+
+	seq_view_reset(view);
+
+	while(seq_view_iterate(view)) {
+		if((view->err = seq_add(out, SEQ_APPEND, view->data))) {
+			seq_view_reset(view);
+
+			break;
+		}
+	}
+
+	if(view->err) {
+		seq_destroy(out);
+
+		return NULL;
+	}
+
+	return out;
+}
+
+seq_data_t seq_view_reduce(
+	seq_view_t view,
+	seq_cb_reduce_t reduce,
+	seq_data_t identity,
+	seq_data_t ctx
+) {
+	seq_data_t acc = identity;
+
+	if(!reduce) return identity;
+
+	seq_view_reset(view);
+
+	while(seq_view_iterate(view)) acc = reduce(acc, view->data, ctx);
+
+	return acc;
+}
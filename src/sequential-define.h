@@ -0,0 +1,423 @@
+#ifndef SEQUENTIAL_DEFINE_H
+#define SEQUENTIAL_DEFINE_H 1
+
+#include "sequential.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* ====================================================================== Type-Specialized Sequences
+ * SEQ_DEFINE_LIST
+ * SEQ_DEFINE_ARRAY
+ * SEQ_DEFINE_MAP
+ * ============================================================================================= */
+
+/* The regular seq_t API stores everything as a seq_data_t and goes through function pointers for
+ * every comparison and removal, which keeps the compiler from inlining (let alone vectorizing)
+ * anything. The macros in this header instead generate a complete, strongly-typed container for a
+ * specific element type, storing the elements BY VALUE and calling the comparator and destructor
+ * directly, much like a C++ template would. Nothing here depends on the compiled library; only the
+ * types and SEQ_ERR constants of sequential.h are shared.
+ *
+ *    #define int_cmp(a, b) seq_define_cmp(a, b)
+ *
+ *    SEQ_DEFINE_ARRAY(ints, int, int_cmp, seq_define_nop)
+ *
+ *    ints_t a = ints_create();
+ *    int* i;
+ *
+ *    ints_append(a, 3);
+ *    ints_append(a, 1);
+ *    ints_sort(a);
+ *
+ *    for(i = ints_first(a); i; i = ints_next(a, i)) printf("%d\n", *i);
+ *
+ *    ints_destroy(a);
+ *
+ * The @cmp argument is a function (or function-like macro) that's passed two const pointers to the
+ * elements (or, for SEQ_DEFINE_MAP, to the keys) and returns a negative, zero or positive value, as
+ * with qsort(). The @dtor argument is passed a pointer to every element that's removed (for
+ * SEQ_DEFINE_MAP, a pointer to the whole name_entry_t). Every generated function is static and
+ * (where the compiler allows it) inline, so each translation unit only pays for what it uses. */
+
+#if defined(__GNUC__)
+	#define SEQ_INLINE static __inline__
+#elif defined(_MSC_VER)
+	#define SEQ_INLINE static __inline
+#else
+	#define SEQ_INLINE static
+#endif
+
+/* A comparator for any type that supports the relational operators, and a destructor that does
+ * nothing at all. */
+#define seq_define_cmp(a, b) (*(a) < *(b) ? -1 : (*(b) < *(a) ? 1 : 0))
+#define seq_define_nop(p) ((void)(p))
+
+/* The same growth policy SEQ_ARRAY uses: start at 16 elements, then double. */
+#define SEQ_DEFINE_CAPACITY 16
+
+/* Generates a doubly-linked list of @T values named @name_t, where every node embeds its element.
+ *
+ *    name_t name_create(void)
+ *    void name_destroy(name_t seq)
+ *    seq_size_t name_size(name_t seq)
+ *    seq_opt_t name_append(name_t seq, T val)
+ *    seq_opt_t name_prepend(name_t seq, T val)
+ *    T* name_get(name_t seq, seq_index_t index)
+ *    seq_opt_t name_remove(name_t seq, seq_index_t index)
+ *    seq_index_t name_find(name_t seq, const T* val)
+ *    T* name_first(name_t seq)
+ *    T* name_next(name_t seq, T* val)
+ *
+ * As with SEQ_LIST, negative indices count from the back, and name_get() walks from whichever end
+ * is closer. Returned pointers remain valid until that element is removed. */
+#define SEQ_DEFINE_LIST(name, T, cmp, dtor) \
+	typedef struct _##name##_node_t* name##_node_t; \
+	typedef struct _##name##_t* name##_t; \
+	struct _##name##_node_t { \
+		name##_node_t next; \
+		name##_node_t prev; \
+		T data; \
+	}; \
+	struct _##name##_t { \
+		name##_node_t front; \
+		name##_node_t back; \
+		seq_size_t size; \
+	}; \
+	SEQ_INLINE name##_node_t name##_node(name##_t seq, seq_index_t index) { \
+		name##_node_t node = NULL; \
+		seq_size_t i; \
+		if(index < 0) index += (seq_index_t)(seq->size); \
+		if(index < 0 || index >= (seq_index_t)(seq->size)) return NULL; \
+		if((seq_size_t)(index) > seq->size / 2) { \
+			node = seq->back; \
+			for(i = seq->size - 1; i > (seq_size_t)(index); i--) node = node->prev; \
+		} \
+		else { \
+			node = seq->front; \
+			for(i = 0; i < (seq_size_t)(index); i++) node = node->next; \
+		} \
+		return node; \
+	} \
+	SEQ_INLINE name##_node_t name##_node_of(T* val) { \
+		return (name##_node_t)((char*)(val) - offsetof(struct _##name##_node_t, data)); \
+	} \
+	SEQ_INLINE name##_t name##_create(void) { \
+		return (name##_t)(calloc(1, sizeof(struct _##name##_t))); \
+	} \
+	SEQ_INLINE void name##_destroy(name##_t seq) { \
+		name##_node_t node = seq->front; \
+		while(node) { \
+			name##_node_t next = node->next; \
+			dtor(&node->data); \
+			free(node); \
+			node = next; \
+		} \
+		free(seq); \
+	} \
+	SEQ_INLINE seq_size_t name##_size(name##_t seq) { \
+		return seq->size; \
+	} \
+	SEQ_INLINE seq_opt_t name##_append(name##_t seq, T val) { \
+		name##_node_t node = (name##_node_t)(malloc(sizeof(struct _##name##_node_t))); \
+		if(!node) return SEQ_ERR_MEM; \
+		node->data = val; \
+		node->next = NULL; \
+		node->prev = seq->back; \
+		if(seq->back) seq->back->next = node; \
+		else seq->front = node; \
+		seq->back = node; \
+		seq->size++; \
+		return SEQ_ERR_NONE; \
+	} \
+	SEQ_INLINE seq_opt_t name##_prepend(name##_t seq, T val) { \
+		name##_node_t node = (name##_node_t)(malloc(sizeof(struct _##name##_node_t))); \
+		if(!node) return SEQ_ERR_MEM; \
+		node->data = val; \
+		node->prev = NULL; \
+		node->next = seq->front; \
+		if(seq->front) seq->front->prev = node; \
+		else seq->back = node; \
+		seq->front = node; \
+		seq->size++; \
+		return SEQ_ERR_NONE; \
+	} \
+	SEQ_INLINE T* name##_get(name##_t seq, seq_index_t index) { \
+		name##_node_t node = name##_node(seq, index); \
+		return node ? &node->data : NULL; \
+	} \
+	SEQ_INLINE seq_opt_t name##_remove(name##_t seq, seq_index_t index) { \
+		name##_node_t node = name##_node(seq, index); \
+		if(!node) return SEQ_ERR_NODE; \
+		if(node->prev) node->prev->next = node->next; \
+		else seq->front = node->next; \
+		if(node->next) node->next->prev = node->prev; \
+		else seq->back = node->prev; \
+		dtor(&node->data); \
+		free(node); \
+		seq->size--; \
+		return SEQ_ERR_NONE; \
+	} \
+	SEQ_INLINE seq_index_t name##_find(name##_t seq, const T* val) { \
+		name##_node_t node; \
+		seq_index_t i = 0; \
+		for(node = seq->front; node; node = node->next, i++) { \
+			if(!cmp((const T*)(&node->data), val)) return i; \
+		} \
+		return -1; \
+	} \
+	SEQ_INLINE T* name##_first(name##_t seq) { \
+		return seq->front ? &seq->front->data : NULL; \
+	} \
+	SEQ_INLINE T* name##_next(name##_t seq, T* val) { \
+		name##_node_t node = name##_node_of(val)->next; \
+		(void)(seq); \
+		return node ? &node->data : NULL; \
+	}
+
+/* Generates a contiguous, growable array of @T values named @name_t.
+ *
+ *    name_t name_create(void)
+ *    void name_destroy(name_t seq)
+ *    seq_size_t name_size(name_t seq)
+ *    seq_opt_t name_append(name_t seq, T val)
+ *    seq_opt_t name_prepend(name_t seq, T val)
+ *    seq_opt_t name_insert(name_t seq, seq_index_t index, T val)
+ *    T* name_get(name_t seq, seq_index_t index)
+ *    seq_opt_t name_remove(name_t seq, seq_index_t index)
+ *    seq_index_t name_find(name_t seq, const T* val)
+ *    void name_sort(name_t seq)
+ *    T* name_first(name_t seq)
+ *    T* name_next(name_t seq, T* val)
+ *
+ * The name_insert() function places the element BEFORE the given index (or at the very end, if the
+ * index equals the size). Returned pointers are only valid until the array is next modified. */
+#define SEQ_DEFINE_ARRAY(name, T, cmp, dtor) \
+	typedef struct _##name##_t* name##_t; \
+	struct _##name##_t { \
+		T* buf; \
+		seq_size_t size; \
+		seq_size_t capacity; \
+	}; \
+	SEQ_INLINE seq_index_t name##_index(name##_t seq, seq_index_t index, seq_size_t end) { \
+		if(index < 0) index += (seq_index_t)(seq->size); \
+		if(index < 0 || index >= (seq_index_t)(seq->size + end)) return -1; \
+		return index; \
+	} \
+	SEQ_INLINE seq_opt_t name##_reserve(name##_t seq, seq_size_t capacity) { \
+		seq_size_t n = seq->capacity ? seq->capacity : SEQ_DEFINE_CAPACITY; \
+		T* buf; \
+		if(capacity <= seq->capacity) return SEQ_ERR_NONE; \
+		while(n < capacity) n *= 2; \
+		if(!(buf = (T*)(realloc(seq->buf, n * sizeof(T))))) return SEQ_ERR_MEM; \
+		seq->buf = buf; \
+		seq->capacity = n; \
+		return SEQ_ERR_NONE; \
+	} \
+	SEQ_INLINE name##_t name##_create(void) { \
+		return (name##_t)(calloc(1, sizeof(struct _##name##_t))); \
+	} \
+	SEQ_INLINE void name##_destroy(name##_t seq) { \
+		seq_size_t i; \
+		for(i = 0; i < seq->size; i++) dtor(&seq->buf[i]); \
+		free(seq->buf); \
+		free(seq); \
+	} \
+	SEQ_INLINE seq_size_t name##_size(name##_t seq) { \
+		return seq->size; \
+	} \
+	SEQ_INLINE seq_opt_t name##_append(name##_t seq, T val) { \
+		if(seq->size == seq->capacity && name##_reserve(seq, seq->size + 1)) return SEQ_ERR_MEM; \
+		seq->buf[seq->size++] = val; \
+		return SEQ_ERR_NONE; \
+	} \
+	SEQ_INLINE seq_opt_t name##_insert(name##_t seq, seq_index_t index, T val) { \
+		if((index = name##_index(seq, index, 1)) < 0) return SEQ_ERR_NODE; \
+		if(seq->size == seq->capacity && name##_reserve(seq, seq->size + 1)) return SEQ_ERR_MEM; \
+		memmove( \
+			seq->buf + index + 1, \
+			seq->buf + index, \
+			(seq->size - (seq_size_t)(index)) * sizeof(T) \
+		); \
+		seq->buf[index] = val; \
+		seq->size++; \
+		return SEQ_ERR_NONE; \
+	} \
+	SEQ_INLINE seq_opt_t name##_prepend(name##_t seq, T val) { \
+		return name##_insert(seq, 0, val); \
+	} \
+	SEQ_INLINE T* name##_get(name##_t seq, seq_index_t index) { \
+		if((index = name##_index(seq, index, 0)) < 0) return NULL; \
+		return &seq->buf[index]; \
+	} \
+	SEQ_INLINE seq_opt_t name##_remove(name##_t seq, seq_index_t index) { \
+		if((index = name##_index(seq, index, 0)) < 0) return SEQ_ERR_NODE; \
+		dtor(&seq->buf[index]); \
+		seq->size--; \
+		memmove( \
+			seq->buf + index, \
+			seq->buf + index + 1, \
+			(seq->size - (seq_size_t)(index)) * sizeof(T) \
+		); \
+		return SEQ_ERR_NONE; \
+	} \
+	SEQ_INLINE seq_index_t name##_find(name##_t seq, const T* val) { \
+		seq_size_t i; \
+		for(i = 0; i < seq->size; i++) { \
+			if(!cmp((const T*)(&seq->buf[i]), val)) return (seq_index_t)(i); \
+		} \
+		return -1; \
+	} \
+	SEQ_INLINE void name##_sort_insertion(T* buf, seq_size_t n) { \
+		seq_size_t i; \
+		seq_size_t j; \
+		T tmp; \
+		for(i = 1; i < n; i++) { \
+			tmp = buf[i]; \
+			for(j = i; j > 0 && cmp((const T*)(&tmp), (const T*)(&buf[j - 1])) < 0; j--) { \
+				buf[j] = buf[j - 1]; \
+			} \
+			buf[j] = tmp; \
+		} \
+	} \
+	SEQ_INLINE void name##_sort_swap(T* lhs, T* rhs) { \
+		T tmp = *lhs; \
+		*lhs = *rhs; \
+		*rhs = tmp; \
+	} \
+	SEQ_INLINE void name##_sort(name##_t seq) { \
+		T* stack[64]; \
+		seq_size_t sizes[64]; \
+		seq_size_t top = 0; \
+		T* buf = seq->buf; \
+		seq_size_t n = seq->size; \
+		seq_size_t i; \
+		seq_size_t j; \
+		T pivot; \
+		for(;;) { \
+			/* Quicksort (using a median-of-3 pivot) down to small partitions, always */ \
+			/* continuing with the smaller half so the stack stays logarithmic; each of */ \
+			/* those is then finished with an insertion sort. */ \
+			while(n > 16) { \
+				T* mid = buf + n / 2; \
+				T* last = buf + n - 1; \
+				if(cmp((const T*)(mid), (const T*)(buf)) < 0) name##_sort_swap(mid, buf); \
+				if(cmp((const T*)(last), (const T*)(mid)) < 0) { \
+					name##_sort_swap(last, mid); \
+					if(cmp((const T*)(mid), (const T*)(buf)) < 0) name##_sort_swap(mid, buf); \
+				} \
+				pivot = *mid; \
+				i = 0; \
+				j = n - 1; \
+				for(;;) { \
+					while(cmp((const T*)(&buf[i]), (const T*)(&pivot)) < 0) i++; \
+					while(cmp((const T*)(&pivot), (const T*)(&buf[j])) < 0) j--; \
+					if(i >= j) break; \
+					name##_sort_swap(&buf[i++], &buf[j--]); \
+				} \
+				j++; \
+				if(j < n - j) { \
+					stack[top] = buf + j; \
+					sizes[top++] = n - j; \
+					n = j; \
+				} \
+				else { \
+					stack[top] = buf; \
+					sizes[top++] = j; \
+					buf += j; \
+					n -= j; \
+				} \
+			} \
+			name##_sort_insertion(buf, n); \
+			if(!top) break; \
+			buf = stack[--top]; \
+			n = sizes[top]; \
+		} \
+	} \
+	SEQ_INLINE T* name##_first(name##_t seq) { \
+		return seq->size ? seq->buf : NULL; \
+	} \
+	SEQ_INLINE T* name##_next(name##_t seq, T* val) { \
+		return val + 1 < seq->buf + seq->size ? val + 1 : NULL; \
+	}
+
+/* Generates an ordered map from @K keys to @V values named @name_t, implemented as a sorted array
+ * of name_entry_t pairs; lookups are binary searches, and iteration visits the keys in order.
+ *
+ *    name_t name_create(void)
+ *    void name_destroy(name_t seq)
+ *    seq_size_t name_size(name_t seq)
+ *    seq_opt_t name_set(name_t seq, K key, V val)
+ *    V* name_get(name_t seq, K key)
+ *    seq_opt_t name_remove(name_t seq, K key)
+ *    name_entry_t* name_first(name_t seq)
+ *    name_entry_t* name_next(name_t seq, name_entry_t* entry)
+ *
+ * The name_set() function replaces (and destroys) any existing entry with an equal key. */
+#define SEQ_DEFINE_MAP(name, K, V, cmp, dtor) \
+	typedef struct _##name##_entry_t { \
+		K key; \
+		V val; \
+	} name##_entry_t; \
+	SEQ_INLINE int name##_entry_cmp(const name##_entry_t* lhs, const name##_entry_t* rhs); \
+	SEQ_DEFINE_ARRAY(name##_entries, name##_entry_t, name##_entry_cmp, dtor) \
+	typedef name##_entries_t name##_t; \
+	SEQ_INLINE int name##_entry_cmp(const name##_entry_t* lhs, const name##_entry_t* rhs) { \
+		return cmp((const K*)(&lhs->key), (const K*)(&rhs->key)); \
+	} \
+	SEQ_INLINE seq_size_t name##_bound(name##_t seq, const K* key, int* found) { \
+		seq_size_t lo = 0; \
+		seq_size_t hi = seq->size; \
+		int c; \
+		*found = 0; \
+		while(lo < hi) { \
+			seq_size_t mid = lo + (hi - lo) / 2; \
+			if((c = cmp((const K*)(&seq->buf[mid].key), key)) < 0) lo = mid + 1; \
+			else { \
+				if(!c) *found = 1; \
+				hi = mid; \
+			} \
+		} \
+		return lo; \
+	} \
+	SEQ_INLINE name##_t name##_create(void) { \
+		return name##_entries_create(); \
+	} \
+	SEQ_INLINE void name##_destroy(name##_t seq) { \
+		name##_entries_destroy(seq); \
+	} \
+	SEQ_INLINE seq_size_t name##_size(name##_t seq) { \
+		return seq->size; \
+	} \
+	SEQ_INLINE seq_opt_t name##_set(name##_t seq, K key, V val) { \
+		int found; \
+		seq_size_t i = name##_bound(seq, &key, &found); \
+		name##_entry_t entry; \
+		entry.key = key; \
+		entry.val = val; \
+		if(found) { \
+			dtor(&seq->buf[i]); \
+			seq->buf[i] = entry; \
+			return SEQ_ERR_NONE; \
+		} \
+		return name##_entries_insert(seq, (seq_index_t)(i), entry); \
+	} \
+	SEQ_INLINE V* name##_get(name##_t seq, K key) { \
+		int found; \
+		seq_size_t i = name##_bound(seq, &key, &found); \
+		return found ? &seq->buf[i].val : NULL; \
+	} \
+	SEQ_INLINE seq_opt_t name##_remove(name##_t seq, K key) { \
+		int found; \
+		seq_size_t i = name##_bound(seq, &key, &found); \
+		if(!found) return SEQ_ERR_NODE; \
+		return name##_entries_remove(seq, (seq_index_t)(i)); \
+	} \
+	SEQ_INLINE name##_entry_t* name##_first(name##_t seq) { \
+		return name##_entries_first(seq); \
+	} \
+	SEQ_INLINE name##_entry_t* name##_next(name##_t seq, name##_entry_t* entry) { \
+		return name##_entries_next(seq, entry); \
+	}
+
+#endif
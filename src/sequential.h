@@ -25,6 +25,19 @@ extern "C" {
  * seq_data_t
  * seq_cb_add_t
  * seq_cb_remove_t
+ * seq_cb_serialize_t
+ * seq_cb_deserialize_t
+ * seq_cb_write_t
+ * seq_cb_read_t
+ * seq_cb_size_t
+ * seq_list_link_t
+ * seq_stats_t
+ * seq_cb_trace_t
+ * seq_cb_each_t
+ * seq_cb_map_t
+ * seq_cb_pred_t
+ * seq_cb_reduce_t
+ * seq_view_t
  * ============================================================================================= */
 
 #define SEQ_VERSION_MAJOR 0
@@ -54,14 +67,35 @@ typedef void* seq_data_t;
 #define SEQ_QUEUE (SEQ_TYPE | 0x0004)
 #define SEQ_STACK (SEQ_TYPE | 0x0005)
 #define SEQ_ARRAY (SEQ_TYPE | 0x0006)
-#define SEQ_TYPE_MAX SEQ_ARRAY
+#define SEQ_HEAP (SEQ_TYPE | 0x0007)
+#define SEQ_DEQUE (SEQ_TYPE | 0x0008)
+#define SEQ_VECTOR (SEQ_TYPE | 0x0009)
+#define SEQ_BTREE (SEQ_TYPE | 0x000A)
+#define SEQ_ART (SEQ_TYPE | 0x000B)
+#define SEQ_CACHE (SEQ_TYPE | 0x000C)
+#define SEQ_TYPE_MAX SEQ_CACHE
 
 #define SEQ_CONFIG 0x22220000
 #define SEQ_CB_ADD (SEQ_CONFIG | 0x0001)
 #define SEQ_CB_REMOVE (SEQ_CONFIG | 0x0002)
 #define SEQ_SORTED (SEQ_CONFIG | 0x0003)
 #define SEQ_BLOCKING (SEQ_CONFIG | 0x0004)
-#define SEQ_CONFIG_MAX SEQ_BLOCKING
+#define SEQ_INTRUSIVE (SEQ_CONFIG | 0x0005)
+#define SEQ_CB_SERIALIZE (SEQ_CONFIG | 0x0006)
+#define SEQ_CB_DESERIALIZE (SEQ_CONFIG | 0x0007)
+#define SEQ_CHECKSUM (SEQ_CONFIG | 0x0008)
+#define SEQ_STATS (SEQ_CONFIG | 0x0009)
+#define SEQ_CB_TRACE (SEQ_CONFIG | 0x000A)
+#define SEQ_TRACE (SEQ_CONFIG | 0x000B)
+#define SEQ_STRIDE (SEQ_CONFIG | 0x000C)
+#define SEQ_CB_CMP (SEQ_CONFIG | 0x000D)
+#define SEQ_THREADS (SEQ_CONFIG | 0x000E)
+#define SEQ_INTERN (SEQ_CONFIG | 0x000F)
+#define SEQ_CAPACITY (SEQ_CONFIG | 0x0010)
+#define SEQ_CB_SIZE (SEQ_CONFIG | 0x0011)
+#define SEQ_BLOOM (SEQ_CONFIG | 0x0012)
+#define SEQ_COMPACT (SEQ_CONFIG | 0x0013)
+#define SEQ_CONFIG_MAX SEQ_COMPACT
 
 #define SEQ_ADD 0x33330000
 #define SEQ_APPEND (SEQ_ADD | 0x0001)
@@ -80,7 +114,9 @@ typedef void* seq_data_t;
 #define SEQ_RECV (SEQ_GET | 0x0003)
 #define SEQ_POP (SEQ_GET | 0x0004)
 #define SEQ_DATA (SEQ_GET | 0x0005)
-#define SEQ_GET_MAX SEQ_DATA
+#define SEQ_PEEK (SEQ_GET | 0x0006)
+#define SEQ_STEAL (SEQ_GET | 0x0007)
+#define SEQ_GET_MAX SEQ_STEAL
 
 #define SEQ_ITER 0x55550000
 #define SEQ_READY (SEQ_ITER | 0x0001)
@@ -88,7 +124,11 @@ typedef void* seq_data_t;
 #define SEQ_STOP (SEQ_ITER | 0x0003)
 #define SEQ_RANGE (SEQ_ITER | 0x0004)
 #define SEQ_INC (SEQ_ITER | 0x0005)
-#define SEQ_ITER_MAX SEQ_INC
+#define SEQ_KEY_PREFIX (SEQ_ITER | 0x0006)
+#define SEQ_REVERSE (SEQ_ITER | 0x0007)
+#define SEQ_EXCLUDE_LO (SEQ_ITER | 0x0008)
+#define SEQ_EXCLUDE_HI (SEQ_ITER | 0x0009)
+#define SEQ_ITER_MAX SEQ_EXCLUDE_HI
 
 #define SEQ_CMP 0x66660000
 #define SEQ_LESS (SEQ_CMP | 0x0001)
@@ -104,7 +144,18 @@ typedef void* seq_data_t;
 #define SEQ_ERR_NODE (SEQ_ERR | 0x0004)
 #define SEQ_ERR_CB (SEQ_ERR | 0x0005)
 #define SEQ_ERR_TODO (SEQ_ERR | 0x0006)
-#define SEQ_ERR_MAX SEQ_ERR_TODO
+#define SEQ_ERR_IO (SEQ_ERR | 0x0007)
+#define SEQ_ERR_MAX SEQ_ERR_IO
+
+#define SEQ_CALL 0x88880000
+#define SEQ_CALL_ADD (SEQ_CALL | 0x0001)
+#define SEQ_CALL_REMOVE (SEQ_CALL | 0x0002)
+#define SEQ_CALL_GET (SEQ_CALL | 0x0003)
+#define SEQ_CALL_SET (SEQ_CALL | 0x0004)
+#define SEQ_CALL_DESTROY (SEQ_CALL | 0x0005)
+#define SEQ_CALL_CB_ADD (SEQ_CALL | 0x0006)
+#define SEQ_CALL_CB_REMOVE (SEQ_CALL | 0x0007)
+#define SEQ_CALL_MAX SEQ_CALL_CB_REMOVE
 
 /* The seq_cb_add_t type defines the signature of an optional callback that will be used internally
  * by the seq_t instance when seq_add() is called, and is passed the remainder of the argument list
@@ -120,9 +171,228 @@ typedef seq_data_t (*seq_cb_add_t)(seq_args_t args);
  * the value returned from the seq_cb_add_t callback, if set). */
 typedef void (*seq_cb_remove_t)(seq_data_t data);
 
-/* TODO: Returns one of the SEQ_CMP values. */
+/* These optional callbacks convert a single element to and from the payload of a record when a
+ * seq_t instance is written with seq_write() or read with seq_read(). The seq_cb_serialize_t
+ * callback encodes @data into @buf and returns the number of bytes the encoding requires; if that
+ * is larger than @size, the contents of @buf are ignored and the callback is simply invoked again
+ * with a buffer large enough. The seq_cb_deserialize_t callback is passed one such payload and
+ * must return the seq_data_t value to append, or NULL on failure. */
+typedef seq_size_t (*seq_cb_serialize_t)(seq_data_t data, void* buf, seq_size_t size);
+typedef seq_data_t (*seq_cb_deserialize_t)(const void* buf, seq_size_t size);
+
+/* The callbacks seq_write() and seq_read() use to move the actual bytes. The seq_cb_write_t callback
+ * must return @size on success (anything else is treated as an error); the seq_cb_read_t callback
+ * returns the number of bytes placed into @buf (up to @size), or 0 at the end of the stream. */
+typedef seq_size_t (*seq_cb_write_t)(const void* buf, seq_size_t size, seq_data_t ctx);
+typedef seq_size_t (*seq_cb_read_t)(void* buf, seq_size_t size, seq_data_t ctx);
+
+/* Compares two elements of the same seq_t instance, returning SEQ_LESS, SEQ_EQUAL or SEQ_GREATER
+ * depending on whether @lhs orders before, alongside or after @rhs. For a SEQ_ARRAY storing its
+ * elements by value, both arguments point to the values themselves. */
 typedef seq_opt_t (*seq_cb_cmp_t)(seq_t seq, seq_data_t lhs, seq_data_t rhs);
 
+/* Returns the number of bytes an element accounts for, against the byte budget of a SEQ_CACHE
+ * (see SEQ_CAPACITY); configured with SEQ_CB_SIZE. */
+typedef seq_size_t (*seq_cb_size_t)(seq_data_t data);
+
+/* A SEQ_LIST configured with SEQ_INTRUSIVE allocates no nodes of its own. Instead, every object
+ * added to the list must embed a struct _seq_list_link_t, whose offset within the object (as given
+ * by offsetof()) is passed along with the SEQ_INTRUSIVE option. Adding and removing then only ever
+ * relinks the objects themselves, and removing by pointer (SEQ_DATA) requires no search.
+ *
+ * The seq member records which seq_t instance currently owns the link (or NULL, if none); adding
+ * an object that is already owned by another intrusive list moves it in O(1), without invoking the
+ * seq_cb_remove_t callback of its previous owner. Since that member is read the first time an
+ * object is added, every link MUST start out zeroed: initialized with SEQ_LIST_LINK_INIT, or
+ * allocated with calloc() or cleared with memset() as part of its object. */
+typedef struct _seq_list_link_t* seq_list_link_t;
+
+struct _seq_list_link_t {
+	seq_list_link_t next;
+	seq_list_link_t prev;
+	seq_t seq;
+};
+
+#define SEQ_LIST_LINK_INIT { NULL, NULL, NULL }
+
+/* A SEQ_ARRAY configured with SEQ_STRIDE (while still empty) stores fixed-size elements of the
+ * given number of bytes BY VALUE, exactly like a mapped array does: seq_add() copies that many bytes
+ * from the data it's given, and seq_get() returns a pointer to the element inside the array, which
+ * remains valid until the array is next modified. Since the elements are moved around with
+ * memmove() and realloc(), they must be safe to relocate bytewise. */
+
+/* A SEQ_LIST or SEQ_ARRAY configured with SEQ_SORTED (while still empty), along with a
+ * seq_cb_cmp_t callback, keeps its elements ordered at all times. The position of each new element
+ * is found in O(log n) comparisons--using a skip list for a SEQ_LIST, and a binary search for a
+ * SEQ_ARRAY--with SEQ_PREPEND placing it before any elements that compare equal to it and
+ * SEQ_APPEND after them; adding relative to an existing element, and replacing one with seq_set(),
+ * are rejected with SEQ_ERR_OPT. Only a sorted SEQ_LIST also accepts SEQ_SEND and SEQ_PUSH, which
+ * remain the same as SEQ_APPEND and SEQ_PREPEND (just as for any list); a sorted SEQ_ARRAY rejects
+ * them. Elements can then also be looked up (and removed) by value, using SEQ_KEY followed by a
+ * seq_data_t that is passed to the callback as @rhs; the first element comparing equal is used. A
+ * sorted SEQ_LIST can't be SEQ_INTRUSIVE. */
+
+/* A SEQ_LIST also works as a FIFO queue, where SEQ_SEND appends and seq_get(list, SEQ_RECV) takes
+ * the front element, and as a LIFO stack, where SEQ_PUSH prepends and seq_get(list, SEQ_POP) takes
+ * the front element as well; taking an element hands its data back to the caller WITHOUT calling
+ * the seq_cb_remove_t callback (seq_remove() with the same constant does call it). SEQ_QUEUE and
+ * SEQ_STACK create lists that are meant to be used exactly this way.
+ *
+ * Configuring SEQ_BLOCKING, followed by an int timeout (in milliseconds) and an int spin count,
+ * makes a seq_t instance safe to share between threads: every call is then serialized by a mutex,
+ * and seq_get() with SEQ_RECV or SEQ_POP waits for an element to arrive, rather than returning NULL
+ * right away. A waiting consumer first checks for new elements the given number of times in a busy
+ * loop, and then sleeps (using a futex, where available) until a producer adds one or the timeout
+ * expires, in which case NULL is returned; a negative timeout waits forever, and 0 disables
+ * blocking again. Producers only pay for a wake-up when a consumer is actually waiting. Iterators
+ * are NOT protected by the mutex, and blocking isn't available on Windows. */
+
+/* A SEQ_HEAP is a priority queue, kept as a 4-ary heap in a single contiguous buffer of seq_data_t
+ * values and ordered by the seq_cb_cmp_t callback configured with SEQ_CB_CMP: the element comparing
+ * less than all others is always at the top, where seq_get(heap, SEQ_PEEK) returns it in O(1).
+ * Elements are added using SEQ_PUSH, and seq_get(heap, SEQ_POP) (or SEQ_RECV) removes the top
+ * element and returns it WITHOUT calling the seq_cb_remove_t callback, handing ownership back to
+ * the caller; the seq_remove() variant does call it. Elements added with SEQ_APPEND are merely
+ * stored, and the heap is only rebuilt, in O(n), once it's next needed (which is also how
+ * seq_create_from() fills one).
+ *
+ * When configured with SEQ_INTRUSIVE, every element must embed a seq_size_t (whose offset within the
+ * element is passed along with the option) that the heap keeps set to the element's position. This
+ * acts as a stable handle: after changing the priority of an element, seq_set(heap, SEQ_DATA, elem,
+ * elem) restores the heap order in O(log n), and removing (or replacing) any element by SEQ_DATA
+ * doesn't require a search either. Iterating a heap visits the elements in storage order. */
+
+/* A SEQ_DEQUE is a lock-free work-stealing deque (Chase-Lev), meant for task schedulers: a single
+ * owner thread adds elements using SEQ_PUSH (or SEQ_APPEND, which is the same) and takes them back
+ * in LIFO order with seq_get(deque, SEQ_POP), while any number of other threads take the oldest
+ * elements with seq_get(deque, SEQ_STEAL). Neither call blocks; NULL is returned once the deque is
+ * empty. The owner only needs atomic read-modify-write operations when a thief might be after the
+ * same (last) element, and the buffer grows as needed. As with the other types, seq_remove() with
+ * either constant calls the seq_cb_remove_t callback on the element taken, and seq_get() doesn't.
+ * Threads other than the owner may only use SEQ_STEAL and seq_size() (which is approximate while
+ * thieves are active); iterating, configuring SEQ_TRACE and destroying the deque are left to the
+ * owner, once the thieves are done. */
+
+/* A SEQ_VECTOR is a persistent vector: a 32-way relaxed radix balanced (RRB) tree whose nodes are
+ * reference counted and shared with any snapshots taken of it using seq_snapshot(), and with the
+ * versions derived from it by seq_update(), seq_concat() and seq_slice(). Elements are looked up
+ * and replaced with SEQ_INDEX in O(log32 n), and appended with SEQ_APPEND in amortized O(1); adding
+ * them with SEQ_PREPEND, or removing any but the last one (using SEQ_INDEX), takes O(log n). The
+ * last one can also be removed with SEQ_POP, and seq_get(vector, SEQ_POP) takes it WITHOUT calling
+ * the seq_cb_remove_t callback. While no other vector shares a node, the vector modifies it in
+ * place; otherwise, only the nodes on the path to the element being changed are copied. Iterators
+ * support SEQ_RANGE and SEQ_INC. */
+
+/* A SEQ_MAP is an ordered map, implemented as a B+tree (SEQ_BTREE creates the very same thing):
+ * every node keeps up to 32 keys in a contiguous array that's binary searched, and the leaves are
+ * linked in key order, so a lookup only touches a few cache lines per level and iterating never
+ * climbs back up the tree. Entries are added with seq_add(map, SEQ_KEYVAL, key, data), replacing
+ * the data of an equal key if there's one (calling the seq_cb_remove_t callback on the old data),
+ * and looked up, replaced and removed with SEQ_KEY; seq_set() and seq_remove() return SEQ_ERR_NODE
+ * if the key isn't there. Keys are compared as NUL-terminated strings, unless a seq_cb_cmp_t
+ * callback is configured (which must happen while the map is empty). Keys are NOT copied: each one
+ * must remain valid, and unchanged, for as long as it's in the map. Iterators visit the entries in
+ * key order; seq_iter_get(iter, SEQ_KEY) returns the key of the current entry. Unless keys are
+ * compared by callback, seq_iter_create(map, SEQ_KEY_PREFIX, "user:", SEQ_ERR_NONE) only visits
+ * the keys starting with the given string.
+ *
+ * Likewise, seq_iter_create(map, SEQ_RANGE, lo, hi, SEQ_ERR_NONE) only visits the keys from @lo to
+ * @hi, inclusive (either bound may be NULL, leaving that end open): the first one is found in
+ * O(log n), and every following one is simply the next entry of the linked leaves, so a range is
+ * never collected up front. SEQ_EXCLUDE_LO and SEQ_EXCLUDE_HI leave the bound keys themselves out,
+ * and SEQ_REVERSE visits the entries in descending key order, starting at @hi; neither SEQ_RANGE
+ * nor SEQ_REVERSE can be combined with SEQ_KEY_PREFIX. */
+
+/* A SEQ_ART is a map keyed by NUL-terminated strings, used exactly like a SEQ_MAP (including
+ * SEQ_KEY_PREFIX), and implemented as an adaptive radix tree: each level branches on one byte of
+ * the key, and chains of single-child levels are collapsed, so a lookup costs O(length of the key)
+ * no matter how many keys there are, and keys sharing a long prefix never compare it twice. Keys
+ * are ordered bytewise (as strcmp() would), and no seq_cb_cmp_t callback can be configured. */
+
+/* A SEQ_CACHE is a bounded map keyed by NUL-terminated strings, which evicts entries on its own to
+ * stay within its limits. Entries are added with seq_add(cache, SEQ_KEYVAL, key, data)--which
+ * copies the key, and replaces the data of an existing one, calling the seq_cb_remove_t callback
+ * on the old data--and looked up, replaced and removed with SEQ_KEY, all in O(1) through a hash
+ * index; seq_get(cache, SEQ_PEEK, key) looks an entry up without counting it as a use. Configuring
+ * SEQ_CAPACITY, followed by two seq_size_t values, limits the number of entries and the total size
+ * of their data in bytes, as reported by the seq_cb_size_t callback configured with SEQ_CB_SIZE
+ * (while the cache is empty); a limit of 0 means none, and lowering a limit evicts right away.
+ *
+ * Once a seq_add() or seq_set() exceeds a limit, entries are evicted following the CLOCK policy,
+ * an approximation of LRU where a hit merely flags the entry (once), rather than moving it to the
+ * front of a list, and handed to the seq_cb_remove_t callback just as if they'd been removed; the
+ * entry being added is never evicted to make room for itself. Data larger than the whole byte
+ * budget can't be cached at all: it's handed to the callback right away (along with the data the
+ * key held until then, if any), and SEQ_ERR_DATA is returned. Iterators visit the entries in the
+ * order the hand comes across them, starting with the next one it will consider for eviction, and
+ * seq_iter_set() doesn't evict anything. */
+
+/* When SEQ_INTERN is enabled on a SEQ_MAP or SEQ_ART (with seq_config(map, SEQ_INTERN, 1), while
+ * the map is empty), keys are copied into a string arena owned by the map the first time they're
+ * added, and equal keys share a single copy; the caller's key no longer needs to outlive the call,
+ * and seq_iter_get(iter, SEQ_KEY) returns the copy. Looking up a key that was never added costs a
+ * single hash lookup, and keys found in the arena are told apart by their address (so interning
+ * can't be combined with a seq_cb_cmp_t callback). The arena only ever grows: keys remain in it
+ * after being removed from the map, until the map is destroyed and the arena freed all at once,
+ * which suits maps whose set of keys is bounded (field names, identifiers, and so on). */
+
+/* SEQ_BLOOM, followed by a seq_size_t number of expected keys (or 0 to disable it), puts a blocked
+ * Bloom filter in front of every lookup by key in a SEQ_MAP or SEQ_ART: about 99% of the keys that
+ * were never added are turned away after testing a single cache line, without descending the map.
+ * The filter is filled with the keys already in the map and grows along with it; as it can't
+ * forget a key, it's rebuilt once the removed keys outnumber the ones left, which amortizes to O(1)
+ * per removal. Like SEQ_INTERN, it only hashes strings, so it can't be combined with a seq_cb_cmp_t
+ * callback. */
+
+/* When SEQ_STATS is enabled, a seq_t instance keeps the following counters, which seq_stats() copies
+ * into a caller-provided struct. The per-operation arrays are indexed by the value of the leading
+ * constant passed to the corresponding function (e.g., add[SEQ_APPEND & 0xFFFF] counts every
+ * seq_add(seq, SEQ_APPEND, ...) call), with index 0 counting calls whose leading constant wasn't
+ * valid at all; seq_remove(), seq_get() and seq_set() are all keyed by their SEQ_GET constant.
+ * Likewise, cb[] is indexed by the value of the SEQ_CB_* constant the callback was configured with;
+ * every seq_cb_cmp_t comparison is counted as cb[SEQ_CB_CMP & 0xFFFF], even if it was configured
+ * using SEQ_SORTED.
+ *
+ * The nodes_alloc and nodes_free counters track the nodes the implementation allocates on its own
+ * (a SEQ_ARRAY, or an intrusive SEQ_LIST, never allocates any), and hops counts every link a
+ * SEQ_LIST follows while looking up an element by index or by data (and every level a SEQ_MAP
+ * descends, or every entry of a hash chain a SEQ_CACHE checks, while looking up a key); a high
+ * ratio of hops to get[SEQ_INDEX & 0xFFFF] is the telltale sign of an O(n) access pattern. */
+typedef struct _seq_stats_t* seq_stats_t;
+
+struct _seq_stats_t {
+	uint64_t add[(SEQ_ADD_MAX & 0xFFFF) + 1];
+	uint64_t remove[(SEQ_GET_MAX & 0xFFFF) + 1];
+	uint64_t get[(SEQ_GET_MAX & 0xFFFF) + 1];
+	uint64_t set[(SEQ_GET_MAX & 0xFFFF) + 1];
+	uint64_t cb[(SEQ_CONFIG_MAX & 0xFFFF) + 1];
+	uint64_t nodes_alloc;
+	uint64_t nodes_free;
+	uint64_t hops;
+	uint64_t size_peak;
+};
+
+/* When set with SEQ_CB_TRACE, this callback is invoked after every traced call completes; @call is
+ * one of the SEQ_CALL constants, @op is the leading constant the call was made with (or 0, if it
+ * was invalid or the call takes none), and @ns is the time it took, in nanoseconds. The time spent
+ * in seq_add() or seq_remove() includes any time spent in the user callbacks, which are ALSO
+ * reported on their own (as SEQ_CALL_CB_ADD and SEQ_CALL_CB_REMOVE). */
+typedef void (*seq_cb_trace_t)(seq_t seq, seq_opt_t call, seq_opt_t op, uint64_t ns);
+
+/* Invoked by seq_parallel_for() once for every element, with the same @ctx pointer each time. */
+typedef void (*seq_cb_each_t)(seq_data_t data, seq_data_t ctx);
+
+/* The callbacks used by seq_map(), seq_filter() and seq_reduce(), which may be invoked from several
+ * threads at once. The seq_cb_map_t callback returns the (non-NULL) value to store in place of
+ * @data; the seq_cb_pred_t callback returns nonzero to keep @data; the seq_cb_reduce_t callback
+ * returns the result of combining the accumulated value @acc with @data. */
+typedef seq_data_t (*seq_cb_map_t)(seq_data_t data, seq_data_t ctx);
+typedef int (*seq_cb_pred_t)(seq_data_t data, seq_data_t ctx);
+typedef seq_data_t (*seq_cb_reduce_t)(seq_data_t acc, seq_data_t data, seq_data_t ctx);
+
+/* A lazy pipeline of stages over a seq_t instance; see the View API below. */
+typedef struct _seq_view_t* seq_view_t;
+
 #define seq_arg(args, type) va_arg(*args, type)
 #define seq_arg_index(args) va_arg(*args, seq_index_t)
 #define seq_arg_data(args) va_arg(*args, seq_data_t)
@@ -138,13 +408,30 @@ typedef seq_opt_t (*seq_cb_cmp_t)(seq_t seq, seq_data_t lhs, seq_data_t rhs);
  * seq_set
  * seq_type
  * seq_size
+ * seq_create_from
+ * seq_create_mapped
+ * seq_sync
+ * seq_write
+ * seq_read
+ * seq_stats
+ * seq_trace
+ * seq_trace_dump
+ * seq_fd
+ * seq_snapshot
+ * seq_update
+ * seq_concat
+ * seq_slice
+ * seq_compact
+ * seq_parallel_for
+ * seq_map
+ * seq_filter
+ * seq_reduce
  *
  * TODO:
  *
  * seq_sort OR seq_config(SEQ_SORT)
  * seq_find
  * seq_flatten OR seq_config(SEQ_FLATTEN)
- * seq_create_from
  * seq_lock
  * seq_unlock
  * ============================================================================================= */
@@ -189,32 +476,265 @@ SEQ_API seq_opt_t seq_type(seq_t seq);
 /* Returns the number of nodes attached to this instance. */
 SEQ_API seq_size_t seq_size(seq_t seq);
 
+/* Creates a new seq_t instance of the given @type holding the same elements as @src, in iteration
+ * order. The elements themselves are NOT copied; the new instance merely refers to the same data,
+ * has no callbacks configured other than the seq_cb_cmp_t callback of @src (if any), and so never
+ * invokes a seq_cb_remove_t callback on them. A SEQ_HEAP created this way is heapified in O(n). */
+SEQ_API seq_t seq_create_from(seq_opt_t type, seq_t src);
+
+/* Creates a SEQ_ARRAY whose elements live in the file at @path, which is mapped into memory and
+ * grown (using ftruncate() and mremap()) as elements are added. Unlike a regular SEQ_ARRAY, each
+ * element is a fixed-size block of @size bytes stored BY VALUE: seq_add() copies @size bytes from
+ * the data it's given, and seq_get() returns a pointer directly into the mapping. The @flags are
+ * passed to open(2) as-is (e.g., O_RDWR | O_CREAT); an existing file is reused without any parsing,
+ * in which case @size must either match the size it was created with or be 0. Returns NULL if the
+ * file can't be opened, isn't a valid mapped array, or the platform doesn't support mapping.
+ *
+ * The elements persist past seq_destroy(), which will NOT call the seq_cb_remove_t callback. */
+SEQ_API seq_t seq_create_mapped(const char* path, seq_size_t size, int flags);
+
+/* Flushes a mapped SEQ_ARRAY to its backing file using msync(), returning SEQ_ERR_IO if that
+ * fails, and SEQ_ERR_OPT if it was opened read-only, or for any other kind of seq_t instance. */
+SEQ_API seq_opt_t seq_sync(seq_t seq);
+
+/* Streams every element of the seq_t instance, in iteration order, to the @write callback using a
+ * compact, versioned binary format, encoding each one with the SEQ_CB_SERIALIZE callback. When
+ * SEQ_CHECKSUM is enabled, a CRC-32 of the stream is appended. Returns SEQ_ERR_CB if no serializer
+ * is configured, and SEQ_ERR_IO if the callback fails to write everything it's given. */
+SEQ_API seq_opt_t seq_write(seq_t seq, seq_cb_write_t write, seq_data_t ctx);
+
+/* Reads a stream produced by seq_write() chunk by chunk from the @read callback, appending each
+ * element (as returned by the SEQ_CB_DESERIALIZE callback) to the seq_t instance; the seq_cb_add_t
+ * callback is NOT used. Returns SEQ_ERR_DATA if the stream is malformed or its checksum doesn't
+ * match, and SEQ_ERR_IO if it ends prematurely; elements read before the error are kept. */
+SEQ_API seq_opt_t seq_read(seq_t seq, seq_cb_read_t read, seq_data_t ctx);
+
+/* Copies the counters of a seq_t instance configured with SEQ_STATS into @stats, returning
+ * SEQ_ERR_OPT if statistics aren't enabled. The counters are updated using relaxed atomic
+ * operations (where the compiler supports them), so they're cheap enough to leave enabled and can
+ * safely be sampled from a different thread; the snapshot as a whole, however, is not atomic.
+ * Configuring SEQ_STATS with a non-zero value again resets every counter, and 0 disables them. */
+SEQ_API seq_opt_t seq_stats(seq_t seq, seq_stats_t stats);
+
+/* With SEQ_TRACE enabled, every traced call (see seq_cb_trace_t) is also recorded in a latency
+ * histogram of its own, keyed by both the SEQ_CALL constant and the leading constant of the call.
+ * The histograms use logarithmic buckets, each split into 4 linear sub-buckets, so any reported
+ * value is within 25% of the actual latency no matter its magnitude. This function returns the
+ * latency (in nanoseconds) that @percentile percent of the recorded calls didn't exceed--e.g.,
+ * seq_trace(seq, SEQ_CALL_GET, SEQ_INDEX, 99.9)--or 0 if none were recorded. SEQ_CALL_DESTROY is
+ * only ever reported to the SEQ_CB_TRACE callback. */
+SEQ_API uint64_t seq_trace(seq_t seq, seq_opt_t call, seq_opt_t op, double percentile);
+
+/* Writes a human-readable summary of every non-empty SEQ_TRACE histogram (one line each, naming
+ * the call and its constant using seq_string()) to the @write callback. Returns SEQ_ERR_OPT if
+ * tracing isn't enabled, and SEQ_ERR_IO if the callback fails. */
+SEQ_API seq_opt_t seq_trace_dump(seq_t seq, seq_cb_write_t write, seq_data_t ctx);
+
+/* Returns a file descriptor (created on the first call, and closed by seq_destroy()) that becomes
+ * readable whenever the seq_t instance goes from empty to non-empty, for use with poll(), epoll and
+ * the like; it's an eventfd on Linux, and the reading end of a pipe elsewhere. Notifications are
+ * edge-triggered and coalesced: only the first seq_add() into an empty instance writes to the
+ * descriptor, so a burst of elements costs a single syscall. A consumer should therefore read (and
+ * discard) whatever is pending on the descriptor, and then keep taking elements--e.g., with
+ * seq_get(seq, SEQ_RECV)--until none are left; the next element added will signal it again.
+ * Returns -1 if the descriptor can't be created, or the platform doesn't support it. */
+SEQ_API int seq_fd(seq_t seq);
+
+/* Returns an immutable snapshot of a SEQ_VECTOR in O(1), as a new SEQ_VECTOR sharing every node of
+ * the original; modifying either of them afterwards copies only what it touches, and the nodes are
+ * freed once the last vector referring to them is destroyed. Adding, removing or replacing
+ * elements of a snapshot fails with SEQ_ERR_OPT, and it never calls a seq_cb_remove_t callback on
+ * the elements it shares, so these must outlive it; the original's callback is still invoked when
+ * it removes them. While the original may only be modified (and snapshotted) by one thread at a
+ * time--unless it's SEQ_BLOCKING, in which case seq_snapshot() takes the lock--every snapshot can
+ * be read, iterated and destroyed from any thread without further synchronization, so a long scan
+ * never holds up the writers. Returns NULL for any other type, or if memory allocation fails. */
+SEQ_API seq_t seq_snapshot(seq_t seq);
+
+/* Returns a new version of a SEQ_VECTOR (or of a snapshot) with the element at @index replaced by
+ * @data, copying only the O(log32 n) nodes on the path to it; the original is left untouched. Like
+ * the other functions below, the version is an ordinary SEQ_VECTOR sharing every other node with
+ * the original, which can be modified and destroyed independently of it. It has no callbacks, so
+ * it never owns the elements it holds: these must outlive every version referring to them. The
+ * original may not be modified by another thread while a version is derived from it. Returns NULL
+ * for any other type, if the index is out of range, or if memory allocation fails. */
+SEQ_API seq_t seq_update(seq_t seq, seq_index_t index, seq_data_t data);
+
+/* Returns a new SEQ_VECTOR holding the elements of @left followed by those of @right, in O(log n):
+ * only the nodes along the seam are rebuilt, merging the ones that are short of full so that
+ * lookups stay (effectively) O(1). Either may be empty, or both may be the same vector. Returns NULL
+ * unless both are SEQ_VECTOR instances, or if memory allocation fails. */
+SEQ_API seq_t seq_concat(seq_t left, seq_t right);
+
+/* Returns a new SEQ_VECTOR holding the elements from @begin to @end (both inclusive, and negative
+ * ones counting from the end, as with SEQ_RANGE) in O(log n); only the nodes along both edges of
+ * the slice are copied. A range that's out of bounds or reversed yields an empty vector. Returns
+ * NULL for any other type, or if memory allocation fails. */
+SEQ_API seq_t seq_slice(seq_t seq, seq_index_t begin, seq_index_t end);
+
+/* Moves every node of a SEQ_LIST (or SEQ_QUEUE, or SEQ_STACK) into a single block of memory, in
+ * the order of the list, so that walking it streams through memory rather than chasing nodes
+ * scattered all over the heap; the block is freed once the last node in it is removed. It costs
+ * O(n). Configuring SEQ_COMPACT with an int percentage (0, the default, disables it) has the list
+ * compact itself as elements are added and removed, once more than that share of its nodes is out
+ * of place: added since, or leaving a hole in the block by being removed. Since compacting would
+ * leave iterators pointing at the old nodes, it's deferred for as long as any iterator over the
+ * list exists; adding to (or removing from) a list while iterating is as safe as it ever was.
+ * Returns SEQ_ERR_OPT for any other type, for an intrusive list, or while an iterator exists, and
+ * SEQ_ERR_MEM if memory allocation fails, leaving the list as it was. */
+SEQ_API seq_opt_t seq_compact(seq_t seq);
+
+/* Invokes the callback on every element of the seq_t instance, spreading the work over a shared
+ * pool of threads. The elements are split into chunks of @grain elements each (0 picks a size that
+ * yields about 8 chunks per thread): SEQ_ARRAY, SEQ_HEAP and SEQ_VECTOR instances are split by
+ * index, while any other type is walked once with an iterator, copying it at every chunk boundary.
+ * Every thread (including the calling one, which takes part as well) then works through its own
+ * share of the chunks, stealing chunks from the others once it runs out. The call returns after
+ * every element has been visited, in no particular order, and the sequence must not be modified in
+ * the meantime.
+ *
+ * The number of threads is configured per seq_t instance with SEQ_THREADS, followed by an int; the
+ * default (0) is the number of online processors, and 1 means no threads at all. The pool is
+ * created on first use, only ever grows, and its threads sleep between calls. A call made while the
+ * pool is busy--whether concurrently or from within the callback--simply runs on the calling
+ * thread, as it does on Windows. Returns SEQ_ERR_CB without a callback, or SEQ_ERR_MEM. */
+SEQ_API seq_opt_t seq_parallel_for(seq_t seq, seq_cb_each_t each, seq_data_t ctx, seq_size_t grain);
+
+/* These process a seq_t instance in chunks, on the same pool of threads as seq_parallel_for() (and
+ * with the same number of them), and never modify it.
+ *
+ * seq_map() returns a new SEQ_ARRAY holding the result of the callback for every element, in
+ * order; the array is allocated in full up front, and every chunk fills in its own part of it. It
+ * returns NULL on failure, including when the callback returns NULL for any element.
+ *
+ * seq_filter() returns a new SEQ_LIST of the elements for which the callback returns nonzero, in
+ * order; every chunk collects its own list, and these are then linked together. It returns NULL if
+ * memory allocation fails.
+ *
+ * seq_reduce() reduces every chunk, starting from @identity, and then reduces the results of the
+ * chunks in turn (again starting from @identity). The callback must therefore be associative, and
+ * the accumulated value must be of the same kind as the elements themselves; e.g., integers
+ * smuggled through a seq_data_t, or pointers to objects owned by @ctx. If memory allocation fails,
+ * @identity is returned.
+ *
+ * The new sequences use the same SEQ_THREADS value as the original, and the data they hold isn't
+ * owned by them (that is, they have no seq_cb_remove_t callback). */
+SEQ_API seq_t seq_map(seq_t seq, seq_cb_map_t map, seq_data_t ctx);
+SEQ_API seq_t seq_filter(seq_t seq, seq_cb_pred_t pred, seq_data_t ctx);
+SEQ_API seq_data_t seq_reduce(seq_t seq, seq_cb_reduce_t reduce, seq_data_t identity, seq_data_t ctx);
+
 /* Converts the given constant--that is, one of the many SEQ_* defines--and returns its string
  * representation, omitting the leading "SEQ_" prefix. */
 SEQ_API const char* seq_string(seq_opt_t opt);
 
-#if 0
 /* ================================================================================== Iteration API
  * seq_iter_create
  * seq_iter_destroy
  * seq_iter_get
  * seq_iter_set
  * seq_iterate
+ * seq_iter_copy
  * ============================================================================================= */
 
+/* Creates a new iterator over the given seq_t instance. The remaining arguments are a list of
+ * SEQ_ITER options (and their values), terminated by SEQ_ERR_NONE; for example:
+ *
+ *    seq_iter_create(seq, SEQ_RANGE, 2, 8, SEQ_INC, 2, SEQ_ERR_NONE)
+ *
+ * ...where the (inclusive) SEQ_RANGE values are seq_index_t (or keys, for a SEQ_MAP) and the
+ * SEQ_INC value is a seq_size_t. Returns NULL if an option isn't supported by the implementation or
+ * memory allocation fails. The sequence must not be modified while an iterator is active, except
+ * through seq_iter_set(). */
 SEQ_API seq_iter_t seq_iter_create(seq_t seq, ...);
 SEQ_API seq_iter_t seq_iter_vcreate(seq_t seq, seq_args_t args);
 
 SEQ_API void seq_iter_destroy(seq_iter_t iter);
 
-SEQ_API seq_get_t seq_iter_get(seq_iter_t iter, ...);
-SEQ_API seq_get_t seq_iter_vget(seq_iter_t iter, seq_args_t args);
+/* Returns the data (SEQ_DATA) of the element the iterator is currently positioned on. */
+SEQ_API seq_data_t seq_iter_get(seq_iter_t iter, ...);
+SEQ_API seq_data_t seq_iter_vget(seq_iter_t iter, seq_args_t args);
 
+/* Replaces the data (SEQ_DATA) of the element the iterator is currently positioned on, exactly as
+ * seq_set() would. */
 SEQ_API seq_opt_t seq_iter_set(seq_iter_t iter, ...);
 SEQ_API seq_opt_t seq_iter_vset(seq_iter_t iter, seq_args_t args);
 
+/* Advances the iterator to the next element (or to the first one, on the initial call), returning
+ * SEQ_ACTIVE if it's positioned on a valid element, or 0 once iteration is finished (at which point
+ * the iterator is in the SEQ_STOP state). The canonical loop is therefore:
+ *
+ *    while(seq_iterate(iter)) { ... seq_iter_get(iter, SEQ_DATA) ... } */
 SEQ_API seq_opt_t seq_iterate(seq_iter_t iter);
-#endif
+
+/* Returns a new, independent iterator in the exact same state (and position) as the given one, or
+ * NULL if memory allocation fails. */
+SEQ_API seq_iter_t seq_iter_copy(seq_iter_t iter);
+
+/* ======================================================================================= View API
+ * seq_view_create
+ * seq_view_destroy
+ * seq_view_filter
+ * seq_view_map
+ * seq_view_skip
+ * seq_view_take
+ * seq_view_stride
+ * seq_view_iterate
+ * seq_view_get
+ * seq_view_collect
+ * seq_view_reduce
+ * ============================================================================================= */
+
+/* Creates a new, empty view of the given seq_t instance, which yields every one of its elements in
+ * iteration order until stages are added to it. A view never copies the sequence, which must
+ * therefore outlive it (and not be modified while a pass is in progress). Returns NULL if memory
+ * allocation fails. */
+SEQ_API seq_view_t seq_view_create(seq_t seq);
+
+SEQ_API void seq_view_destroy(seq_view_t view);
+
+/* Each of these appends a stage to the view and returns it, so they can be nested; e.g.:
+ *
+ *    seq_view_take(seq_view_map(seq_view_filter(seq_view_create(seq), pred, NULL), map, NULL), 10)
+ *
+ * Nothing is evaluated (or allocated) at this point. Instead, every element is pulled through the
+ * stages one at a time while the view is iterated, so a filter followed by a map never builds an
+ * intermediate sequence, and a take stops pulling elements as soon as it has let through the last
+ * one it needs. A filter keeps the elements for which the seq_cb_pred_t callback returns nonzero; a
+ * map replaces every element with the (non-NULL) result of the seq_cb_map_t callback; a skip drops
+ * the first @n elements reaching it, a take lets through no more than @n, and a stride keeps every
+ * @nth one (starting with the first). Any skip, take or stride stages preceding the first filter
+ * are folded into the SEQ_RANGE and SEQ_INC options of the iterator over a SEQ_LIST (or SEQ_QUEUE,
+ * SEQ_STACK), SEQ_ARRAY, SEQ_HEAP or SEQ_VECTOR, so the elements they'd drop are never visited.
+ *
+ * A view holds up to 16 stages. If a stage is invalid (a NULL callback, or a stride of 0) or won't
+ * fit, the view is destroyed and NULL is returned; passing NULL in also returns NULL, so a nested
+ * expression like the one above only has to be checked once. */
+SEQ_API seq_view_t seq_view_filter(seq_view_t view, seq_cb_pred_t pred, seq_data_t ctx);
+SEQ_API seq_view_t seq_view_map(seq_view_t view, seq_cb_map_t map, seq_data_t ctx);
+SEQ_API seq_view_t seq_view_skip(seq_view_t view, seq_size_t n);
+SEQ_API seq_view_t seq_view_take(seq_view_t view, seq_size_t n);
+SEQ_API seq_view_t seq_view_stride(seq_view_t view, seq_size_t n);
+
+/* Evaluates the view up to its next element, which seq_view_get() then returns, exactly like
+ * seq_iterate() and seq_iter_get() do for an iterator. Once it returns 0, the pass is over and the
+ * next call starts over from the beginning; a pass also ends early if a map callback returns NULL.
+ * Adding a stage abandons the current pass. */
+SEQ_API seq_opt_t seq_view_iterate(seq_view_t view);
+SEQ_API seq_data_t seq_view_get(seq_view_t view);
+
+/* The terminal operations, which always evaluate the view from the beginning. The seq_view_collect()
+ * function appends every element of the view to a new seq_t instance of the given @type (which,
+ * like those returned by seq_map(), doesn't own them), returning NULL if that fails or a map
+ * callback returns NULL. The seq_view_reduce() function folds the elements into @identity, in
+ * order and on the calling thread; unlike with seq_reduce(), the callback therefore needn't be
+ * associative, and the accumulated value can be of any kind. */
+SEQ_API seq_t seq_view_collect(seq_view_t view, seq_opt_t type);
+SEQ_API seq_data_t seq_view_reduce(
+	seq_view_t view,
+	seq_cb_reduce_t reduce,
+	seq_data_t identity,
+	seq_data_t ctx
+);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,807 @@
+#ifndef SEQUENTIAL_HPP
+#define SEQUENTIAL_HPP 1
+
+#include "sequential.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/* ======================================================================================= C++ API
+ * seq::list
+ * seq::array
+ * seq::map
+ * ============================================================================================= */
+
+/* A thin, header-only C++11 layer over the C core. Every container owns exactly one seq_t (which
+ * native() exposes), is movable but not copyable, and stores its elements in place:
+ *
+ *    seq::list<T>   A SEQ_LIST in SEQ_INTRUSIVE mode, where each element lives in a single node
+ *                   that embeds the list link; bidirectional iterators.
+ *
+ *    seq::array<T>  A SEQ_ARRAY in SEQ_STRIDE mode; trivially copyable elements are stored
+ *                   directly in the buffer (and the iterators are plain pointers), anything else
+ *                   is stored as an owning pointer; random-access iterators.
+ *
+ *    seq::map<K, V> An ordered map kept as a sorted seq::array of seq::pair<K, V> entries.
+ *
+ * Ownership is handed to the seq_t itself using the SEQ_CB_REMOVE callback, so an element is
+ * destroyed no matter which path (seq_remove(), seq_destroy(), etc.) removes it. Failures reported
+ * by the C core are turned into exceptions: std::bad_alloc for SEQ_ERR_MEM, and std::runtime_error
+ * (carrying the seq_string() of the error) for everything else. */
+
+namespace seq {
+
+namespace detail {
+	inline void check(seq_opt_t err) {
+		if(err == SEQ_ERR_MEM) throw std::bad_alloc();
+
+		else if(err) throw std::runtime_error(seq_string(err));
+	}
+
+	inline seq_t create(seq_opt_t type) {
+		seq_t seq = seq_create(type);
+
+		if(!seq) throw std::bad_alloc();
+
+		return seq;
+	}
+
+	/* The shared boilerplate of owning a seq_t: destruction, moves, and the size accessors. */
+	class base {
+	public:
+		base(const base&) = delete;
+		base& operator=(const base&) = delete;
+
+		seq_size_t size() const {
+			return seq_ ? seq_size(seq_) : 0;
+		}
+
+		bool empty() const {
+			return !size();
+		}
+
+		seq_t native() const {
+			return seq_;
+		}
+
+	protected:
+		explicit base(seq_opt_t type): seq_(create(type)) {
+		}
+
+		base(base&& rhs) noexcept: seq_(rhs.seq_) {
+			rhs.seq_ = NULL;
+		}
+
+		base& operator=(base&& rhs) noexcept {
+			std::swap(seq_, rhs.seq_);
+
+			return *this;
+		}
+
+		~base() {
+			if(seq_) seq_destroy(seq_);
+		}
+
+		seq_t seq_;
+	};
+}
+
+/* ==================================================================================== seq::list */
+
+template<typename T>
+class list: public detail::base {
+	/* The node IS the link (by inheritance), so the SEQ_INTRUSIVE offset is always 0. */
+	struct node: public _seq_list_link_t {
+		template<typename... Args>
+		explicit node(Args&&... args): _seq_list_link_t(), value(std::forward<Args>(args)...) {
+		}
+
+		T value;
+	};
+
+	static void remove(seq_data_t data) {
+		delete static_cast<node*>(data);
+	}
+
+	static node* get(seq_list_link_t link) {
+		return static_cast<node*>(link);
+	}
+
+	template<bool Const>
+	class basic_iterator {
+	public:
+		typedef std::bidirectional_iterator_tag iterator_category;
+		typedef T value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef typename std::conditional<Const, const T*, T*>::type pointer;
+		typedef typename std::conditional<Const, const T&, T&>::type reference;
+
+		basic_iterator(): seq_(NULL), link_(NULL) {
+		}
+
+		basic_iterator(seq_t seq, seq_list_link_t link): seq_(seq), link_(link) {
+		}
+
+		/* Every iterator converts to a const_iterator. */
+		template<bool C, typename = typename std::enable_if<Const && !C>::type>
+		basic_iterator(const basic_iterator<C>& it): seq_(it.seq_), link_(it.link_) {
+		}
+
+		reference operator*() const {
+			return get(link_)->value;
+		}
+
+		pointer operator->() const {
+			return &get(link_)->value;
+		}
+
+		basic_iterator& operator++() {
+			link_ = link_->next;
+
+			return *this;
+		}
+
+		basic_iterator operator++(int) {
+			basic_iterator it(*this);
+
+			++*this;
+
+			return it;
+		}
+
+		/* Stepping back from end() lands on the last element. */
+		basic_iterator& operator--() {
+			if(link_) link_ = link_->prev;
+
+			else link_ = static_cast<node*>(seq_get(seq_, SEQ_INDEX, static_cast<seq_index_t>(-1)));
+
+			return *this;
+		}
+
+		basic_iterator operator--(int) {
+			basic_iterator it(*this);
+
+			--*this;
+
+			return it;
+		}
+
+		bool operator==(const basic_iterator& rhs) const {
+			return link_ == rhs.link_;
+		}
+
+		bool operator!=(const basic_iterator& rhs) const {
+			return link_ != rhs.link_;
+		}
+
+		seq_list_link_t link() const {
+			return link_;
+		}
+
+	private:
+		template<bool> friend class basic_iterator;
+
+		seq_t seq_;
+		seq_list_link_t link_;
+	};
+
+public:
+	typedef T value_type;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef seq_size_t size_type;
+	typedef basic_iterator<false> iterator;
+	typedef basic_iterator<true> const_iterator;
+
+	list(): base(SEQ_LIST) {
+		detail::check(seq_config(seq_, SEQ_INTRUSIVE, static_cast<seq_size_t>(0)));
+		detail::check(seq_config(seq_, SEQ_CB_REMOVE, &list::remove));
+	}
+
+	list(list&& rhs) noexcept: base(std::move(rhs)) {
+	}
+
+	list& operator=(list&& rhs) noexcept {
+		base::operator=(std::move(rhs));
+
+		return *this;
+	}
+
+	iterator begin() {
+		return iterator(seq_, first());
+	}
+
+	iterator end() {
+		return iterator(seq_, NULL);
+	}
+
+	const_iterator begin() const {
+		return const_iterator(seq_, first());
+	}
+
+	const_iterator end() const {
+		return const_iterator(seq_, NULL);
+	}
+
+	const_iterator cbegin() const {
+		return begin();
+	}
+
+	const_iterator cend() const {
+		return end();
+	}
+
+	T& front() {
+		return *begin();
+	}
+
+	T& back() {
+		return *--end();
+	}
+
+	const T& front() const {
+		return *begin();
+	}
+
+	const T& back() const {
+		return *--end();
+	}
+
+	/* Constructs a new element in place, immediately BEFORE @pos. */
+	template<typename... Args>
+	iterator emplace(const_iterator pos, Args&&... args) {
+		node* n = new node(std::forward<Args>(args)...);
+		seq_opt_t err;
+
+		if(pos.link()) err = seq_add(
+			seq_,
+			SEQ_BEFORE,
+			SEQ_DATA,
+			static_cast<seq_data_t>(get(pos.link())),
+			static_cast<seq_data_t>(n)
+		);
+
+		else err = seq_add(seq_, SEQ_APPEND, static_cast<seq_data_t>(n));
+
+		if(err) {
+			delete n;
+
+			detail::check(err);
+		}
+
+		return iterator(seq_, n);
+	}
+
+	template<typename... Args>
+	T& emplace_back(Args&&... args) {
+		return *emplace(cend(), std::forward<Args>(args)...);
+	}
+
+	template<typename... Args>
+	T& emplace_front(Args&&... args) {
+		return *emplace(cbegin(), std::forward<Args>(args)...);
+	}
+
+	iterator insert(const_iterator pos, const T& value) {
+		return emplace(pos, value);
+	}
+
+	iterator insert(const_iterator pos, T&& value) {
+		return emplace(pos, std::move(value));
+	}
+
+	void push_back(const T& value) {
+		emplace_back(value);
+	}
+
+	void push_back(T&& value) {
+		emplace_back(std::move(value));
+	}
+
+	void push_front(const T& value) {
+		emplace_front(value);
+	}
+
+	void push_front(T&& value) {
+		emplace_front(std::move(value));
+	}
+
+	/* Removes (and destroys) the element at @pos, returning an iterator to the one after it. */
+	iterator erase(const_iterator pos) {
+		seq_list_link_t next = pos.link()->next;
+
+		detail::check(seq_remove(seq_, SEQ_DATA, static_cast<seq_data_t>(get(pos.link()))));
+
+		return iterator(seq_, next);
+	}
+
+	void pop_front() {
+		detail::check(seq_remove(seq_, SEQ_INDEX, static_cast<seq_index_t>(0)));
+	}
+
+	void pop_back() {
+		detail::check(seq_remove(seq_, SEQ_INDEX, static_cast<seq_index_t>(-1)));
+	}
+
+	void clear() {
+		while(!empty()) pop_front();
+	}
+
+private:
+	seq_list_link_t first() const {
+		if(empty()) return NULL;
+
+		return static_cast<node*>(seq_get(seq_, SEQ_INDEX, static_cast<seq_index_t>(0)));
+	}
+};
+
+/* =================================================================================== seq::array */
+
+namespace detail {
+	/* The iterator used by seq::array for elements that aren't stored directly: a random-access
+	 * iterator over the owning pointers, dereferencing twice. */
+	template<typename T, typename U>
+	class indirect_iterator {
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef T value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef U* pointer;
+		typedef U& reference;
+
+		indirect_iterator(): p_(NULL) {
+		}
+
+		explicit indirect_iterator(T* const* p): p_(p) {
+		}
+
+		template<typename V, typename = typename std::enable_if<
+			std::is_same<V, T>::value && !std::is_same<U, T>::value
+		>::type>
+		indirect_iterator(const indirect_iterator<T, V>& it): p_(it.p_) {
+		}
+
+		reference operator*() const {
+			return **p_;
+		}
+
+		pointer operator->() const {
+			return *p_;
+		}
+
+		reference operator[](difference_type n) const {
+			return *p_[n];
+		}
+
+		indirect_iterator& operator++() {
+			++p_;
+
+			return *this;
+		}
+
+		indirect_iterator operator++(int) {
+			return indirect_iterator(p_++);
+		}
+
+		indirect_iterator& operator--() {
+			--p_;
+
+			return *this;
+		}
+
+		indirect_iterator operator--(int) {
+			return indirect_iterator(p_--);
+		}
+
+		indirect_iterator& operator+=(difference_type n) {
+			p_ += n;
+
+			return *this;
+		}
+
+		indirect_iterator& operator-=(difference_type n) {
+			p_ -= n;
+
+			return *this;
+		}
+
+		indirect_iterator operator+(difference_type n) const {
+			return indirect_iterator(p_ + n);
+		}
+
+		indirect_iterator operator-(difference_type n) const {
+			return indirect_iterator(p_ - n);
+		}
+
+		friend indirect_iterator operator+(difference_type n, const indirect_iterator& it) {
+			return it + n;
+		}
+
+		difference_type operator-(const indirect_iterator& rhs) const {
+			return p_ - rhs.p_;
+		}
+
+		bool operator==(const indirect_iterator& rhs) const { return p_ == rhs.p_; }
+		bool operator!=(const indirect_iterator& rhs) const { return p_ != rhs.p_; }
+		bool operator<(const indirect_iterator& rhs) const { return p_ < rhs.p_; }
+		bool operator>(const indirect_iterator& rhs) const { return p_ > rhs.p_; }
+		bool operator<=(const indirect_iterator& rhs) const { return p_ <= rhs.p_; }
+		bool operator>=(const indirect_iterator& rhs) const { return p_ >= rhs.p_; }
+
+	private:
+		template<typename, typename> friend class indirect_iterator;
+
+		T* const* p_;
+	};
+}
+
+template<typename T>
+class array: public detail::base {
+	/* Elements that can't be relocated with memmove() are kept on the heap, and the array only
+	 * stores (and owns) pointers to them. */
+	static const bool indirect = !std::is_trivially_copyable<T>::value;
+
+	typedef typename std::conditional<indirect, T*, T>::type slot;
+
+public:
+	typedef T value_type;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef seq_size_t size_type;
+
+	typedef typename std::conditional<
+		indirect,
+		detail::indirect_iterator<T, T>,
+		T*
+	>::type iterator;
+
+	typedef typename std::conditional<
+		indirect,
+		detail::indirect_iterator<T, const T>,
+		const T*
+	>::type const_iterator;
+
+private:
+
+	static void remove(seq_data_t data) {
+		delete *static_cast<T**>(data);
+	}
+
+	slot* slots() const {
+		if(empty()) return NULL;
+
+		return static_cast<slot*>(seq_get(seq_, SEQ_INDEX, static_cast<seq_index_t>(0)));
+	}
+
+	static T& deref(T& value) {
+		return value;
+	}
+
+	static T& deref(T* value) {
+		return *value;
+	}
+
+	seq_index_t index(const_iterator pos) const {
+		return static_cast<seq_index_t>(pos - cbegin());
+	}
+
+	/* Copies the slot into the array, BEFORE @pos (or at the very end). */
+	void add(seq_index_t pos, slot* s) {
+		seq_data_t d = static_cast<seq_data_t>(s);
+
+		if(pos == static_cast<seq_index_t>(size())) detail::check(seq_add(seq_, SEQ_APPEND, d));
+
+		else detail::check(seq_add(seq_, SEQ_BEFORE, SEQ_INDEX, pos, d));
+	}
+
+	template<typename... Args>
+	void construct(std::true_type, seq_index_t pos, Args&&... args) {
+		T* value = new T(std::forward<Args>(args)...);
+
+		try {
+			add(pos, &value);
+		}
+
+		catch(...) {
+			delete value;
+
+			throw;
+		}
+	}
+
+	template<typename... Args>
+	void construct(std::false_type, seq_index_t pos, Args&&... args) {
+		T value(std::forward<Args>(args)...);
+
+		add(pos, &value);
+	}
+
+public:
+	array(): base(SEQ_ARRAY) {
+		detail::check(seq_config(seq_, SEQ_STRIDE, static_cast<seq_size_t>(sizeof(slot))));
+
+		if(indirect) detail::check(seq_config(seq_, SEQ_CB_REMOVE, &array::remove));
+	}
+
+	array(array&& rhs) noexcept: base(std::move(rhs)) {
+	}
+
+	array& operator=(array&& rhs) noexcept {
+		base::operator=(std::move(rhs));
+
+		return *this;
+	}
+
+	iterator begin() {
+		return iterator(slots());
+	}
+
+	iterator end() {
+		return iterator(slots() + size());
+	}
+
+	const_iterator begin() const {
+		return const_iterator(slots());
+	}
+
+	const_iterator end() const {
+		return const_iterator(slots() + size());
+	}
+
+	const_iterator cbegin() const {
+		return begin();
+	}
+
+	const_iterator cend() const {
+		return end();
+	}
+
+	T& operator[](seq_size_t i) {
+		return deref(slots()[i]);
+	}
+
+	const T& operator[](seq_size_t i) const {
+		return deref(slots()[i]);
+	}
+
+	T& at(seq_size_t i) {
+		if(i >= size()) throw std::out_of_range("seq::array::at");
+
+		return (*this)[i];
+	}
+
+	const T& at(seq_size_t i) const {
+		if(i >= size()) throw std::out_of_range("seq::array::at");
+
+		return (*this)[i];
+	}
+
+	T& front() {
+		return (*this)[0];
+	}
+
+	T& back() {
+		return (*this)[size() - 1];
+	}
+
+	const T& front() const {
+		return (*this)[0];
+	}
+
+	const T& back() const {
+		return (*this)[size() - 1];
+	}
+
+	/* Constructs a new element, immediately BEFORE @pos. */
+	template<typename... Args>
+	iterator emplace(const_iterator pos, Args&&... args) {
+		seq_index_t i = index(pos);
+
+		construct(std::integral_constant<bool, indirect>(), i, std::forward<Args>(args)...);
+
+		return begin() + i;
+	}
+
+	template<typename... Args>
+	T& emplace_back(Args&&... args) {
+		return *emplace(cend(), std::forward<Args>(args)...);
+	}
+
+	iterator insert(const_iterator pos, const T& value) {
+		return emplace(pos, value);
+	}
+
+	iterator insert(const_iterator pos, T&& value) {
+		return emplace(pos, std::move(value));
+	}
+
+	void push_back(const T& value) {
+		emplace_back(value);
+	}
+
+	void push_back(T&& value) {
+		emplace_back(std::move(value));
+	}
+
+	/* Removes (and destroys) the element at @pos, returning an iterator to the one after it. */
+	iterator erase(const_iterator pos) {
+		seq_index_t i = index(pos);
+
+		detail::check(seq_remove(seq_, SEQ_INDEX, i));
+
+		return begin() + i;
+	}
+
+	void pop_back() {
+		detail::check(seq_remove(seq_, SEQ_INDEX, static_cast<seq_index_t>(-1)));
+	}
+
+	void clear() {
+		while(!empty()) pop_back();
+	}
+};
+
+/* ===================================================================================== seq::map */
+
+template<typename K, typename V>
+struct pair {
+	K first;
+	V second;
+};
+
+template<typename K, typename V, typename Compare = std::less<K> >
+class map {
+public:
+	typedef K key_type;
+	typedef V mapped_type;
+	typedef seq::pair<K, V> value_type;
+	typedef seq_size_t size_type;
+	typedef typename array<value_type>::iterator iterator;
+	typedef typename array<value_type>::const_iterator const_iterator;
+
+	explicit map(const Compare& cmp = Compare()): cmp_(cmp) {
+	}
+
+	seq_size_t size() const {
+		return entries_.size();
+	}
+
+	bool empty() const {
+		return entries_.empty();
+	}
+
+	seq_t native() const {
+		return entries_.native();
+	}
+
+	iterator begin() {
+		return entries_.begin();
+	}
+
+	iterator end() {
+		return entries_.end();
+	}
+
+	const_iterator begin() const {
+		return entries_.begin();
+	}
+
+	const_iterator end() const {
+		return entries_.end();
+	}
+
+	const_iterator cbegin() const {
+		return entries_.cbegin();
+	}
+
+	const_iterator cend() const {
+		return entries_.cend();
+	}
+
+	iterator lower_bound(const K& key) {
+		return std::lower_bound(begin(), end(), key, less(cmp_));
+	}
+
+	const_iterator lower_bound(const K& key) const {
+		return std::lower_bound(begin(), end(), key, less(cmp_));
+	}
+
+	iterator find(const K& key) {
+		iterator it = lower_bound(key);
+
+		return it != end() && !cmp_(key, it->first) ? it : end();
+	}
+
+	const_iterator find(const K& key) const {
+		const_iterator it = lower_bound(key);
+
+		return it != end() && !cmp_(key, it->first) ? it : end();
+	}
+
+	seq_size_t count(const K& key) const {
+		return find(key) != end() ? 1 : 0;
+	}
+
+	V& at(const K& key) {
+		iterator it = find(key);
+
+		if(it == end()) throw std::out_of_range("seq::map::at");
+
+		return it->second;
+	}
+
+	/* Returns the value bound to @key, inserting a value-initialized one first if necessary. */
+	V& operator[](const K& key) {
+		iterator it = lower_bound(key);
+
+		if(it == end() || cmp_(key, it->first)) it = entries_.emplace(it, value_type{ key, V() });
+
+		return it->second;
+	}
+
+	/* Inserts @value unless its key is already present; the bool is true if it was inserted. */
+	std::pair<iterator, bool> insert(const value_type& value) {
+		iterator it = lower_bound(value.first);
+
+		if(it != end() && !cmp_(value.first, it->first)) return std::make_pair(it, false);
+
+		return std::make_pair(entries_.emplace(it, value), true);
+	}
+
+	template<typename M>
+	std::pair<iterator, bool> insert_or_assign(const K& key, M&& val) {
+		iterator it = lower_bound(key);
+
+		if(it != end() && !cmp_(key, it->first)) {
+			it->second = std::forward<M>(val);
+
+			return std::make_pair(it, false);
+		}
+
+		return std::make_pair(entries_.emplace(it, value_type{ key, std::forward<M>(val) }), true);
+	}
+
+	iterator erase(const_iterator pos) {
+		return entries_.erase(pos);
+	}
+
+	seq_size_t erase(const K& key) {
+		iterator it = find(key);
+
+		if(it == end()) return 0;
+
+		entries_.erase(it);
+
+		return 1;
+	}
+
+	void clear() {
+		entries_.clear();
+	}
+
+private:
+	/* Adapts Compare to std::lower_bound(), comparing an entry against a bare key. */
+	struct less {
+		explicit less(const Compare& cmp): cmp(cmp) {
+		}
+
+		bool operator()(const value_type& lhs, const K& rhs) const {
+			return cmp(lhs.first, rhs);
+		}
+
+		const Compare& cmp;
+	};
+
+	array<value_type> entries_;
+	Compare cmp_;
+};
+
+}
+
+#endif
@@ -0,0 +1,530 @@
+#if !defined(_WIN32)
+#define _GNU_SOURCE
+#endif
+
+#include <sequential.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+/* seq-bench [csv|json] [max-size]
+ *
+ * Measures the core operations of every container type across sizes from 10 up to max-size
+ * (10^7 by default), growing by powers of 10. Each row reports the nanoseconds per operation, the
+ * number of heap allocations per operation, and the resident set size once the operation is done.
+ * Operations whose cost grows with the size of the sequence (index-based access, inserts and
+ * removes) are sampled a limited number of times, so that large sizes still finish quickly. Every
+ * operation's result is checked, and the first one to fail ends the run (with an error, and
+ * without reporting its timing), since numbers measured past a failure would mean nothing. */
+
+#define BENCH_MAX_SIZE 10000000
+#define BENCH_SLOW_BUDGET 10000000
+
+/* ================================================================================ Allocation Count
+ * When linked against glibc, the allocator entry points are wrapped so that every allocation made
+ * by the library can be counted. Elsewhere, allocations are reported as -1. */
+
+static unsigned long bench_allocs = 0;
+
+#if defined(__GLIBC__)
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+	bench_allocs++;
+
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+	bench_allocs++;
+
+	return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+	bench_allocs++;
+
+	return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+	__libc_free(ptr);
+}
+
+#define BENCH_ALLOCS 1
+#else
+#define BENCH_ALLOCS 0
+#endif
+
+/* ========================================================================================= Helpers */
+
+typedef struct _bench_t {
+	const char* format;
+	int rows;
+	uint64_t rng;
+	seq_opt_t err;
+} bench_t;
+
+static uint64_t bench_clock(void) {
+#if defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)(ts.tv_sec) * 1000000000) + (uint64_t)(ts.tv_nsec);
+#else
+	return (uint64_t)(clock()) * (1000000000 / CLOCKS_PER_SEC);
+#endif
+}
+
+static long bench_rss(void) {
+#if defined(__linux__)
+	FILE* f = fopen("/proc/self/statm", "r");
+	long pages = 0;
+	long rss = 0;
+
+	if(f) {
+		if(fscanf(f, "%ld %ld", &pages, &rss) != 2) rss = 0;
+
+		fclose(f);
+
+		return rss * (sysconf(_SC_PAGESIZE) / 1024);
+	}
+#endif
+
+#if !defined(_WIN32)
+	{
+		struct rusage usage;
+
+		getrusage(RUSAGE_SELF, &usage);
+
+		return usage.ru_maxrss;
+	}
+#else
+	return 0;
+#endif
+}
+
+static void bench_fail(seq_opt_t type, const char* op, seq_opt_t err) {
+	fprintf(stderr, "seq-bench: %s %s failed: %s\n", seq_string(type), op, seq_string(err));
+
+	exit(1);
+}
+
+/* Kept a macro, so that checking doesn't add a function call to the operations being timed. */
+#define BENCH_CHECK(b, type, op, expr) if(((b)->err = (expr))) bench_fail(type, op, (b)->err)
+
+#define BENCH_CHECK_DATA(type, op, expr) if(!(expr)) bench_fail(type, op, SEQ_ERR_NODE)
+
+static seq_size_t bench_rand(bench_t* b, seq_size_t n) {
+	b->rng ^= b->rng << 13;
+	b->rng ^= b->rng >> 7;
+	b->rng ^= b->rng << 17;
+
+	return (seq_size_t)(b->rng % n);
+}
+
+static void bench_report(
+	bench_t* b,
+	seq_opt_t type,
+	const char* op,
+	seq_size_t size,
+	seq_size_t ops,
+	uint64_t ns,
+	unsigned long allocs
+) {
+	double ns_op = ops ? (double)(ns) / (double)(ops) : 0.0;
+	double allocs_op = BENCH_ALLOCS && ops ? (double)(allocs) / (double)(ops) : -1.0;
+	long rss = bench_rss();
+
+	if(!strcmp(b->format, "json")) printf(
+		"%s{\"type\":\"%s\",\"op\":\"%s\",\"size\":%lu,\"ops\":%lu,"
+		"\"ns_per_op\":%.2f,\"allocs_per_op\":%.3f,\"rss_kb\":%ld}",
+		b->rows ? ",\n  " : "[\n  ",
+		seq_string(type),
+		op,
+		(unsigned long)(size),
+		(unsigned long)(ops),
+		ns_op,
+		allocs_op,
+		rss
+	);
+
+	else printf(
+		"%s,%s,%lu,%lu,%.2f,%.3f,%ld\n",
+		seq_string(type),
+		op,
+		(unsigned long)(size),
+		(unsigned long)(ops),
+		ns_op,
+		allocs_op,
+		rss
+	);
+
+	b->rows++;
+
+	fflush(stdout);
+}
+
+/* Every benchmark is bracketed the same way: reset the allocation counter, start the clock, run
+ * the body, and report. */
+#define BENCH_BEGIN(b) { \
+	uint64_t _t; \
+	unsigned long _a; \
+	_a = bench_allocs; \
+	_t = bench_clock();
+
+#define BENCH_END(b, type, op, size, ops) \
+	_t = bench_clock() - _t; \
+	bench_report(b, type, op, size, ops, _t, bench_allocs - _a); \
+}
+
+/* ====================================================================================== Benchmarks */
+
+static int bench_data = 0;
+
+/* Starts iterating, stopping the run if the iterator can't even be created. */
+static seq_iter_t bench_iter(seq_t seq, seq_opt_t type, const char* op) {
+	seq_iter_t iter = seq_iter_create(seq, SEQ_ERR_NONE);
+
+	if(!iter) bench_fail(type, op, SEQ_ERR_MEM);
+
+	return iter;
+}
+
+/* A SEQ_VECTOR can only be added to at either end, so it skips inserting before and after (and
+ * removes fewer elements, having fewer to spare). */
+static void bench_type(bench_t* b, seq_opt_t type, seq_size_t size) {
+	seq_t seq = seq_create(type);
+	seq_iter_t iter = NULL;
+	seq_size_t slow = BENCH_SLOW_BUDGET / size;
+	seq_size_t removes;
+	seq_size_t i;
+	seq_size_t n = 0;
+
+	if(!seq) bench_fail(type, "create", SEQ_ERR_MEM);
+
+	if(slow < 10) slow = 10;
+
+	if(slow > size) slow = size;
+
+	removes = type == SEQ_VECTOR ? slow : slow * 3;
+
+	BENCH_BEGIN(b)
+		for(i = 0; i < size; i++) {
+			BENCH_CHECK(b, type, "append", seq_add(seq, SEQ_APPEND, &bench_data));
+		}
+	BENCH_END(b, type, "append", size, size)
+
+	BENCH_BEGIN(b)
+		iter = bench_iter(seq, type, "iterate");
+
+		while(seq_iterate(iter)) n += seq_iter_get(iter, SEQ_DATA) == &bench_data;
+
+		seq_iter_destroy(iter);
+	BENCH_END(b, type, "iterate", size, n)
+
+	BENCH_BEGIN(b)
+		for(i = 0; i < slow; i++) BENCH_CHECK_DATA(
+			type,
+			"get",
+			seq_get(seq, SEQ_INDEX, (seq_index_t)(bench_rand(b, size)))
+		);
+	BENCH_END(b, type, "get", size, slow)
+
+	BENCH_BEGIN(b)
+		for(i = 0; i < slow; i++) {
+			BENCH_CHECK(b, type, "prepend", seq_add(seq, SEQ_PREPEND, &bench_data));
+		}
+	BENCH_END(b, type, "prepend", size, slow)
+
+	if(type != SEQ_VECTOR) {
+		BENCH_BEGIN(b)
+			for(i = 0; i < slow; i++) BENCH_CHECK(b, type, "before", seq_add(
+				seq,
+				SEQ_BEFORE,
+				SEQ_INDEX,
+				(seq_index_t)(bench_rand(b, seq_size(seq))),
+				&bench_data
+			));
+		BENCH_END(b, type, "before", size, slow)
+
+		BENCH_BEGIN(b)
+			for(i = 0; i < slow; i++) BENCH_CHECK(b, type, "after", seq_add(
+				seq,
+				SEQ_AFTER,
+				SEQ_INDEX,
+				(seq_index_t)(bench_rand(b, seq_size(seq))),
+				&bench_data
+			));
+		BENCH_END(b, type, "after", size, slow)
+	}
+
+	BENCH_BEGIN(b)
+		for(i = 0; i < removes; i++) BENCH_CHECK(b, type, "remove", seq_remove(
+			seq,
+			SEQ_INDEX,
+			(seq_index_t)(bench_rand(b, seq_size(seq)))
+		));
+	BENCH_END(b, type, "remove", size, removes)
+
+	BENCH_BEGIN(b)
+		seq_destroy(seq);
+	BENCH_END(b, type, "destroy", size, size)
+}
+
+static seq_opt_t bench_cmp(seq_t seq, seq_data_t lhs, seq_data_t rhs) {
+	seq_size_t a = *(seq_size_t*)(lhs);
+	seq_size_t b = *(seq_size_t*)(rhs);
+
+	return a < b ? SEQ_LESS : (a > b ? SEQ_GREATER : SEQ_EQUAL);
+}
+
+/* Maps are keyed rather than indexed, so they get their own set of operations: the even numbers
+ * below 2 * size are inserted in random order, then scanned in windows of 16 keys, looked up (and
+ * missed, using the odd ones) at random, and finally all removed. A SEQ_ART is keyed by strings
+ * instead, zero-padded so they sort the same way, and has no range scans. */
+static void bench_map(bench_t* b, seq_opt_t type, seq_size_t size) {
+	seq_t seq = seq_create(type);
+	seq_iter_t iter = NULL;
+	seq_size_t* nums = (seq_size_t*)(malloc(size * 2 * sizeof(seq_size_t)));
+	char* strs = type == SEQ_ART ? (char*)(malloc(size * 2 * 16)) : NULL;
+	seq_data_t* keys = (seq_data_t*)(malloc(size * 2 * sizeof(seq_data_t)));
+	seq_data_t tmp;
+	seq_size_t lo;
+	seq_size_t hi;
+	seq_size_t i;
+	seq_size_t j;
+	seq_size_t n = 0;
+
+	if(
+		!seq ||
+		!nums ||
+		!keys ||
+		(type == SEQ_ART && !strs) ||
+		(type != SEQ_ART && seq_config(seq, SEQ_CB_CMP, bench_cmp))
+	) bench_fail(type, "create", SEQ_ERR_MEM);
+
+	for(i = 0; i < size * 2; i++) {
+		nums[i] = i;
+		keys[i] = &nums[i];
+
+		if(strs) {
+			sprintf(&strs[i * 16], "%015lu", (unsigned long)(i));
+
+			keys[i] = &strs[i * 16];
+		}
+	}
+
+	for(i = size - 1; i > 0; i--) {
+		j = bench_rand(b, i + 1);
+		tmp = keys[i * 2];
+		keys[i * 2] = keys[j * 2];
+		keys[j * 2] = tmp;
+	}
+
+	BENCH_BEGIN(b)
+		for(i = 0; i < size; i++) BENCH_CHECK(
+			b,
+			type,
+			"insert",
+			seq_add(seq, SEQ_KEYVAL, keys[i * 2], &bench_data)
+		);
+	BENCH_END(b, type, "insert", size, size)
+
+	BENCH_BEGIN(b)
+		iter = bench_iter(seq, type, "iterate");
+
+		while(seq_iterate(iter)) n += seq_iter_get(iter, SEQ_DATA) == &bench_data;
+
+		seq_iter_destroy(iter);
+	BENCH_END(b, type, "iterate", size, n)
+
+	if(type != SEQ_ART) {
+		BENCH_BEGIN(b)
+			for(i = 0; i < size; i++) {
+				lo = bench_rand(b, size) * 2;
+				hi = lo + 31;
+				iter = seq_iter_create(seq, SEQ_RANGE, &lo, &hi, SEQ_ERR_NONE);
+
+				if(!iter) bench_fail(type, "range", SEQ_ERR_MEM);
+
+				while(seq_iterate(iter)) n++;
+
+				seq_iter_destroy(iter);
+			}
+		BENCH_END(b, type, "range", size, size)
+	}
+
+	BENCH_BEGIN(b)
+		for(i = 0; i < size; i++) BENCH_CHECK_DATA(
+			type,
+			"get",
+			seq_get(seq, SEQ_KEY, keys[bench_rand(b, size) * 2])
+		);
+	BENCH_END(b, type, "get", size, size)
+
+	BENCH_BEGIN(b)
+		for(i = 0; i < size; i++) BENCH_CHECK_DATA(
+			type,
+			"miss",
+			!seq_get(seq, SEQ_KEY, keys[(bench_rand(b, size) * 2) + 1])
+		);
+	BENCH_END(b, type, "miss", size, size)
+
+	BENCH_BEGIN(b)
+		for(i = 0; i < size; i++) {
+			BENCH_CHECK(b, type, "remove", seq_remove(seq, SEQ_KEY, keys[i * 2]));
+		}
+	BENCH_END(b, type, "remove", size, size)
+
+	seq_destroy(seq);
+
+	free(keys);
+	free(strs);
+	free(nums);
+}
+
+/* Heaps and deques are only ever added to and taken from at their ends: every element is pushed
+ * (with a random priority, for a heap), and then all of them are popped--except that thieves take
+ * the older half of a deque's elements, from the other end. */
+static void bench_queue(bench_t* b, seq_opt_t type, seq_size_t size) {
+	seq_t seq = seq_create(type);
+	seq_iter_t iter = NULL;
+	seq_size_t* nums = (seq_size_t*)(malloc(size * sizeof(seq_size_t)));
+	seq_size_t pops = type == SEQ_DEQUE ? size / 2 : size;
+	seq_size_t i;
+	seq_size_t n = 0;
+
+	if(!seq || !nums || (type == SEQ_HEAP && seq_config(seq, SEQ_CB_CMP, bench_cmp))) {
+		bench_fail(type, "create", SEQ_ERR_MEM);
+	}
+
+	for(i = 0; i < size; i++) nums[i] = bench_rand(b, size);
+
+	BENCH_BEGIN(b)
+		for(i = 0; i < size; i++) BENCH_CHECK(b, type, "push", seq_add(seq, SEQ_PUSH, &nums[i]));
+	BENCH_END(b, type, "push", size, size)
+
+	BENCH_BEGIN(b)
+		iter = bench_iter(seq, type, "iterate");
+
+		while(seq_iterate(iter)) n += seq_iter_get(iter, SEQ_DATA) != NULL;
+
+		seq_iter_destroy(iter);
+	BENCH_END(b, type, "iterate", size, n)
+
+	BENCH_BEGIN(b)
+		for(i = 0; i < pops; i++) BENCH_CHECK_DATA(type, "pop", seq_get(seq, SEQ_POP));
+	BENCH_END(b, type, "pop", size, pops)
+
+	if(type == SEQ_DEQUE) {
+		BENCH_BEGIN(b)
+			for(i = pops; i < size; i++) {
+				BENCH_CHECK_DATA(type, "steal", seq_get(seq, SEQ_STEAL));
+			}
+		BENCH_END(b, type, "steal", size, size - pops)
+	}
+
+	if(seq_size(seq)) bench_fail(type, "pop", SEQ_ERR_DATA);
+
+	seq_destroy(seq);
+
+	free(nums);
+}
+
+/* A cache with room for half of its keys: random keys are added until it's full, and then looked
+ * up at random, adding those that miss back in (evicting another entry every time). */
+static void bench_cache(bench_t* b, seq_size_t size) {
+	seq_t seq = seq_create(SEQ_CACHE);
+	char* keys = (char*)(malloc(size * 16));
+	char* key = NULL;
+	seq_size_t i;
+	seq_size_t n = 0;
+
+	if(!seq || !keys || seq_config(seq, SEQ_CAPACITY, size / 2 + 1, (seq_size_t)(0))) {
+		bench_fail(SEQ_CACHE, "create", SEQ_ERR_MEM);
+	}
+
+	for(i = 0; i < size; i++) sprintf(&keys[i * 16], "%lu", (unsigned long)(i));
+
+	BENCH_BEGIN(b)
+		for(i = 0; i < size; i++) BENCH_CHECK(
+			b,
+			SEQ_CACHE,
+			"insert",
+			seq_add(seq, SEQ_KEYVAL, &keys[bench_rand(b, size) * 16], &bench_data)
+		);
+	BENCH_END(b, SEQ_CACHE, "insert", size, size)
+
+	BENCH_BEGIN(b)
+		for(i = 0; i < size; i++) {
+			key = &keys[bench_rand(b, size) * 16];
+
+			if(!seq_get(seq, SEQ_KEY, key)) {
+				BENCH_CHECK(b, SEQ_CACHE, "get-or-add", seq_add(seq, SEQ_KEYVAL, key, &bench_data));
+			}
+		}
+	BENCH_END(b, SEQ_CACHE, "get-or-add", size, size)
+
+	n = seq_size(seq);
+
+	BENCH_BEGIN(b)
+		seq_destroy(seq);
+	BENCH_END(b, SEQ_CACHE, "destroy", size, n)
+
+	free(keys);
+}
+
+int main(int argc, char** argv) {
+	static const seq_opt_t types[] = { SEQ_LIST, SEQ_ARRAY, SEQ_VECTOR };
+	static const seq_opt_t maps[] = { SEQ_MAP, SEQ_ART };
+	static const seq_opt_t queues[] = { SEQ_HEAP, SEQ_DEQUE };
+	bench_t b;
+	seq_size_t max = BENCH_MAX_SIZE;
+	seq_size_t size;
+	seq_size_t t;
+
+	b.format = argc > 1 ? argv[1] : "csv";
+	b.rows = 0;
+	b.rng = 88172645463325252UL;
+	b.err = SEQ_ERR_NONE;
+
+	if(argc > 2) max = (seq_size_t)(strtoul(argv[2], NULL, 10));
+
+	if(strcmp(b.format, "csv") && strcmp(b.format, "json")) {
+		fprintf(stderr, "usage: %s [csv|json] [max-size]\n", argv[0]);
+
+		return 1;
+	}
+
+	if(!strcmp(b.format, "csv")) printf("type,op,size,ops,ns_per_op,allocs_per_op,rss_kb\n");
+
+	for(t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+		for(size = 10; size <= max; size *= 10) bench_type(&b, types[t], size);
+	}
+
+	for(t = 0; t < sizeof(maps) / sizeof(maps[0]); t++) {
+		for(size = 10; size <= max; size *= 10) bench_map(&b, maps[t], size);
+	}
+
+	for(t = 0; t < sizeof(queues) / sizeof(queues[0]); t++) {
+		for(size = 10; size <= max; size *= 10) bench_queue(&b, queues[t], size);
+	}
+
+	for(size = 10; size <= max; size *= 10) bench_cache(&b, size);
+
+	if(!strcmp(b.format, "json")) printf("%s]\n", b.rows ? "\n" : "[");
+
+	return 0;
+}
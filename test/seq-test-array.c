@@ -0,0 +1,158 @@
+#include "seq-test.h"
+
+#include <string.h>
+#include <fcntl.h>
+
+typedef struct _point_t {
+	int32_t x;
+	int32_t y;
+} point_t;
+
+static const char* test_path = "seq-test-array.dat";
+
+static point_t* point(int32_t x, int32_t y) {
+	static point_t p;
+
+	p.x = x;
+	p.y = y;
+
+	return &p;
+}
+
+static const char* test_str(seq_t seq, seq_index_t index) {
+	const char* str = (const char*)(seq_get(seq, SEQ_INDEX, index));
+
+	return str ? str : "";
+}
+
+SEQ_TEST_BEGIN_TYPE(add_remove, SEQ_ARRAY)
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, "bar") )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, "baz") )
+	SEQ_ASSERT( !seq_add(seq, SEQ_PREPEND, "foo") )
+	SEQ_ASSERT( !seq_add(seq, SEQ_AFTER, SEQ_INDEX, (seq_index_t)(-1), "qux") )
+	SEQ_ASSERT( !seq_add(seq, SEQ_BEFORE, SEQ_INDEX, (seq_index_t)(1), "FOO") )
+	SEQ_ASSERT( !seq_add(seq, SEQ_REPLACE, SEQ_INDEX, (seq_index_t)(1), "Foo") )
+	SEQ_ASSERT( seq_add(seq, SEQ_BEFORE, SEQ_INDEX, (seq_index_t)(9), "err") == SEQ_ERR_NODE )
+	SEQ_ASSERT( seq_size(seq) == 5 )
+	SEQ_ASSERT( !strcmp(test_str(seq, 0), "foo") )
+	SEQ_ASSERT( !strcmp(test_str(seq, 1), "Foo") )
+	SEQ_ASSERT( !strcmp(test_str(seq, 2), "bar") )
+	SEQ_ASSERT( !strcmp(test_str(seq, -1), "qux") )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_INDEX, (seq_index_t)(1)) )
+	SEQ_ASSERT( !seq_set(seq, SEQ_INDEX, (seq_index_t)(0), "FOO") )
+	SEQ_ASSERT( !strcmp(test_str(seq, 0), "FOO") )
+	SEQ_ASSERT( !strcmp(test_str(seq, 1), "bar") )
+	SEQ_ASSERT( seq_size(seq) == 4 )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(mapped, SEQ_ARRAY)
+	uint64_t size = ((uint64_t)(1) << 61) + 1;
+	seq_t map = NULL;
+	point_t* p = NULL;
+	FILE* file = NULL;
+	int32_t i;
+
+	remove(test_path);
+
+	SEQ_ASSERT( !seq_create_mapped(test_path, sizeof(point_t), O_RDWR) )
+	SEQ_ASSERT( (map = seq_create_mapped(test_path, sizeof(point_t), O_RDWR | O_CREAT)) )
+
+	for(i = 0; i < 1000; i++) seq_add(map, SEQ_APPEND, point(i, i * 2));
+
+	SEQ_ASSERT( seq_size(map) == 1000 )
+	SEQ_ASSERT( !seq_remove(map, SEQ_INDEX, (seq_index_t)(0)) )
+	SEQ_ASSERT( !seq_add(map, SEQ_PREPEND, point(-1, -2)) )
+	SEQ_ASSERT( !seq_add(map, SEQ_APPEND, seq_get(map, SEQ_INDEX, (seq_index_t)(1))) )
+	SEQ_ASSERT( (p = (point_t*)(seq_get(map, SEQ_INDEX, (seq_index_t)(-1)))) && p->y == 2 )
+	SEQ_ASSERT( !seq_remove(map, SEQ_INDEX, (seq_index_t)(-1)) )
+	SEQ_ASSERT( !seq_sync(map) )
+	SEQ_ASSERT( seq_sync(seq) == SEQ_ERR_OPT )
+
+	seq_destroy(map);
+
+	SEQ_ASSERT( !seq_create_mapped(test_path, sizeof(point_t) * 2, O_RDWR) )
+	SEQ_ASSERT( (map = seq_create_mapped(test_path, 0, O_RDONLY)) )
+	SEQ_ASSERT( seq_size(map) == 1000 )
+	SEQ_ASSERT( (p = (point_t*)(seq_get(map, SEQ_INDEX, (seq_index_t)(0)))) && p->x == -1 )
+	SEQ_ASSERT( (p = (point_t*)(seq_get(map, SEQ_INDEX, (seq_index_t)(999)))) && p->y == 1998 )
+	SEQ_ASSERT( seq_get(map, SEQ_DATA, p) == p )
+	SEQ_ASSERT( seq_add(map, SEQ_APPEND, point(0, 0)) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_sync(map) == SEQ_ERR_OPT )
+
+	seq_destroy(map);
+
+	SEQ_ASSERT( (map = seq_create_mapped(test_path, sizeof(point_t), O_RDWR)) )
+	SEQ_ASSERT( (p = (point_t*)(seq_get(map, SEQ_INDEX, (seq_index_t)(500)))) && p->x == 500 )
+	SEQ_ASSERT( !seq_remove(map, SEQ_DATA, p) )
+	SEQ_ASSERT( seq_size(map) == 999 )
+	SEQ_ASSERT( (p = (point_t*)(seq_get(map, SEQ_INDEX, (seq_index_t)(500)))) && p->x == 501 )
+
+	seq_destroy(map);
+
+	/* A corrupt size whose byte length overflows must not pass for one that fits the file. */
+	SEQ_ASSERT( (file = fopen(test_path, "r+b")) != NULL )
+	SEQ_ASSERT( !fseek(file, 16, SEEK_SET) && fwrite(&size, sizeof(size), 1, file) == 1 )
+
+	fclose(file);
+
+	SEQ_ASSERT( !seq_create_mapped(test_path, 0, O_RDONLY) )
+
+	remove(test_path);
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(stride, SEQ_ARRAY)
+	double v = 1.5;
+	double* p;
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( seq_config(seq, SEQ_STRIDE, (seq_size_t)(0)) == SEQ_ERR_OPT )
+	SEQ_ASSERT( !seq_config(seq, SEQ_STRIDE, sizeof(double)) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, &v) )
+
+	v = 2.5;
+
+	SEQ_ASSERT( !seq_add(seq, SEQ_PREPEND, &v) )
+	SEQ_ASSERT( seq_config(seq, SEQ_STRIDE, sizeof(float)) == SEQ_ERR_OPT )
+
+	p = (double*)(seq_get(seq, SEQ_INDEX, (seq_index_t)(0)));
+
+	SEQ_ASSERT( p[0] == 2.5 && p[1] == 1.5 )
+	SEQ_ASSERT( seq_get(seq, SEQ_DATA, &p[1]) == &p[1] )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_DATA, &p[0]) )
+	SEQ_ASSERT( *(double*)(seq_get(seq, SEQ_INDEX, (seq_index_t)(0))) == 1.5 )
+
+	/* Copying an element of the array into it again, while the buffer grows or shifts. */
+	for(i = 0; i < 100; i++) {
+		if(seq_add(seq, SEQ_APPEND, seq_get(seq, SEQ_INDEX, (seq_index_t)(0)))) ok = 0;
+	}
+
+	v = 3.5;
+
+	SEQ_ASSERT( ok && !seq_add(seq, SEQ_APPEND, &v) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_PREPEND, seq_get(seq, SEQ_INDEX, (seq_index_t)(-1))) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_PREPEND, seq_get(seq, SEQ_INDEX, (seq_index_t)(1))) )
+
+	p = (double*)(seq_get(seq, SEQ_INDEX, (seq_index_t)(2)));
+
+	SEQ_ASSERT( !seq_add(seq, SEQ_BEFORE, SEQ_INDEX, (seq_index_t)(1), p) )
+	SEQ_ASSERT( seq_size(seq) == 105 )
+
+	p = (double*)(seq_get(seq, SEQ_INDEX, (seq_index_t)(0)));
+
+	SEQ_ASSERT( p[0] == 1.5 && p[1] == 1.5 && p[2] == 3.5 && p[104] == 3.5 )
+
+	for(i = 3; i < 104; i++) {
+		if(p[i] != 1.5) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	test_add_remove("SEQ_ARRAY");
+	test_mapped("seq_create_mapped / seq_sync");
+	test_stride("SEQ_STRIDE");
+
+	return test_failures;
+}
@@ -0,0 +1,415 @@
+#include "seq-test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ART_KEYS 3000
+#define ART_STEPS 30000
+
+static char keys[ART_KEYS][64];
+static char bytes[255][3];
+static int vals[ART_KEYS];
+static int present[ART_KEYS];
+static int removed = 0;
+static unsigned long art_seed = 7;
+
+/* Long shared prefixes exercise path compression beyond the bytes a node keeps. */
+static const char* prefixes[] = {
+	"user:",
+	"user:1",
+	"us",
+	"https://example.com/a/rather/long/path/",
+	"https://example.com/a/rather/long/path/to/somewhere/",
+	""
+};
+
+static void val_remove(seq_data_t data) {
+	removed++;
+}
+
+static seq_opt_t val_cmp(seq_t seq, seq_data_t lhs, seq_data_t rhs) {
+	return SEQ_EQUAL;
+}
+
+static void keys_init(void) {
+	int i;
+
+	for(i = 0; i < ART_KEYS; i++) {
+		sprintf(keys[i], "%s%d", prefixes[i % 6], i);
+
+		vals[i] = i;
+	}
+
+	for(i = 0; i < 255; i++) {
+		bytes[i][0] = 'x';
+		bytes[i][1] = (char)(i + 1);
+		bytes[i][2] = 0;
+	}
+}
+
+static int art_rand(int n) {
+	art_seed = (art_seed * 1103515245UL) + 12345UL;
+
+	return (int)((art_seed >> 16) % (unsigned long)(n));
+}
+
+static int art_starts(const char* key, const char* prefix) {
+	return !strncmp(key, prefix, strlen(prefix));
+}
+
+/* Iterates the keys starting with @prefix (all of them, if it's NULL), verifying they come out in
+ * order and match the model (if given); returns how many were seen, or -1. */
+static int art_scan(seq_t seq, const char* prefix, const int* model) {
+	seq_iter_t iter = prefix ?
+		seq_iter_create(seq, SEQ_KEY_PREFIX, prefix, SEQ_ERR_NONE) :
+		seq_iter_create(seq, SEQ_ERR_NONE)
+	;
+
+	const char* prev = NULL;
+	const char* key = NULL;
+	int n = 0;
+	int ok = 1;
+	int i;
+
+	if(!iter) return -1;
+
+	while(seq_iterate(iter)) {
+		key = (const char*)(seq_iter_get(iter, SEQ_KEY));
+		i = *(int*)(seq_iter_get(iter, SEQ_DATA));
+
+		if(prev && strcmp(prev, key) >= 0) ok = 0;
+
+		if(prefix && !art_starts(key, prefix)) ok = 0;
+
+		if(key != keys[i] || (model && !model[i])) ok = 0;
+
+		prev = key;
+
+		n++;
+	}
+
+	seq_iter_destroy(iter);
+
+	return ok ? n : -1;
+}
+
+/* Counts the keys of the model that start with @prefix. */
+static int art_count(const char* prefix, const int* model) {
+	int n = 0;
+	int i;
+
+	for(i = 0; i < ART_KEYS; i++) n += (!model || model[i]) && art_starts(keys[i], prefix);
+
+	return n;
+}
+
+SEQ_TEST_BEGIN_TYPE(keyval, SEQ_ART)
+	struct _seq_stats_t stats;
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( seq_type(seq) == SEQ_ART )
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_REMOVE, val_remove) )
+	SEQ_ASSERT( seq_config(seq, SEQ_CB_CMP, val_cmp) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[0]) == NULL )
+	SEQ_ASSERT( seq_remove(seq, SEQ_KEY, keys[0]) == SEQ_ERR_NODE )
+	SEQ_ASSERT( seq_add(seq, SEQ_APPEND, &vals[0]) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_add(seq, SEQ_KEYVAL, NULL, &vals[0]) == SEQ_ERR_DATA )
+	SEQ_ASSERT( art_scan(seq, NULL, NULL) == 0 )
+
+	for(i = ART_KEYS - 1; i >= 0; i--) {
+		if(seq_add(seq, SEQ_KEYVAL, keys[i], &vals[i])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_size(seq) == ART_KEYS )
+	SEQ_ASSERT( art_scan(seq, NULL, NULL) == ART_KEYS )
+
+	for(i = 0; i < ART_KEYS; i++) {
+		if(seq_get(seq, SEQ_KEY, keys[i]) != &vals[i]) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, "user") == NULL )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, "https://example.com/a/rather/long/path/") == NULL )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, "https://example.com/a/rather/LONG/path/3") == NULL )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, "") == NULL )
+
+	/* Lookups cost one hop per distinguishing byte, however many keys there are. */
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.hops < (seq_size_t)(ART_KEYS) * 2 * 8 )
+
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, "user:0", &vals[1]) )
+	SEQ_ASSERT( removed == 1 && seq_size(seq) == ART_KEYS )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[0]) == &vals[1] )
+	SEQ_ASSERT( !seq_set(seq, SEQ_KEY, keys[0], &vals[0]) )
+	SEQ_ASSERT( removed == 2 && seq_get(seq, SEQ_KEY, "user:0") == &vals[0] )
+	SEQ_ASSERT( seq_set(seq, SEQ_KEY, "user:", &vals[0]) == SEQ_ERR_NODE )
+
+	for(i = 0; i < ART_KEYS; i += 2) {
+		if(seq_remove(seq, SEQ_KEY, keys[i])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( removed == 2 + (ART_KEYS / 2) )
+	SEQ_ASSERT( seq_size(seq) == ART_KEYS / 2 )
+	SEQ_ASSERT( seq_remove(seq, SEQ_KEY, keys[0]) == SEQ_ERR_NODE )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[1]) == &vals[1] )
+	SEQ_ASSERT( art_scan(seq, NULL, NULL) == ART_KEYS / 2 )
+
+	for(i = 1; i < ART_KEYS; i += 2) {
+		if(seq_remove(seq, SEQ_KEY, keys[i])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_size(seq) == 0 )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.nodes_alloc > 0 && stats.nodes_alloc == stats.nodes_free )
+SEQ_TEST_END
+
+/* Every possible byte after the same first one grows a node through all four sizes, and back. */
+SEQ_TEST_BEGIN_TYPE(nodes, SEQ_ART)
+	struct _seq_stats_t stats;
+	seq_iter_t iter = NULL;
+	int prev = 0;
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+
+	for(i = 0; i < 255; i++) {
+		if(seq_add(seq, SEQ_KEYVAL, bytes[(i * 101) % 255], &vals[(i * 101) % 255])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_size(seq) == 255 )
+	SEQ_ASSERT( (iter = seq_iter_create(seq, SEQ_ERR_NONE)) != NULL )
+
+	for(i = 0; seq_iterate(iter); i++) {
+		if(seq_iter_get(iter, SEQ_KEY) != bytes[i]) ok = 0;
+
+		if(i == 100) seq_iter_set(iter, SEQ_DATA, &vals[0]);
+	}
+
+	seq_iter_destroy(iter);
+
+	SEQ_ASSERT( ok && i == 255 )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, bytes[100]) == &vals[0] )
+
+	for(i = 0; i < 255; i++) {
+		if(i != 17 && i != 200 && seq_remove(seq, SEQ_KEY, bytes[i])) ok = 0;
+
+		if(i == 127 && (iter = seq_iter_create(seq, SEQ_KEY_PREFIX, "x", SEQ_ERR_NONE))) {
+			for(prev = 0; seq_iterate(iter); prev++);
+
+			seq_iter_destroy(iter);
+		}
+	}
+
+	SEQ_ASSERT( ok && prev == 255 - 127 )
+	SEQ_ASSERT( seq_size(seq) == 2 )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, bytes[17]) == &vals[17] )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, bytes[200]) == &vals[200] )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_KEY, bytes[17]) )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, bytes[200]) == &vals[200] )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_KEY, bytes[200]) )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.nodes_alloc == stats.nodes_free )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(prefix, SEQ_ART)
+	seq_iter_t iter = NULL;
+	seq_iter_t copy = NULL;
+	int ok = 1;
+	int i;
+
+	for(i = 0; i < ART_KEYS; i++) seq_add(seq, SEQ_KEYVAL, keys[i], &vals[i]);
+
+	SEQ_ASSERT( art_scan(seq, "user:", NULL) == art_count("user:", NULL) )
+	SEQ_ASSERT( art_scan(seq, "user:1", NULL) == art_count("user:1", NULL) )
+	SEQ_ASSERT( art_scan(seq, "user:12", NULL) == art_count("user:12", NULL) )
+	SEQ_ASSERT( art_scan(seq, "us", NULL) == art_count("us", NULL) )
+	SEQ_ASSERT( art_scan(seq, "https://example.com/a/rather", NULL) == ART_KEYS / 3 )
+	SEQ_ASSERT( art_scan(seq, "https://example.com/a/rather/long/path/to/", NULL) == ART_KEYS / 6 )
+	SEQ_ASSERT( art_scan(seq, "https://example.com/a/rather/short", NULL) == 0 )
+	SEQ_ASSERT( art_scan(seq, "user:1000", NULL) == art_count("user:1000", NULL) )
+	SEQ_ASSERT( art_scan(seq, "user:10000", NULL) == 0 )
+	SEQ_ASSERT( art_scan(seq, "zzz", NULL) == 0 )
+	SEQ_ASSERT( art_scan(seq, "", NULL) == ART_KEYS )
+	SEQ_ASSERT( seq_iter_create(seq, SEQ_KEY_PREFIX, NULL, SEQ_ERR_NONE) == NULL )
+	SEQ_ASSERT( seq_iter_create(seq, SEQ_RANGE, 0, 1, SEQ_ERR_NONE) == NULL )
+
+	/* A copy carries on from the same position, independently. */
+	SEQ_ASSERT( (iter = seq_iter_create(seq, SEQ_KEY_PREFIX, "us", SEQ_ERR_NONE)) != NULL )
+
+	for(i = 0; i < 10; i++) seq_iterate(iter);
+
+	SEQ_ASSERT( (copy = seq_iter_copy(iter)) != NULL )
+
+	while(seq_iterate(iter)) {
+		if(!seq_iterate(copy) || seq_iter_get(copy, SEQ_KEY) != seq_iter_get(iter, SEQ_KEY)) ok = 0;
+	}
+
+	SEQ_ASSERT( ok && !seq_iterate(copy) )
+
+	seq_iter_destroy(copy);
+	seq_iter_destroy(iter);
+SEQ_TEST_END
+
+/* Keys are copied from a single buffer, which is overwritten between calls. */
+SEQ_TEST_BEGIN_TYPE(intern, SEQ_ART)
+	seq_iter_t iter = NULL;
+	const char* key = NULL;
+	char buf[64];
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_INTERN, 1) )
+
+	for(i = 0; i < ART_KEYS; i++) {
+		strcpy(buf, keys[i]);
+
+		if(seq_add(seq, SEQ_KEYVAL, buf, &vals[i])) ok = 0;
+	}
+
+	strcpy(buf, keys[42]);
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_config(seq, SEQ_INTERN, 0) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_size(seq) == ART_KEYS )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[42]) == &vals[42] )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, "user:") == NULL )
+	SEQ_ASSERT( (iter = seq_iter_create(seq, SEQ_KEY_PREFIX, buf, SEQ_ERR_NONE)) != NULL )
+	SEQ_ASSERT( seq_iterate(iter) && (key = (const char*)(seq_iter_get(iter, SEQ_KEY))) != buf )
+	SEQ_ASSERT( !strcmp(key, keys[42]) && key != keys[42] )
+
+	seq_iter_destroy(iter);
+
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, keys[42], &vals[0]) )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_KEY, buf) && seq_get(seq, SEQ_KEY, keys[42]) == NULL )
+	SEQ_ASSERT( seq_remove(seq, SEQ_KEY, "user:") == SEQ_ERR_NODE )
+	SEQ_ASSERT( seq_set(seq, SEQ_KEY, "user:", &vals[0]) == SEQ_ERR_NODE )
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, buf, &vals[42]) )
+	SEQ_ASSERT( (iter = seq_iter_create(seq, SEQ_KEY_PREFIX, buf, SEQ_ERR_NONE)) != NULL )
+	SEQ_ASSERT( seq_iterate(iter) && seq_iter_get(iter, SEQ_KEY) == key )
+
+	seq_iter_destroy(iter);
+
+	for(i = 0; i < ART_KEYS; i++) {
+		if(seq_remove(seq, SEQ_KEY, keys[i])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok && seq_size(seq) == 0 )
+	SEQ_ASSERT( !seq_config(seq, SEQ_INTERN, 0) )
+SEQ_TEST_END
+
+/* The filter works alongside interning, and turns keys away before they're looked up in the arena;
+ * removing most keys rebuilds it without losing those still present. */
+SEQ_TEST_BEGIN_TYPE(bloom, SEQ_ART)
+	struct _seq_stats_t stats;
+	char buf[64];
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_INTERN, 1) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_BLOOM, (seq_size_t)(ART_KEYS)) )
+
+	for(i = 0; i < ART_KEYS; i++) {
+		if(seq_add(seq, SEQ_KEYVAL, keys[i], &vals[i])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok && seq_size(seq) == ART_KEYS )
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+
+	for(i = 0; i < ART_KEYS; i++) {
+		sprintf(buf, "%s%dx", prefixes[i % 6], i);
+
+		if(seq_get(seq, SEQ_KEY, buf)) ok = 0;
+	}
+
+	SEQ_ASSERT( ok && !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.hops < ART_KEYS / 10 )
+
+	for(i = 0; i < ART_KEYS; i++) {
+		if(i % 4 && seq_remove(seq, SEQ_KEY, keys[i])) ok = 0;
+	}
+
+	for(i = 0; i < ART_KEYS; i++) {
+		if(seq_get(seq, SEQ_KEY, keys[i]) != (i % 4 ? NULL : &vals[i])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok && seq_size(seq) == ART_KEYS / 4 )
+	SEQ_ASSERT( !seq_config(seq, SEQ_BLOOM, (seq_size_t)(0)) )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[4]) == &vals[4] && !seq_get(seq, SEQ_KEY, keys[5]) )
+SEQ_TEST_END
+
+/* Random insertions and removals against a model, checking order and prefix scans as it goes. */
+SEQ_TEST_BEGIN_TYPE(model, SEQ_ART)
+	struct _seq_stats_t stats;
+	seq_size_t size = 0;
+	int ok = 1;
+	int i;
+	int k;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+
+	memset(present, 0, sizeof(present));
+
+	for(i = 0; i < ART_STEPS; i++) {
+		k = art_rand(i < ART_STEPS / 2 ? ART_KEYS : ART_KEYS / 5);
+
+		if(art_rand(10) < (i < ART_STEPS / 2 ? 6 : 3)) {
+			if(seq_add(seq, SEQ_KEYVAL, keys[k], &vals[k])) ok = 0;
+
+			if(!present[k]) size++;
+
+			present[k] = 1;
+		}
+
+		else {
+			if(seq_remove(seq, SEQ_KEY, keys[k]) != (present[k] ? SEQ_ERR_NONE : SEQ_ERR_NODE)) {
+				ok = 0;
+			}
+
+			if(present[k]) size--;
+
+			present[k] = 0;
+		}
+
+		if(seq_size(seq) != size) ok = 0;
+
+		if(!(i % 3000)) {
+			if(art_scan(seq, NULL, present) != (int)(size)) ok = 0;
+
+			if(art_scan(seq, prefixes[i % 5], present) != art_count(prefixes[i % 5], present)) ok = 0;
+		}
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( art_scan(seq, NULL, present) == (int)(size) )
+
+	for(i = 0; i < ART_KEYS; i++) {
+		if(seq_get(seq, SEQ_KEY, keys[i]) != (present[i] ? &vals[i] : NULL)) ok = 0;
+
+		if(present[i] && seq_remove(seq, SEQ_KEY, keys[i])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_size(seq) == 0 )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.nodes_alloc == stats.nodes_free )
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	keys_init();
+
+	test_keyval("SEQ_ART add/get/set/remove");
+	test_nodes("SEQ_ART node sizes");
+	test_prefix("SEQ_ART SEQ_KEY_PREFIX");
+	test_intern("SEQ_ART SEQ_INTERN");
+	test_bloom("SEQ_ART SEQ_BLOOM");
+	test_model("SEQ_ART random insert/remove");
+
+	return test_failures;
+}
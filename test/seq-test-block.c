@@ -0,0 +1,189 @@
+#if !defined(_WIN32)
+#define _GNU_SOURCE
+#endif
+
+#include "seq-test.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#define BLOCK_ITEMS 100000
+#define BLOCK_CONSUMERS 3
+#define BLOCK_PRODUCERS 4
+
+static int items[BLOCK_ITEMS];
+static int stop = 0;
+static char dump[4096];
+static seq_size_t dumped = 0;
+
+static uint64_t block_ms(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)(ts.tv_sec) * 1000) + ((uint64_t)(ts.tv_nsec) / 1000000);
+}
+
+typedef struct _block_consumer_t {
+	seq_t seq;
+	int received;
+} block_consumer_t;
+
+static void* block_consume(void* arg) {
+	block_consumer_t* consumer = (block_consumer_t*)(arg);
+	int* item;
+
+	while((item = (int*)(seq_get(consumer->seq, SEQ_RECV))) != &stop) {
+		if(item) {
+			(*item)++;
+
+			consumer->received++;
+		}
+	}
+
+	return NULL;
+}
+
+typedef struct _block_producer_t {
+	seq_t seq;
+	int first;
+} block_producer_t;
+
+static void* block_produce(void* arg) {
+	block_producer_t* producer = (block_producer_t*)(arg);
+	int i;
+
+	for(i = 0; i < BLOCK_ITEMS / BLOCK_PRODUCERS; i++) {
+		seq_add(producer->seq, SEQ_SEND, &items[producer->first + i]);
+	}
+
+	return NULL;
+}
+
+static seq_size_t block_write(const void* buf, seq_size_t size, seq_data_t ctx) {
+	if(dumped + size >= sizeof(dump)) return 0;
+
+	memcpy(dump + dumped, buf, size);
+
+	dumped += size;
+
+	return size;
+}
+
+SEQ_TEST_BEGIN_TYPE(queue, SEQ_QUEUE)
+	seq_t stack = seq_create(SEQ_STACK);
+
+	SEQ_ASSERT( seq_type(seq) == SEQ_QUEUE && seq_type(stack) == SEQ_STACK )
+	SEQ_ASSERT( !seq_add(seq, SEQ_SEND, &items[0]) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_SEND, &items[1]) )
+	SEQ_ASSERT( seq_get(seq, SEQ_RECV) == &items[0] )
+	SEQ_ASSERT( seq_get(seq, SEQ_RECV) == &items[1] )
+	SEQ_ASSERT( seq_get(seq, SEQ_RECV) == NULL )
+	SEQ_ASSERT( seq_size(seq) == 0 )
+	SEQ_ASSERT( !seq_add(stack, SEQ_PUSH, &items[0]) )
+	SEQ_ASSERT( !seq_add(stack, SEQ_PUSH, &items[1]) )
+	SEQ_ASSERT( seq_get(stack, SEQ_POP) == &items[1] )
+	SEQ_ASSERT( !seq_remove(stack, SEQ_POP) )
+	SEQ_ASSERT( seq_remove(stack, SEQ_POP) == SEQ_ERR_NODE )
+	SEQ_ASSERT( seq_set(stack, SEQ_POP, &items[0]) == SEQ_ERR_OPT )
+
+	seq_destroy(stack);
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(timeout, SEQ_QUEUE)
+	uint64_t begin;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_BLOCKING, 50, 100) )
+
+	begin = block_ms();
+
+	SEQ_ASSERT( seq_get(seq, SEQ_RECV) == NULL )
+	SEQ_ASSERT( block_ms() - begin >= 45 )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(0)) == NULL )
+	SEQ_ASSERT( !seq_add(seq, SEQ_SEND, &items[0]) )
+
+	begin = block_ms();
+
+	SEQ_ASSERT( seq_get(seq, SEQ_RECV) == &items[0] )
+	SEQ_ASSERT( block_ms() - begin < 45 )
+	SEQ_ASSERT( !seq_config(seq, SEQ_BLOCKING, 0, 0) )
+	SEQ_ASSERT( seq_get(seq, SEQ_RECV) == NULL )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(threads, SEQ_QUEUE)
+	pthread_t threads[BLOCK_CONSUMERS];
+	block_consumer_t consumers[BLOCK_CONSUMERS];
+	int total = 0;
+	int once = 1;
+	int i;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_BLOCKING, -1, 200) )
+
+	for(i = 0; i < BLOCK_CONSUMERS; i++) {
+		consumers[i].seq = seq;
+		consumers[i].received = 0;
+
+		pthread_create(&threads[i], NULL, block_consume, &consumers[i]);
+	}
+
+	for(i = 0; i < BLOCK_ITEMS; i++) seq_add(seq, SEQ_SEND, &items[i]);
+
+	for(i = 0; i < BLOCK_CONSUMERS; i++) seq_add(seq, SEQ_SEND, &stop);
+
+	for(i = 0; i < BLOCK_CONSUMERS; i++) {
+		pthread_join(threads[i], NULL);
+
+		total += consumers[i].received;
+	}
+
+	for(i = 0; i < BLOCK_ITEMS; i++) {
+		if(items[i] != 1) once = 0;
+	}
+
+	SEQ_ASSERT( total == BLOCK_ITEMS )
+	SEQ_ASSERT( once )
+	SEQ_ASSERT( seq_size(seq) == 0 )
+SEQ_TEST_END
+
+/* The SEQ_STATS and SEQ_TRACE bookkeeping happens partly outside the lock, yet must not lose a
+ * single call made by any of the producers. */
+SEQ_TEST_BEGIN_TYPE(producers, SEQ_QUEUE)
+	pthread_t threads[BLOCK_PRODUCERS];
+	block_producer_t producers[BLOCK_PRODUCERS];
+	struct _seq_stats_t stats;
+	int received = 0;
+	int i;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_BLOCKING, -1, 200) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_TRACE, 1) )
+
+	for(i = 0; i < BLOCK_PRODUCERS; i++) {
+		producers[i].seq = seq;
+		producers[i].first = i * (BLOCK_ITEMS / BLOCK_PRODUCERS);
+
+		pthread_create(&threads[i], NULL, block_produce, &producers[i]);
+	}
+
+	for(i = 0; i < BLOCK_ITEMS; i++) received += seq_get(seq, SEQ_RECV) != NULL;
+
+	for(i = 0; i < BLOCK_PRODUCERS; i++) pthread_join(threads[i], NULL);
+
+	SEQ_ASSERT( received == BLOCK_ITEMS && seq_size(seq) == 0 )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.add[SEQ_SEND & 0xFFFF] == BLOCK_ITEMS )
+	SEQ_ASSERT( stats.size_peak > 0 && stats.size_peak <= BLOCK_ITEMS )
+	SEQ_ASSERT( !seq_trace_dump(seq, block_write, NULL) )
+	SEQ_ASSERT( strstr(dump, "SEND     count=100000 ") != NULL )
+	SEQ_ASSERT( strstr(dump, "RECV     count=100000 ") != NULL )
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	test_queue("SEQ_QUEUE / SEQ_STACK");
+	test_timeout("SEQ_BLOCKING timeout");
+	test_threads("SEQ_BLOCKING producer/consumers");
+	test_producers("SEQ_BLOCKING producers (SEQ_STATS / SEQ_TRACE)");
+
+	return test_failures;
+}
@@ -0,0 +1,326 @@
+#include "seq-test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_KEYS 3000
+#define CACHE_STEPS 30000
+#define CACHE_CAPACITY 100
+
+static char keys[CACHE_KEYS][16];
+static int vals[CACHE_KEYS];
+static int present[CACHE_KEYS];
+static int removed = 0;
+static int evicted = -1;
+static unsigned long cache_seed = 7;
+
+/* Every element is one of the vals[], so the callback knows exactly which key it belonged to. */
+static void val_remove(seq_data_t data) {
+	removed++;
+
+	evicted = (int)((int*)(data) - vals);
+
+	present[evicted] = 0;
+}
+
+/* Each element is as large as its value. */
+static seq_size_t val_size(seq_data_t data) {
+	return (seq_size_t)(*(int*)(data));
+}
+
+static void keys_init(void) {
+	int i;
+
+	for(i = 0; i < CACHE_KEYS; i++) {
+		sprintf(keys[i], "key:%d", i);
+
+		vals[i] = i;
+	}
+}
+
+static int cache_rand(int n) {
+	cache_seed = (cache_seed * 1103515245UL) + 12345UL;
+
+	return (int)((cache_seed >> 16) % (unsigned long)(n));
+}
+
+/* Iterates the cache, returning how many entries were seen (or -1 if any doesn't match its key). */
+static int cache_scan(seq_t seq) {
+	seq_iter_t iter = seq_iter_create(seq, SEQ_ERR_NONE);
+	int n = 0;
+	int ok = 1;
+	int i;
+
+	if(!iter) return -1;
+
+	while(seq_iterate(iter)) {
+		i = *(int*)(seq_iter_get(iter, SEQ_DATA));
+
+		if(strcmp((const char*)(seq_iter_get(iter, SEQ_KEY)), keys[i])) ok = 0;
+
+		n++;
+	}
+
+	seq_iter_destroy(iter);
+
+	return ok ? n : -1;
+}
+
+SEQ_TEST_BEGIN_TYPE(keyval, SEQ_CACHE)
+	struct _seq_stats_t stats;
+	char buf[16];
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( seq_type(seq) == SEQ_CACHE )
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_REMOVE, val_remove) )
+	SEQ_ASSERT( seq_config(seq, SEQ_INTERN, 1) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_config(seq, SEQ_CB_SIZE, NULL) == SEQ_ERR_CB )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[0]) == NULL )
+	SEQ_ASSERT( seq_remove(seq, SEQ_KEY, keys[0]) == SEQ_ERR_NODE )
+	SEQ_ASSERT( seq_set(seq, SEQ_KEY, keys[0], &vals[0]) == SEQ_ERR_NODE )
+	SEQ_ASSERT( seq_add(seq, SEQ_APPEND, &vals[0]) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_add(seq, SEQ_KEYVAL, NULL, &vals[0]) == SEQ_ERR_DATA )
+	SEQ_ASSERT( seq_add(seq, SEQ_KEYVAL, keys[0], NULL) == SEQ_ERR_DATA )
+	SEQ_ASSERT( cache_scan(seq) == 0 )
+
+	/* Keys are copied, so the same buffer can be reused for every one of them. */
+	for(i = 0; i < CACHE_KEYS; i++) {
+		strcpy(buf, keys[i]);
+
+		if(seq_add(seq, SEQ_KEYVAL, buf, &vals[i])) ok = 0;
+	}
+
+	strcpy(buf, "gone");
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_size(seq) == CACHE_KEYS )
+	SEQ_ASSERT( removed == 0 )
+	SEQ_ASSERT( cache_scan(seq) == CACHE_KEYS )
+
+	for(i = 0; i < CACHE_KEYS; i++) {
+		if(seq_get(seq, SEQ_KEY, keys[i]) != &vals[i]) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, "key:") == NULL )
+	SEQ_ASSERT( seq_get(seq, SEQ_PEEK, "gone") == NULL )
+	SEQ_ASSERT( seq_get(seq, SEQ_PEEK, keys[7]) == &vals[7] )
+
+	/* The hash index grows along with the cache, so the chains stay short. */
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.hops < (seq_size_t)(CACHE_KEYS) * 2 * 2 )
+
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, keys[0], &vals[1]) )
+	SEQ_ASSERT( removed == 1 && evicted == 0 && seq_size(seq) == CACHE_KEYS )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[0]) == &vals[1] )
+	SEQ_ASSERT( !seq_set(seq, SEQ_KEY, keys[0], &vals[0]) )
+	SEQ_ASSERT( removed == 2 && evicted == 1 && seq_get(seq, SEQ_KEY, keys[0]) == &vals[0] )
+
+	for(i = 0; i < CACHE_KEYS; i += 2) {
+		if(seq_remove(seq, SEQ_KEY, keys[i]) || evicted != i) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_size(seq) == CACHE_KEYS / 2 )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[0]) == NULL )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[1]) == &vals[1] )
+	SEQ_ASSERT( cache_scan(seq) == CACHE_KEYS / 2 )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.nodes_alloc - stats.nodes_free == CACHE_KEYS / 2 )
+SEQ_TEST_END
+
+/* With room for 4 entries, the ones used since the hand last went by survive the next eviction. */
+SEQ_TEST_BEGIN_TYPE(clock, SEQ_CACHE)
+	seq_iter_t iter = NULL;
+	int order[8];
+	int n = 0;
+	int i;
+
+	removed = 0;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_REMOVE, val_remove) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CAPACITY, (seq_size_t)(4), (seq_size_t)(0)) )
+
+	for(i = 0; i < 4; i++) seq_add(seq, SEQ_KEYVAL, keys[i], &vals[i]);
+
+	SEQ_ASSERT( seq_size(seq) == 4 && removed == 0 )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[0]) == &vals[0] )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[1]) == &vals[1] )
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, keys[4], &vals[4]) )
+	SEQ_ASSERT( seq_size(seq) == 4 && removed == 1 && evicted == 2 )
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, keys[5], &vals[5]) )
+	SEQ_ASSERT( removed == 2 && evicted == 3 )
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, keys[6], &vals[6]) )
+	SEQ_ASSERT( removed == 3 && evicted == 4 )
+
+	/* Peeking doesn't count as a use, while replacing does. */
+	SEQ_ASSERT( seq_get(seq, SEQ_PEEK, keys[0]) == &vals[0] )
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, keys[7], &vals[7]) )
+	SEQ_ASSERT( removed == 4 && evicted == 0 )
+	SEQ_ASSERT( !seq_set(seq, SEQ_KEY, keys[1], &vals[1]) )
+	SEQ_ASSERT( removed == 5 && evicted == 1 )
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, keys[8], &vals[8]) )
+	SEQ_ASSERT( removed == 6 && evicted == 5 )
+	SEQ_ASSERT( seq_get(seq, SEQ_PEEK, keys[1]) == &vals[1] )
+
+	/* Iteration follows the hand, starting with the next entry it will look at. */
+	iter = seq_iter_create(seq, SEQ_ERR_NONE);
+
+	while(seq_iterate(iter) && n < 8) order[n++] = *(int*)(seq_iter_get(iter, SEQ_DATA));
+
+	seq_iter_destroy(iter);
+
+	SEQ_ASSERT( n == 4 )
+	SEQ_ASSERT( order[0] == 6 && order[1] == 7 && order[2] == 8 && order[3] == 1 )
+	SEQ_ASSERT( seq_iter_create(seq, SEQ_KEY_PREFIX, "key:", SEQ_ERR_NONE) == NULL )
+
+	/* Lowering the capacity evicts right away. */
+	SEQ_ASSERT( !seq_config(seq, SEQ_CAPACITY, (seq_size_t)(2), (seq_size_t)(0)) )
+	SEQ_ASSERT( seq_size(seq) == 2 && removed == 8 )
+	SEQ_ASSERT( seq_get(seq, SEQ_PEEK, keys[8]) && seq_get(seq, SEQ_PEEK, keys[1]) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CAPACITY, (seq_size_t)(1), (seq_size_t)(0)) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, keys[9], &vals[9]) )
+	SEQ_ASSERT( seq_size(seq) == 1 && seq_get(seq, SEQ_PEEK, keys[9]) == &vals[9] )
+SEQ_TEST_END
+
+/* Every element takes as many bytes as its value, against a budget of 100. */
+SEQ_TEST_BEGIN_TYPE(budget, SEQ_CACHE)
+	seq_t list = seq_create(SEQ_LIST);
+
+	removed = 0;
+
+	SEQ_ASSERT( seq_config(list, SEQ_CB_SIZE, val_size) == SEQ_ERR_OPT )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_REMOVE, val_remove) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_SIZE, val_size) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CAPACITY, (seq_size_t)(0), (seq_size_t)(100)) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, keys[40], &vals[40]) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, keys[41], &vals[41]) )
+	SEQ_ASSERT( seq_config(seq, SEQ_CB_SIZE, val_size) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_size(seq) == 2 && removed == 0 )
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, keys[30], &vals[30]) )
+	SEQ_ASSERT( seq_size(seq) == 2 && removed == 1 && evicted == 40 )
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, keys[10], &vals[10]) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, keys[11], &vals[11]) )
+	SEQ_ASSERT( seq_size(seq) == 4 && removed == 1 )
+
+	/* Growing an entry evicts the others, but never the entry itself. */
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[30]) == &vals[30] )
+	SEQ_ASSERT( !seq_set(seq, SEQ_KEY, keys[11], &vals[70]) )
+	SEQ_ASSERT( removed == 4 && seq_size(seq) == 2 )
+	SEQ_ASSERT( seq_get(seq, SEQ_PEEK, keys[11]) == &vals[70] )
+	SEQ_ASSERT( seq_get(seq, SEQ_PEEK, keys[30]) == &vals[30] )
+
+	/* Data too large for the budget can't be cached at all, and takes the old entry with it. */
+	SEQ_ASSERT( seq_add(seq, SEQ_KEYVAL, keys[0], &vals[101]) == SEQ_ERR_DATA )
+	SEQ_ASSERT( removed == 5 && evicted == 101 && seq_size(seq) == 2 )
+	SEQ_ASSERT( seq_set(seq, SEQ_KEY, keys[30], &vals[101]) == SEQ_ERR_DATA )
+	SEQ_ASSERT( removed == 7 && seq_size(seq) == 1 )
+	SEQ_ASSERT( seq_get(seq, SEQ_PEEK, keys[30]) == NULL )
+
+	/* An entry that no longer fits once the budget shrinks is evicted like any other. */
+	SEQ_ASSERT( !seq_config(seq, SEQ_CAPACITY, (seq_size_t)(0), (seq_size_t)(50)) )
+	SEQ_ASSERT( removed == 8 && evicted == 70 && seq_size(seq) == 0 )
+
+	seq_destroy(list);
+SEQ_TEST_END
+
+/* A handful of hot keys, used more often than the hand comes around, outlive a scan of many cold
+ * keys that would flush a FIFO cache of the same size. */
+SEQ_TEST_BEGIN_TYPE(hot, SEQ_CACHE)
+	int misses = 0;
+	int i;
+	int k;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_REMOVE, val_remove) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CAPACITY, (seq_size_t)(CACHE_CAPACITY), (seq_size_t)(0)) )
+
+	for(i = 0; i < CACHE_KEYS - 10; i++) {
+		k = CACHE_KEYS - 1 - (i % 10);
+
+		if(!seq_get(seq, SEQ_KEY, keys[k])) {
+			misses++;
+
+			seq_add(seq, SEQ_KEYVAL, keys[k], &vals[k]);
+		}
+
+		seq_add(seq, SEQ_KEYVAL, keys[i], &vals[i]);
+	}
+
+	SEQ_ASSERT( misses == 10 )
+	SEQ_ASSERT( seq_size(seq) == CACHE_CAPACITY )
+	SEQ_ASSERT( cache_scan(seq) == CACHE_CAPACITY )
+SEQ_TEST_END
+
+/* Random additions, lookups and removals against a model kept up to date by the callback. */
+SEQ_TEST_BEGIN_TYPE(model, SEQ_CACHE)
+	struct _seq_stats_t stats;
+	int ok = 1;
+	int p;
+	int i;
+	int k;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_REMOVE, val_remove) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CAPACITY, (seq_size_t)(CACHE_CAPACITY), (seq_size_t)(0)) )
+
+	memset(present, 0, sizeof(present));
+
+	for(i = 0; i < CACHE_STEPS; i++) {
+		k = cache_rand(i < CACHE_STEPS / 2 ? CACHE_KEYS / 10 : CACHE_KEYS);
+
+		/* The callback clears present[k], so it must be read beforehand. */
+		p = present[k];
+
+		switch(cache_rand(4)) {
+		case 0:
+			if(seq_remove(seq, SEQ_KEY, keys[k]) != (p ? SEQ_ERR_NONE : SEQ_ERR_NODE)) ok = 0;
+
+			break;
+
+		case 1:
+			if(seq_get(seq, SEQ_KEY, keys[k]) != (p ? &vals[k] : NULL)) ok = 0;
+
+			break;
+
+		default:
+			evicted = -1;
+
+			if(seq_add(seq, SEQ_KEYVAL, keys[k], &vals[k])) ok = 0;
+
+			/* The entry just added never makes room for itself. */
+			if(!p && evicted == k) ok = 0;
+
+			present[k] = 1;
+		}
+
+		if(seq_size(seq) > CACHE_CAPACITY) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+
+	for(i = 0, k = 0; i < CACHE_KEYS; i++) {
+		if(seq_get(seq, SEQ_PEEK, keys[i]) != (present[i] ? &vals[i] : NULL)) ok = 0;
+
+		k += present[i];
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_size(seq) == (seq_size_t)(k) )
+	SEQ_ASSERT( cache_scan(seq) == k )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.nodes_alloc - stats.nodes_free == (uint64_t)(k) )
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	keys_init();
+
+	test_keyval("SEQ_CACHE add/get/set/remove");
+	test_clock("SEQ_CACHE CLOCK eviction");
+	test_budget("SEQ_CACHE SEQ_CB_SIZE byte budget");
+	test_hot("SEQ_CACHE hot keys during a scan");
+	test_model("SEQ_CACHE random add/get/remove");
+
+	return test_failures;
+}
@@ -0,0 +1,284 @@
+#include "seq-test.h"
+
+#include <stddef.h>
+
+#define COMPACT_VALUES 5000
+#define COMPACT_STEPS 40000
+
+typedef struct _item_t {
+	int value;
+	struct _seq_list_link_t link;
+} item_t;
+
+static int values[COMPACT_VALUES];
+static int present[COMPACT_VALUES];
+static unsigned long compact_seed = 3;
+
+static seq_opt_t value_cmp(seq_t seq, seq_data_t lhs, seq_data_t rhs) {
+	int a = *(int*)(lhs);
+	int b = *(int*)(rhs);
+
+	return a < b ? SEQ_LESS : (a > b ? SEQ_GREATER : SEQ_EQUAL);
+}
+
+static int compact_rand(int n) {
+	compact_seed = (compact_seed * 1103515245UL) + 12345UL;
+
+	return (int)((compact_seed >> 16) % (unsigned long)(n));
+}
+
+/* Walks the list both ways (by iterator, and by negative index from the back), verifying that the
+ * values come out in the order given; returns the number of values or -1. */
+static int compact_matches(seq_t seq, int* const* order) {
+	seq_iter_t iter = seq_iter_create(seq, SEQ_ERR_NONE);
+	seq_size_t n = 0;
+	int ok = 1;
+
+	if(!iter) return -1;
+
+	while(seq_iterate(iter)) {
+		if(seq_iter_get(iter, SEQ_DATA) != order[n++]) ok = 0;
+	}
+
+	seq_iter_destroy(iter);
+
+	if(n != seq_size(seq)) return -1;
+
+	if(n && seq_get(seq, SEQ_INDEX, (seq_index_t)(-1)) != order[n - 1]) ok = 0;
+
+	if(n > 1 && seq_get(seq, SEQ_INDEX, (seq_index_t)(n) - 2) != order[n - 2]) ok = 0;
+
+	return ok ? (int)(n) : -1;
+}
+
+/* Walks a sorted list, verifying its values are in order. */
+static int compact_sorted(seq_t seq) {
+	seq_iter_t iter = seq_iter_create(seq, SEQ_ERR_NONE);
+	int prev = -1;
+	int ok = 1;
+
+	if(!iter) return 0;
+
+	while(seq_iterate(iter)) {
+		if(*(int*)(seq_iter_get(iter, SEQ_DATA)) < prev) ok = 0;
+
+		prev = *(int*)(seq_iter_get(iter, SEQ_DATA));
+	}
+
+	seq_iter_destroy(iter);
+
+	return ok;
+}
+
+static void values_init(void) {
+	int i;
+
+	for(i = 0; i < COMPACT_VALUES; i++) values[i] = i;
+}
+
+/* The nodes are moved, but the list (and the data it holds) stays exactly as it was. */
+SEQ_TEST_BEGIN(list)
+	struct _seq_stats_t stats;
+	static int* order[COMPACT_VALUES];
+	int n = 0;
+	int i;
+
+	SEQ_ASSERT( !seq_compact(seq) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+
+	for(i = 0; i < COMPACT_VALUES; i++) {
+		seq_add(seq, i % 2 ? SEQ_APPEND : SEQ_PREPEND, &values[i]);
+	}
+
+	for(i = 0; i < COMPACT_VALUES; i += 3) seq_remove(seq, SEQ_DATA, &values[i]);
+
+	for(i = COMPACT_VALUES - 2; i >= 0; i -= 2) {
+		if(i % 3) order[n++] = &values[i];
+	}
+
+	for(i = 1; i < COMPACT_VALUES; i += 2) {
+		if(i % 3) order[n++] = &values[i];
+	}
+
+	SEQ_ASSERT( compact_matches(seq, order) == n )
+	SEQ_ASSERT( !seq_compact(seq) )
+	SEQ_ASSERT( compact_matches(seq, order) == n )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.nodes_alloc == COMPACT_VALUES + (seq_size_t)(n) )
+	SEQ_ASSERT( stats.nodes_alloc - stats.nodes_free == (seq_size_t)(n) )
+
+	/* Nodes in the block and nodes added since mix freely, until the block is freed. */
+	SEQ_ASSERT( !seq_add(seq, SEQ_AFTER, SEQ_INDEX, (seq_index_t)(0), &values[0]) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_REPLACE, SEQ_INDEX, (seq_index_t)(2), &values[3]) )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(1)) == &values[0] )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(2)) == &values[3] )
+
+	while(seq_size(seq) > 1) seq_remove(seq, SEQ_INDEX, (seq_index_t)(seq_size(seq) % 2 ? 0 : -1));
+
+	SEQ_ASSERT( !seq_compact(seq) )
+	SEQ_ASSERT( seq_get(seq, SEQ_POP) != NULL && seq_size(seq) == 0 )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.nodes_alloc == stats.nodes_free )
+SEQ_TEST_END
+
+/* The skip list is woven through the nodes, so its links are moved along with them. */
+SEQ_TEST_BEGIN(sorted)
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_SORTED, value_cmp) )
+
+	for(i = 0; i < COMPACT_VALUES; i++) {
+		seq_add(seq, SEQ_APPEND, &values[(int)(((long)(i) * 2957) % COMPACT_VALUES)]);
+	}
+
+	SEQ_ASSERT( !seq_compact(seq) )
+	SEQ_ASSERT( seq_size(seq) == COMPACT_VALUES && compact_sorted(seq) )
+
+	for(i = 0; i < COMPACT_VALUES; i++) {
+		if(seq_get(seq, SEQ_KEY, &values[i]) != &values[i]) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+
+	for(i = 0; i < COMPACT_VALUES; i += 2) seq_remove(seq, SEQ_DATA, &values[i]);
+
+	for(i = 0; i < COMPACT_VALUES; i += 4) seq_add(seq, SEQ_PREPEND, &values[i]);
+
+	SEQ_ASSERT( !seq_compact(seq) )
+	SEQ_ASSERT( seq_size(seq) == COMPACT_VALUES * 3 / 4 && compact_sorted(seq) )
+
+	for(i = 0; i < COMPACT_VALUES; i++) {
+		if(seq_get(seq, SEQ_KEY, &values[i]) != (i % 4 == 2 ? NULL : &values[i])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+SEQ_TEST_END
+
+/* Random additions and removals against a model, compacting automatically along the way; the
+ * total number of nodes moved stays proportional to the number of calls. */
+SEQ_TEST_BEGIN_TYPE(automatic, SEQ_QUEUE)
+	struct _seq_stats_t stats;
+	seq_iter_t iter = NULL;
+	seq_size_t size = 0;
+	seq_size_t adds = 0;
+	int* d = NULL;
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( seq_config(seq, SEQ_COMPACT, -1) == SEQ_ERR_OPT )
+	SEQ_ASSERT( !seq_config(seq, SEQ_COMPACT, 25) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+
+	for(i = 0; i < COMPACT_STEPS; i++) {
+		int k = compact_rand(COMPACT_VALUES);
+
+		if(compact_rand(3) && !present[k]) {
+			if(seq_add(seq, SEQ_SEND, &values[k])) ok = 0;
+
+			present[k] = 1;
+			size++;
+			adds++;
+		}
+
+		else if(present[k]) {
+			if(seq_remove(seq, SEQ_DATA, &values[k])) ok = 0;
+
+			present[k] = 0;
+			size--;
+		}
+
+		else if(size && (d = (int*)(seq_get(seq, SEQ_RECV)))) {
+			present[*d] = 0;
+			size--;
+		}
+	}
+
+	SEQ_ASSERT( ok && seq_size(seq) == size )
+	SEQ_ASSERT( (iter = seq_iter_create(seq, SEQ_ERR_NONE)) != NULL )
+
+	while(seq_iterate(iter)) {
+		if(!present[*(int*)(seq_iter_get(iter, SEQ_DATA))]) ok = 0;
+	}
+
+	seq_iter_destroy(iter);
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.nodes_alloc - stats.nodes_free == size )
+	SEQ_ASSERT( stats.nodes_alloc > adds && stats.nodes_alloc < adds + (COMPACT_STEPS * 5) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_COMPACT, 0) )
+SEQ_TEST_END
+
+/* Adding to a list while iterating over it is safe, so compacting waits until the iterators (and
+ * their copies) are gone. */
+SEQ_TEST_BEGIN(iterators)
+	struct _seq_stats_t before;
+	struct _seq_stats_t stats;
+	seq_iter_t iter = NULL;
+	seq_iter_t copy = NULL;
+	seq_size_t n = 0;
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_COMPACT, 10) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+
+	for(i = 0; i < 100; i++) seq_add(seq, SEQ_APPEND, &values[i]);
+
+	SEQ_ASSERT( (iter = seq_iter_create(seq, SEQ_ERR_NONE)) != NULL )
+	SEQ_ASSERT( seq_compact(seq) == SEQ_ERR_OPT )
+	SEQ_ASSERT( !seq_stats(seq, &before) )
+
+	/* The range of the iterator is set when it's created, so it won't reach the new elements. */
+	while(seq_iterate(iter)) {
+		if(seq_iter_get(iter, SEQ_DATA) != &values[n++]) ok = 0;
+
+		if(seq_add(seq, SEQ_APPEND, &values[n + 99])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok && n == 100 && seq_size(seq) == 200 )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.nodes_free == before.nodes_free )
+	SEQ_ASSERT( (copy = seq_iter_copy(iter)) != NULL )
+
+	seq_iter_destroy(iter);
+
+	SEQ_ASSERT( seq_compact(seq) == SEQ_ERR_OPT )
+
+	seq_iter_destroy(copy);
+
+	SEQ_ASSERT( !seq_remove(seq, SEQ_INDEX, (seq_index_t)(0)) )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.nodes_free > before.nodes_free + 1 )
+	SEQ_ASSERT( stats.nodes_alloc - stats.nodes_free == seq_size(seq) )
+	SEQ_ASSERT( !seq_compact(seq) )
+	SEQ_ASSERT( compact_sorted(seq) )
+SEQ_TEST_END
+
+/* Intrusive links belong to the objects themselves, which can't be moved. */
+SEQ_TEST_BEGIN(errors)
+	seq_t array = seq_create(SEQ_ARRAY);
+	item_t item = { 0, SEQ_LIST_LINK_INIT };
+
+	SEQ_ASSERT( seq_compact(array) == SEQ_ERR_OPT )
+	SEQ_ASSERT( !seq_config(seq, SEQ_INTRUSIVE, offsetof(item_t, link)) )
+	SEQ_ASSERT( seq_config(seq, SEQ_COMPACT, 25) == SEQ_ERR_OPT )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, &item) )
+	SEQ_ASSERT( seq_compact(seq) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_get(seq, SEQ_POP) == &item )
+
+	seq_destroy(array);
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	values_init();
+
+	test_list("seq_compact() on a SEQ_LIST");
+	test_sorted("seq_compact() on a SEQ_SORTED list");
+	test_automatic("SEQ_COMPACT on a SEQ_QUEUE");
+	test_iterators("SEQ_COMPACT while iterating");
+	test_errors("seq_compact() errors");
+
+	return test_failures;
+}
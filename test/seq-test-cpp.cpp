@@ -0,0 +1,147 @@
+#include "seq-test.h"
+
+#include <sequential.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <string>
+
+static int alive = 0;
+
+struct tracked {
+	explicit tracked(int v): value(v) {
+		alive++;
+	}
+
+	tracked(tracked&& rhs): value(rhs.value) {
+		alive++;
+	}
+
+	tracked(const tracked&) = delete;
+
+	~tracked() {
+		alive--;
+	}
+
+	int value;
+};
+
+SEQ_TEST_BEGIN(list)
+	seq::list<int> l;
+	seq::list<std::unique_ptr<int> > p;
+
+	l.push_back(2);
+	l.push_back(3);
+	l.push_front(1);
+	l.insert(std::find(l.begin(), l.end(), 3), 5);
+
+	SEQ_ASSERT( l.size() == 4 )
+	SEQ_ASSERT( l.front() == 1 && l.back() == 3 )
+	SEQ_ASSERT( std::accumulate(l.begin(), l.end(), 0) == 11 )
+
+	std::reverse(l.begin(), l.end());
+
+	SEQ_ASSERT( l.front() == 3 && *++l.begin() == 5 )
+	SEQ_ASSERT( *l.erase(++l.begin()) == 2 )
+	SEQ_ASSERT( l.size() == 3 )
+
+	p.push_back(std::unique_ptr<int>(new int(7)));
+	p.emplace_front(new int(6));
+
+	SEQ_ASSERT( *p.front() == 6 && *p.back() == 7 )
+
+	seq::list<std::unique_ptr<int> > q(std::move(p));
+
+	SEQ_ASSERT( p.size() == 0 && q.size() == 2 )
+	SEQ_ASSERT( seq_size(q.native()) == 2 )
+
+	{
+		seq::list<tracked> t;
+
+		t.emplace_back(1);
+		t.emplace_back(2);
+		t.pop_front();
+
+		SEQ_ASSERT( alive == 1 )
+	}
+
+	SEQ_ASSERT( alive == 0 )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN(array)
+	seq::array<int> a;
+	seq::array<std::string> s;
+	int i;
+
+	for(i = 0; i < 100; i++) a.push_back((i * 37) % 100);
+
+	std::sort(a.begin(), a.end());
+
+	SEQ_ASSERT( a.size() == 100 )
+	SEQ_ASSERT( std::is_sorted(a.begin(), a.end()) )
+	SEQ_ASSERT( a[0] == 0 && a[99] == 99 && a.at(50) == 50 )
+	SEQ_ASSERT( *static_cast<int*>(seq_get(a.native(), SEQ_INDEX, (seq_index_t)(7))) == 7 )
+
+	a.erase(a.begin());
+	a.insert(a.begin() + 10, -1);
+
+	SEQ_ASSERT( a.front() == 1 && a[10] == -1 && a.size() == 100 )
+
+	s.push_back("banana");
+	s.push_back("cherry");
+	s.insert(s.begin(), "apple");
+	s.emplace_back(3, 'z');
+
+	SEQ_ASSERT( s.size() == 4 )
+	SEQ_ASSERT( s[0] == "apple" && s.back() == "zzz" )
+	SEQ_ASSERT( std::find(s.begin(), s.end(), "cherry") - s.begin() == 2 )
+
+	std::sort(s.begin(), s.end(), std::greater<std::string>());
+
+	SEQ_ASSERT( s.front() == "zzz" && s.back() == "apple" )
+
+	{
+		seq::array<tracked> t;
+
+		t.emplace_back(1);
+		t.emplace_back(2);
+		t.emplace_back(3);
+		t.erase(t.begin() + 1);
+
+		SEQ_ASSERT( alive == 2 && t[1].value == 3 )
+	}
+
+	SEQ_ASSERT( alive == 0 )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN(map)
+	seq::map<int, double> m;
+	seq::map<std::string, std::string> n;
+	int i;
+
+	for(i = 10; i > 0; i--) m[i] = i * 0.5;
+
+	SEQ_ASSERT( m.size() == 10 )
+	SEQ_ASSERT( m.begin()->first == 1 && m.at(4) == 2.0 )
+	SEQ_ASSERT( m.count(11) == 0 )
+	SEQ_ASSERT( !m.insert(seq::pair<int, double>{ 4, 9.0 }).second )
+	SEQ_ASSERT( !m.insert_or_assign(4, 9.0).second && m[4] == 9.0 )
+	SEQ_ASSERT( m.erase(4) == 1 && m.erase(4) == 0 && m.size() == 9 )
+
+	n["b"] = "two";
+	n["a"] = "one";
+	n.insert_or_assign("c", std::string("three"));
+
+	SEQ_ASSERT( n.begin()->second == "one" )
+	SEQ_ASSERT( n.find("c") != n.end() && n.find("d") == n.end() )
+	SEQ_ASSERT( n.lower_bound("bb")->first == "c" )
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	test_list("seq::list");
+	test_array("seq::array");
+	test_map("seq::map");
+
+	return test_failures;
+}
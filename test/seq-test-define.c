@@ -0,0 +1,120 @@
+#include "seq-test.h"
+
+#include <sequential-define.h>
+
+typedef struct _point_t {
+	int x;
+	int y;
+} point_t;
+
+static int destroyed = 0;
+
+#define point_cmp(a, b) ((a)->x - (b)->x)
+#define point_dtor(p) (destroyed++)
+
+SEQ_DEFINE_LIST(ints, int, seq_define_cmp, seq_define_nop)
+SEQ_DEFINE_ARRAY(points, point_t, point_cmp, point_dtor)
+SEQ_DEFINE_MAP(squares, int, long, seq_define_cmp, seq_define_nop)
+
+static int points_sorted(points_t a) {
+	point_t* p;
+
+	for(p = points_first(a); p && points_next(a, p); p = points_next(a, p)) {
+		if(p->x > points_next(a, p)->x) return 0;
+	}
+
+	return 1;
+}
+
+SEQ_TEST_BEGIN(list)
+	ints_t l = ints_create();
+	int v = 3;
+	int* i;
+	int sum = 0;
+
+	SEQ_ASSERT( !ints_append(l, 2) )
+	SEQ_ASSERT( !ints_append(l, 3) )
+	SEQ_ASSERT( !ints_prepend(l, 1) )
+	SEQ_ASSERT( ints_size(l) == 3 )
+	SEQ_ASSERT( *ints_get(l, 0) == 1 )
+	SEQ_ASSERT( *ints_get(l, -1) == 3 )
+	SEQ_ASSERT( ints_get(l, 3) == NULL )
+	SEQ_ASSERT( ints_find(l, &v) == 2 )
+	SEQ_ASSERT( !ints_remove(l, 1) )
+	SEQ_ASSERT( ints_remove(l, 2) == SEQ_ERR_NODE )
+
+	for(i = ints_first(l); i; i = ints_next(l, i)) sum += *i;
+
+	SEQ_ASSERT( sum == 4 )
+
+	ints_destroy(l);
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN(array)
+	points_t a = points_create();
+	point_t p;
+	int i;
+
+	for(i = 0; i < 1000; i++) {
+		p.x = (i * 7919) % 1000;
+		p.y = i;
+
+		points_append(a, p);
+	}
+
+	p.x = -1;
+
+	SEQ_ASSERT( points_size(a) == 1000 )
+	SEQ_ASSERT( !points_insert(a, 0, p) )
+	SEQ_ASSERT( !points_insert(a, 1001, p) )
+	SEQ_ASSERT( points_insert(a, 1003, p) == SEQ_ERR_NODE )
+	SEQ_ASSERT( points_get(a, -1)->x == -1 )
+
+	points_sort(a);
+
+	SEQ_ASSERT( points_sorted(a) )
+	SEQ_ASSERT( points_get(a, 2)->x == 0 )
+	SEQ_ASSERT( points_get(a, -1)->x == 999 )
+	SEQ_ASSERT( points_find(a, points_get(a, 500)) >= 0 )
+	SEQ_ASSERT( !points_remove(a, 0) )
+	SEQ_ASSERT( destroyed == 1 )
+
+	points_destroy(a);
+
+	SEQ_ASSERT( destroyed == 1002 )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN(map)
+	squares_t m = squares_create();
+	squares_entry_t* e;
+	int i;
+	int ordered = 1;
+
+	for(i = 50; i > -50; i--) squares_set(m, i, (long)(i) * i);
+
+	SEQ_ASSERT( squares_size(m) == 100 )
+	SEQ_ASSERT( *squares_get(m, 7) == 49 )
+	SEQ_ASSERT( squares_get(m, 51) == NULL )
+	SEQ_ASSERT( !squares_set(m, 7, 0) )
+	SEQ_ASSERT( *squares_get(m, 7) == 0 )
+	SEQ_ASSERT( squares_size(m) == 100 )
+	SEQ_ASSERT( !squares_remove(m, -49) )
+	SEQ_ASSERT( squares_remove(m, -49) == SEQ_ERR_NODE )
+	SEQ_ASSERT( squares_first(m)->key == -48 )
+
+	for(e = squares_first(m); squares_next(m, e); e = squares_next(m, e)) {
+		if(e->key >= squares_next(m, e)->key) ordered = 0;
+	}
+
+	SEQ_ASSERT( ordered )
+
+	squares_destroy(m);
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	test_list("SEQ_DEFINE_LIST");
+	test_array("SEQ_DEFINE_ARRAY");
+	test_map("SEQ_DEFINE_MAP");
+
+	return test_failures;
+}
@@ -0,0 +1,155 @@
+#include "seq-test.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#define DEQUE_ITEMS 100000
+#define DEQUE_THIEVES 3
+
+static int items[DEQUE_ITEMS];
+static int done = 0;
+static int removed = 0;
+static char dump[4096];
+static seq_size_t dumped = 0;
+
+static void deque_remove(seq_data_t data) {
+	removed++;
+}
+
+typedef struct _deque_thief_t {
+	seq_t seq;
+	int stolen;
+} deque_thief_t;
+
+static void* deque_steal(void* arg) {
+	deque_thief_t* thief = (deque_thief_t*)(arg);
+	int* item;
+
+	for(;;) {
+		if((item = (int*)(seq_get(thief->seq, SEQ_STEAL)))) {
+			(*item)++;
+
+			thief->stolen++;
+		}
+
+		else if(__atomic_load_n(&done, __ATOMIC_ACQUIRE)) break;
+	}
+
+	return NULL;
+}
+
+static seq_size_t deque_write(const void* buf, seq_size_t size, seq_data_t ctx) {
+	if(dumped + size >= sizeof(dump)) return 0;
+
+	memcpy(dump + dumped, buf, size);
+
+	dumped += size;
+
+	return size;
+}
+
+SEQ_TEST_BEGIN_TYPE(owner, SEQ_DEQUE)
+	seq_iter_t iter;
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( seq_get(seq, SEQ_POP) == NULL && seq_get(seq, SEQ_STEAL) == NULL )
+	SEQ_ASSERT( seq_add(seq, SEQ_PREPEND, &items[0]) == SEQ_ERR_OPT )
+
+	/* Enough elements to make the buffer grow a few times. */
+	for(i = 0; i < 100; i++) {
+		if(seq_add(seq, SEQ_PUSH, &items[i])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok && seq_size(seq) == 100 )
+	SEQ_ASSERT( seq_get(seq, SEQ_POP) == &items[99] )
+	SEQ_ASSERT( seq_get(seq, SEQ_STEAL) == &items[0] )
+	SEQ_ASSERT( seq_get(seq, SEQ_STEAL) == &items[1] )
+	SEQ_ASSERT( seq_get(seq, SEQ_POP) == &items[98] )
+	SEQ_ASSERT( seq_size(seq) == 96 )
+	SEQ_ASSERT( (iter = seq_iter_create(seq, SEQ_ERR_NONE)) != NULL )
+
+	for(i = 2; seq_iterate(iter); i++) {
+		if(seq_iter_get(iter, SEQ_DATA) != &items[i]) ok = 0;
+	}
+
+	seq_iter_destroy(iter);
+
+	SEQ_ASSERT( ok && i == 98 )
+	SEQ_ASSERT( seq_set(seq, SEQ_POP, &items[0]) == SEQ_ERR_OPT )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_REMOVE, deque_remove) )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_POP) && !seq_remove(seq, SEQ_STEAL) )
+	SEQ_ASSERT( removed == 2 )
+
+	while(seq_get(seq, SEQ_STEAL));
+
+	SEQ_ASSERT( seq_size(seq) == 0 )
+	SEQ_ASSERT( seq_remove(seq, SEQ_POP) == SEQ_ERR_NODE )
+	SEQ_ASSERT( !seq_add(seq, SEQ_PUSH, &items[0]) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, &items[1]) )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(steal, SEQ_DEQUE)
+	pthread_t threads[DEQUE_THIEVES];
+	deque_thief_t thieves[DEQUE_THIEVES];
+	int total = 0;
+	int popped = 0;
+	int once = 1;
+	int* item;
+	int i;
+
+	for(i = 0; i < DEQUE_ITEMS; i++) items[i] = 0;
+
+	/* The thieves record their calls alongside the owner's, without any lock to share. */
+	SEQ_ASSERT( !seq_config(seq, SEQ_TRACE, 1) )
+
+	for(i = 0; i < DEQUE_THIEVES; i++) {
+		thieves[i].seq = seq;
+		thieves[i].stolen = 0;
+
+		pthread_create(&threads[i], NULL, deque_steal, &thieves[i]);
+	}
+
+	/* The owner keeps popping every other element, racing the thieves for the last one. */
+	for(i = 0; i < DEQUE_ITEMS; i++) {
+		seq_add(seq, SEQ_PUSH, &items[i]);
+
+		if(i % 2 && (item = (int*)(seq_get(seq, SEQ_POP)))) {
+			(*item)++;
+
+			popped++;
+		}
+	}
+
+	while((item = (int*)(seq_get(seq, SEQ_POP)))) {
+		(*item)++;
+
+		popped++;
+	}
+
+	__atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+
+	for(i = 0; i < DEQUE_THIEVES; i++) {
+		pthread_join(threads[i], NULL);
+
+		total += thieves[i].stolen;
+	}
+
+	for(i = 0; i < DEQUE_ITEMS; i++) {
+		if(items[i] != 1) once = 0;
+	}
+
+	SEQ_ASSERT( total + popped == DEQUE_ITEMS )
+	SEQ_ASSERT( once )
+	SEQ_ASSERT( seq_size(seq) == 0 )
+	SEQ_ASSERT( !seq_trace_dump(seq, deque_write, NULL) )
+	SEQ_ASSERT( strstr(dump, "PUSH     count=100000 ") != NULL )
+	SEQ_ASSERT( strstr(dump, "STEAL") != NULL )
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	test_owner("SEQ_DEQUE owner/thief ends");
+	test_steal("SEQ_DEQUE work-stealing");
+
+	return test_failures;
+}
@@ -0,0 +1,89 @@
+#if !defined(_WIN32)
+#define _GNU_SOURCE
+#endif
+
+#include "seq-test.h"
+
+#include <poll.h>
+#include <unistd.h>
+
+static int items[8];
+
+static int event_readable(int fd) {
+	struct pollfd p;
+
+	p.fd = fd;
+	p.events = POLLIN;
+	p.revents = 0;
+
+	return poll(&p, 1, 0) == 1 && (p.revents & POLLIN);
+}
+
+/* Reads whatever is pending on the descriptor, returning the number of notifications. */
+static int event_drain(int fd) {
+	uint64_t count = 0;
+	uint64_t value;
+	int n = 0;
+
+	while(read(fd, &value, sizeof(value)) == sizeof(value)) {
+		count += value;
+
+		n++;
+	}
+
+#if defined(__linux__)
+	return (int)(count);
+#else
+	return n;
+#endif
+}
+
+SEQ_TEST_BEGIN_TYPE(edge, SEQ_QUEUE)
+	int fd = seq_fd(seq);
+
+	SEQ_ASSERT( fd >= 0 )
+	SEQ_ASSERT( seq_fd(seq) == fd )
+	SEQ_ASSERT( !event_readable(fd) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_SEND, &items[0]) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_SEND, &items[1]) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_SEND, &items[2]) )
+	SEQ_ASSERT( event_readable(fd) )
+	SEQ_ASSERT( event_drain(fd) == 1 )
+	SEQ_ASSERT( !event_readable(fd) )
+	SEQ_ASSERT( seq_get(seq, SEQ_RECV) == &items[0] )
+	SEQ_ASSERT( !seq_add(seq, SEQ_SEND, &items[3]) )
+	SEQ_ASSERT( !event_readable(fd) )
+
+	while(seq_get(seq, SEQ_RECV));
+
+	SEQ_ASSERT( !seq_add(seq, SEQ_SEND, &items[4]) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_SEND, &items[5]) )
+	SEQ_ASSERT( event_drain(fd) == 1 )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_RECV) && !seq_remove(seq, SEQ_RECV) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_SEND, &items[6]) )
+	SEQ_ASSERT( event_drain(fd) == 1 )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(late, SEQ_QUEUE)
+	int fd;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_BLOCKING, 10, 0) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_SEND, &items[0]) )
+
+	fd = seq_fd(seq);
+
+	SEQ_ASSERT( fd >= 0 && event_readable(fd) )
+	SEQ_ASSERT( event_drain(fd) == 1 )
+	SEQ_ASSERT( seq_get(seq, SEQ_RECV) == &items[0] )
+	SEQ_ASSERT( seq_get(seq, SEQ_RECV) == NULL )
+	SEQ_ASSERT( !seq_add(seq, SEQ_SEND, &items[1]) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_SEND, &items[2]) )
+	SEQ_ASSERT( event_drain(fd) == 1 )
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	test_edge("seq_fd edge-coalescing");
+	test_late("seq_fd with SEQ_BLOCKING");
+
+	return test_failures;
+}
@@ -0,0 +1,126 @@
+#include "seq-test.h"
+
+#include <stddef.h>
+
+typedef struct _job_t {
+	int priority;
+	seq_size_t pos;
+} job_t;
+
+static job_t jobs[1000];
+static int removed = 0;
+
+static seq_opt_t job_cmp(seq_t seq, seq_data_t lhs, seq_data_t rhs) {
+	int a = ((job_t*)(lhs))->priority;
+	int b = ((job_t*)(rhs))->priority;
+
+	return a < b ? SEQ_LESS : (a > b ? SEQ_GREATER : SEQ_EQUAL);
+}
+
+static void job_remove(seq_data_t data) {
+	removed++;
+}
+
+static void jobs_init(void) {
+	int i;
+
+	for(i = 0; i < 1000; i++) jobs[i].priority = (i * 7919) % 1000;
+}
+
+/* Pops every job, verifying they come out in order; returns the number popped. */
+static int jobs_drain(seq_t seq) {
+	job_t* prev = NULL;
+	job_t* job;
+	int n = 0;
+
+	while((job = (job_t*)(seq_get(seq, SEQ_POP)))) {
+		if(prev && prev->priority > job->priority) return -1;
+
+		prev = job;
+
+		n++;
+	}
+
+	return n;
+}
+
+SEQ_TEST_BEGIN_TYPE(push_pop, SEQ_HEAP)
+	struct _seq_stats_t stats;
+	int i;
+
+	SEQ_ASSERT( seq_add(seq, SEQ_PUSH, &jobs[0]) == SEQ_ERR_CB )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_CMP, job_cmp) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+	SEQ_ASSERT( seq_get(seq, SEQ_PEEK) == NULL )
+
+	for(i = 0; i < 1000; i++) seq_add(seq, SEQ_PUSH, &jobs[i]);
+
+	SEQ_ASSERT( seq_size(seq) == 1000 )
+	SEQ_ASSERT( ((job_t*)(seq_get(seq, SEQ_PEEK)))->priority == 0 )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(0)) == seq_get(seq, SEQ_PEEK) )
+	SEQ_ASSERT( seq_add(seq, SEQ_PREPEND, &jobs[0]) == SEQ_ERR_OPT )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_REMOVE, job_remove) )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_POP) )
+	SEQ_ASSERT( removed == 1 )
+	SEQ_ASSERT( ((job_t*)(seq_get(seq, SEQ_PEEK)))->priority == 1 )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_DATA, &jobs[500]) )
+	SEQ_ASSERT( seq_remove(seq, SEQ_DATA, &jobs[500]) == SEQ_ERR_NODE )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.cb[SEQ_CB_CMP & 0xFFFF] < 1000 * 16 )
+	SEQ_ASSERT( jobs_drain(seq) == 998 )
+	SEQ_ASSERT( removed == 2 )
+	SEQ_ASSERT( seq_remove(seq, SEQ_POP) == SEQ_ERR_NODE )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(heapify, SEQ_ARRAY)
+	seq_t heap = NULL;
+	int i;
+
+	for(i = 0; i < 1000; i++) seq_add(seq, SEQ_APPEND, &jobs[i]);
+
+	SEQ_ASSERT( (heap = seq_create_from(SEQ_HEAP, seq)) != NULL )
+	SEQ_ASSERT( seq_size(heap) == 1000 )
+	SEQ_ASSERT( seq_get(heap, SEQ_PEEK) == NULL )
+	SEQ_ASSERT( !seq_config(heap, SEQ_CB_CMP, job_cmp) )
+	SEQ_ASSERT( ((job_t*)(seq_get(heap, SEQ_PEEK)))->priority == 0 )
+	SEQ_ASSERT( !seq_add(heap, SEQ_APPEND, &jobs[0]) )
+	SEQ_ASSERT( jobs_drain(heap) == 1001 )
+
+	seq_destroy(heap);
+
+	SEQ_ASSERT( seq_size(seq) == 1000 && seq_get(seq, SEQ_INDEX, (seq_index_t)(0)) == &jobs[0] )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(decrease_key, SEQ_HEAP)
+	int i;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_CMP, job_cmp) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_INTRUSIVE, offsetof(job_t, pos)) )
+
+	for(i = 0; i < 1000; i++) seq_add(seq, SEQ_PUSH, &jobs[i]);
+
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(jobs[123].pos)) == &jobs[123] )
+
+	jobs[123].priority = -1;
+
+	SEQ_ASSERT( !seq_set(seq, SEQ_DATA, &jobs[123], &jobs[123]) )
+	SEQ_ASSERT( seq_get(seq, SEQ_PEEK) == &jobs[123] && jobs[123].pos == 0 )
+
+	jobs[123].priority = 5000;
+
+	SEQ_ASSERT( !seq_set(seq, SEQ_DATA, &jobs[123], &jobs[123]) )
+	SEQ_ASSERT( seq_get(seq, SEQ_PEEK) != &jobs[123] )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_DATA, &jobs[123]) )
+	SEQ_ASSERT( seq_get(seq, SEQ_DATA, &jobs[123]) == NULL )
+	SEQ_ASSERT( jobs_drain(seq) == 999 )
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	jobs_init();
+
+	test_push_pop("SEQ_HEAP push/pop");
+	test_heapify("seq_create_from(SEQ_HEAP)");
+	test_decrease_key("SEQ_HEAP intrusive decrease-key");
+
+	return test_failures;
+}
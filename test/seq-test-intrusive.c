@@ -0,0 +1,130 @@
+#include "seq-test.h"
+
+#include <string.h>
+
+typedef struct _obj_t {
+	int value;
+	struct _seq_list_link_t link;
+} obj_t;
+
+static obj_t objs[4];
+static int removed = 0;
+
+static void obj_remove(seq_data_t data) {
+	removed++;
+}
+
+static int obj_value(seq_t seq, seq_index_t index) {
+	obj_t* obj = (obj_t*)(seq_get(seq, SEQ_INDEX, index));
+
+	return obj ? obj->value : -1;
+}
+
+static void obj_init(void) {
+	int i;
+
+	memset(objs, 0, sizeof(objs));
+
+	for(i = 0; i < 4; i++) objs[i].value = i;
+
+	removed = 0;
+}
+
+SEQ_TEST_BEGIN(add_remove)
+	obj_init();
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_INTRUSIVE, offsetof(obj_t, link)) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_REMOVE, obj_remove) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, &objs[1]) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, &objs[3]) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_PREPEND, &objs[0]) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_BEFORE, SEQ_INDEX, 2, &objs[2]) )
+	SEQ_ASSERT( seq_size(seq) == 4 )
+	SEQ_ASSERT( obj_value(seq, 0) == 0 )
+	SEQ_ASSERT( obj_value(seq, 1) == 1 )
+	SEQ_ASSERT( obj_value(seq, 2) == 2 )
+	SEQ_ASSERT( obj_value(seq, -1) == 3 )
+	SEQ_ASSERT( objs[2].link.seq == seq )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_DATA, &objs[2]) )
+	SEQ_ASSERT( objs[2].link.seq == NULL )
+	SEQ_ASSERT( seq_remove(seq, SEQ_DATA, &objs[2]) == SEQ_ERR_NODE )
+	SEQ_ASSERT( removed == 1 )
+	SEQ_ASSERT( seq_size(seq) == 3 )
+	SEQ_ASSERT( obj_value(seq, 2) == 3 )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_INDEX, 0) )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_INDEX, 0) )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_INDEX, 0) )
+	SEQ_ASSERT( seq_size(seq) == 0 )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, &objs[0]) )
+	SEQ_ASSERT( obj_value(seq, 0) == 0 )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN(move)
+	seq_t other = seq_create(SEQ_LIST);
+
+	obj_init();
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_INTRUSIVE, offsetof(obj_t, link)) )
+	SEQ_ASSERT( !seq_config(other, SEQ_INTRUSIVE, offsetof(obj_t, link)) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_REMOVE, obj_remove) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, &objs[0]) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, &objs[1]) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, &objs[2]) )
+	SEQ_ASSERT( !seq_add(other, SEQ_APPEND, &objs[1]) )
+	SEQ_ASSERT( removed == 0 )
+	SEQ_ASSERT( seq_size(seq) == 2 )
+	SEQ_ASSERT( seq_size(other) == 1 )
+	SEQ_ASSERT( obj_value(seq, 1) == 2 )
+	SEQ_ASSERT( objs[1].link.seq == other )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, &objs[0]) )
+	SEQ_ASSERT( seq_size(seq) == 2 )
+	SEQ_ASSERT( obj_value(seq, 0) == 2 )
+	SEQ_ASSERT( obj_value(seq, 1) == 0 )
+	SEQ_ASSERT( !seq_set(seq, SEQ_INDEX, 0, &objs[3]) )
+	SEQ_ASSERT( removed == 1 )
+	SEQ_ASSERT( obj_value(seq, 0) == 3 )
+	SEQ_ASSERT( seq_add(seq, SEQ_APPEND, NULL) == SEQ_ERR_DATA )
+
+	seq_destroy(other);
+SEQ_TEST_END
+
+/* Objects that don't come from obj_init() start out unlinked, as the links must. */
+SEQ_TEST_BEGIN(init)
+	obj_t a = { 10, SEQ_LIST_LINK_INIT };
+	obj_t b = { 11, SEQ_LIST_LINK_INIT };
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_INTRUSIVE, offsetof(obj_t, link)) )
+	SEQ_ASSERT( a.link.seq == NULL && a.link.next == NULL )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, &a) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_PREPEND, &b) )
+	SEQ_ASSERT( a.link.seq == seq && b.link.seq == seq )
+	SEQ_ASSERT( obj_value(seq, 0) == 11 && obj_value(seq, 1) == 10 )
+	SEQ_ASSERT( seq_get(seq, SEQ_POP) == &b && seq_get(seq, SEQ_POP) == &a )
+	SEQ_ASSERT( seq_size(seq) == 0 && a.link.seq == NULL && b.link.seq == NULL )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN(data)
+	const char* foo = "foo";
+	const char* bar = "bar";
+
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, foo) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, bar) )
+	SEQ_ASSERT( seq_config(seq, SEQ_INTRUSIVE, 0) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_get(seq, SEQ_DATA, bar) == bar )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_DATA, foo) )
+	SEQ_ASSERT( seq_remove(seq, SEQ_DATA, foo) == SEQ_ERR_NODE )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, 0) == bar )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_INDEX, 0) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, foo) )
+	SEQ_ASSERT( seq_size(seq) == 1 )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(-1)) == foo )
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	test_add_remove("SEQ_INTRUSIVE / SEQ_DATA");
+	test_move("SEQ_INTRUSIVE (MOVE / REPLACE)");
+	test_init("SEQ_LIST_LINK_INIT");
+	test_data("SEQ_DATA");
+
+	return test_failures;
+}
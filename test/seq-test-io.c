@@ -0,0 +1,177 @@
+#include "seq-test.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+typedef struct _buf_t {
+	char* data;
+	seq_size_t size;
+	seq_size_t pos;
+	seq_size_t chunk;
+	seq_size_t writes;
+} buf_t;
+
+static seq_size_t buf_write(const void* data, seq_size_t size, seq_data_t ctx) {
+	buf_t* buf = (buf_t*)(ctx);
+
+	buf->data = (char*)(realloc(buf->data, buf->size + size));
+
+	memcpy(buf->data + buf->size, data, size);
+
+	buf->size += size;
+	buf->writes++;
+
+	return size;
+}
+
+/* Deliberately hands out tiny, odd-sized chunks to exercise record reassembly. */
+static seq_size_t buf_read(void* data, seq_size_t size, seq_data_t ctx) {
+	buf_t* buf = (buf_t*)(ctx);
+	seq_size_t n = buf->size - buf->pos;
+
+	if(n > buf->chunk) n = buf->chunk;
+
+	if(n > size) n = size;
+
+	memcpy(data, buf->data + buf->pos, n);
+
+	buf->pos += n;
+
+	return n;
+}
+
+static seq_size_t str_serialize(seq_data_t data, void* buf, seq_size_t size) {
+	seq_size_t len = strlen((const char*)(data));
+
+	if(len <= size) memcpy(buf, data, len);
+
+	return len;
+}
+
+static seq_data_t str_deserialize(const void* buf, seq_size_t size) {
+	char* str = (char*)(malloc(size + 1));
+
+	memcpy(str, buf, size);
+
+	str[size] = 0;
+
+	return str;
+}
+
+static void str_config(seq_t seq) {
+	seq_config(seq, SEQ_CB_SERIALIZE, str_serialize);
+	seq_config(seq, SEQ_CB_DESERIALIZE, str_deserialize);
+	seq_config(seq, SEQ_CB_REMOVE, free);
+}
+
+static char* str_create(seq_size_t size, char c) {
+	char* str = (char*)(malloc(size + 1));
+
+	memset(str, c, size);
+
+	str[size] = 0;
+
+	return str;
+}
+
+SEQ_TEST_BEGIN(iterate)
+	seq_iter_t iter = NULL;
+	seq_size_t i = 0;
+	const char* expect[] = { "b", "d" };
+
+	seq_add(seq, SEQ_APPEND, "a");
+	seq_add(seq, SEQ_APPEND, "b");
+	seq_add(seq, SEQ_APPEND, "c");
+	seq_add(seq, SEQ_APPEND, "d");
+	seq_add(seq, SEQ_APPEND, "e");
+
+	SEQ_ASSERT( (iter = seq_iter_create(seq, SEQ_RANGE, (seq_index_t)(1), (seq_index_t)(-2), SEQ_INC, (seq_size_t)(2), SEQ_ERR_NONE)) )
+
+	while(seq_iterate(iter)) {
+		SEQ_ASSERT( i < 2 && !strcmp(seq_iter_get(iter, SEQ_DATA), expect[i]) )
+
+		i++;
+	}
+
+	SEQ_ASSERT( i == 2 )
+	SEQ_ASSERT( !seq_iterate(iter) )
+	SEQ_ASSERT( !seq_iter_get(iter, SEQ_DATA) )
+
+	seq_iter_destroy(iter);
+
+	SEQ_ASSERT( !seq_iter_create(seq, SEQ_KEY, SEQ_ERR_NONE) )
+	SEQ_ASSERT( (iter = seq_iter_create(seq, SEQ_ERR_NONE)) )
+	SEQ_ASSERT( seq_iterate(iter) == SEQ_ACTIVE )
+	SEQ_ASSERT( !seq_iter_set(iter, SEQ_DATA, "A") )
+	SEQ_ASSERT( !strcmp(seq_get(seq, SEQ_INDEX, (seq_index_t)(0)), "A") )
+
+	seq_iter_destroy(iter);
+SEQ_TEST_END
+
+static void io_roundtrip(seq_opt_t type, int checksum) {
+	seq_t seq = seq_create(type);
+	seq_t copy = seq_create(type);
+	buf_t buf;
+	seq_size_t i;
+	int same = 1;
+
+	memset(&buf, 0, sizeof(buf));
+
+	str_config(seq);
+	str_config(copy);
+
+	seq_config(seq, SEQ_CHECKSUM, checksum);
+
+	for(i = 0; i < 5000; i++) seq_add(seq, SEQ_APPEND, str_create(i % 97, (char)('a' + (i % 26))));
+
+	seq_add(seq, SEQ_APPEND, str_create(200000, 'z'));
+
+	SEQ_ASSERT( !seq_write(seq, buf_write, &buf) )
+	SEQ_ASSERT( buf.writes < 10 )
+
+	buf.chunk = 4093;
+
+	SEQ_ASSERT( !seq_read(copy, buf_read, &buf) )
+	SEQ_ASSERT( seq_size(copy) == seq_size(seq) )
+
+	for(i = 0; i < seq_size(seq); i++) same &= !strcmp(
+		seq_get(seq, SEQ_INDEX, (seq_index_t)(i)),
+		seq_get(copy, SEQ_INDEX, (seq_index_t)(i))
+	);
+
+	SEQ_ASSERT( same )
+
+	/* Flip a single payload byte; only the checksum can catch it. */
+	buf.data[buf.size / 2] ^= 0x01;
+	buf.pos = 0;
+
+	if(checksum) {
+		SEQ_ASSERT( seq_read(copy, buf_read, &buf) == SEQ_ERR_DATA )
+	}
+
+	/* Truncated streams are always detected. */
+	buf.size -= 10;
+	buf.pos = 0;
+
+	SEQ_ASSERT( seq_read(copy, buf_read, &buf) != SEQ_ERR_NONE )
+
+	free(buf.data);
+
+	seq_destroy(seq);
+	seq_destroy(copy);
+}
+
+SEQ_TEST_BEGIN(roundtrip)
+	SEQ_ASSERT( seq_write(seq, buf_write, NULL) == SEQ_ERR_CB )
+
+	io_roundtrip(SEQ_LIST, 0);
+	io_roundtrip(SEQ_LIST, 1);
+	io_roundtrip(SEQ_ARRAY, 1);
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	test_iterate("seq_iter_create / seq_iterate");
+	test_roundtrip("seq_write / seq_read");
+
+	return test_failures;
+}
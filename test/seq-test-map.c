@@ -0,0 +1,473 @@
+#include "seq-test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MAP_KEYS 5000
+#define MAP_STEPS 40000
+
+static char keys[MAP_KEYS][8];
+static int vals[MAP_KEYS];
+static int present[MAP_KEYS];
+static int removed = 0;
+static unsigned long map_seed = 1;
+
+static void val_remove(seq_data_t data) {
+	removed++;
+}
+
+/* Orders integer keys in reverse, to make sure the callback is what's being used. */
+static seq_opt_t val_cmp(seq_t seq, seq_data_t lhs, seq_data_t rhs) {
+	int a = *(int*)(lhs);
+	int b = *(int*)(rhs);
+
+	return a > b ? SEQ_LESS : (a < b ? SEQ_GREATER : SEQ_EQUAL);
+}
+
+static void keys_init(void) {
+	int i;
+
+	for(i = 0; i < MAP_KEYS; i++) {
+		sprintf(keys[i], "k%05d", i);
+
+		vals[i] = i;
+	}
+}
+
+static int map_rand(int n) {
+	map_seed = (map_seed * 1103515245UL) + 12345UL;
+
+	return (int)((map_seed >> 16) % (unsigned long)(n));
+}
+
+/* Walks the whole map, verifying the keys come out in order and match the model (if given). */
+static int map_matches(seq_t seq, const int* model) {
+	seq_iter_t iter = seq_iter_create(seq, SEQ_ERR_NONE);
+	const char* prev = NULL;
+	const char* key = NULL;
+	seq_size_t n = 0;
+	int ok = 1;
+
+	if(!iter) return 0;
+
+	while(seq_iterate(iter)) {
+		key = (const char*)(seq_iter_get(iter, SEQ_KEY));
+
+		if(prev && strcmp(prev, key) >= 0) ok = 0;
+
+		if(*(int*)(seq_iter_get(iter, SEQ_DATA)) != atoi(key + 1)) ok = 0;
+
+		if(model && !model[atoi(key + 1)]) ok = 0;
+
+		prev = key;
+
+		n++;
+	}
+
+	seq_iter_destroy(iter);
+
+	return ok && n == seq_size(seq);
+}
+
+/* Counts the keys starting with @prefix, or returns -1 if any other key shows up. */
+static int map_prefix(seq_t seq, const char* prefix) {
+	seq_iter_t iter = seq_iter_create(seq, SEQ_KEY_PREFIX, prefix, SEQ_ERR_NONE);
+	int n = 0;
+
+	if(!iter) return -1;
+
+	while(seq_iterate(iter)) {
+		if(strncmp((const char*)(seq_iter_get(iter, SEQ_KEY)), prefix, strlen(prefix))) n = -1;
+
+		else if(n >= 0) n++;
+	}
+
+	seq_iter_destroy(iter);
+
+	return n;
+}
+
+/* Visits the keys[] from @lo to @hi (either -1 for no bound) with the given SEQ_ITER @flags,
+ * checking that they're exactly the present[] ones, in order; returns how many or -1. */
+static int map_range(seq_t seq, int lo, int hi, seq_opt_t flags, seq_opt_t more) {
+	seq_iter_t iter = NULL;
+	int reverse = flags == SEQ_REVERSE || more == SEQ_REVERSE;
+	int exclude_lo = flags == SEQ_EXCLUDE_LO || more == SEQ_EXCLUDE_LO;
+	int exclude_hi = flags == SEQ_EXCLUDE_HI || more == SEQ_EXCLUDE_HI;
+	int i = reverse ? MAP_KEYS - 1 : 0;
+	int n = 0;
+
+	/* The first SEQ_ERR_NONE ends the options, so it mustn't come before the other flag. */
+	if(!flags) {
+		flags = more;
+		more = SEQ_ERR_NONE;
+	}
+
+	iter = seq_iter_create(
+		seq,
+		SEQ_RANGE,
+		lo < 0 ? NULL : keys[lo],
+		hi < 0 ? NULL : keys[hi],
+		flags,
+		more,
+		SEQ_ERR_NONE
+	);
+
+	if(!iter) return -1;
+
+	for(; i >= 0 && i < MAP_KEYS; i += reverse ? -1 : 1) {
+		if(!present[i] || (lo >= 0 && (i < lo || (i == lo && exclude_lo)))) continue;
+
+		if(hi >= 0 && (i > hi || (i == hi && exclude_hi))) continue;
+
+		if(!seq_iterate(iter) || seq_iter_get(iter, SEQ_KEY) != keys[i]) n = -1;
+
+		else if(n >= 0) n++;
+	}
+
+	if(seq_iterate(iter)) n = -1;
+
+	seq_iter_destroy(iter);
+
+	return n;
+}
+
+SEQ_TEST_BEGIN_TYPE(keyval, SEQ_MAP)
+	struct _seq_stats_t stats;
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_REMOVE, val_remove) )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[0]) == NULL )
+	SEQ_ASSERT( seq_remove(seq, SEQ_KEY, keys[0]) == SEQ_ERR_NODE )
+	SEQ_ASSERT( seq_add(seq, SEQ_APPEND, &vals[0]) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_add(seq, SEQ_KEYVAL, NULL, &vals[0]) == SEQ_ERR_DATA )
+
+	/* A stride coprime with the key count shuffles the order of insertion. */
+	for(i = 0; i < MAP_KEYS; i++) {
+		int k = (int)(((long)(i) * 2957) % MAP_KEYS);
+
+		if(seq_add(seq, SEQ_KEYVAL, keys[k], &vals[k])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_size(seq) == MAP_KEYS )
+	SEQ_ASSERT( map_matches(seq, NULL) )
+
+	for(i = 0; i < MAP_KEYS; i++) {
+		if(seq_get(seq, SEQ_KEY, keys[i]) != &vals[i]) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, "k99999") == NULL )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, "a") == NULL )
+	SEQ_ASSERT( map_prefix(seq, "k0004") == 10 )
+	SEQ_ASSERT( map_prefix(seq, "k04999") == 1 && map_prefix(seq, "k05") == 0 )
+	SEQ_ASSERT( map_prefix(seq, "k04") == 1000 )
+	SEQ_ASSERT( map_prefix(seq, "k") == MAP_KEYS )
+	SEQ_ASSERT( map_prefix(seq, "") == MAP_KEYS )
+	SEQ_ASSERT( map_prefix(seq, "a") == 0 && map_prefix(seq, "z") == 0 )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.hops < (seq_size_t)(MAP_KEYS) * 2 * 4 )
+
+	/* Adding an existing key replaces its data, and a separate but equal key buffer works too. */
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, "k00042", &vals[7]) )
+	SEQ_ASSERT( removed == 1 && seq_size(seq) == MAP_KEYS )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[42]) == &vals[7] )
+	SEQ_ASSERT( !seq_set(seq, SEQ_KEY, keys[42], &vals[42]) )
+	SEQ_ASSERT( removed == 2 && seq_get(seq, SEQ_KEY, "k00042") == &vals[42] )
+	SEQ_ASSERT( seq_set(seq, SEQ_KEY, "nope", &vals[0]) == SEQ_ERR_NODE )
+
+	for(i = 0; i < MAP_KEYS; i += 2) {
+		if(seq_remove(seq, SEQ_KEY, keys[i])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( removed == 2 + (MAP_KEYS / 2) )
+	SEQ_ASSERT( seq_size(seq) == MAP_KEYS / 2 )
+	SEQ_ASSERT( seq_remove(seq, SEQ_KEY, keys[0]) == SEQ_ERR_NODE )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[1]) == &vals[1] )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[2]) == NULL )
+	SEQ_ASSERT( map_matches(seq, NULL) )
+
+	for(i = 1; i < MAP_KEYS; i += 2) {
+		if(seq_remove(seq, SEQ_KEY, keys[i])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_size(seq) == 0 )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.nodes_alloc > 0 && stats.nodes_alloc == stats.nodes_free )
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, keys[3], &vals[3]) )
+	SEQ_ASSERT( map_matches(seq, NULL) )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(cmp, SEQ_BTREE)
+	seq_iter_t iter = NULL;
+	int prev = MAP_KEYS;
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( seq_type(seq) == SEQ_BTREE )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_CMP, val_cmp) )
+	SEQ_ASSERT( seq_config(seq, SEQ_SORTED, val_cmp) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_config(seq, SEQ_BLOOM, (seq_size_t)(100)) == SEQ_ERR_OPT )
+
+	for(i = 0; i < 1000; i++) seq_add(seq, SEQ_KEYVAL, &vals[(i * 7) % 1000], keys[i]);
+
+	SEQ_ASSERT( seq_config(seq, SEQ_CB_CMP, val_cmp) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_iter_create(seq, SEQ_KEY_PREFIX, "k", SEQ_ERR_NONE) == NULL )
+	SEQ_ASSERT( seq_size(seq) == 1000 )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, &vals[7]) == keys[1] )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, &vals[500]) == keys[500] )
+	SEQ_ASSERT( (iter = seq_iter_create(seq, SEQ_ERR_NONE)) != NULL )
+
+	while(seq_iterate(iter)) {
+		if(*(int*)(seq_iter_get(iter, SEQ_KEY)) >= prev) ok = 0;
+
+		prev = *(int*)(seq_iter_get(iter, SEQ_KEY));
+
+		if(prev == 10) seq_iter_set(iter, SEQ_DATA, keys[11]);
+	}
+
+	seq_iter_destroy(iter);
+
+	SEQ_ASSERT( ok && prev == 0 )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, &vals[10]) == keys[11] )
+
+	/* The bounds of a range follow the callback's order too. */
+	iter = seq_iter_create(seq, SEQ_RANGE, &vals[20], &vals[10], SEQ_ERR_NONE);
+
+	SEQ_ASSERT( iter != NULL )
+
+	for(prev = 21; seq_iterate(iter); prev--) {
+		if(*(int*)(seq_iter_get(iter, SEQ_KEY)) != prev - 1) ok = 0;
+	}
+
+	seq_iter_destroy(iter);
+
+	SEQ_ASSERT( ok && prev == 10 )
+SEQ_TEST_END
+
+/* Keys are copied from a single buffer, which is overwritten between calls. */
+SEQ_TEST_BEGIN_TYPE(intern, SEQ_MAP)
+	seq_iter_t iter = NULL;
+	const char* key = NULL;
+	char buf[8];
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_INTERN, 1) )
+	SEQ_ASSERT( seq_config(seq, SEQ_CB_CMP, val_cmp) == SEQ_ERR_OPT )
+
+	for(i = 0; i < MAP_KEYS; i++) {
+		sprintf(buf, "k%05d", MAP_KEYS - i - 1);
+
+		if(seq_add(seq, SEQ_KEYVAL, buf, &vals[MAP_KEYS - i - 1])) ok = 0;
+	}
+
+	strcpy(buf, "k00042");
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_config(seq, SEQ_INTERN, 0) == SEQ_ERR_OPT )
+	SEQ_ASSERT( map_matches(seq, NULL) && map_prefix(seq, "k001") == 100 )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[42]) == &vals[42] )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, "k10000") == NULL )
+	SEQ_ASSERT( (iter = seq_iter_create(seq, SEQ_KEY_PREFIX, buf, SEQ_ERR_NONE)) != NULL )
+	SEQ_ASSERT( seq_iterate(iter) && (key = (const char*)(seq_iter_get(iter, SEQ_KEY))) != buf )
+	SEQ_ASSERT( !strcmp(key, "k00042") && key != keys[42] )
+
+	seq_iter_destroy(iter);
+
+	/* Adding the key again, or removing and re-adding it, reuses the same copy. */
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, keys[42], &vals[0]) )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_KEY, buf) && seq_get(seq, SEQ_KEY, keys[42]) == NULL )
+	SEQ_ASSERT( seq_remove(seq, SEQ_KEY, "k10000") == SEQ_ERR_NODE )
+	SEQ_ASSERT( seq_set(seq, SEQ_KEY, "k10000", &vals[0]) == SEQ_ERR_NODE )
+	SEQ_ASSERT( !seq_add(seq, SEQ_KEYVAL, buf, &vals[42]) )
+	SEQ_ASSERT( (iter = seq_iter_create(seq, SEQ_KEY_PREFIX, buf, SEQ_ERR_NONE)) != NULL )
+	SEQ_ASSERT( seq_iterate(iter) && seq_iter_get(iter, SEQ_KEY) == key )
+
+	seq_iter_destroy(iter);
+SEQ_TEST_END
+
+/* Ranges seek their first key and walk the leaves from there, forward or backward, stopping at
+ * the other bound; bounds needn't be keys in the map. */
+SEQ_TEST_BEGIN_TYPE(range, SEQ_MAP)
+	struct _seq_stats_t stats;
+	seq_iter_t iter = NULL;
+	seq_opt_t flags[] = { SEQ_ERR_NONE, SEQ_REVERSE, SEQ_EXCLUDE_LO, SEQ_EXCLUDE_HI };
+	seq_size_t hops;
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( map_range(seq, -1, -1, SEQ_ERR_NONE, SEQ_ERR_NONE) == 0 )
+	SEQ_ASSERT( map_range(seq, 10, 20, SEQ_REVERSE, SEQ_ERR_NONE) == 0 )
+
+	for(i = 0; i < MAP_KEYS; i++) {
+		if(i % 3 && seq_add(seq, SEQ_KEYVAL, keys[i], &vals[i])) ok = 0;
+
+		present[i] = i % 3 != 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( map_range(seq, -1, -1, SEQ_ERR_NONE, SEQ_ERR_NONE) == (int)(seq_size(seq)) )
+	SEQ_ASSERT( map_range(seq, -1, -1, SEQ_REVERSE, SEQ_ERR_NONE) == (int)(seq_size(seq)) )
+	SEQ_ASSERT( map_range(seq, 100, 199, SEQ_ERR_NONE, SEQ_ERR_NONE) == 67 )
+	SEQ_ASSERT( map_range(seq, 101, 200, SEQ_EXCLUDE_LO, SEQ_EXCLUDE_HI) == 65 )
+	SEQ_ASSERT( map_range(seq, 101, 200, SEQ_REVERSE, SEQ_EXCLUDE_HI) == 66 )
+	SEQ_ASSERT( map_range(seq, 99, 102, SEQ_REVERSE, SEQ_ERR_NONE) == 2 )
+	SEQ_ASSERT( map_range(seq, 101, 101, SEQ_ERR_NONE, SEQ_ERR_NONE) == 1 )
+	SEQ_ASSERT( map_range(seq, 101, 101, SEQ_REVERSE, SEQ_EXCLUDE_LO) == 0 )
+	SEQ_ASSERT( map_range(seq, 200, 100, SEQ_ERR_NONE, SEQ_ERR_NONE) == 0 )
+	SEQ_ASSERT( map_range(seq, MAP_KEYS - 1, -1, SEQ_ERR_NONE, SEQ_ERR_NONE) == 1 )
+	SEQ_ASSERT( map_range(seq, -1, 0, SEQ_REVERSE, SEQ_ERR_NONE) == 0 )
+
+	for(i = 0; i < 1000; i++) {
+		int lo = map_rand(MAP_KEYS + 1) - 1;
+		int hi = map_rand(MAP_KEYS + 1) - 1;
+
+		if(map_range(seq, lo, hi, flags[map_rand(4)], flags[map_rand(4)]) < 0) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_iter_create(seq, SEQ_KEY_PREFIX, "k", SEQ_REVERSE, SEQ_ERR_NONE) == NULL )
+	SEQ_ASSERT( !seq_iter_create(seq, SEQ_KEY_PREFIX, "k", SEQ_RANGE, keys[1], NULL, SEQ_ERR_NONE) )
+
+	/* Seeking costs as much as a single lookup, and the rest of the range nothing at all. */
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[1000]) && !seq_stats(seq, &stats) )
+
+	hops = stats.hops;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+	SEQ_ASSERT( (iter = seq_iter_create(seq, SEQ_RANGE, keys[1000], NULL, SEQ_ERR_NONE)) != NULL )
+
+	while(seq_iterate(iter));
+
+	seq_iter_destroy(iter);
+
+	SEQ_ASSERT( !seq_stats(seq, &stats) && stats.hops == hops && hops > 0 )
+
+	memset(present, 0, sizeof(present));
+SEQ_TEST_END
+
+/* Keys that were never added are turned away by the filter, whether they were added before it was
+ * enabled or after, and removing keys (and rebuilding the filter) never loses one still present. */
+SEQ_TEST_BEGIN_TYPE(bloom, SEQ_MAP)
+	struct _seq_stats_t stats;
+	char buf[8];
+	int ok = 1;
+	int i;
+
+	for(i = 0; i < MAP_KEYS / 2; i++) seq_add(seq, SEQ_KEYVAL, keys[i], &vals[i]);
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_BLOOM, (seq_size_t)(100)) )
+	SEQ_ASSERT( seq_config(seq, SEQ_CB_CMP, val_cmp) == SEQ_ERR_OPT )
+
+	for(i = MAP_KEYS / 2; i < MAP_KEYS; i++) seq_add(seq, SEQ_KEYVAL, keys[i], &vals[i]);
+
+	for(i = 0; i < MAP_KEYS; i++) {
+		if(seq_get(seq, SEQ_KEY, keys[i]) != &vals[i]) ok = 0;
+	}
+
+	SEQ_ASSERT( ok && seq_size(seq) == MAP_KEYS )
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+
+	for(i = 0; i < MAP_KEYS; i++) {
+		sprintf(buf, "m%05d", i);
+
+		if(seq_get(seq, SEQ_KEY, buf)) ok = 0;
+	}
+
+	SEQ_ASSERT( ok && !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.hops < MAP_KEYS / 10 )
+	SEQ_ASSERT( seq_remove(seq, SEQ_KEY, "m00000") == SEQ_ERR_NODE )
+
+	/* Removing three out of four keys rebuilds the filter once, halfway through. */
+	for(i = 0; i < MAP_KEYS; i++) {
+		if(i % 4 && seq_remove(seq, SEQ_KEY, keys[i])) ok = 0;
+	}
+
+	for(i = 0; i < MAP_KEYS; i++) {
+		if(seq_get(seq, SEQ_KEY, keys[i]) != (i % 4 ? NULL : &vals[i])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok && seq_size(seq) == MAP_KEYS / 4 )
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+
+	for(i = 0; i < MAP_KEYS; i++) {
+		if(i % 4) seq_get(seq, SEQ_KEY, keys[i]);
+	}
+
+	SEQ_ASSERT( !seq_stats(seq, &stats) && stats.hops < MAP_KEYS )
+	SEQ_ASSERT( !seq_config(seq, SEQ_BLOOM, (seq_size_t)(0)) )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, keys[4]) == &vals[4] && !seq_get(seq, SEQ_KEY, keys[5]) )
+SEQ_TEST_END
+
+/* Random insertions and removals against a model, exercising every borrow and merge case. */
+SEQ_TEST_BEGIN_TYPE(model, SEQ_MAP)
+	struct _seq_stats_t stats;
+	seq_size_t size = 0;
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+
+	memset(present, 0, sizeof(present));
+
+	for(i = 0; i < MAP_STEPS; i++) {
+		int k = map_rand(i < MAP_STEPS / 2 ? MAP_KEYS : MAP_KEYS / 4);
+
+		/* Insert more than remove during the first half, and the opposite afterwards. */
+		if(map_rand(10) < (i < MAP_STEPS / 2 ? 6 : 3)) {
+			if(seq_add(seq, SEQ_KEYVAL, keys[k], &vals[k])) ok = 0;
+
+			if(!present[k]) size++;
+
+			present[k] = 1;
+		}
+
+		else {
+			if(seq_remove(seq, SEQ_KEY, keys[k]) != (present[k] ? SEQ_ERR_NONE : SEQ_ERR_NODE)) {
+				ok = 0;
+			}
+
+			if(present[k]) size--;
+
+			present[k] = 0;
+		}
+
+		if(seq_size(seq) != size) ok = 0;
+
+		if(!(i % 4000) && !map_matches(seq, present)) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( map_matches(seq, present) )
+
+	for(i = 0; i < MAP_KEYS; i++) {
+		if(seq_get(seq, SEQ_KEY, keys[i]) != (present[i] ? &vals[i] : NULL)) ok = 0;
+
+		if(present[i] && seq_remove(seq, SEQ_KEY, keys[i])) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_size(seq) == 0 )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.nodes_alloc == stats.nodes_free )
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	keys_init();
+
+	test_keyval("SEQ_MAP add/get/set/remove");
+	test_cmp("SEQ_BTREE custom comparison");
+	test_intern("SEQ_MAP SEQ_INTERN");
+	test_range("SEQ_MAP SEQ_RANGE");
+	test_bloom("SEQ_MAP SEQ_BLOOM");
+	test_model("SEQ_MAP random insert/remove");
+
+	return test_failures;
+}
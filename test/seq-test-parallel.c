@@ -0,0 +1,255 @@
+#include "seq-test.h"
+
+#define PARALLEL_ITEMS 100000
+
+static int items[PARALLEL_ITEMS + 1];
+
+static void parallel_inc(seq_data_t data, seq_data_t ctx) {
+	__atomic_fetch_add((int*)(data), 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add((int*)(ctx), 1, __ATOMIC_RELAXED);
+}
+
+/* Calls seq_parallel_for() from within the callback, which must then run on the calling thread. */
+static void parallel_nested(seq_data_t data, seq_data_t ctx) {
+	int count = 0;
+
+	seq_parallel_for((seq_t)(ctx), parallel_inc, &count, 1);
+
+	if(count == 4) __atomic_fetch_add((int*)(data), 1, __ATOMIC_RELAXED);
+}
+
+/* Maps every element to the one following it. */
+static seq_data_t parallel_next(seq_data_t data, seq_data_t ctx) {
+	return (int*)(data) + 1;
+}
+
+static seq_data_t parallel_null(seq_data_t data, seq_data_t ctx) {
+	return data == ctx ? NULL : data;
+}
+
+static int parallel_even(seq_data_t data, seq_data_t ctx) {
+	return !(((int*)(data) - items) % 2);
+}
+
+/* Both the elements and the accumulated value are integers, stored directly as seq_data_t. */
+static seq_data_t parallel_sum(seq_data_t acc, seq_data_t data, seq_data_t ctx) {
+	return (seq_data_t)((seq_size_t)(acc) + (seq_size_t)(data));
+}
+
+static void items_reset(void) {
+	int i;
+
+	for(i = 0; i < PARALLEL_ITEMS; i++) items[i] = 0;
+}
+
+/* Returns whether every element was visited exactly the given number of times. */
+static int items_visited(int times) {
+	int i;
+
+	for(i = 0; i < PARALLEL_ITEMS; i++) {
+		if(items[i] != times) return 0;
+	}
+
+	return 1;
+}
+
+static void items_add(seq_t seq) {
+	int i;
+
+	for(i = 0; i < PARALLEL_ITEMS; i++) seq_add(seq, SEQ_APPEND, &items[i]);
+}
+
+SEQ_TEST_BEGIN_TYPE(array, SEQ_ARRAY)
+	int count = 0;
+
+	items_reset();
+	items_add(seq);
+
+	SEQ_ASSERT( seq_parallel_for(seq, NULL, NULL, 0) == SEQ_ERR_CB )
+	SEQ_ASSERT( !seq_config(seq, SEQ_THREADS, 4) )
+	SEQ_ASSERT( seq_config(seq, SEQ_THREADS, -1) == SEQ_ERR_OPT )
+	SEQ_ASSERT( !seq_parallel_for(seq, parallel_inc, &count, 0) )
+	SEQ_ASSERT( count == PARALLEL_ITEMS && items_visited(1) )
+	SEQ_ASSERT( !seq_parallel_for(seq, parallel_inc, &count, 1000) )
+	SEQ_ASSERT( !seq_parallel_for(seq, parallel_inc, &count, 999) )
+	SEQ_ASSERT( !seq_parallel_for(seq, parallel_inc, &count, PARALLEL_ITEMS * 2) )
+	SEQ_ASSERT( count == PARALLEL_ITEMS * 4 && items_visited(4) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_THREADS, 1) )
+	SEQ_ASSERT( !seq_parallel_for(seq, parallel_inc, &count, 0) )
+	SEQ_ASSERT( count == PARALLEL_ITEMS * 5 && items_visited(5) )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN(list)
+	int count = 0;
+
+	items_reset();
+	items_add(seq);
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_THREADS, 3) )
+	SEQ_ASSERT( !seq_parallel_for(seq, parallel_inc, &count, 0) )
+	SEQ_ASSERT( !seq_parallel_for(seq, parallel_inc, &count, 7) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_THREADS, 8) )
+	SEQ_ASSERT( !seq_parallel_for(seq, parallel_inc, &count, 4096) )
+	SEQ_ASSERT( count == PARALLEL_ITEMS * 3 && items_visited(3) )
+SEQ_TEST_END
+
+/* Workers left out of a call may only wake up once it has returned, so a wide call is followed by
+ * many narrow (and quick) ones, making sure those workers never pick up a job that's gone. */
+SEQ_TEST_BEGIN_TYPE(threads, SEQ_ARRAY)
+	seq_t small = seq_create(SEQ_ARRAY);
+	int count = 0;
+	int ok = 1;
+	int i;
+
+	items_reset();
+	items_add(seq);
+
+	seq_add(small, SEQ_APPEND, &items[PARALLEL_ITEMS]);
+	seq_add(small, SEQ_APPEND, &items[PARALLEL_ITEMS]);
+
+	SEQ_ASSERT( !seq_config(small, SEQ_THREADS, 2) )
+
+	for(i = 0; i < 1000; i++) {
+		if(!(i % 100)) {
+			if(seq_config(seq, SEQ_THREADS, i % 200 ? 2 : 64)) ok = 0;
+
+			if(seq_parallel_for(seq, parallel_inc, &count, 0)) ok = 0;
+		}
+
+		if(seq_parallel_for(small, parallel_inc, &count, 1)) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( count == PARALLEL_ITEMS * 10 + 2000 && items_visited(10) )
+	SEQ_ASSERT( items[PARALLEL_ITEMS] == 2000 )
+
+	seq_destroy(small);
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(nested, SEQ_ARRAY)
+	seq_t inner = seq_create(SEQ_ARRAY);
+	int ok[16];
+	int i;
+
+	for(i = 0; i < 4; i++) seq_add(inner, SEQ_APPEND, &items[i]);
+
+	for(i = 0; i < 16; i++) {
+		ok[i] = 0;
+
+		seq_add(seq, SEQ_APPEND, &ok[i]);
+	}
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_THREADS, 4) && !seq_config(inner, SEQ_THREADS, 4) )
+	SEQ_ASSERT( !seq_parallel_for(seq, parallel_nested, inner, 1) )
+
+	for(i = 0; i < 16; i++) {
+		if(ok[i] != 1) break;
+	}
+
+	SEQ_ASSERT( i == 16 )
+
+	seq_destroy(inner);
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(map, SEQ_ARRAY)
+	seq_t out = NULL;
+	seq_t list = seq_create(SEQ_LIST);
+	seq_size_t i;
+	int ok = 1;
+
+	items_add(seq);
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_THREADS, 4) )
+	SEQ_ASSERT( seq_map(seq, NULL, NULL) == NULL )
+	SEQ_ASSERT( (out = seq_map(seq, parallel_next, NULL)) != NULL )
+	SEQ_ASSERT( seq_type(out) == SEQ_ARRAY && seq_size(out) == PARALLEL_ITEMS )
+
+	for(i = 0; i < PARALLEL_ITEMS; i++) {
+		if(seq_get(out, SEQ_INDEX, (seq_index_t)(i)) != &items[i + 1]) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( seq_map(seq, parallel_null, &items[777]) == NULL )
+
+	seq_destroy(out);
+
+	/* An empty sequence maps to an empty array. */
+	SEQ_ASSERT( (out = seq_map(list, parallel_next, NULL)) != NULL && seq_size(out) == 0 )
+
+	seq_destroy(out);
+
+	items_add(list);
+
+	SEQ_ASSERT( !seq_config(list, SEQ_THREADS, 3) )
+	SEQ_ASSERT( (out = seq_map(list, parallel_next, NULL)) != NULL )
+	SEQ_ASSERT( seq_get(out, SEQ_INDEX, (seq_index_t)(-1)) == &items[PARALLEL_ITEMS] )
+
+	seq_destroy(out);
+	seq_destroy(list);
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN(filter)
+	seq_t out = NULL;
+	seq_iter_t iter = NULL;
+	int* prev = NULL;
+	int ok = 1;
+
+	items_add(seq);
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_THREADS, 4) )
+	SEQ_ASSERT( (out = seq_filter(seq, parallel_even, NULL)) != NULL )
+	SEQ_ASSERT( seq_type(out) == SEQ_LIST && seq_size(out) == PARALLEL_ITEMS / 2 )
+
+	iter = seq_iter_create(out, SEQ_ERR_NONE);
+
+	while(seq_iterate(iter)) {
+		int* item = (int*)(seq_iter_get(iter, SEQ_DATA));
+
+		if((item - items) % 2 || (prev && item != prev + 2)) ok = 0;
+
+		prev = item;
+	}
+
+	seq_iter_destroy(iter);
+
+	SEQ_ASSERT( ok && prev == &items[PARALLEL_ITEMS - 2] )
+	SEQ_ASSERT( seq_get(out, SEQ_INDEX, (seq_index_t)(0)) == &items[0] )
+	SEQ_ASSERT( !seq_remove(out, SEQ_INDEX, (seq_index_t)(-1)) )
+	SEQ_ASSERT( !seq_add(out, SEQ_APPEND, &items[1]) )
+	SEQ_ASSERT( seq_get(out, SEQ_INDEX, (seq_index_t)(-1)) == &items[1] )
+
+	seq_destroy(out);
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(reduce, SEQ_ARRAY)
+	seq_t list = seq_create(SEQ_LIST);
+	seq_size_t sum = 0;
+	seq_size_t i;
+
+	for(i = 0; i < PARALLEL_ITEMS; i++) {
+		seq_add(seq, SEQ_APPEND, (seq_data_t)((i % 7) + 1));
+		seq_add(list, SEQ_APPEND, (seq_data_t)((i % 7) + 1));
+
+		sum += (i % 7) + 1;
+	}
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_THREADS, 4) )
+	SEQ_ASSERT( (seq_size_t)(seq_reduce(seq, parallel_sum, NULL, NULL)) == sum )
+	SEQ_ASSERT( (seq_size_t)(seq_reduce(list, parallel_sum, NULL, NULL)) == sum )
+	SEQ_ASSERT( !seq_config(list, SEQ_THREADS, 1) )
+	SEQ_ASSERT( (seq_size_t)(seq_reduce(list, parallel_sum, NULL, NULL)) == sum )
+
+	seq_destroy(list);
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	test_array("seq_parallel_for (SEQ_ARRAY)");
+	test_list("seq_parallel_for (SEQ_LIST)");
+	test_threads("seq_parallel_for (SEQ_THREADS)");
+	test_nested("seq_parallel_for nested");
+	test_map("seq_map");
+	test_filter("seq_filter");
+	test_reduce("seq_reduce");
+
+	return test_failures;
+}
@@ -0,0 +1,163 @@
+#include "seq-test.h"
+
+typedef struct _order_t {
+	int price;
+	int id;
+} order_t;
+
+static order_t orders[2000];
+
+static seq_opt_t order_cmp(seq_t seq, seq_data_t lhs, seq_data_t rhs) {
+	int a = ((order_t*)(lhs))->price;
+	int b = ((order_t*)(rhs))->price;
+
+	return a < b ? SEQ_LESS : (a > b ? SEQ_GREATER : SEQ_EQUAL);
+}
+
+/* Verifies that the elements are ordered by price and, among equal prices, by id. */
+static int orders_sorted(seq_t seq) {
+	seq_iter_t iter = seq_iter_create(seq, SEQ_ERR_NONE);
+	order_t* prev = NULL;
+	int sorted = 1;
+
+	while(seq_iterate(iter)) {
+		order_t* o = (order_t*)(seq_iter_get(iter, SEQ_DATA));
+
+		if(prev && (prev->price > o->price || (prev->price == o->price && prev->id > o->id))) {
+			sorted = 0;
+		}
+
+		prev = o;
+	}
+
+	seq_iter_destroy(iter);
+
+	return sorted;
+}
+
+static void orders_init(void) {
+	int i;
+
+	for(i = 0; i < 2000; i++) {
+		orders[i].price = (i * 7919) % 500;
+		orders[i].id = i;
+	}
+}
+
+/* Returns the nth order (by id) with the given price; every price is shared by 4 orders. */
+static order_t* orders_price(int price, int n) {
+	int i;
+
+	for(i = 0; i < 2000; i++) {
+		if(orders[i].price == price && !n--) return &orders[i];
+	}
+
+	return NULL;
+}
+
+static void orders_add(seq_t seq) {
+	int i;
+
+	for(i = 0; i < 2000; i++) seq_add(seq, SEQ_APPEND, &orders[i]);
+}
+
+SEQ_TEST_BEGIN(list)
+	struct _seq_stats_t stats;
+	order_t key = { 250, 0 };
+	order_t* o;
+	int i;
+
+	SEQ_ASSERT( seq_config(seq, SEQ_SORTED, NULL) == SEQ_ERR_CB )
+	SEQ_ASSERT( !seq_config(seq, SEQ_SORTED, order_cmp) )
+	SEQ_ASSERT( seq_config(seq, SEQ_INTRUSIVE, (seq_size_t)(0)) == SEQ_ERR_OPT )
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+
+	orders_add(seq);
+
+	SEQ_ASSERT( seq_size(seq) == 2000 )
+	SEQ_ASSERT( orders_sorted(seq) )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.cb[SEQ_CB_CMP & 0xFFFF] < 2000 * 64 )
+	SEQ_ASSERT( ((order_t*)(seq_get(seq, SEQ_INDEX, (seq_index_t)(0))))->price == 0 )
+	SEQ_ASSERT( ((order_t*)(seq_get(seq, SEQ_INDEX, (seq_index_t)(-1))))->price == 499 )
+
+	o = (order_t*)(seq_get(seq, SEQ_KEY, &key));
+
+	SEQ_ASSERT( o == orders_price(250, 0) )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_KEY, &key) )
+	SEQ_ASSERT( seq_get(seq, SEQ_DATA, o) == NULL )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, &key) == orders_price(250, 1) )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_DATA, orders_price(250, 2)) )
+	SEQ_ASSERT( seq_get(seq, SEQ_DATA, orders_price(250, 3)) == orders_price(250, 3) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_PREPEND, o) )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, &key) == o )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_DATA, o) )
+	SEQ_ASSERT( !seq_add(seq, SEQ_PUSH, o) )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, &key) == o )
+	SEQ_ASSERT( seq_add(seq, SEQ_AFTER, SEQ_INDEX, (seq_index_t)(0), &orders[0]) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_set(seq, SEQ_INDEX, (seq_index_t)(0), &orders[1]) == SEQ_ERR_OPT )
+
+	/* Removing everything (from both ends and the middle) must keep the skip list intact. */
+	for(i = 0; i < 2000; i += 3) seq_remove(seq, SEQ_DATA, &orders[i]);
+
+	SEQ_ASSERT( orders_sorted(seq) )
+
+	while(seq_size(seq)) seq_remove(seq, SEQ_INDEX, (seq_index_t)(seq_size(seq) % 2 ? 0 : -1));
+
+	key.price = 0;
+
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, &key) == NULL )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, &orders[0]) )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, &key) == &orders[0] )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(array, SEQ_ARRAY)
+	order_t key = { 42, 0 };
+	order_t* o = orders_price(42, 2);
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_SORTED, order_cmp) )
+
+	orders_add(seq);
+
+	SEQ_ASSERT( orders_sorted(seq) )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, &key) == orders_price(42, 0) )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(4 * 42 + 3)) == orders_price(42, 3) )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_DATA, o) )
+	SEQ_ASSERT( seq_remove(seq, SEQ_DATA, o) == SEQ_ERR_NODE )
+	SEQ_ASSERT( !seq_add(seq, SEQ_PREPEND, o) )
+	SEQ_ASSERT( seq_get(seq, SEQ_KEY, &key) == o )
+	SEQ_ASSERT( seq_add(seq, SEQ_BEFORE, SEQ_INDEX, (seq_index_t)(0), &orders[0]) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_add(seq, SEQ_PUSH, o) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_set(seq, SEQ_INDEX, (seq_index_t)(0), &orders[1]) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_config(seq, SEQ_SORTED, order_cmp) == SEQ_ERR_OPT )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(values, SEQ_ARRAY)
+	order_t key = { 499, 0 };
+	order_t* o;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_STRIDE, sizeof(order_t)) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_SORTED, order_cmp) )
+
+	orders_add(seq);
+
+	SEQ_ASSERT( orders_sorted(seq) )
+
+	o = (order_t*)(seq_get(seq, SEQ_KEY, &key));
+
+	SEQ_ASSERT( o && o->id == orders_price(499, 0)->id )
+	SEQ_ASSERT( o != orders_price(499, 0) )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_KEY, &key) )
+	SEQ_ASSERT( seq_size(seq) == 1999 )
+	SEQ_ASSERT( orders_sorted(seq) )
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	orders_init();
+
+	test_list("SEQ_SORTED (SEQ_LIST)");
+	test_array("SEQ_SORTED (SEQ_ARRAY)");
+	test_values("SEQ_SORTED (SEQ_STRIDE)");
+
+	return test_failures;
+}
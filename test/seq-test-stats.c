@@ -0,0 +1,70 @@
+#include "seq-test.h"
+
+static int values[8];
+
+static void stats_remove(seq_data_t data) {
+}
+
+#define stats_op(field, opt) stats.field[(opt) & 0xFFFF]
+
+SEQ_TEST_BEGIN(list)
+	struct _seq_stats_t stats;
+	int i;
+
+	SEQ_ASSERT( seq_stats(seq, &stats) == SEQ_ERR_OPT )
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_REMOVE, stats_remove) )
+
+	for(i = 0; i < 8; i++) seq_add(seq, SEQ_APPEND, &values[i]);
+
+	SEQ_ASSERT( !seq_add(seq, SEQ_PREPEND, &values[0]) )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(3)) == &values[2] )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(-2)) == &values[6] )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_DATA, &values[7]) )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_INDEX, (seq_index_t)(0)) )
+	SEQ_ASSERT( seq_add(seq, 0) == SEQ_ERR_OPT )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats_op(add, SEQ_APPEND) == 8 )
+	SEQ_ASSERT( stats_op(add, SEQ_PREPEND) == 1 )
+	SEQ_ASSERT( stats.add[0] == 1 )
+	SEQ_ASSERT( stats_op(get, SEQ_INDEX) == 2 )
+	SEQ_ASSERT( stats_op(remove, SEQ_DATA) == 1 )
+	SEQ_ASSERT( stats_op(remove, SEQ_INDEX) == 1 )
+	SEQ_ASSERT( stats.nodes_alloc == 9 )
+	SEQ_ASSERT( stats.nodes_free == 2 )
+	SEQ_ASSERT( stats.hops == 3 + 1 + 8 )
+	SEQ_ASSERT( stats_op(cb, SEQ_CB_REMOVE) == 2 )
+	SEQ_ASSERT( stats.size_peak == 9 )
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats.hops == 0 )
+	SEQ_ASSERT( stats.size_peak == 7 )
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 0) )
+	SEQ_ASSERT( seq_stats(seq, &stats) == SEQ_ERR_OPT )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(array, SEQ_ARRAY)
+	struct _seq_stats_t stats;
+	int i;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+
+	for(i = 0; i < 8; i++) seq_add(seq, SEQ_APPEND, &values[i]);
+
+	SEQ_ASSERT( !seq_set(seq, SEQ_INDEX, (seq_index_t)(0), &values[1]) )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(7)) == &values[7] )
+	SEQ_ASSERT( !seq_stats(seq, &stats) )
+	SEQ_ASSERT( stats_op(add, SEQ_APPEND) == 8 )
+	SEQ_ASSERT( stats_op(set, SEQ_INDEX) == 1 )
+	SEQ_ASSERT( stats_op(get, SEQ_INDEX) == 1 )
+	SEQ_ASSERT( stats.nodes_alloc == 0 )
+	SEQ_ASSERT( stats.hops == 0 )
+	SEQ_ASSERT( stats.size_peak == 8 )
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	test_list("SEQ_STATS (SEQ_LIST)");
+	test_array("SEQ_STATS (SEQ_ARRAY)");
+
+	return test_failures;
+}
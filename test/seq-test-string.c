@@ -14,12 +14,33 @@ int main(int argc, char** argv) {
 	test_seq_string(SEQ_QUEUE, "SEQ_QUEUE");
 	test_seq_string(SEQ_STACK, "SEQ_STACK");
 	test_seq_string(SEQ_ARRAY, "SEQ_ARRAY");
+	test_seq_string(SEQ_HEAP, "SEQ_HEAP");
+	test_seq_string(SEQ_DEQUE, "SEQ_DEQUE");
+	test_seq_string(SEQ_VECTOR, "SEQ_VECTOR");
+	test_seq_string(SEQ_BTREE, "SEQ_BTREE");
+	test_seq_string(SEQ_ART, "SEQ_ART");
+	test_seq_string(SEQ_CACHE, "SEQ_CACHE");
 
 	test_seq_string(SEQ_CONFIG, "SEQ_CONFIG");
 	test_seq_string(SEQ_CB_ADD, "SEQ_CB_ADD");
 	test_seq_string(SEQ_CB_REMOVE, "SEQ_CB_REMOVE");
 	test_seq_string(SEQ_SORTED, "SEQ_SORTED");
 	test_seq_string(SEQ_BLOCKING, "SEQ_BLOCKING");
+	test_seq_string(SEQ_INTRUSIVE, "SEQ_INTRUSIVE");
+	test_seq_string(SEQ_CB_SERIALIZE, "SEQ_CB_SERIALIZE");
+	test_seq_string(SEQ_CB_DESERIALIZE, "SEQ_CB_DESERIALIZE");
+	test_seq_string(SEQ_CHECKSUM, "SEQ_CHECKSUM");
+	test_seq_string(SEQ_STATS, "SEQ_STATS");
+	test_seq_string(SEQ_CB_TRACE, "SEQ_CB_TRACE");
+	test_seq_string(SEQ_TRACE, "SEQ_TRACE");
+	test_seq_string(SEQ_STRIDE, "SEQ_STRIDE");
+	test_seq_string(SEQ_CB_CMP, "SEQ_CB_CMP");
+	test_seq_string(SEQ_THREADS, "SEQ_THREADS");
+	test_seq_string(SEQ_INTERN, "SEQ_INTERN");
+	test_seq_string(SEQ_CAPACITY, "SEQ_CAPACITY");
+	test_seq_string(SEQ_CB_SIZE, "SEQ_CB_SIZE");
+	test_seq_string(SEQ_BLOOM, "SEQ_BLOOM");
+	test_seq_string(SEQ_COMPACT, "SEQ_COMPACT");
 
 	test_seq_string(SEQ_ADD, "SEQ_ADD");
 	test_seq_string(SEQ_APPEND, "SEQ_APPEND");
@@ -37,6 +58,8 @@ int main(int argc, char** argv) {
 	test_seq_string(SEQ_RECV, "SEQ_RECV");
 	test_seq_string(SEQ_POP, "SEQ_POP");
 	test_seq_string(SEQ_DATA, "SEQ_DATA");
+	test_seq_string(SEQ_PEEK, "SEQ_PEEK");
+	test_seq_string(SEQ_STEAL, "SEQ_STEAL");
 
 	test_seq_string(SEQ_ITER, "SEQ_ITER");
 	test_seq_string(SEQ_READY, "SEQ_READY");
@@ -44,6 +67,10 @@ int main(int argc, char** argv) {
 	test_seq_string(SEQ_STOP, "SEQ_STOP");
 	test_seq_string(SEQ_RANGE, "SEQ_RANGE");
 	test_seq_string(SEQ_INC, "SEQ_INC");
+	test_seq_string(SEQ_KEY_PREFIX, "SEQ_KEY_PREFIX");
+	test_seq_string(SEQ_REVERSE, "SEQ_REVERSE");
+	test_seq_string(SEQ_EXCLUDE_LO, "SEQ_EXCLUDE_LO");
+	test_seq_string(SEQ_EXCLUDE_HI, "SEQ_EXCLUDE_HI");
 
 	test_seq_string(SEQ_CMP, "SEQ_CMP");
 	test_seq_string(SEQ_LESS, "SEQ_LESS");
@@ -58,6 +85,16 @@ int main(int argc, char** argv) {
 	test_seq_string(SEQ_ERR_NODE, "SEQ_ERR_NODE");
 	test_seq_string(SEQ_ERR_CB, "SEQ_ERR_CB");
 	test_seq_string(SEQ_ERR_TODO, "SEQ_ERR_TODO");
+	test_seq_string(SEQ_ERR_IO, "SEQ_ERR_IO");
+
+	test_seq_string(SEQ_CALL, "SEQ_CALL");
+	test_seq_string(SEQ_CALL_ADD, "SEQ_CALL_ADD");
+	test_seq_string(SEQ_CALL_REMOVE, "SEQ_CALL_REMOVE");
+	test_seq_string(SEQ_CALL_GET, "SEQ_CALL_GET");
+	test_seq_string(SEQ_CALL_SET, "SEQ_CALL_SET");
+	test_seq_string(SEQ_CALL_DESTROY, "SEQ_CALL_DESTROY");
+	test_seq_string(SEQ_CALL_CB_ADD, "SEQ_CALL_CB_ADD");
+	test_seq_string(SEQ_CALL_CB_REMOVE, "SEQ_CALL_CB_REMOVE");
 
 	test_seq_string(0x10101010, "(null)");
 
@@ -0,0 +1,90 @@
+#include "seq-test.h"
+
+#include <string.h>
+
+static int values[64];
+static int traced[(SEQ_CALL_MAX & 0xFFFF) + 1];
+static seq_opt_t traced_op = 0;
+static char dump[4096];
+static seq_size_t dump_len = 0;
+
+static void trace_cb(seq_t seq, seq_opt_t call, seq_opt_t op, uint64_t ns) {
+	traced[call & 0xFFFF]++;
+
+	if(call == SEQ_CALL_GET) traced_op = op;
+}
+
+static void trace_remove(seq_data_t data) {
+}
+
+static seq_size_t trace_write(const void* buf, seq_size_t size, seq_data_t ctx) {
+	if(dump_len + size >= sizeof(dump)) return 0;
+
+	memcpy(dump + dump_len, buf, size);
+
+	dump_len += size;
+	dump[dump_len] = 0;
+
+	return size;
+}
+
+SEQ_TEST_BEGIN(hook)
+	int i;
+
+	SEQ_ASSERT( seq_config(seq, SEQ_CB_TRACE, NULL) == SEQ_ERR_CB )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_TRACE, trace_cb) )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_REMOVE, trace_remove) )
+
+	for(i = 0; i < 4; i++) seq_add(seq, SEQ_APPEND, &values[i]);
+
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(1)) == &values[1] )
+	SEQ_ASSERT( !seq_remove(seq, SEQ_INDEX, (seq_index_t)(0)) )
+	SEQ_ASSERT( traced[SEQ_CALL_ADD & 0xFFFF] == 4 )
+	SEQ_ASSERT( traced[SEQ_CALL_GET & 0xFFFF] == 1 )
+	SEQ_ASSERT( traced_op == SEQ_INDEX )
+	SEQ_ASSERT( traced[SEQ_CALL_REMOVE & 0xFFFF] == 1 )
+	SEQ_ASSERT( traced[SEQ_CALL_CB_REMOVE & 0xFFFF] == 1 )
+	SEQ_ASSERT( seq_trace(seq, SEQ_CALL_ADD, SEQ_APPEND, 50.0) == 0 )
+	SEQ_ASSERT( seq_trace_dump(seq, trace_write, NULL) == SEQ_ERR_OPT )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(histogram, SEQ_ARRAY)
+	uint64_t p50;
+	uint64_t p999;
+	uint64_t max;
+	int i;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_TRACE, 1) )
+
+	for(i = 0; i < 64; i++) seq_add(seq, SEQ_APPEND, &values[i]);
+
+	for(i = 0; i < 64; i++) seq_get(seq, SEQ_INDEX, (seq_index_t)(i));
+
+	p50 = seq_trace(seq, SEQ_CALL_ADD, SEQ_APPEND, 50.0);
+	p999 = seq_trace(seq, SEQ_CALL_ADD, SEQ_APPEND, 99.9);
+	max = seq_trace(seq, SEQ_CALL_ADD, SEQ_APPEND, 100.0);
+
+	SEQ_ASSERT( p50 > 0 )
+	SEQ_ASSERT( p50 <= p999 )
+	SEQ_ASSERT( p999 <= max )
+	SEQ_ASSERT( seq_trace(seq, SEQ_CALL_GET, SEQ_INDEX, 99.0) > 0 )
+	SEQ_ASSERT( seq_trace(seq, SEQ_CALL_GET, SEQ_DATA, 99.0) == 0 )
+	SEQ_ASSERT( !seq_trace_dump(seq, trace_write, NULL) )
+	SEQ_ASSERT( strstr(dump, "CALL_ADD") != NULL )
+	SEQ_ASSERT( strstr(dump, "APPEND   count=64") != NULL )
+	SEQ_ASSERT( strstr(dump, "CALL_GET") != NULL )
+	SEQ_ASSERT( strstr(dump, "p99.9=") != NULL )
+	SEQ_ASSERT( !seq_config(seq, SEQ_TRACE, 1) )
+	SEQ_ASSERT( seq_trace(seq, SEQ_CALL_ADD, SEQ_APPEND, 50.0) == 0 )
+	SEQ_ASSERT( !seq_config(seq, SEQ_TRACE, 0) )
+	SEQ_ASSERT( seq_trace_dump(seq, trace_write, NULL) == SEQ_ERR_OPT )
+
+	printf("%s", dump);
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	test_hook("SEQ_CB_TRACE");
+	test_histogram("SEQ_TRACE");
+
+	return test_failures;
+}
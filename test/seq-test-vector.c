@@ -0,0 +1,412 @@
+#include "seq-test.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#define VECTOR_ITEMS 5000
+#define VECTOR_MODEL 40000
+#define VECTOR_STEPS 500
+
+static int items[VECTOR_ITEMS];
+static int other[VECTOR_ITEMS];
+static int removed = 0;
+
+/* The versions derived from one another are checked against plain arrays of indexes into items. */
+static int model[VECTOR_MODEL];
+static int prev[VECTOR_MODEL];
+static seq_size_t rand_state = 1;
+
+static void vector_remove(seq_data_t data) {
+	removed++;
+}
+
+static void items_add(seq_t seq) {
+	int i;
+
+	for(i = 0; i < VECTOR_ITEMS; i++) seq_add(seq, SEQ_APPEND, &items[i]);
+}
+
+/* Returns whether every element of the vector is the item at the same index of @expect. */
+static int vector_holds(seq_t seq, int* expect, seq_size_t size) {
+	seq_iter_t iter = NULL;
+	seq_size_t i = 0;
+	int ok = seq_size(seq) == size;
+
+	iter = seq_iter_create(seq, SEQ_ERR_NONE);
+
+	for(i = 0; seq_iterate(iter); i++) {
+		if(seq_iter_get(iter, SEQ_DATA) != &expect[i]) ok = 0;
+	}
+
+	seq_iter_destroy(iter);
+
+	return ok && i == size;
+}
+
+static seq_size_t vector_rand(seq_size_t n) {
+	rand_state = rand_state * 1103515245 + 12345;
+
+	return n ? (rand_state >> 8) % n : 0;
+}
+
+/* Returns a new vector holding items[first] up to (but not including) items[first + n]. */
+static seq_t vector_range(int first, int n) {
+	seq_t seq = seq_create(SEQ_VECTOR);
+	int i;
+
+	for(i = first; i < first + n; i++) seq_add(seq, SEQ_APPEND, &items[i]);
+
+	return seq;
+}
+
+/* Like vector_holds(), but against a model, and looking up a few elements by index as well. */
+static int vector_matches(seq_t seq, const int* expect, seq_size_t size) {
+	seq_iter_t iter = seq_iter_create(seq, SEQ_ERR_NONE);
+	seq_size_t i = 0;
+	seq_size_t j;
+	int ok = seq_size(seq) == size;
+
+	for(i = 0; seq_iterate(iter); i++) {
+		if(i >= size || seq_iter_get(iter, SEQ_DATA) != &items[expect[i]]) ok = 0;
+	}
+
+	seq_iter_destroy(iter);
+
+	for(j = 0; j < 16 && size; j++) {
+		seq_size_t index = vector_rand(size);
+
+		if(seq_get(seq, SEQ_INDEX, (seq_index_t)(index)) != &items[expect[index]]) ok = 0;
+	}
+
+	return ok && i == size;
+}
+
+SEQ_TEST_BEGIN_TYPE(vector, SEQ_VECTOR)
+	struct _seq_stats_t stats;
+	seq_iter_t iter = NULL;
+	int ok = 1;
+	int i;
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) )
+	SEQ_ASSERT( seq_add(seq, SEQ_PUSH, &items[0]) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_get(seq, SEQ_POP) == NULL )
+
+	items_add(seq);
+
+	SEQ_ASSERT( vector_holds(seq, items, VECTOR_ITEMS) )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(1234)) == &items[1234] )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(-1)) == &items[VECTOR_ITEMS - 1] )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(VECTOR_ITEMS)) == NULL )
+	SEQ_ASSERT( !seq_set(seq, SEQ_INDEX, (seq_index_t)(1024), &other[1024]) )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(1024)) == &other[1024] )
+	SEQ_ASSERT( seq_remove(seq, SEQ_INDEX, (seq_index_t)(VECTOR_ITEMS)) == SEQ_ERR_NODE )
+
+	iter = seq_iter_create(
+		seq,
+		SEQ_RANGE,
+		(seq_index_t)(1000),
+		(seq_index_t)(1100),
+		SEQ_INC,
+		(seq_size_t)(50),
+		SEQ_ERR_NONE
+	);
+
+	for(i = 1000; seq_iterate(iter); i += 50) {
+		if(seq_iter_get(iter, SEQ_DATA) != &items[i]) ok = 0;
+
+		if(i == 1000 && seq_iter_set(iter, SEQ_DATA, &other[i])) ok = 0;
+	}
+
+	seq_iter_destroy(iter);
+
+	SEQ_ASSERT( ok && i == 1150 )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(1000)) == &other[1000] )
+	SEQ_ASSERT( !seq_config(seq, SEQ_CB_REMOVE, vector_remove) )
+
+	/* Popping every element frees every node, crossing each level boundary on the way down. */
+	for(i = VECTOR_ITEMS - 1; i >= 0 && ok; i--) {
+		int* expect = i == 1000 || i == 1024 ? &other[i] : &items[i];
+
+		if(i % 2) ok = seq_get(seq, SEQ_POP) == expect;
+
+		else ok = seq_get(seq, SEQ_INDEX, (seq_index_t)(-1)) == expect && !seq_remove(seq, SEQ_POP);
+	}
+
+	SEQ_ASSERT( ok && seq_size(seq) == 0 && removed == VECTOR_ITEMS / 2 )
+	SEQ_ASSERT( !seq_stats(seq, &stats) && stats.nodes_alloc == stats.nodes_free )
+	SEQ_ASSERT( !seq_add(seq, SEQ_APPEND, &items[0]) )
+	SEQ_ASSERT( seq_get(seq, SEQ_INDEX, (seq_index_t)(0)) == &items[0] )
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(snapshot, SEQ_VECTOR)
+	struct _seq_stats_t before;
+	struct _seq_stats_t after;
+	seq_t list = seq_create(SEQ_LIST);
+	seq_t snap = NULL;
+	seq_t again = NULL;
+	int i;
+
+	removed = 0;
+
+	SEQ_ASSERT( seq_snapshot(list) == NULL )
+	SEQ_ASSERT( (snap = seq_snapshot(seq)) != NULL && seq_size(snap) == 0 )
+
+	seq_destroy(snap);
+
+	items_add(seq);
+
+	SEQ_ASSERT( !seq_config(seq, SEQ_STATS, 1) && !seq_config(seq, SEQ_CB_REMOVE, vector_remove) )
+	SEQ_ASSERT( (snap = seq_snapshot(seq)) != NULL )
+	SEQ_ASSERT( seq_type(snap) == SEQ_VECTOR && vector_holds(snap, items, VECTOR_ITEMS) )
+
+	/* A shared trie of 5000 elements is three levels deep, so that's how many nodes are copied. */
+	seq_stats(seq, &before);
+
+	SEQ_ASSERT( !seq_set(seq, SEQ_INDEX, (seq_index_t)(7), &other[7]) )
+
+	seq_stats(seq, &after);
+
+	SEQ_ASSERT( after.nodes_alloc - before.nodes_alloc == 3 )
+	SEQ_ASSERT( !seq_set(seq, SEQ_INDEX, (seq_index_t)(8), &other[8]) )
+
+	seq_stats(seq, &before);
+
+	SEQ_ASSERT( before.nodes_alloc == after.nodes_alloc )
+	SEQ_ASSERT( seq_get(snap, SEQ_INDEX, (seq_index_t)(7)) == &items[7] )
+	SEQ_ASSERT( seq_add(snap, SEQ_APPEND, &items[0]) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_set(snap, SEQ_INDEX, (seq_index_t)(0), &items[0]) == SEQ_ERR_OPT )
+	SEQ_ASSERT( seq_remove(snap, SEQ_POP) == SEQ_ERR_OPT && seq_get(snap, SEQ_POP) == NULL )
+
+	/* A snapshot of a snapshot shares the same nodes, and outlives the vector it came from. */
+	SEQ_ASSERT( (again = seq_snapshot(snap)) != NULL )
+
+	for(i = 0; i < VECTOR_ITEMS; i++) seq_get(seq, SEQ_POP);
+
+	SEQ_ASSERT( seq_size(seq) == 0 && removed == 2 )
+
+	seq_destroy(snap);
+
+	SEQ_ASSERT( vector_holds(again, items, VECTOR_ITEMS) )
+
+	seq_destroy(again);
+	seq_destroy(list);
+
+	SEQ_ASSERT( removed == 2 )
+SEQ_TEST_END
+
+/* Every pair of sizes around the boundaries of the levels, so that seams fall in every spot. */
+SEQ_TEST_BEGIN_TYPE(concat, SEQ_VECTOR)
+	static const int sizes[] = { 0, 1, 31, 32, 33, 1023, 1024, 1025, 2500 };
+	seq_t left = NULL;
+	seq_t right = NULL;
+	seq_t both = NULL;
+	seq_t slice = NULL;
+	int ok = 1;
+	int i, j, k;
+
+	for(i = 0; i < 9; i++) {
+		for(j = 0; j < 9; j++) {
+			left = vector_range(0, sizes[i]);
+			right = vector_range(sizes[i], sizes[j]);
+
+			for(k = 0; k < sizes[i] + sizes[j]; k++) model[k] = k;
+
+			if(!(both = seq_concat(left, right))) ok = 0;
+
+			else if(!vector_matches(both, model, sizes[i] + sizes[j])) ok = 0;
+
+			if(!vector_matches(left, model, sizes[i])) ok = 0;
+
+			seq_destroy(left);
+			seq_destroy(right);
+
+			/* Cutting the result back up at the seam undoes it. */
+			if(both && sizes[i]) {
+				slice = seq_slice(both, (seq_index_t)(sizes[i]), (seq_index_t)(-1));
+
+				if(!slice || !vector_matches(slice, &model[sizes[i]], sizes[j])) ok = 0;
+
+				seq_destroy(slice);
+			}
+
+			seq_destroy(both);
+		}
+	}
+
+	SEQ_ASSERT( ok )
+
+	items_add(seq);
+
+	SEQ_ASSERT( (both = seq_concat(seq, seq)) != NULL && seq_size(both) == VECTOR_ITEMS * 2 )
+	SEQ_ASSERT( seq_get(both, SEQ_INDEX, (seq_index_t)(VECTOR_ITEMS + 7)) == &items[7] )
+	SEQ_ASSERT( (slice = seq_slice(both, (seq_index_t)(10), (seq_index_t)(9))) != NULL )
+	SEQ_ASSERT( seq_size(slice) == 0 )
+
+	seq_destroy(slice);
+
+	SEQ_ASSERT( (slice = seq_slice(both, (seq_index_t)(-3), (seq_index_t)(-2))) != NULL )
+	SEQ_ASSERT( seq_size(slice) == 2 )
+	SEQ_ASSERT( seq_get(slice, SEQ_INDEX, (seq_index_t)(1)) == &items[VECTOR_ITEMS - 2] )
+
+	seq_destroy(slice);
+	seq_destroy(both);
+SEQ_TEST_END
+
+/* Every step derives a new version from the current one, leaving the latter (checked once more
+ * afterwards) as it was; the operations that work in place are applied to a full slice. */
+SEQ_TEST_BEGIN_TYPE(versions, SEQ_VECTOR)
+	seq_t cur = NULL;
+	seq_t next = NULL;
+	seq_size_t size = VECTOR_ITEMS;
+	seq_size_t old;
+	seq_size_t a, b, i;
+	int ok = 1;
+	int step, op;
+
+	items_add(seq);
+
+	for(i = 0; i < size; i++) model[i] = (int)(i);
+
+	cur = seq_slice(seq, (seq_index_t)(0), (seq_index_t)(-1));
+
+	for(step = 0; step < VECTOR_STEPS && ok; step++) {
+		memcpy(prev, model, size * sizeof(int));
+
+		old = size;
+		op = (int)(vector_rand(7));
+
+		if(size * 2 > VECTOR_MODEL) op = 1;
+
+		else if(size < 2) op = 0;
+
+		a = vector_rand(size);
+		b = a + vector_rand(size - a);
+
+		if(op == 0 && !vector_rand(4)) {
+			next = seq_concat(cur, cur);
+
+			memcpy(&model[size], prev, size * sizeof(int));
+
+			size *= 2;
+		}
+
+		else if(op == 0) {
+			seq_t slice = seq_slice(cur, (seq_index_t)(a), (seq_index_t)(b));
+			int front = (int)(vector_rand(2));
+
+			next = slice ? seq_concat(front ? slice : cur, front ? cur : slice) : NULL;
+
+			if(front) {
+				memcpy(model, &prev[a], (b - a + 1) * sizeof(int));
+				memcpy(&model[b - a + 1], prev, size * sizeof(int));
+			}
+
+			else memcpy(&model[size], &prev[a], (b - a + 1) * sizeof(int));
+
+			size += b - a + 1;
+
+			if(slice) seq_destroy(slice);
+		}
+
+		else if(op == 1) {
+			next = seq_slice(cur, (seq_index_t)(a), (seq_index_t)(b));
+
+			memmove(model, &model[a], (b - a + 1) * sizeof(int));
+
+			size = b - a + 1;
+		}
+
+		else if(op == 2) {
+			int item = (int)(vector_rand(VECTOR_ITEMS));
+
+			next = seq_update(cur, (seq_index_t)(a), &items[item]);
+
+			model[a] = item;
+		}
+
+		else {
+			next = seq_slice(cur, (seq_index_t)(0), (seq_index_t)(-1));
+
+			if(op == 3) {
+				if(next && seq_add(next, SEQ_PREPEND, &items[b % VECTOR_ITEMS])) ok = 0;
+
+				memmove(&model[1], model, size * sizeof(int));
+
+				model[0] = (int)(b % VECTOR_ITEMS);
+				size++;
+			}
+
+			else if(op == 4 || op == 5) {
+				if(next && seq_remove(next, SEQ_INDEX, (seq_index_t)(a))) ok = 0;
+
+				memmove(&model[a], &model[a + 1], (size - a - 1) * sizeof(int));
+
+				size--;
+			}
+
+			else {
+				if(next && seq_add(next, SEQ_APPEND, &items[a % VECTOR_ITEMS])) ok = 0;
+
+				model[size++] = (int)(a % VECTOR_ITEMS);
+			}
+		}
+
+		if(!next || !vector_matches(next, model, size) || !vector_matches(cur, prev, old)) ok = 0;
+
+		seq_destroy(cur);
+
+		cur = next;
+	}
+
+	SEQ_ASSERT( ok && step == VECTOR_STEPS )
+
+	/* A version of a version is still an ordinary vector, which can be emptied like any other. */
+	while(seq_size(cur) && seq_get(cur, SEQ_POP));
+
+	SEQ_ASSERT( seq_size(cur) == 0 )
+	SEQ_ASSERT( seq_update(cur, (seq_index_t)(0), &items[0]) == NULL )
+
+	seq_destroy(cur);
+SEQ_TEST_END
+
+static void* vector_scan(void* arg) {
+	seq_t snap = (seq_t)(arg);
+	int ok = vector_holds(snap, items, VECTOR_ITEMS);
+
+	seq_destroy(snap);
+
+	return ok ? arg : NULL;
+}
+
+/* Readers scan (and release) their snapshots while the writer keeps replacing every element. */
+SEQ_TEST_BEGIN_TYPE(concurrent, SEQ_VECTOR)
+	pthread_t threads[4];
+	void* result = NULL;
+	int ok = 1;
+	int i;
+
+	items_add(seq);
+
+	for(i = 0; i < 4; i++) pthread_create(&threads[i], NULL, vector_scan, seq_snapshot(seq));
+
+	for(i = 0; i < VECTOR_ITEMS; i++) seq_set(seq, SEQ_INDEX, (seq_index_t)(i), &other[i]);
+
+	for(i = 0; i < 4; i++) {
+		pthread_join(threads[i], &result);
+
+		if(!result) ok = 0;
+	}
+
+	SEQ_ASSERT( ok )
+	SEQ_ASSERT( vector_holds(seq, other, VECTOR_ITEMS) )
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	test_vector("SEQ_VECTOR");
+	test_snapshot("seq_snapshot");
+	test_concat("seq_concat/seq_slice");
+	test_versions("seq_update/seq_concat/seq_slice versions");
+	test_concurrent("seq_snapshot concurrent readers");
+
+	return test_failures;
+}
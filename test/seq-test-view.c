@@ -0,0 +1,169 @@
+#include "seq-test.h"
+
+#define VIEW_ITEMS 100
+
+static int items[VIEW_ITEMS];
+static int calls = 0;
+
+static int view_even(seq_data_t data, seq_data_t ctx) {
+	calls++;
+
+	return !(((int*)(data) - items) % 2);
+}
+
+/* Maps every element to the one following it. */
+static seq_data_t view_next(seq_data_t data, seq_data_t ctx) {
+	calls++;
+
+	return (int*)(data) + 1;
+}
+
+static seq_data_t view_null(seq_data_t data, seq_data_t ctx) {
+	return data == ctx ? NULL : data;
+}
+
+static seq_data_t view_count(seq_data_t acc, seq_data_t data, seq_data_t ctx) {
+	return (seq_data_t)((seq_size_t)(acc) + 1);
+}
+
+static void items_add(seq_t seq) {
+	int i;
+
+	for(i = 0; i < VIEW_ITEMS; i++) seq_add(seq, SEQ_APPEND, &items[i]);
+}
+
+/* Returns whether a pass over the view yields exactly the given items, in order. */
+static int view_yields(seq_view_t view, const int* index, int n) {
+	int i = 0;
+
+	while(seq_view_iterate(view)) {
+		if(i == n || seq_view_get(view) != &items[index[i]]) {
+			while(seq_view_iterate(view));
+
+			return 0;
+		}
+
+		i++;
+	}
+
+	return i == n;
+}
+
+SEQ_TEST_BEGIN_TYPE(pipeline, SEQ_ARRAY)
+	static const int expect[] = { 1, 3, 5 };
+	seq_view_t view = NULL;
+	seq_t out = NULL;
+
+	items_add(seq);
+
+	view = seq_view_take(seq_view_map(seq_view_filter(
+		seq_view_create(seq),
+		view_even,
+		NULL
+	), view_next, NULL), 3);
+
+	SEQ_ASSERT( view != NULL )
+
+	/* Only the five elements needed are ever filtered, and only the three kept are mapped. */
+	SEQ_ASSERT( view_yields(view, expect, 3) && calls == 8 )
+	SEQ_ASSERT( view_yields(view, expect, 3) && calls == 16 )
+	SEQ_ASSERT( (out = seq_view_collect(view, SEQ_LIST)) != NULL )
+	SEQ_ASSERT( seq_size(out) == 3 && seq_get(out, SEQ_INDEX, (seq_index_t)(-1)) == &items[5] )
+	SEQ_ASSERT( (seq_size_t)(seq_view_reduce(view, view_count, NULL, NULL)) == 3 )
+
+	seq_destroy(out);
+
+	/* An abandoned pass doesn't affect the terminal operations. */
+	SEQ_ASSERT( seq_view_iterate(view) && seq_view_get(view) == &items[1] )
+	SEQ_ASSERT( (seq_size_t)(seq_view_reduce(view, view_count, NULL, NULL)) == 3 )
+	SEQ_ASSERT( seq_view_map(view, view_null, &items[3]) == view )
+	SEQ_ASSERT( seq_view_collect(view, SEQ_ARRAY) == NULL )
+
+	seq_view_destroy(view);
+SEQ_TEST_END
+
+/* The same index-based stages, on types whose iterators do and don't support SEQ_RANGE. */
+static void view_index(seq_t seq) {
+	static const int skipped[] = { 21, 24, 27, 30 };
+	static const int filtered[] = { 6, 10, 14 };
+	static const int last[] = { VIEW_ITEMS - 1 };
+	seq_view_t view = NULL;
+
+	items_add(seq);
+
+	view = seq_view_take(seq_view_stride(seq_view_skip(seq_view_create(seq), 21), 3), 4);
+
+	SEQ_ASSERT( view_yields(view, skipped, 4) )
+
+	seq_view_destroy(view);
+
+	view = seq_view_take(seq_view_stride(seq_view_skip(seq_view_filter(
+		seq_view_create(seq),
+		view_even,
+		NULL
+	), 3), 2), 3);
+
+	SEQ_ASSERT( view_yields(view, filtered, 3) )
+
+	seq_view_destroy(view);
+
+	view = seq_view_stride(seq_view_skip(seq_view_create(seq), VIEW_ITEMS - 1), 1000);
+
+	SEQ_ASSERT( view_yields(view, last, 1) )
+
+	seq_view_destroy(view);
+
+	view = seq_view_take(seq_view_skip(seq_view_create(seq), VIEW_ITEMS), 5);
+
+	SEQ_ASSERT( view_yields(view, last, 0) )
+	SEQ_ASSERT( seq_view_take(view, 0) == view && !seq_view_iterate(view) )
+
+	seq_view_destroy(view);
+
+	view = seq_view_take(seq_view_create(seq), 1000);
+
+	SEQ_ASSERT( (seq_size_t)(seq_view_reduce(view, view_count, NULL, NULL)) == VIEW_ITEMS )
+
+	seq_view_destroy(view);
+}
+
+SEQ_TEST_BEGIN_TYPE(array, SEQ_ARRAY)
+	view_index(seq);
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN(list)
+	view_index(seq);
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN_TYPE(deque, SEQ_DEQUE)
+	view_index(seq);
+SEQ_TEST_END
+
+SEQ_TEST_BEGIN(invalid)
+	seq_view_t view = seq_view_create(seq);
+	int i;
+
+	SEQ_ASSERT( view != NULL )
+	SEQ_ASSERT( seq_view_skip(NULL, 1) == NULL )
+	SEQ_ASSERT( seq_view_filter(seq_view_create(seq), NULL, NULL) == NULL )
+	SEQ_ASSERT( seq_view_stride(seq_view_create(seq), 0) == NULL )
+
+	/* An empty view just yields the sequence itself. */
+	items_add(seq);
+
+	SEQ_ASSERT( (seq_size_t)(seq_view_reduce(view, view_count, NULL, NULL)) == VIEW_ITEMS )
+
+	for(i = 0; i < 16; i++) view = seq_view_skip(view, 0);
+
+	SEQ_ASSERT( view != NULL && seq_view_skip(view, 0) == NULL )
+SEQ_TEST_END
+
+int main(int argc, char** argv) {
+	test_pipeline("seq_view filter/map/take");
+	test_array("seq_view skip/take/stride (SEQ_ARRAY)");
+	test_list("seq_view skip/take/stride (SEQ_LIST)");
+	test_deque("seq_view skip/take/stride (SEQ_DEQUE)");
+	test_invalid("seq_view invalid stages");
+
+	return test_failures;
+}
@@ -53,9 +53,13 @@ void test_info(const char* fmt, ...) {
 	va_end(args);
 }
 
-#define SEQ_TEST_BEGIN(name) \
+static int test_failures = 0;
+
+#define SEQ_TEST_BEGIN(name) SEQ_TEST_BEGIN_TYPE(name, SEQ_LIST)
+
+#define SEQ_TEST_BEGIN_TYPE(name, type) \
 void test_##name(const char* descr) { \
-	seq_t seq = seq_create(SEQ_LIST); \
+	seq_t seq = seq_create(type); \
 	printf("======================================================================\n"); \
 	printf("test_%s: %s\n", #name, descr); \
 	printf("======================================================================\n"); { \
@@ -66,7 +70,7 @@ void test_##name(const char* descr) { \
 }
 
 #define SEQ_ASSERT(expr) \
-	if(!(expr)) printf(" >> [" TEST_FAIL "] " #expr "\n"); \
+	if(!(expr)) { printf(" >> [" TEST_FAIL "] " #expr "\n"); test_failures++; } \
 	else printf(" >> [" TEST_PASS "] " #expr "\n");
 
 #define SEQ_ASSERT_STRCMP(expr, str) \